@@ -0,0 +1,559 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "DimTypes/Arrow.hpp":                         //
+//        Apache Arrow C Data Interface Export/Import of "DimQ" Columns      //
+//===========================================================================//
+// The "ArrowSchema" and "ArrowArray" structs are defined here directly (as
+// required by the Arrow C Data Interface spec, ie w/o any library dependency).
+// A "DimQ" column is exported as a primitive Arrow array ("f" for "float", "g"
+// for "double") whose data buffer is the "DimQ" array itself (NO copying); the
+// Units are carried in the field metadata under the "DimTypes.units" key, in
+// the format of "Bits::PutUnits" (eg "km sec^(-1)"). Tables are exported as
+// Arrow structs ("+s") with one child per column:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <vector>
+#include <array>
+#include <span>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+//===========================================================================//
+// Arrow C Data Interface ABI (verbatim from the spec):                      //
+//===========================================================================//
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE           2
+#define ARROW_FLAG_MAP_KEYS_SORTED    4
+
+extern "C"
+{
+  struct ArrowSchema
+  {
+    // Array type description
+    const char*          format;
+    const char*          name;
+    const char*          metadata;
+    int64_t              flags;
+    int64_t              n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema*  dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void*                private_data;
+  };
+
+  struct ArrowArray
+  {
+    // Array data description
+    int64_t              length;
+    int64_t              null_count;
+    int64_t              offset;
+    int64_t              n_buffers;
+    int64_t              n_children;
+    const void**         buffers;
+    struct ArrowArray**  children;
+    struct ArrowArray*   dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void*                private_data;
+  };
+}
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Arrow Utils:                                                            //
+  //=========================================================================//
+  constexpr inline char ArrowUnitsKey[] = "DimTypes.units";
+
+  template<typename RepT> inline constexpr char const* ArrowFormat = nullptr;
+  template<> inline constexpr char const* ArrowFormat<float>  = "f";
+  template<> inline constexpr char const* ArrowFormat<double> = "g";
+
+  //-------------------------------------------------------------------------//
+  // "ArrowSchemaPriv", "ArrowSchemaRelease":                                //
+  //-------------------------------------------------------------------------//
+  // "private_data" of exported schemas: owns all strings and children (which
+  // are released and deleted by the Dtor, so a partially-built one held in a
+  // "unique_ptr" is cleaned up on exceptions):
+  //
+  struct ArrowSchemaPriv
+  {
+    std::string               m_format;
+    std::string               m_name;
+    std::string               m_metadata;
+    std::vector<ArrowSchema*> m_children;
+
+    ArrowSchemaPriv() = default;
+    ArrowSchemaPriv(ArrowSchemaPriv const&)            = delete;
+    ArrowSchemaPriv& operator=(ArrowSchemaPriv const&) = delete;
+
+    ~ArrowSchemaPriv()
+    {
+      for (ArrowSchema* child: m_children)
+      {
+        if (child->release != nullptr)
+          child->release(child);
+        delete child;
+      }
+    }
+  };
+
+  inline void ArrowSchemaRelease(ArrowSchema* a_schema)
+  {
+    assert(a_schema != nullptr && a_schema->release != nullptr);
+    delete static_cast<ArrowSchemaPriv*>(a_schema->private_data);
+    a_schema->release = nullptr;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ArrowArrayPriv", "ArrowArrayRelease":                                  //
+  //-------------------------------------------------------------------------//
+  // "private_data" of exported arrays. "m_owner" keeps the data alive if it
+  // was handed over to Arrow (it is empty for borrowed data). The children
+  // are owned as in "ArrowSchemaPriv":
+  //
+  struct ArrowArrayPriv
+  {
+    void const*               m_buffers[2] {};
+    std::vector<ArrowArray*>  m_children;
+    std::shared_ptr<void>     m_owner;
+
+    ArrowArrayPriv() = default;
+    ArrowArrayPriv(ArrowArrayPriv const&)            = delete;
+    ArrowArrayPriv& operator=(ArrowArrayPriv const&) = delete;
+
+    ~ArrowArrayPriv()
+    {
+      for (ArrowArray* child: m_children)
+      {
+        if (child->release != nullptr)
+          child->release(child);
+        delete child;
+      }
+    }
+  };
+
+  inline void ArrowArrayRelease(ArrowArray* a_array)
+  {
+    assert(a_array != nullptr && a_array->release != nullptr);
+    delete static_cast<ArrowArrayPriv*>(a_array->private_data);
+    a_array->release = nullptr;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ArrowMetadata": Encodes a single (Key, Val) pair:                      //
+  //-------------------------------------------------------------------------//
+  // The format is: Int32 NPairs, then for each pair: Int32 KeyLen, Key bytes,
+  // Int32 ValLen, Val bytes (all Int32s in the native byte order):
+  //
+  inline std::string ArrowMetadata(char const* a_key, char const* a_val)
+  {
+    auto putInt = [](std::string* a_res, int32_t a_n)
+      { a_res->append(reinterpret_cast<char const*>(&a_n), sizeof(a_n)); };
+
+    std::string res;
+    putInt(&res, 1);
+    putInt(&res, int32_t(strlen(a_key)));
+    res += a_key;
+    putInt(&res, int32_t(strlen(a_val)));
+    res += a_val;
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ArrowFindMetadata":                                                    //
+  //-------------------------------------------------------------------------//
+  // Returns "false" if the key was not found, or if the metadata are malformed
+  // (negative counts or lengths; NB: the total size of the metadata is not
+  // known, so it cannot be checked):
+  //
+  inline bool ArrowFindMetadata
+    (char const* a_metadata, char const* a_key, std::string* a_val)
+  {
+    if (a_metadata == nullptr)
+      return false;
+    auto getInt = [&a_metadata]()
+    {
+      int32_t n;
+      memcpy(&n, a_metadata, sizeof(n));
+      a_metadata += sizeof(n);
+      return n;
+    };
+    int32_t nPairs = getInt();
+    size_t  keyLen = strlen(a_key);
+    for (int32_t i = 0; i < nPairs; ++i)
+    {
+      int32_t     kLen = getInt();
+      if (UNLIKELY(kLen < 0))
+        return false;
+      char const* key  = a_metadata;
+      a_metadata      += kLen;
+      int32_t     vLen = getInt();
+      if (UNLIKELY(vLen < 0))
+        return false;
+      if (size_t(kLen) == keyLen && memcmp(key, a_key, keyLen) == 0)
+      {
+        a_val->assign(a_metadata, size_t(vLen));
+        return true;
+      }
+      a_metadata += vLen;
+    }
+    return false;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ArrowExportCol": Fills in a primitive (Schema, Array) pair:            //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  void ArrowExportCol
+  (
+    DQ const*             a_data,
+    size_t                a_n,
+    char const*           a_name,
+    std::shared_ptr<void> a_owner,
+    ArrowArray*           a_array,
+    ArrowSchema*          a_schema
+  )
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Sys::RepT;
+    static_assert(Tr::IsDimQ && std::is_same_v<typename Tr::RepT, RepT> &&
+                  Tr::MaxDims == Sys::MaxDims,
+                  "ArrowExport: Incompatible DimQ Type");
+    static_assert(ArrowFormat<RepT> != nullptr,
+                  "ArrowExport: Only float and double RepTs are supported");
+    assert(a_array != nullptr && a_schema != nullptr);
+
+    char units[256];
+    PutUnits<Sys>(Tr::E, Tr::U, units, units + sizeof(units));
+
+    // The output structs are only filled in when nothing can throw anymore:
+    auto spriv        = std::make_unique<ArrowSchemaPriv>();
+    spriv->m_format   = ArrowFormat<RepT>;
+    spriv->m_name     = (a_name != nullptr) ? a_name : "";
+    spriv->m_metadata = ArrowMetadata(ArrowUnitsKey, units);
+
+    auto apriv          = std::make_unique<ArrowArrayPriv>();
+    apriv->m_buffers[0] = nullptr;   // No validity bitmap: no nulls
+    apriv->m_buffers[1] = a_data;
+    apriv->m_owner      = std::move(a_owner);
+
+    *a_schema = ArrowSchema
+    {
+      .format       = spriv->m_format.c_str(),
+      .name         = spriv->m_name.c_str(),
+      .metadata     = spriv->m_metadata.data(),
+      .flags        = 0,
+      .n_children   = 0,
+      .children     = nullptr,
+      .dictionary   = nullptr,
+      .release      = ArrowSchemaRelease,
+      .private_data = spriv.release()
+    };
+    *a_array = ArrowArray
+    {
+      .length       = int64_t(a_n),
+      .null_count   = 0,
+      .offset       = 0,
+      .n_buffers    = 2,
+      .n_children   = 0,
+      .buffers      = apriv->m_buffers,
+      .children     = nullptr,
+      .dictionary   = nullptr,
+      .release      = ArrowArrayRelease,
+      .private_data = apriv.release()
+    };
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // Export:                                                                 //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS". The consumer becomes
+  // responsible for calling the "release" callbacks of the output structs.
+  //-------------------------------------------------------------------------//
+  // "ExportArrow": Borrowed Data:                                           //
+  //-------------------------------------------------------------------------//
+  // The data must remain alive until the consumer releases "a_array":
+  //
+  template<typename Sys, typename DQ>
+  void ExportArrow
+  (
+    DQ const*     a_data,
+    size_t        a_n,
+    char const*   a_name,
+    ArrowArray*   a_array,
+    ArrowSchema*  a_schema
+  )
+  {
+    Bits::ArrowExportCol<Sys, DQ>
+      (a_data, a_n, a_name, nullptr, a_array, a_schema);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ExportArrow": Owned Data:                                              //
+  //-------------------------------------------------------------------------//
+  // The vector is moved into the Arrow array (so still NO copying of data),
+  // and is destroyed by the "release" callback:
+  //
+  template<typename Sys, typename DQ>
+  void ExportArrow
+  (
+    std::vector<DQ>&& a_data,
+    char const*       a_name,
+    ArrowArray*       a_array,
+    ArrowSchema*      a_schema
+  )
+  {
+    auto owner = std::make_shared<std::vector<DQ>>(std::move(a_data));
+    Bits::ArrowExportCol<Sys, DQ>
+      (owner->data(), owner->size(), a_name, owner, a_array, a_schema);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ExportArrowTable": Borrowed Columns of "a_n" rows each:                //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename... DQs>
+  void ExportArrowTable
+  (
+    size_t                                          a_n,
+    std::array<char const*, sizeof...(DQs)> const&  a_names,
+    ArrowArray*                                     a_array,
+    ArrowSchema*                                    a_schema,
+    DQs const*...                                   a_cols
+  )
+  {
+    assert(a_array != nullptr && a_schema != nullptr);
+    constexpr size_t NC = sizeof...(DQs);
+
+    // The children already exported are released by the "unique_ptr"s if a
+    // subsequent one throws; "reserve" makes the "push_back"s non-throwing, so
+    // each child is owned as soon as it is allocated (and it is zeroed, so it
+    // is not released unless it has been exported):
+    auto spriv      = std::make_unique<Bits::ArrowSchemaPriv>();
+    spriv->m_format = "+s";
+    auto apriv      = std::make_unique<Bits::ArrowArrayPriv>();
+    spriv->m_children.reserve(NC);
+    apriv->m_children.reserve(NC);
+
+    size_t k = 0;
+    ((spriv->m_children.push_back(new ArrowSchema {}),
+      apriv->m_children.push_back(new ArrowArray  {}),
+      Bits::ArrowExportCol<Sys, DQs>
+        (a_cols, a_n, a_names[k], nullptr,
+         apriv->m_children.back(), spriv->m_children.back()),
+      ++k), ...);
+
+    *a_schema = ArrowSchema
+    {
+      .format       = spriv->m_format.c_str(),
+      .name         = "",
+      .metadata     = nullptr,
+      .flags        = 0,
+      .n_children   = int64_t(NC),
+      .children     = spriv->m_children.data(),
+      .dictionary   = nullptr,
+      .release      = Bits::ArrowSchemaRelease,
+      .private_data = spriv.release()
+    };
+    *a_array = ArrowArray
+    {
+      .length       = int64_t(a_n),
+      .null_count   = 0,
+      .offset       = 0,
+      .n_buffers    = 1,
+      .n_children   = int64_t(NC),
+      .buffers      = apriv->m_buffers,
+      .children     = apriv->m_children.data(),
+      .dictionary   = nullptr,
+      .release      = Bits::ArrowArrayRelease,
+      .private_data = apriv.release()
+    };
+  }
+
+  //=========================================================================//
+  // "ArrowImport":                                                          //
+  //=========================================================================//
+  // Takes over (moves) an Arrow (Array, Schema) pair from the producer, which
+  // is either a single primitive column or a struct of them, and provides ty-
+  // ped zero-copy views of the columns.  The Units in the field metadata must
+  // then have the same scales as those of the requested "DimQ" type; "Copy-
+  // Column" converts the Units if required. Releases the Arrow structs in the
+  // Dtor:
+  //
+  template<typename Sys>
+  class ArrowImport
+  {
+  private:
+    using RepT = typename Sys::RepT;
+    using En   = Bits::Encodings<RepT, Sys::MaxDims>;
+
+    ArrowArray  m_array;
+    ArrowSchema m_schema;
+    bool        m_isStruct;
+
+    [[noreturn]] static void Fail(char const* a_msg)
+      { throw std::runtime_error(std::string("ArrowImport: ") + a_msg); }
+
+    //-----------------------------------------------------------------------//
+    // "GetCol": Validates a column and returns its data and conv factor:    //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    RepT const* GetCol(unsigned a_col, double* a_factor) const
+    {
+      using Tr = DimQTraits<DQ>;
+      static_assert(Tr::IsDimQ && std::is_same_v<typename Tr::RepT, RepT> &&
+                    Tr::MaxDims == Sys::MaxDims,
+                    "ArrowImport: Incompatible DimQ Type");
+      if (UNLIKELY(a_col >= NCols()))
+        Fail("Invalid Column");
+
+      ArrowArray  const* arr =
+        m_isStruct ? m_array .children[a_col] : &m_array;
+      ArrowSchema const* sch =
+        m_isStruct ? m_schema.children[a_col] : &m_schema;
+
+      if (UNLIKELY(strcmp(sch->format, Bits::ArrowFormat<RepT>) != 0))
+        Fail("RepT MisMatch");
+      if (UNLIKELY(arr->null_count != 0 && arr->buffers[0] != nullptr))
+        Fail("Nulls are not supported");
+
+      // A sliced struct has its own "offset" (added to those of the children)
+      // and "length" (that of the slice); the children are not sliced, so
+      // they must cover the whole slice:
+      int64_t pOff = m_isStruct ? m_array.offset : 0;
+      if (UNLIKELY(arr->n_buffers != 2 || arr->offset < 0 ||
+                   arr->length    <  0 || pOff > arr->length ||
+                   m_array.length >  arr->length - pOff      ||
+                   arr->offset    >  INT64_MAX   - pOff))
+        Fail("Invalid Array");
+      int64_t off  = arr->offset + pOff;
+
+      std::string units;
+      uint64_t    E = 0;
+      uint64_t    U = 0;
+      if (UNLIKELY
+         (!Bits::ArrowFindMetadata(sch->metadata, Bits::ArrowUnitsKey, &units)
+          || !Bits::ParseUnits<Sys>
+              (units.data(), units.data() + units.size(), &E, &U)))
+        Fail("Missing or Invalid Units Metadata");
+      if (UNLIKELY(E != Tr::E))
+        Fail("Dims MisMatch");
+
+      *a_factor =
+        Bits::UnitsConvFactor<Sys>(E, U, En::CleanUpUnits(Tr::E, Tr::U));
+      return static_cast<RepT const*>(arr->buffers[1]) + off;
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    ArrowImport(ArrowArray* a_array, ArrowSchema* a_schema)
+    : m_array   (*a_array),
+      m_schema  (*a_schema),
+      m_isStruct(strcmp(a_schema->format, "+s") == 0)
+    {
+      // The structs must not have been released (moved) already:
+      assert(a_array->release != nullptr && a_schema->release != nullptr);
+      // Mark the source structs as moved:
+      a_array ->release = nullptr;
+      a_schema->release = nullptr;
+      if (UNLIKELY(m_array.offset < 0 || m_array.length < 0 ||
+                   (m_isStruct &&
+                    (m_array.n_children != m_schema.n_children ||
+                     (m_array.null_count != 0 &&
+                      m_array.buffers[0] != nullptr)))))
+      {
+        // The Dtor would not be invoked:
+        if (m_array.release  != nullptr)
+          m_array.release (&m_array);
+        if (m_schema.release != nullptr)
+          m_schema.release(&m_schema);
+        Fail("Invalid Struct, or Array and Schema MisMatch");
+      }
+    }
+
+    ~ArrowImport()
+    {
+      if (m_array.release  != nullptr)
+        m_array.release (&m_array);
+      if (m_schema.release != nullptr)
+        m_schema.release(&m_schema);
+    }
+
+    ArrowImport(ArrowImport const&)            = delete;
+    ArrowImport& operator=(ArrowImport const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t   NRows() const { return size_t(m_array.length); }
+    unsigned NCols() const
+      { return m_isStruct ? unsigned(m_schema.n_children) : 1; }
+
+    char const* ColName(unsigned a_col) const
+    {
+      assert(a_col < NCols());
+      char const* name =
+        m_isStruct ? m_schema.children[a_col]->name : m_schema.name;
+      return (name != nullptr) ? name : "";
+    }
+
+    // Returns -1 if not found:
+    int FindCol(char const* a_name) const
+    {
+      for (unsigned i = 0; i < NCols(); ++i)
+        if (strcmp(ColName(i), a_name) == 0)
+          return int(i);
+      return -1;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "GetColumn": Zero-Copy Typed View:                                    //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    std::span<DQ const> GetColumn(unsigned a_col) const
+    {
+      double      factor = 1.0;
+      RepT const* data   = GetCol<DQ>(a_col, &factor);
+      if (UNLIKELY(factor != 1.0))
+        Fail("Units MisMatch (use CopyColumn)");
+      return std::span<DQ const>
+             (reinterpret_cast<DQ const*>(data), NRows());
+    }
+
+    //-----------------------------------------------------------------------//
+    // "CopyColumn": With Units Conversion if necessary:                     //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    void CopyColumn(unsigned a_col, std::vector<DQ>* a_res) const
+    {
+      assert(a_res != nullptr);
+      double      factor = 1.0;
+      RepT const* data   = GetCol<DQ>(a_col, &factor);
+      size_t      n      = NRows();
+      a_res->resize(n);
+      RepT*       res    = reinterpret_cast<RepT*>(a_res->data());
+      for (size_t i = 0; i < n; ++i)
+        res[i] = data[i] * RepT(factor);
+    }
+  };
+}
+// End namespace DimTypes
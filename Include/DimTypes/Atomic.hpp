@@ -0,0 +1,253 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "DimTypes/Atomic.hpp":                         //
+//          Lock-Free Atomic "DimQ"s with Dims-Checked Arithmetic            //
+//===========================================================================//
+// "AtomicDimQ<DQ>" keeps the bit pattern of the "RepT" magnitude in a "std::
+// atomic" unsigned integer of the same size, so it is lock-free whenever the
+// platform supports 32- and 64-bit atomics (ie everywhere we care about). The
+// interface follows that of "std::atomic" (hence the lower-case method names)
+// so it can replace "std::atomic<DQ>", but "fetch_add" and "fetch_sub" (which
+// "std::atomic" does not provide for class types) accept any "DimQ" which is
+// accepted by "DQ::operator+=",  with the same static checks of the Dims and
+// Units. They are implemented as CAS loops.
+// NB: As for "std::atomic<double>", "compare_exchange_*" compare the bit pat-
+// terns, so eg +0.0 and -0.0 are different, and a NaN is equal to itself. Only
+// real "float" and "double" RepTs are supported:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <atomic>
+#include <bit>
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "AtomicDimQ":                                                           //
+  //=========================================================================//
+  template<typename DQ>
+  class AtomicDimQ
+  {
+  private:
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    using En   = Bits::Encodings<RepT, Tr::MaxDims>;
+    static_assert(Tr::IsDimQ &&
+                  (std::is_same_v<RepT, float> || std::is_same_v<RepT, double>),
+                  "AtomicDimQ: UnSupported DimQ Type");
+
+    using UInt = std::conditional_t<sizeof(RepT) == 4, uint32_t, uint64_t>;
+    static_assert(std::atomic<UInt>::is_always_lock_free,
+                  "AtomicDimQ: Not Lock-Free on this Platform");
+
+    std::atomic<UInt> m_bits;
+
+    constexpr static UInt ToBits(DQ a_val)
+      { return std::bit_cast<UInt>(a_val.Magnitude()); }
+
+    constexpr static DQ   FromBits(UInt a_bits)
+      { return DQ(std::bit_cast<RepT>(a_bits)); }
+
+    //-----------------------------------------------------------------------//
+    // "Update": The CAS Loop applying "a_f" to the curr val:                //
+    //-----------------------------------------------------------------------//
+    // Returns the previous val:
+    //
+    template<typename Func>
+    DQ Update(Func const& a_f, std::memory_order a_order) noexcept
+    {
+      UInt old = m_bits.load(std::memory_order_relaxed);
+      while (!m_bits.compare_exchange_weak
+             (old, ToBits(a_f(FromBits(old))), a_order,
+              std::memory_order_relaxed))
+        ;
+      return FromBits(old);
+    }
+
+  public:
+    static constexpr bool is_always_lock_free = true;
+
+    //-----------------------------------------------------------------------//
+    // Ctors, Assignment:                                                    //
+    //-----------------------------------------------------------------------//
+    constexpr AtomicDimQ() noexcept
+    : m_bits(ToBits(DQ()))
+    {}
+
+    constexpr explicit AtomicDimQ(DQ a_val) noexcept
+    : m_bits(ToBits(a_val))
+    {}
+
+    AtomicDimQ(AtomicDimQ const&)            = delete;
+    AtomicDimQ& operator=(AtomicDimQ const&) = delete;
+
+    DQ operator=(DQ a_val) noexcept
+    {
+      store(a_val);
+      return a_val;
+    }
+
+    bool is_lock_free() const noexcept { return true; }
+
+    //-----------------------------------------------------------------------//
+    // "load", "store", "exchange":                                          //
+    //-----------------------------------------------------------------------//
+    DQ load(std::memory_order a_order = std::memory_order_seq_cst)
+    const noexcept
+      { return FromBits(m_bits.load(a_order)); }
+
+    operator DQ() const noexcept { return load(); }
+
+    void store
+      (DQ a_val, std::memory_order a_order = std::memory_order_seq_cst)
+    noexcept
+      { m_bits.store(ToBits(a_val), a_order); }
+
+    DQ exchange
+      (DQ a_val, std::memory_order a_order = std::memory_order_seq_cst)
+    noexcept
+      { return FromBits(m_bits.exchange(ToBits(a_val), a_order)); }
+
+    //-----------------------------------------------------------------------//
+    // "compare_exchange_{weak,strong}":                                     //
+    //-----------------------------------------------------------------------//
+    // On failure, "a_expected" is updated with the curr val:
+    //
+    bool compare_exchange_weak
+    (
+      DQ&               a_expected,
+      DQ                a_desired,
+      std::memory_order a_success,
+      std::memory_order a_failure
+    )
+    noexcept
+    {
+      UInt exp = ToBits(a_expected);
+      bool res = m_bits.compare_exchange_weak
+                 (exp, ToBits(a_desired), a_success, a_failure);
+      a_expected = FromBits(exp);
+      return res;
+    }
+
+    bool compare_exchange_strong
+    (
+      DQ&               a_expected,
+      DQ                a_desired,
+      std::memory_order a_success,
+      std::memory_order a_failure
+    )
+    noexcept
+    {
+      UInt exp = ToBits(a_expected);
+      bool res = m_bits.compare_exchange_strong
+                 (exp, ToBits(a_desired), a_success, a_failure);
+      a_expected = FromBits(exp);
+      return res;
+    }
+
+    bool compare_exchange_weak
+    (
+      DQ&               a_expected,
+      DQ                a_desired,
+      std::memory_order a_order = std::memory_order_seq_cst
+    )
+    noexcept
+    {
+      UInt exp = ToBits(a_expected);
+      bool res = m_bits.compare_exchange_weak(exp, ToBits(a_desired), a_order);
+      a_expected = FromBits(exp);
+      return res;
+    }
+
+    bool compare_exchange_strong
+    (
+      DQ&               a_expected,
+      DQ                a_desired,
+      std::memory_order a_order = std::memory_order_seq_cst
+    )
+    noexcept
+    {
+      UInt exp = ToBits(a_expected);
+      bool res =
+        m_bits.compare_exchange_strong(exp, ToBits(a_desired), a_order);
+      a_expected = FromBits(exp);
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "fetch_add", "fetch_sub": Return the previous val:                    //
+    //-----------------------------------------------------------------------//
+    // Same constraints as for "DimQ::operator+=" and "operator-=":
+    //
+    template<uint64_t F, uint64_t V>
+    DQ fetch_add
+    (
+      DimQ<F, V, RepT, Tr::MaxDims> a_right,
+      std::memory_order             a_order = std::memory_order_seq_cst
+    )
+    noexcept
+    {
+      static_assert(Tr::E == F,             "ERROR: fetch_add: Different Dims");
+      static_assert(En::UnitsOK(Tr::E, Tr::U, V),
+                    "ERROR: fetch_add: Units do not unify");
+      RepT right = a_right.Magnitude();
+      return Update([right](DQ a_x) { return DQ(a_x.Magnitude() + right); },
+                    a_order);
+    }
+
+    template<uint64_t F, uint64_t V>
+    DQ fetch_sub
+    (
+      DimQ<F, V, RepT, Tr::MaxDims> a_right,
+      std::memory_order             a_order = std::memory_order_seq_cst
+    )
+    noexcept
+    {
+      static_assert(Tr::E == F,             "ERROR: fetch_sub: Different Dims");
+      static_assert(En::UnitsOK(Tr::E, Tr::U, V),
+                    "ERROR: fetch_sub: Units do not unify");
+      RepT right = a_right.Magnitude();
+      return Update([right](DQ a_x) { return DQ(a_x.Magnitude() - right); },
+                    a_order);
+    }
+
+    // "+=" and "-=" return the NEW val, as for "std::atomic":
+    template<uint64_t F, uint64_t V>
+    DQ operator+=(DimQ<F, V, RepT, Tr::MaxDims> a_right) noexcept
+      { return DQ(fetch_add(a_right).Magnitude() + a_right.Magnitude()); }
+
+    template<uint64_t F, uint64_t V>
+    DQ operator-=(DimQ<F, V, RepT, Tr::MaxDims> a_right) noexcept
+      { return DQ(fetch_sub(a_right).Magnitude() - a_right.Magnitude()); }
+
+    //-----------------------------------------------------------------------//
+    // "fetch_max", "fetch_min": Return the previous val:                    //
+    //-----------------------------------------------------------------------//
+    // Do not write anything if the curr val is already the max (min):
+    //
+    DQ fetch_max
+      (DQ a_val, std::memory_order a_order = std::memory_order_seq_cst)
+    noexcept
+    {
+      UInt old = m_bits.load(std::memory_order_relaxed);
+      while (FromBits(old) < a_val &&
+             !m_bits.compare_exchange_weak
+             (old, ToBits(a_val), a_order, std::memory_order_relaxed))
+        ;
+      return FromBits(old);
+    }
+
+    DQ fetch_min
+      (DQ a_val, std::memory_order a_order = std::memory_order_seq_cst)
+    noexcept
+    {
+      UInt old = m_bits.load(std::memory_order_relaxed);
+      while (a_val < FromBits(old) &&
+             !m_bits.compare_exchange_weak
+             (old, ToBits(a_val), a_order, std::memory_order_relaxed))
+        ;
+      return FromBits(old);
+    }
+  };
+}
+// End namespace DimTypes
@@ -0,0 +1,97 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/AutoDiff.hpp":                         //
+//       Forward-Mode Automatic Differentiation of "DimQ" Computations       //
+//===========================================================================//
+// A computation written over "DimQ"s is differentiated by running it on the
+// "DimQ"s which have "Dual<RepT, N>" (see "Bits/Dual.hpp") as their "RepT":
+// (*) "ADQ<DQ, N>" is the type "DQ" re-based onto "Dual<RepT, N>";
+// (*) "MkVar<N>(x, i)" makes the independent variable "i" (out of N) with the
+//     value "x"; "MkConst<N>(x)" lifts a constant (with zero derivatives);
+// (*) "ValueOf(f)" drops the derivatives;
+// (*) "Deriv(f, x, i)" is the partial derivative of "f" w.r.t. the variable
+//     "x" seeded as "i". It has the type of f/x, ie the Dims Exponent
+//     SubExp(E_f, E_x), so eg the derivative of a period w.r.t. a length is
+//     typed as Time/Len, and its use in a dimensionally-wrong formula is a
+//     compile-time error.
+// With N seeds, a single evaluation gives the derivatives of all outputs w.r.t.
+// all N variables, eg
+//
+//   auto L = MkVar<2>(1.0_m,  0);
+//   auto g = MkVar<2>(9.81_m / (1.0_sec * 1.0_sec), 1);
+//   auto T = TwoPi<double> * SqRt(L / g);
+//   auto dTdL = Deriv(T, L, 0);    // Time / Len
+//   auto dTdg = Deriv(T, g, 1);    // Time / (Len Time^-2)
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <type_traits>
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "ADQ":                                                                  //
+  //=========================================================================//
+  template<typename DQ, unsigned N = 1>
+  using ADQ = DimQ<DimQTraits<DQ>::E,
+                   DimQTraits<DQ>::U,
+                   Dual<typename DimQTraits<DQ>::RepT, N>,
+                   DimQTraits<DQ>::MaxDims>;
+
+  //=========================================================================//
+  // "MkVar", "MkConst", "ValueOf":                                          //
+  //=========================================================================//
+  template<unsigned N = 1,
+           uint64_t E, uint64_t U, typename T, unsigned MaxDims>
+  constexpr DimQ<E, U, Dual<T, N>, MaxDims>
+  MkVar(DimQ<E, U, T, MaxDims> a_x, unsigned a_i = 0)
+  {
+    return DimQ<E, U, Dual<T, N>, MaxDims>
+           (Dual<T, N>::Var(a_x.Magnitude(), a_i));
+  }
+
+  template<unsigned N = 1,
+           uint64_t E, uint64_t U, typename T, unsigned MaxDims>
+  constexpr DimQ<E, U, Dual<T, N>, MaxDims>
+  MkConst(DimQ<E, U, T, MaxDims> a_x)
+    { return DimQ<E, U, Dual<T, N>, MaxDims>(Dual<T, N>(a_x.Magnitude())); }
+
+  template<uint64_t E, uint64_t U, typename T, unsigned N, unsigned MaxDims>
+  constexpr DimQ<E, U, T, MaxDims>
+  ValueOf(DimQ<E, U, Dual<T, N>, MaxDims> a_f)
+    { return DimQ<E, U, T, MaxDims>(a_f.Magnitude().Value()); }
+
+  //=========================================================================//
+  // "Deriv":                                                                //
+  //=========================================================================//
+  // "a_x" is only used for its type, so it may be either the "Dual"-based
+  // variable itself, or a plain "DimQ" of the same Dims and Units:
+  //
+  template<uint64_t EF, uint64_t UF, typename T, unsigned N, unsigned MaxDims,
+           uint64_t EX, uint64_t UX, typename RX>
+  constexpr auto Deriv
+  (
+    DimQ<EF, UF, Dual<T, N>, MaxDims> a_f,
+    DimQ<EX, UX, RX,         MaxDims>,      // a_x
+    unsigned                          a_i = 0
+  )
+  {
+    static_assert(std::is_same_v<RX, T> || std::is_same_v<RX, Dual<T, N>>,
+                  "ERROR: Deriv: Incompatible RepT");
+    using Res = decltype(DimQ<EF, UF, T, MaxDims>() /
+                         DimQ<EX, UX, T, MaxDims>());
+    return Res(a_f.Magnitude().Deriv(a_i));
+  }
+
+  // A DimLess "Dual" result (eg of "ATan2"):
+  template<typename T, unsigned N,
+           uint64_t EX, uint64_t UX, typename RX, unsigned MaxDims>
+  constexpr auto Deriv
+  (
+    Dual<T, N>                        a_f,
+    DimQ<EX, UX, RX, MaxDims>         a_x,
+    unsigned                          a_i = 0
+  )
+    { return Deriv(DimQ<0, 0, Dual<T, N>, MaxDims>(a_f), a_x, a_i); }
+}
+// End namespace DimTypes
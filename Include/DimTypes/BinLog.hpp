@@ -0,0 +1,657 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "DimTypes/BinLog.hpp":                         //
+//             Deferred-Formatting Binary Logger for "DimQ" Values           //
+//===========================================================================//
+// "BinLogger::Log" does NOT format anything: it stores the label ptr, an opt-
+// ional time stamp, a compact type id (registered once per "DimQ" type, with
+// its E, U, RepT and MaxDims) and the raw magnitude bytes into a lock-free
+// per-thread SPSC ring buffer, ie a handful of stores on the hot path.  A
+// background thread drains the rings and either formats the records as text
+// (using the same rules as "Put"), or writes them to a compact binary file
+// which can be converted into text later by "DecodeBinLog":
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include "Bits/FileIO.hpp"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Log Records and Types:                                                  //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "LogRec": A ring buffer slot, exactly 1 cache line:                     //
+  //-------------------------------------------------------------------------//
+  struct alignas(64) LogRec
+  {
+    char const*                 m_label;   // Must be a static string
+    int64_t                     m_ts;      // 0 if not provided
+    uint32_t                    m_typeId;
+    uint32_t                    m_pad;
+    alignas(16) unsigned char   m_mag[32]; // Enough for complex<long double>
+  };
+  static_assert(sizeof(LogRec) == 64);
+
+  //-------------------------------------------------------------------------//
+  // "LogTypeInfo":                                                          //
+  //-------------------------------------------------------------------------//
+  struct LogTypeInfo
+  {
+    uint64_t m_E;
+    uint64_t m_U;
+    uint8_t  m_repCode;   // See "RepCode"
+    uint8_t  m_maxDims;
+  };
+
+  // Sizes of magnitudes by "RepCode":
+  constexpr inline unsigned LogRepSizes[7] =
+  {
+    0, sizeof(float),               sizeof(double),
+       sizeof(long double),         sizeof(std::complex<float>),
+       sizeof(std::complex<double>), sizeof(std::complex<long double>)
+  };
+
+  //-------------------------------------------------------------------------//
+  // "PutLogMagnitude":                                                      //
+  //-------------------------------------------------------------------------//
+  // Formats raw magnitude bytes of the given "RepCode" as "Put" would do; the
+  // buffer must have room for "MaxMagnitudeLen" of the corresp "RepT":
+  //
+  template<typename RepT>
+  char* PutLogMagnitude1(void const* a_mag, char* a_buff)
+  {
+    RepT val;
+    memcpy(&val, a_mag, sizeof(RepT));
+    return PutMagnitudeNX(a_buff, val);
+  }
+
+  inline char* PutLogMagnitude
+    (uint8_t a_repCode, void const* a_mag, char* a_buff)
+  {
+    using CF  = std::complex<float>;
+    using CD  = std::complex<double>;
+    using CLD = std::complex<long double>;
+    switch (a_repCode)
+    {
+      case 1:  return PutLogMagnitude1<float>      (a_mag, a_buff);
+      case 2:  return PutLogMagnitude1<double>     (a_mag, a_buff);
+      case 3:  return PutLogMagnitude1<long double>(a_mag, a_buff);
+      case 4:  return PutLogMagnitude1<CF>         (a_mag, a_buff);
+      case 5:  return PutLogMagnitude1<CD>         (a_mag, a_buff);
+      case 6:  return PutLogMagnitude1<CLD>        (a_mag, a_buff);
+      default: throw std::runtime_error("PutLogMagnitude: Invalid RepCode");
+    }
+  }
+
+  //=========================================================================//
+  // "LogRing": Lock-Free SPSC Ring Buffer of "LogRec"s:                     //
+  //=========================================================================//
+  struct LogRing
+  {
+    // Producer side:
+    alignas(64) std::atomic<uint64_t> m_head;
+    uint64_t                          m_tailCache;
+    std::atomic<uint64_t>             m_dropped;
+    // Consumer side:
+    alignas(64) std::atomic<uint64_t> m_tail;
+    // Immutable:
+    alignas(64) std::thread::id       m_owner;
+    uint64_t                          m_mask;
+    std::unique_ptr<LogRec[]>         m_recs;
+
+    LogRing(unsigned a_capacity)
+    : m_head     (0),
+      m_tailCache(0),
+      m_dropped  (0),
+      m_tail     (0),
+      m_owner    (std::this_thread::get_id()),
+      m_mask     (a_capacity - 1),
+      m_recs     (new LogRec[a_capacity])
+    {
+      if (UNLIKELY(a_capacity == 0 || (a_capacity & (a_capacity - 1)) != 0))
+        throw std::invalid_argument
+              ("LogRing: Capacity must be a power of 2");
+    }
+  };
+
+  //=========================================================================//
+  // "LogSink": Text or Binary Output of Records (on the consumer side):     //
+  //=========================================================================//
+  // Binary file format (native byte order): the "BinLogMagic", followed by a
+  // stream of entries, each starting with a 1-byte tag:
+  // 'T': UInt32 TypeId,  UInt64 E, UInt64 U, UInt8 RepCode, UInt8 MaxDims;
+  // 'L': UInt32 LabelId, UInt32 Len, Len bytes;
+  // 'R': Int64  TS,      UInt32 LabelId, UInt32 TypeId, magnitude bytes.
+  // Type and Label entries precede the first Record which refers to them:
+  //
+  constexpr inline char BinLogMagic[8] = "DimQLog";
+
+  template<typename Sys>
+  class LogSink
+  {
+  private:
+    constexpr static size_t BuffSize = 1 << 16;
+
+    int                                     m_fd;
+    bool                                    m_binary;
+    std::vector<char>                       m_buff;
+    size_t                                  m_len;
+    // Text mode: Units strings by TypeId (in the "Put" format):
+    std::vector<std::string>                m_units;
+    // Binary mode: TypeIds and LabelIds already written:
+    std::vector<bool>                       m_typesOut;
+    std::unordered_map<char const*, uint32_t> m_labelIds;
+
+    void Reserve(size_t a_n)
+    {
+      if (m_len + a_n > m_buff.size())
+      {
+        Flush();
+        if (a_n > m_buff.size())
+          m_buff.resize(a_n);
+      }
+    }
+
+    void Append(void const* a_data, size_t a_n)
+    {
+      memcpy(m_buff.data() + m_len, a_data, a_n);
+      m_len += a_n;
+    }
+
+    template<typename T>
+    void Append(T a_val) { Append(&a_val, sizeof(T)); }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    LogSink(char const* a_path, bool a_binary)
+    : m_fd    (open(a_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+      m_binary(a_binary),
+      m_buff  (BuffSize),
+      m_len   (0)
+    {
+      if (UNLIKELY(m_fd < 0))
+        ThrowSysErr("LogSink::Ctor");
+      if (m_binary)
+        Append(BinLogMagic, sizeof(BinLogMagic));
+    }
+
+    ~LogSink()
+    {
+      try { Flush(); } catch (...) {}
+      close(m_fd);
+    }
+
+    LogSink(LogSink const&)            = delete;
+    LogSink& operator=(LogSink const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "Put": Outputs a single Record:                                       //
+    //-----------------------------------------------------------------------//
+    void Put
+    (
+      int64_t             a_ts,
+      char const*         a_label,
+      size_t              a_labelLen,
+      uint32_t            a_typeId,
+      LogTypeInfo const&  a_type,
+      void const*         a_mag
+    )
+    {
+      if (m_binary)
+      {
+        if (a_typeId >= m_typesOut.size())
+          m_typesOut.resize(a_typeId + 1, false);
+        if (!m_typesOut[a_typeId])
+        {
+          Reserve(1 + 4 + 8 + 8 + 1 + 1);
+          Append('T');
+          Append(a_typeId);
+          Append(a_type.m_E);
+          Append(a_type.m_U);
+          Append(a_type.m_repCode);
+          Append(a_type.m_maxDims);
+          m_typesOut[a_typeId] = true;
+        }
+        auto [it, isNew] =
+          m_labelIds.try_emplace(a_label, uint32_t(m_labelIds.size()));
+        if (isNew)
+        {
+          Reserve(1 + 4 + 4 + a_labelLen);
+          Append('L');
+          Append(it->second);
+          Append(uint32_t(a_labelLen));
+          Append(a_label, a_labelLen);
+        }
+        unsigned repSize = LogRepSizes[a_type.m_repCode];
+        Reserve(1 + 8 + 4 + 4 + repSize);
+        Append('R');
+        Append(a_ts);
+        Append(it->second);
+        Append(a_typeId);
+        Append(a_mag, repSize);
+        return;
+      }
+      // Text Mode: "[TS ]Label = Magnitude Units\n":
+      if (a_typeId >= m_units.size())
+        m_units.resize(a_typeId + 1);
+      std::string& units = m_units[a_typeId];
+      if (units.empty())
+      {
+        // Construct and memoise it (with a leading space); for DimLess vals,
+        // it is a single space which is not output:
+        char buff[256];
+        buff[0] = ' ';
+        PutUnits<Sys>
+          (a_type.m_E, a_type.m_U, buff + 1, buff + sizeof(buff));
+        units = buff;
+      }
+      Reserve(24 + a_labelLen + 3 + 2 * MaxRealLen + 9 + units.size() + 1);
+      if (a_ts != 0)
+      {
+        char* curr = m_buff.data() + m_len;
+        curr       = std::to_chars(curr, curr + 24, a_ts).ptr;
+        *curr++    = ' ';
+        m_len      = size_t(curr - m_buff.data());
+      }
+      Append(a_label, a_labelLen);
+      Append(" = ", 3);
+      m_len = size_t(PutLogMagnitude(a_type.m_repCode, a_mag,
+                     m_buff.data() + m_len) - m_buff.data());
+      if (units.size() > 1)
+        Append(units.data(), units.size());
+      Append('\n');
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Flush":                                                              //
+    //-----------------------------------------------------------------------//
+    void Flush()
+    {
+      WriteAll(m_fd, m_buff.data(), m_len, "LogSink::Flush");
+      m_len = 0;
+    }
+  };
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "BinLogger":                                                            //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS". Each thread calling
+  // "Log" gets its own ring of "a_ringCap" records; if it is full, the record
+  // is dropped (and counted), so the producers never block:
+  //
+  template<typename Sys>
+  class BinLogger
+  {
+  private:
+    constexpr static unsigned MaxTypes = 4096;
+
+    // Registry of all "DimQ" types logged (common for all "BinLogger"s with
+    // the same "Sys"). Entries are immutable once published via "s_nTypes":
+    inline static Bits::LogTypeInfo     s_types[MaxTypes];
+    inline static std::atomic<uint32_t> s_nTypes   = 0;
+    inline static std::mutex            s_typesMtx;
+    inline static std::atomic<uint64_t> s_nextId   = 1;
+
+    uint64_t const                          m_id;  // Unique across instances
+    unsigned const                          m_ringCap;
+    int      const                          m_pollUS;
+    std::mutex                              m_ringsMtx;
+    std::vector<std::unique_ptr<Bits::LogRing>> m_rings;
+    std::vector<Bits::LogRing*>             m_drainRings;  // Drain-side copy
+    Bits::LogSink<Sys>                      m_sink;
+    std::atomic<bool>                       m_stop;
+    std::atomic<bool>                       m_failed;  // Output error?
+    std::exception_ptr                      m_error;   // Set before "m_failed"
+    std::thread                             m_thread;
+
+    //-----------------------------------------------------------------------//
+    // "TypeId": Registers the type on first use:                            //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    static uint32_t TypeId() noexcept
+    {
+      static uint32_t const id = []() noexcept
+      {
+        using Tr = DimQTraits<DQ>;
+        std::lock_guard<std::mutex> lock(s_typesMtx);
+        uint32_t n = s_nTypes.load(std::memory_order_relaxed);
+        if (UNLIKELY(n >= MaxTypes))
+          return UINT32_MAX;
+        s_types[n] = Bits::LogTypeInfo
+          { Tr::E, Tr::U, Bits::RepCode<typename Tr::RepT>, Tr::MaxDims };
+        s_nTypes.store(n + 1, std::memory_order_release);
+        return n;
+      }();
+      return id;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "GetRing": The ring of the calling thread:                            //
+    //-----------------------------------------------------------------------//
+    Bits::LogRing* GetRing() noexcept
+    {
+      struct Cache { uint64_t m_loggerId; Bits::LogRing* m_ring; };
+      thread_local Cache cache { 0, nullptr };
+
+      if (LIKELY(cache.m_loggerId == m_id))
+        return cache.m_ring;
+      // Slow Path: Find or create the ring:
+      try
+      {
+        std::lock_guard<std::mutex> lock(m_ringsMtx);
+        std::thread::id tid = std::this_thread::get_id();
+        Bits::LogRing*  ring = nullptr;
+        for (auto const& r: m_rings)
+          if (r->m_owner == tid)
+          {
+            ring = r.get();
+            break;
+          }
+        if (ring == nullptr)
+        {
+          m_rings.push_back(std::make_unique<Bits::LogRing>(m_ringCap));
+          ring = m_rings.back().get();
+        }
+        cache = Cache{ m_id, ring };
+        return ring;
+      }
+      catch (...)
+        { return nullptr; }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Drain": Consumes all available records; returns their number:        //
+    //-----------------------------------------------------------------------//
+    // Rings are never removed (and are heap-allocated), so only the ptrs to
+    // the new ones are copied under the lock; the output itself is done w/o
+    // holding it, so that threads creating their rings are not blocked by the
+    // file I/O:
+    //
+    size_t Drain()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_ringsMtx);
+        for (size_t i = m_drainRings.size(); i < m_rings.size(); ++i)
+          m_drainRings.push_back(m_rings[i].get());
+      }
+      size_t total = 0;
+      for (Bits::LogRing* ring: m_drainRings)
+      {
+        uint64_t tail = ring->m_tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->m_head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+          Bits::LogRec const& rec = ring->m_recs[tail & ring->m_mask];
+          m_sink.Put(rec.m_ts, rec.m_label, strlen(rec.m_label),
+                     rec.m_typeId, s_types[rec.m_typeId], rec.m_mag);
+          ++total;
+        }
+        ring->m_tail.store(tail, std::memory_order_release);
+      }
+      return total;
+    }
+
+    // An exception from the sink (eg an I/O error) stops the background thread;
+    // it is saved to be re-thrown by "Stop" on the caller's thread (the subse-
+    // quent records are then dropped once the rings are full):
+    //
+    void Run()
+    {
+      try
+      {
+        while (true)
+        {
+          bool stopping = m_stop.load(std::memory_order_acquire);
+          if (Drain() == 0)
+          {
+            if (stopping)
+              break;
+            m_sink.Flush();
+            std::this_thread::sleep_for(std::chrono::microseconds(m_pollUS));
+          }
+        }
+        m_sink.Flush();
+      }
+      catch (...)
+      {
+        m_error = std::current_exception();
+        m_failed.store(true, std::memory_order_release);
+      }
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    // If "a_binary" is set, the output is in the binary format to be decoded
+    // by "DecodeBinLog"; "a_pollUS" is the sleep time of the background thread
+    // when all rings are empty:
+    //
+    BinLogger
+    (
+      char const* a_path,
+      bool        a_binary  = false,
+      unsigned    a_ringCap = 4096,
+      int         a_pollUS  = 1000
+    )
+    : m_id     (s_nextId.fetch_add(1)),
+      m_ringCap(a_ringCap),
+      m_pollUS (a_pollUS),
+      m_sink   (a_path, a_binary),
+      m_stop   (false),
+      m_failed (false),
+      m_error  (),
+      m_thread ([this]() { Run(); })
+    {}
+
+    // NB: Output errors are not reported by the Dtor; call "Stop" for that:
+    ~BinLogger()
+      { try { Stop(); } catch (...) {} }
+
+    BinLogger(BinLogger const&)            = delete;
+    BinLogger& operator=(BinLogger const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "Log": The Hot Path:                                                  //
+    //-----------------------------------------------------------------------//
+    // "a_label" must be a static string (eg a literal), as only its ptr is
+    // stored. "a_ts" is an optional time stamp (output as is unless 0).
+    // Returns "false" if the record was dropped:
+    //
+    template<typename DQ>
+    bool Log(char const* a_label, DQ a_val, int64_t a_ts = 0) noexcept
+    {
+      using Tr = DimQTraits<DQ>;
+      static_assert(Tr::IsDimQ && Tr::MaxDims == Sys::MaxDims &&
+                    std::is_same_v<typename Tr::RepT, typename Sys::RepT>,
+                    "BinLogger::Log: Incompatible DimQ Type");
+      uint32_t       typeId = TypeId<DQ>();
+      Bits::LogRing* ring   = GetRing();
+      if (UNLIKELY(typeId == UINT32_MAX || ring == nullptr))
+        return false;
+
+      uint64_t head = ring->m_head.load(std::memory_order_relaxed);
+      if (UNLIKELY(head - ring->m_tailCache > ring->m_mask))
+      {
+        ring->m_tailCache = ring->m_tail.load(std::memory_order_acquire);
+        if (head - ring->m_tailCache > ring->m_mask)
+        {
+          ring->m_dropped.store
+            (ring->m_dropped.load(std::memory_order_relaxed) + 1,
+             std::memory_order_relaxed);
+          return false;
+        }
+      }
+      Bits::LogRec& rec = ring->m_recs[head & ring->m_mask];
+      rec.m_label       = a_label;
+      rec.m_ts          = a_ts;
+      rec.m_typeId      = typeId;
+      auto mag          = a_val.Magnitude();
+      memcpy(rec.m_mag, &mag, sizeof(mag));
+      ring->m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Stop": Drains all rings and stops the background thread:             //
+    //-----------------------------------------------------------------------//
+    // NB: Records logged after "Stop" remain in the rings and are not output.
+    // Re-throws the exception (if any) which has stopped the background thread
+    // (only once):
+    //
+    void Stop()
+    {
+      if (!m_thread.joinable())
+        return;
+      m_stop.store(true, std::memory_order_release);
+      m_thread.join();
+      if (UNLIKELY(m_error != nullptr))
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Failed": Has the background thread been stopped by an output error?  //
+    //-----------------------------------------------------------------------//
+    bool Failed() const noexcept
+      { return m_failed.load(std::memory_order_acquire); }
+
+    //-----------------------------------------------------------------------//
+    // "NDropped": Total number of records dropped due to full rings:        //
+    //-----------------------------------------------------------------------//
+    uint64_t NDropped()
+    {
+      std::lock_guard<std::mutex> lock(m_ringsMtx);
+      uint64_t res = 0;
+      for (auto const& ring: m_rings)
+        res += ring->m_dropped.load(std::memory_order_relaxed);
+      return res;
+    }
+  };
+
+  //=========================================================================//
+  // "DecodeBinLog":                                                         //
+  //=========================================================================//
+  // Converts a binary log file produced by "BinLogger" into the same text as
+  // it would produce in the text mode. "Sys" must be same as in the logger:
+  //
+  template<typename Sys>
+  void DecodeBinLog(char const* a_inPath, char const* a_outPath)
+  {
+    int fd = open(a_inPath, O_RDONLY | O_CLOEXEC);
+    if (UNLIKELY(fd < 0))
+      Bits::ThrowSysErr("DecodeBinLog: open");
+    struct stat st;
+    if (UNLIKELY(fstat(fd, &st) < 0))
+    {
+      close(fd);
+      Bits::ThrowSysErr("DecodeBinLog: fstat");
+    }
+    size_t len = size_t(st.st_size);
+    void*  map =
+      (len != 0) ? mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    close(fd);
+    if (UNLIKELY(map == MAP_FAILED))
+      Bits::ThrowSysErr("DecodeBinLog: mmap");
+
+    char const* curr = static_cast<char const*>(map);
+    char const* end  = curr + len;
+    auto fail = [map, len](char const* a_msg)
+    {
+      if (map != nullptr)
+        munmap(map, len);
+      throw std::runtime_error(std::string("DecodeBinLog: ") + a_msg);
+    };
+    auto get  = [&curr, end, &fail](void* a_res, size_t a_n)
+    {
+      if (UNLIKELY(size_t(end - curr) < a_n))
+        fail("Truncated File");
+      memcpy(a_res, curr, a_n);
+      curr += a_n;
+    };
+    char magic[sizeof(Bits::BinLogMagic)];
+    get(magic, sizeof(magic));
+    if (UNLIKELY(memcmp(magic, Bits::BinLogMagic, sizeof(magic)) != 0))
+      fail("Not a DimQ Log");
+
+    std::vector<Bits::LogTypeInfo> types;
+    std::vector<bool>              typesOK;
+    std::vector<std::string>       labels;
+    Bits::LogSink<Sys>             sink(a_outPath, false);
+    while (curr < end)
+    {
+      char     tag = *curr++;
+      uint32_t id  = 0;
+      if (tag == 'T')
+      {
+        get(&id, 4);
+        if (id >= types.size())
+        {
+          types  .resize(id + 1);
+          typesOK.resize(id + 1, false);
+        }
+        Bits::LogTypeInfo& ti = types[id];
+        get(&ti.m_E, 8);
+        get(&ti.m_U, 8);
+        get(&ti.m_repCode, 1);
+        get(&ti.m_maxDims, 1);
+        if (UNLIKELY(ti.m_maxDims != Sys::MaxDims || ti.m_repCode == 0 ||
+                     ti.m_repCode >= std::size(Bits::LogRepSizes)))
+          fail("Incompatible Type");
+        typesOK[id] = true;
+      }
+      else
+      if (tag == 'L')
+      {
+        uint32_t n = 0;
+        get(&id, 4);
+        get(&n,  4);
+        if (UNLIKELY(size_t(end - curr) < n))
+          fail("Truncated File");
+        if (id >= labels.size())
+          labels.resize(id + 1);
+        labels[id].assign(curr, n);
+        curr += n;
+      }
+      else
+      if (tag == 'R')
+      {
+        int64_t  ts      = 0;
+        uint32_t labelId = 0;
+        uint32_t typeId  = 0;
+        get(&ts,      8);
+        get(&labelId, 4);
+        get(&typeId,  4);
+        if (UNLIKELY(typeId  >= types.size() || !typesOK[typeId] ||
+                     labelId >= labels.size()))
+          fail("Undefined Type or Label");
+        alignas(16) unsigned char mag[32];
+        get(mag, Bits::LogRepSizes[types[typeId].m_repCode]);
+        sink.Put(ts, labels[labelId].data(), labels[labelId].size(),
+                 typeId, types[typeId], mag);
+      }
+      else
+        fail("Invalid Tag");
+    }
+    if (map != nullptr)
+      munmap(map, len);
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,237 @@
+// vim:ts=2:et
+//===========================================================================//
+//                       "DimTypes/Bits/BoundedPut.hpp":                     //
+//         Non-Throwing "DimQ" Output with a Compile-Time Size Bound         //
+//===========================================================================//
+// Unlike "Put" generated by "DECLARE_DIMS", which uses "snprintf" and throws
+// on buffer overflow, "PutBounded" never throws and never allocates: the Units
+// part of the output is fully determined by (E,U), so it is built at compile
+// time and just copied, and the magnitude is formatted by "std::to_chars" in-
+// to a known maximum length. Thus, the exact max output size "MaxPutSize" is
+// a compile-time const, and the output is identical to that of "Put":
+//
+#pragma  once
+#include "Encodings.hpp"
+#include "UnitsInfo.hpp"
+#include "Macros.h"
+#include <array>
+#include <charconv>
+#include <cstring>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Magnitude:                                                              //
+  //=========================================================================//
+  // Max length of a real magnitude in the "%.16e" format:
+  // "-d.dddddddddddddddde-ddd" = 24 chars; a complex one is formatted as
+  // "(Re +|- |Im| * I)":
+  //
+  constexpr inline size_t MaxRealLen = 24;
+
+  template<typename RepT>
+  constexpr inline size_t MaxMagnitudeLen =
+    CEMaths::IsComplex<RepT> ? (2 * MaxRealLen + 9) : MaxRealLen;
+
+  //-------------------------------------------------------------------------//
+  // "PutReal":                                                              //
+  //-------------------------------------------------------------------------//
+  // "a_buff" must have room for at least "MaxRealLen" chars; NOT 0-terminated:
+  //
+  inline char* PutReal(char* a_buff, double a_val) noexcept
+  {
+    auto res = std::to_chars
+      (a_buff, a_buff + MaxRealLen, a_val, std::chars_format::scientific, 16);
+    assert(res.ec == std::errc());
+    return res.ptr;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "PutMagnitudeNX":                                                       //
+  //-------------------------------------------------------------------------//
+  // Same format as "Encodings::PutMagnitude". "a_buff" must have room for at
+  // least "MaxMagnitudeLen<RepT>" chars; NOT 0-terminated:
+  //
+  template<typename RepT>
+  char* PutMagnitudeNX(char* a_buff, RepT const& a_val) noexcept
+  {
+    if constexpr(CEMaths::IsComplex<RepT>)
+    {
+      double magRe = double(a_val.real());
+      double magIm = double(a_val.imag());
+      char*  curr  = a_buff;
+      *curr++ = '(';
+      curr    = PutReal(curr, magRe);
+      memcpy(curr, (magIm < 0.0) ? " - " : " + ", 3);
+      curr   += 3;
+      curr    = PutReal(curr, (magIm < 0.0) ? (-magIm) : magIm);
+      memcpy(curr, " * I)", 5);
+      return curr + 5;
+    }
+    else
+      return PutReal(a_buff, double(a_val));
+  }
+
+  //=========================================================================//
+  // Units:                                                                  //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "DecLen", "PutDec": Compile-Time Decimal Formatting:                    //
+  //-------------------------------------------------------------------------//
+  constexpr unsigned DecLen(int a_n)
+  {
+    unsigned len = (a_n < 0) ? 2 : 1;
+    for (unsigned n = unsigned((a_n < 0) ? -a_n : a_n); n >= 10; n /= 10)
+      ++len;
+    return len;
+  }
+
+  constexpr char* PutDec(char* a_buff, int a_n)
+  {
+    unsigned len = DecLen(a_n);
+    if (a_n < 0)
+      *a_buff = '-';
+    char*    curr = a_buff + len;
+    unsigned n    = unsigned((a_n < 0) ? -a_n : a_n);
+    do
+    {
+      *--curr = char('0' + n % 10);
+      n /= 10;
+    }
+    while (n != 0);
+    return a_buff + len;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "MkUnitsSuffix":                                                        //
+  //-------------------------------------------------------------------------//
+  // Generates the Units part of the "Put" output (each Unit preceded by a
+  // space) into "a_buff" (if non-NULL); returns the length. Invalid Dims or
+  // Units result in a compile-time error:
+  //
+  template<typename Sys>
+  constexpr size_t MkUnitsSuffix(uint64_t a_E, uint64_t a_U, char* a_buff)
+  {
+    using En = Encodings<typename Sys::RepT, Sys::MaxDims>;
+    size_t len = 0;
+    auto   put = [a_buff, &len](char a_c)
+    {
+      if (a_buff != nullptr)
+        a_buff[len] = a_c;
+      ++len;
+    };
+    for (unsigned dim = 0; dim < Sys::MaxDims; ++dim)
+    {
+      uint64_t e = En::GetFld(a_E, dim);
+      if (e == 0)
+        continue;
+      unsigned unit = unsigned(En::GetFld(a_U, dim));
+      if (dim >= Sys::NDims || unit >= Sys::Dims[dim].m_nUnits)
+        throw "MkUnitsSuffix: Invalid Dim or Unit";
+
+      put(' ');
+      for (char const* c = Sys::Dims[dim].m_unitNames[unit]; *c != '\0'; ++c)
+        put(*c);
+
+      auto     numDen = En::GetNumerAndDenom(e);
+      int      numer  = numDen.first;
+      unsigned denom  = numDen.second;
+      if (numer == 1 && denom == 1)
+        continue;
+      bool brackets   = numer < 0 || denom != 1;
+      put('^');
+      if (brackets)
+        put('(');
+      char dec[16];
+      for (char* c = dec; c != PutDec(dec, numer); ++c)
+        put(*c);
+      if (denom != 1)
+      {
+        put('/');
+        for (char* c = dec; c != PutDec(dec, int(denom)); ++c)
+          put(*c);
+      }
+      if (brackets)
+        put(')');
+    }
+    return len;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "UnitsSuffix": The above as a compile-time 0-terminated string:         //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, uint64_t E, uint64_t U>
+  constexpr inline size_t UnitsSuffixLen = MkUnitsSuffix<Sys>(E, U, nullptr);
+
+  template<typename Sys, uint64_t E, uint64_t U>
+  constexpr inline std::array<char, UnitsSuffixLen<Sys, E, U> + 1>
+    UnitsSuffix = []()
+    {
+      std::array<char, UnitsSuffixLen<Sys, E, U> + 1> res {};
+      MkUnitsSuffix<Sys>(E, U, res.data());
+      return res;
+    }();
+
+  //=========================================================================//
+  // "MaxPutSize", "PutBounded":                                             //
+  //=========================================================================//
+  // "MaxPutSize" is the exact upper bound of the output size, INCLUDING the
+  // terminating 0, so a buffer of that size can never be truncated:
+  //
+  template<typename Sys, uint64_t E, uint64_t U>
+  constexpr inline size_t MaxPutSize =
+    MaxMagnitudeLen<typename Sys::RepT> + UnitsSuffixLen<Sys, E, U> + 1;
+
+  //-------------------------------------------------------------------------//
+  // "PutBounded":                                                           //
+  //-------------------------------------------------------------------------//
+  // Outputs the magnitude and (E,U) Units into [a_buff, a_end), in the same
+  // format as "Put". The output is always 0-terminated (unless the buffer is
+  // empty); returns the ptr to the terminating 0. If the buffer is too small,
+  // the output is truncated and "*a_truncated" is set (it is reset otherwise).
+  // The cost is fixed: one "to_chars" (two for complex) and one "memcpy" (plus
+  // one more for truncated output):
+  //
+  template<typename Sys, uint64_t E, uint64_t U>
+  char* PutBounded
+  (
+    typename Sys::RepT const& a_mag,
+    char*                     a_buff,
+    char const*               a_end,
+    bool*                     a_truncated
+  )
+  noexcept
+  {
+    assert(a_buff != nullptr && a_end >= a_buff && a_truncated != nullptr);
+    constexpr size_t MaxSz  = MaxPutSize<Sys, E, U>;
+    constexpr auto&  Suffix = UnitsSuffix<Sys, E, U>;
+    size_t n = size_t(a_end - a_buff);
+
+    if (LIKELY(n >= MaxSz))
+    {
+      // Generic Case: No truncation is possible:
+      char* curr = PutMagnitudeNX(a_buff, a_mag);
+      memcpy(curr, Suffix.data(), Suffix.size());  // Incl the terminating 0
+      *a_truncated = false;
+      return curr + Suffix.size() - 1;
+    }
+    // Otherwise, format into a tmp buffer and copy the fitting part:
+    char   tmp[MaxSz];
+    char*  tmpEnd = PutMagnitudeNX(tmp, a_mag);
+    memcpy(tmpEnd, Suffix.data(), Suffix.size());
+    size_t len    = size_t(tmpEnd - tmp) + Suffix.size() - 1;
+
+    *a_truncated  = (len >= n);
+    if (UNLIKELY(n == 0))
+      return a_buff;
+    size_t toCopy = *a_truncated ? (n - 1) : len;
+    memcpy(a_buff, tmp, toCopy);
+    a_buff[toCopy] = '\0';
+    return a_buff + toCopy;
+  }
+}
+// End namespace Bits
+}
+// End namespace DimTypes
@@ -0,0 +1,315 @@
+// vim:ts=2:et
+//===========================================================================//
+//                                "Bits/Dual.hpp":                           //
+//          Dual Numbers for the Forward-Mode Automatic Differentiation      //
+//===========================================================================//
+// "Dual<T, N>" is a value "m_v" (of the Real Field "T") together with its
+// partial derivatives "m_d[0..N)" w.r.t. N independent variables ("seeds").
+// It can be used as the "RepT" of "DimQ": the arithmetic ops and the "CEMaths"
+// functions below propagate the derivatives by the chain rule, so a single
+// evaluation of a function of N variables yields its value and its gradient
+// (or, for several outputs, the whole Jacobian) instead of N finite differ-
+// ences. The derivative parts are fixed-size arrays updated by fixed-length
+// loops, which the compiler maps onto the SIMD registers (eg for N=4 doubles,
+// each op on the derivatives is a single AVX2 op); N=1 is the ordinary dual
+// number.
+// NB: "Encodings" and "DimQ" call the "CEMaths" functions by qualified names,
+// so the overloads for "Dual" must be declared BEFORE them; for that reason,
+// this header is included by "Encodings.hpp". The user-level API (seeding
+// the variables and extracting the typed derivatives) is in "AutoDiff.hpp":
+//
+#pragma  once
+#include "CEMaths.hpp"
+#include <type_traits>
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "Dual":                                                                 //
+  //=========================================================================//
+  template<typename T, unsigned N = 1>
+  struct Dual
+  {
+    static_assert(std::is_floating_point_v<T> && N >= 1,
+                  "ERROR: Dual: T must be Real, and N >= 1");
+    T m_v;       // Value
+    T m_d[N];    // Partial derivatives
+
+    //-----------------------------------------------------------------------//
+    // Ctors, Accessors:                                                     //
+    //-----------------------------------------------------------------------//
+    // IMPLICIT lifting of a constant (with zero derivatives), so that "Dual"
+    // can be used wherever "RepT" is constructed from a literal:
+    //
+    constexpr Dual(T a_v = T(0.0)): m_v(a_v), m_d{} {}
+
+    // The independent variable "a_i" (ie dv/dv = 1 in the seed "a_i"):
+    constexpr static Dual Var(T a_v, unsigned a_i = 0)
+    {
+      assert(a_i < N);
+      Dual res(a_v);
+      res.m_d[a_i] = T(1.0);
+      return res;
+    }
+
+    constexpr T Value()             const { return m_v; }
+    constexpr T Deriv(unsigned a_i) const { assert(a_i < N); return m_d[a_i]; }
+
+    // Dropping the derivatives must be explicit (it is used for printing):
+    constexpr explicit operator T() const { return m_v; }
+
+    //-----------------------------------------------------------------------//
+    // "Chain":                                                              //
+    //-----------------------------------------------------------------------//
+    // The result "a_f" of a function at "a_x", with the derivative "a_df":
+    //
+    constexpr static Dual Chain(Dual a_x, T a_f, T a_df)
+    {
+      Dual res(a_f);
+      for (unsigned i = 0; i < N; ++i)
+        res.m_d[i] = a_df * a_x.m_d[i];
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // Arithmetic:                                                           //
+    //-----------------------------------------------------------------------//
+    // Hidden friends, so that the constants (of type "T") are lifted implic-
+    // itly on either side:
+    //
+    constexpr friend Dual operator+(Dual a_x, Dual a_y)
+    {
+      Dual res(a_x.m_v + a_y.m_v);
+      for (unsigned i = 0; i < N; ++i)
+        res.m_d[i] = a_x.m_d[i] + a_y.m_d[i];
+      return res;
+    }
+
+    constexpr friend Dual operator-(Dual a_x, Dual a_y)
+    {
+      Dual res(a_x.m_v - a_y.m_v);
+      for (unsigned i = 0; i < N; ++i)
+        res.m_d[i] = a_x.m_d[i] - a_y.m_d[i];
+      return res;
+    }
+
+    constexpr friend Dual operator*(Dual a_x, Dual a_y)
+    {
+      Dual res(a_x.m_v * a_y.m_v);
+      for (unsigned i = 0; i < N; ++i)
+        res.m_d[i] = a_x.m_d[i] * a_y.m_v + a_x.m_v * a_y.m_d[i];
+      return res;
+    }
+
+    constexpr friend Dual operator/(Dual a_x, Dual a_y)
+    {
+      T    r = T(1.0) / a_y.m_v;
+      Dual res(a_x.m_v * r);
+      for (unsigned i = 0; i < N; ++i)
+        res.m_d[i] = (a_x.m_d[i] - res.m_v * a_y.m_d[i]) * r;
+      return res;
+    }
+
+    // Scaling by constants (no product rule needed):
+    constexpr friend Dual operator*(Dual a_x, T a_c)
+      { return Chain(a_x, a_x.m_v * a_c, a_c); }
+
+    constexpr friend Dual operator*(T a_c, Dual a_x)
+      { return Chain(a_x, a_c * a_x.m_v, a_c); }
+
+    constexpr friend Dual operator/(Dual a_x, T a_c)
+      { return a_x * (T(1.0) / a_c); }
+
+    constexpr Dual operator-() const
+      { return Chain(*this, - m_v, T(-1.0)); }
+
+    constexpr Dual& operator+=(Dual a_y) { return (*this = *this + a_y); }
+    constexpr Dual& operator-=(Dual a_y) { return (*this = *this - a_y); }
+    constexpr Dual& operator*=(Dual a_y) { return (*this = *this * a_y); }
+    constexpr Dual& operator/=(Dual a_y) { return (*this = *this / a_y); }
+
+    //-----------------------------------------------------------------------//
+    // Comparisons: By the Values Only:                                      //
+    //-----------------------------------------------------------------------//
+    constexpr friend bool operator==(Dual a_x, Dual a_y)
+      { return a_x.m_v == a_y.m_v; }
+    constexpr friend bool operator!=(Dual a_x, Dual a_y)
+      { return a_x.m_v != a_y.m_v; }
+    constexpr friend bool operator< (Dual a_x, Dual a_y)
+      { return a_x.m_v <  a_y.m_v; }
+    constexpr friend bool operator<=(Dual a_x, Dual a_y)
+      { return a_x.m_v <= a_y.m_v; }
+    constexpr friend bool operator> (Dual a_x, Dual a_y)
+      { return a_x.m_v >  a_y.m_v; }
+    constexpr friend bool operator>=(Dual a_x, Dual a_y)
+      { return a_x.m_v >= a_y.m_v; }
+  };
+
+  template<typename T>
+  inline constexpr bool IsDual = false;
+
+  template<typename T, unsigned N>
+  inline constexpr bool IsDual<Dual<T, N>> = true;
+
+namespace Bits::CEMaths
+{
+  //=========================================================================//
+  // "CEMaths" Functions of "Dual"s:                                         //
+  //=========================================================================//
+  // The values are computed by the Real functions above (so they are "const-
+  // expr" whenever those are), and the derivatives by the chain rule:
+  //
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Abs(Dual<T, N> a_x)
+    { return (a_x.m_v < T(0)) ? -a_x : a_x; }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Floor(Dual<T, N> a_x)
+    { return Dual<T, N>(Floor(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Ceil(Dual<T, N> a_x)
+    { return Dual<T, N>(Ceil(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Round(Dual<T, N> a_x)
+    { return Dual<T, N>(Round(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Exp(Dual<T, N> a_x)
+  {
+    T e = Exp(a_x.m_v);
+    return Dual<T, N>::Chain(a_x, e, e);
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Log(Dual<T, N> a_x)
+    { return Dual<T, N>::Chain(a_x, Log(a_x.m_v), T(1.0) / a_x.m_v); }
+
+  // A constant power:
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Pow(Dual<T, N> a_x, T a_p)
+  {
+    T z = Pow(a_x.m_v, a_p);
+    return Dual<T, N>::Chain(a_x, z, a_p * Pow(a_x.m_v, a_p - T(1.0)));
+  }
+
+  // The general case: d(x^y) = y x^(y-1) dx + x^y Log(x) dy; the 2nd term is
+  // omitted if "y" is a constant (so that x <= 0 is OK then):
+  //
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Pow(Dual<T, N> a_x, Dual<T, N> a_y)
+  {
+    Dual<T, N> res = Pow(a_x, a_y.m_v);
+    bool       yConst = true;
+    for (unsigned i = 0; i < N; ++i)
+      yConst &= (a_y.m_d[i] == T(0));
+    if (!yConst)
+    {
+      T zl = res.m_v * Log(a_x.m_v);
+      for (unsigned i = 0; i < N; ++i)
+        res.m_d[i] += zl * a_y.m_d[i];
+    }
+    return res;
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Cos(Dual<T, N> a_x)
+    { return Dual<T, N>::Chain(a_x, Cos(a_x.m_v), - Sin(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Sin(Dual<T, N> a_x)
+    { return Dual<T, N>::Chain(a_x, Sin(a_x.m_v),   Cos(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> Tan(Dual<T, N> a_x)
+  {
+    T t = Tan(a_x.m_v);
+    return Dual<T, N>::Chain(a_x, t, T(1.0) + t * t);
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ATan(Dual<T, N> a_x)
+  {
+    return Dual<T, N>::Chain
+      (a_x, ATan(a_x.m_v), T(1.0) / (T(1.0) + a_x.m_v * a_x.m_v));
+  }
+
+  // d ATan2(y, x) = (x dy - y dx) / (x^2 + y^2):
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ATan2(Dual<T, N> a_y, Dual<T, N> a_x)
+  {
+    Dual<T, N> res(ATan2(a_y.m_v, a_x.m_v));
+    T          r2 = T(1.0) / (a_x.m_v * a_x.m_v + a_y.m_v * a_y.m_v);
+    for (unsigned i = 0; i < N; ++i)
+      res.m_d[i] = (a_x.m_v * a_y.m_d[i] - a_y.m_v * a_x.m_d[i]) * r2;
+    return res;
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> SqRt(Dual<T, N> a_x)
+  {
+    T s = SqRt(a_x.m_v);
+    return Dual<T, N>::Chain(a_x, s, T(0.5) / s);
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> CbRt(Dual<T, N> a_x)
+  {
+    T c = CbRt(a_x.m_v);
+    return Dual<T, N>::Chain(a_x, c, T(1.0) / (T(3.0) * c * c));
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ASin(Dual<T, N> a_x)
+  {
+    return Dual<T, N>::Chain
+      (a_x, ASin(a_x.m_v),   T(1.0) / SqRt(T(1.0) - a_x.m_v * a_x.m_v));
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ACos(Dual<T, N> a_x)
+  {
+    return Dual<T, N>::Chain
+      (a_x, ACos(a_x.m_v), - T(1.0) / SqRt(T(1.0) - a_x.m_v * a_x.m_v));
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> SinH(Dual<T, N> a_x)
+    { return Dual<T, N>::Chain(a_x, SinH(a_x.m_v), CosH(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> CosH(Dual<T, N> a_x)
+    { return Dual<T, N>::Chain(a_x, CosH(a_x.m_v), SinH(a_x.m_v)); }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> TanH(Dual<T, N> a_x)
+  {
+    T t = TanH(a_x.m_v);
+    return Dual<T, N>::Chain(a_x, t, T(1.0) - t * t);
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ASinH(Dual<T, N> a_x)
+  {
+    return Dual<T, N>::Chain
+      (a_x, ASinH(a_x.m_v), T(1.0) / SqRt(a_x.m_v * a_x.m_v + T(1.0)));
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ACosH(Dual<T, N> a_x)
+  {
+    return Dual<T, N>::Chain
+      (a_x, ACosH(a_x.m_v), T(1.0) / SqRt(a_x.m_v * a_x.m_v - T(1.0)));
+  }
+
+  template<typename T, unsigned N>
+  constexpr Dual<T, N> ATanH(Dual<T, N> a_x)
+  {
+    return Dual<T, N>::Chain
+      (a_x, ATanH(a_x.m_v), T(1.0) / (T(1.0) - a_x.m_v * a_x.m_v));
+  }
+}
+// End namespace Bits::CEMaths
+}
+// End namespace DimTypes
@@ -4,7 +4,7 @@
 //         Encoding/Decoding of Dimension Exponents and Unit Vectors         //
 //===========================================================================//
 #pragma once
-#include "CEMaths.hpp"
+#include "Dual.hpp"
 #include <complex>
 #include <cstdio>
 #include <cmath>
@@ -444,7 +444,9 @@ namespace Bits
     // "FracPow23":                                                          //
     //-----------------------------------------------------------------------//
     // "N" is assumed to consist of 2 and 3 multiples only, so we can use the
-    // square and cubic roots:
+    // square and cubic roots. NB: the "CEMaths" functions are called w/o expl-
+    // icit template args, so that the overloads for Complex and "Dual" "RepT"s
+    // are selected:
     //
     template<int M, unsigned N>
     constexpr static RepT FracPow23(RepT a_x)
@@ -456,11 +458,11 @@ namespace Bits
         return IntPow<M>(a_x);
       else
       if constexpr(N % 2 == 0)
-        return FracPow23<M, N/2>(CEMaths::SqRt<RepT>(a_x));
+        return FracPow23<M, N/2>(CEMaths::SqRt(a_x));
       else
       {
         static_assert(N % 3 == 0, "FracPow23: N != Mults(2,3)");
-        return FracPow23<M, N/3>(CEMaths::CbRt<RepT>(a_x));
+        return FracPow23<M, N/3>(CEMaths::CbRt(a_x));
       }
     }
 
@@ -493,11 +495,11 @@ namespace Bits
         // If "RepT" is "complex", the type of the degree is still the underly-
         // ing real one:
         using P = typename  RepT::value_type;
-        return CEMaths::Pow<RepT>(a_x, P(M1)/P(N1));
+        return CEMaths::Pow(a_x, P(M1)/P(N1));
       }
       else
         // Otherwise, use the generic real "Pow":
-        return CEMaths::Pow<RepT>(a_x, RepT(M1) / RepT(N1));
+        return CEMaths::Pow(a_x, RepT(M1) / RepT(N1));
     }
 
     //=======================================================================//
@@ -0,0 +1,83 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "DimTypes/Bits/FileIO.hpp":                       //
+//                POSIX File I/O Utils for DimTypes Readers/Writers          //
+//===========================================================================//
+#pragma  once
+#include "Macros.h"
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // "ThrowSysErr":                                                          //
+  //-------------------------------------------------------------------------//
+  // Throws "std::runtime_error" with the "errno"-based message:
+  //
+  [[noreturn]] inline void ThrowSysErr(char const* a_where)
+  {
+    char buff[256];
+    snprintf(buff, sizeof(buff), "%s: %s", a_where, strerror(errno));
+    throw std::runtime_error(buff);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "WriteAll":                                                             //
+  //-------------------------------------------------------------------------//
+  // Writes all "a_len" bytes, re-trying on partial writes and "EINTR":
+  //
+  inline void WriteAll
+    (int a_fd, void const* a_data, size_t a_len, char const* a_where)
+  {
+    char const* curr = static_cast<char const*>(a_data);
+    while (a_len > 0)
+    {
+      ssize_t rc = write(a_fd, curr, a_len);
+      if (UNLIKELY(rc < 0))
+      {
+        if (errno == EINTR)
+          continue;
+        ThrowSysErr(a_where);
+      }
+      curr  += rc;
+      a_len -= size_t(rc);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ReadUpTo":                                                             //
+  //-------------------------------------------------------------------------//
+  // Reads up to "a_len" bytes; returns the number of bytes actually read, which
+  // is less than "a_len" only at EOF:
+  //
+  inline size_t ReadUpTo
+    (int a_fd, void* a_data, size_t a_len, char const* a_where)
+  {
+    char*  curr = static_cast<char*>(a_data);
+    size_t done = 0;
+    while (done < a_len)
+    {
+      ssize_t rc = read(a_fd, curr + done, a_len - done);
+      if (UNLIKELY(rc < 0))
+      {
+        if (errno == EINTR)
+          continue;
+        ThrowSysErr(a_where);
+      }
+      if (rc == 0)
+        break;    // EOF
+      done += size_t(rc);
+    }
+    return done;
+  }
+}
+// End namespace Bits
+}
+// End namespace DimTypes
@@ -155,7 +155,10 @@
 // (*) with the naming conventions used, it is OK to have same-named Units for
 //     different Dims, though this is very rarely needed;
 // (*) modular arithmetic is not used for Units,  so any Unit codes up to and
-//     including the corresp "PMask" are OK:
+//     including the corresp "PMask" are OK;
+// (*) in addition, run-time tables of all Dims, Unit names and scales are gen-
+//     erated, available to generic code via the "DimQ_Sys" type, along with
+//     "DimQ_Fingerprint", a compile-time hash of all of the above:
 //
 #ifdef  DECLARE_DIMS
 #undef  DECLARE_DIMS
@@ -202,6 +205,29 @@
   using DimLess = DimTypes::DimQ<0, 0, RepT, DimQ_MaxDims>; \
   \
   /*-----------------------------------------------------------------------*/ \
+  /* "DimQ_DimsInfo": Run-Time Descriptors of all Dims and their Units:    */ \
+  /*-----------------------------------------------------------------------*/ \
+  inline constexpr DimTypes::Bits::DimInfo<DimQ_RepT> DimQ_DimsInfo[] = \
+  { \
+    FOR_EACH_DIM(MK_DIM_INFO_COMMA, __VA_ARGS__) \
+  }; \
+  \
+  /*-----------------------------------------------------------------------*/ \
+  /* "DimQ_Sys": The whole Dimension System as a single Type, to be passed */ \
+  /* to generic (library) code which needs Unit names and scales:          */ \
+  /*-----------------------------------------------------------------------*/ \
+  using DimQ_Sys = \
+    DimTypes::Bits::DimsSys \
+    <DimQ_RepT, DimQ_MaxDims, DimQ_DimsInfo, \
+     unsigned(std::size(DimQ_DimsInfo))>; \
+  \
+  /*-----------------------------------------------------------------------*/ \
+  /* "DimQ_Fingerprint": Compile-time hash of the whole Dimension System:  */ \
+  /*-----------------------------------------------------------------------*/ \
+  constexpr inline uint64_t DimQ_Fingerprint = \
+    DimTypes::Bits::DimsFingerprint<DimQ_Sys>; \
+  \
+  /*-----------------------------------------------------------------------*/ \
   /* Finally, generate a "DimQ" output function.                           */ \
   /* It uses the above-generated templates:                                */ \
   /*-----------------------------------------------------------------------*/ \
@@ -228,6 +254,28 @@
 #endif
 #define GET_DIM_NAME(    DimName, _FundUnitName, ...)  DimName
 
+//---------------------------------------------------------------------------//
+// "MK_DIM_INFO_COMMA", "MK_DIM_INFO":                                       //
+//---------------------------------------------------------------------------//
+// Another "Action" for use with "FOR_EACH_DIM": creates an initialiser of the
+// "DimTypes::Bits::DimInfo" struct for the given Dim:
+//
+#ifdef  MK_DIM_INFO_COMMA
+#undef  MK_DIM_INFO_COMMA
+#endif
+#define MK_DIM_INFO_COMMA(DimDcl) MK_DIM_INFO DimDcl ,
+
+#ifdef  MK_DIM_INFO
+#undef  MK_DIM_INFO
+#endif
+#define MK_DIM_INFO(DimName, _FundUnitName, ...) \
+  { \
+    #DimName, \
+    unsigned(std::size(DimName##UnitNames)), \
+    DimName##UnitNames,  \
+    DimName##UnitScales  \
+  }
+
 //---------------------------------------------------------------------------//
 // "GET_FUND_UNIT", "MK_FUND_UNIT_STR":                                      //
 //---------------------------------------------------------------------------//
@@ -272,6 +320,18 @@
 #define GET_UNIT_NAME_COMMA(_DimName, UnitDcl) \
   GET_UNIT_NAME UnitDcl ,
 
+#ifdef  GET_UNIT_NAME_STR_COMMA
+#undef  GET_UNIT_NAME_STR_COMMA
+#endif
+#define GET_UNIT_NAME_STR_COMMA(_DimName, UnitDcl) \
+  STRINGIFY_NAME(GET_UNIT_NAME UnitDcl) ,
+
+#ifdef  GET_UNIT_VAL_COMMA
+#undef  GET_UNIT_VAL_COMMA
+#endif
+#define GET_UNIT_VAL_COMMA(_DimName, UnitDcl) \
+  DimQ_RepT(GET_UNIT_VAL UnitDcl) ,
+
 #ifdef  GET_UNIT_NAME
 #undef  GET_UNIT_NAME
 #endif
@@ -317,6 +377,21 @@
                       GET_OTHER_UNITS_DCLS   DimDcl) \
   \
   /*-----------------------------------------------------------------------*/ \
+  /* "{Dim}UnitNames", "{Dim}UnitScales": Run-Time Tables (by Unit code):  */ \
+  /*-----------------------------------------------------------------------*/ \
+  inline constexpr char const* MK_UNIT_NAMES_TBL DimDcl[] = \
+  { \
+    MK_FUND_UNIT_STR DimDcl, \
+    FOR_EACH_OTHER_UNIT(GET_UNIT_NAME_STR_COMMA, GET_DIM_NAME DimDcl, \
+                        GET_OTHER_UNITS_DCLS     DimDcl) \
+  }; \
+  inline constexpr DimQ_RepT   MK_UNIT_SCALES_TBL DimDcl[] = \
+  { \
+    DimQ_RepT(1.0), \
+    FOR_EACH_OTHER_UNIT(GET_UNIT_VAL_COMMA,      GET_DIM_NAME DimDcl, \
+                        GET_OTHER_UNITS_DCLS     DimDcl) \
+  }; \
+  /*-----------------------------------------------------------------------*/ \
   /* Convenience Type for this Dim (with implicit FundUnit):               */ \
   /*-----------------------------------------------------------------------*/ \
   static_assert \
@@ -463,6 +538,16 @@
 #endif
 #define MK_UNITS_ENUM_NAME( DimName, _FundUnitName, ...) DimName##UnitsE
 
+#ifdef  MK_UNIT_NAMES_TBL
+#undef  MK_UNIT_NAMES_TBL
+#endif
+#define MK_UNIT_NAMES_TBL( DimName, _FundUnitName, ...) DimName##UnitNames
+
+#ifdef  MK_UNIT_SCALES_TBL
+#undef  MK_UNIT_SCALES_TBL
+#endif
+#define MK_UNIT_SCALES_TBL(DimName, _FundUnitName, ...) DimName##UnitScales
+
 #ifdef  MK_UNITS_ENTRY_NAME
 #undef  MK_UNITS_ENTRY_NAME
 #endif
@@ -562,6 +647,42 @@
     return buff;    \
   } \
   /*-----------------------------------------------------------------------*/ \
+  /* "PutBounded", "ToStrBounded": Non-throwing versions of the above, for */ \
+  /* real-time paths; "DimQ_MaxPutSize<DQ>" is the exact max output size:  */ \
+  /*-----------------------------------------------------------------------*/ \
+  template<typename DQ> \
+  constexpr inline size_t DimQ_MaxPutSize = \
+    DimTypes::Bits::MaxPutSize \
+    <DimQ_Sys, DimTypes::DimQTraits<std::remove_cv_t<DQ>>::E, \
+               DimTypes::DimQTraits<std::remove_cv_t<DQ>>::U>;  \
+  \
+  template<uint64_t E, uint64_t U>  \
+  inline char* PutBounded \
+  ( \
+    DimTypes::DimQ<E, U, DimQ_RepT, DimQ_MaxDims> a_dimq,      \
+    char*                                         a_buff,      \
+    char const*                                   a_end,       \
+    bool*                                         a_truncated  \
+  ) \
+  noexcept \
+  { \
+    return DimTypes::Bits::PutBounded<DimQ_Sys, E, U> \
+           (a_dimq.Magnitude(), a_buff, a_end, a_truncated); \
+  } \
+  \
+  template<uint64_t E, uint64_t U>  \
+  inline std::array<char, DimTypes::Bits::MaxPutSize<DimQ_Sys, E, U>> \
+  ToStrBounded(DimTypes::DimQ<E, U, DimQ_RepT, DimQ_MaxDims> a_dimq) \
+  noexcept \
+  { \
+    std::array<char, DimTypes::Bits::MaxPutSize<DimQ_Sys, E, U>> buff; \
+    bool truncated = false; \
+    PutBounded<E, U>(a_dimq, buff.data(), buff.data() + buff.size(), \
+                     &truncated); \
+    assert(!truncated); \
+    return buff;  \
+  } \
+  /*-----------------------------------------------------------------------*/ \
   /* Output: "operator<<":                                                 */ \
   /*-----------------------------------------------------------------------*/ \
   template<uint64_t E, uint64_t U> \
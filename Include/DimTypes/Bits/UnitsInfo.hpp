@@ -0,0 +1,499 @@
+// vim:ts=2:et
+//===========================================================================//
+//                        "DimTypes/Bits/UnitsInfo.hpp":                     //
+//       Run-Time Descriptors of Dimension Systems, Units and Rep Types      //
+//===========================================================================//
+#pragma  once
+#include "Encodings.hpp"
+#include "Macros.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <complex>
+#include <bit>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // "DimInfo":                                                              //
+  //=========================================================================//
+  // Run-time descriptor of a Dim and all its Units, generated by "DECLARE_DIMS"
+  // (one per Dim, in the "DimsE" order).  Unit names and scales are stored in
+  // the order of Unit codes, so the FundUnit (with Scale=1) always comes 1st:
+  //
+  template<typename RepT>
+  struct DimInfo
+  {
+    char const*        m_name;        // Dim name, eg "Len"
+    unsigned           m_nUnits;      // Number of Units declared for this Dim
+    char const* const* m_unitNames;   // [m_nUnits]: eg "m", "km", ...
+    RepT const*        m_unitScales;  // [m_nUnits]: Unit vals in FundUnits
+  };
+
+  //=========================================================================//
+  // "DimsSys":                                                              //
+  //=========================================================================//
+  // A whole Dimension System as a single type: "DECLARE_DIMS" generates it as
+  // "DimQ_Sys", to be passed to generic code which needs Unit names and scales
+  // at run-time. "Dims" points to the array of "NDims" "DimInfo"s:
+  //
+  template<typename RepT_,     unsigned MaxDims_,
+           DimInfo<RepT_> const* Dims_, unsigned NDims_>
+  struct DimsSys
+  {
+    using                     RepT    = RepT_;
+    constexpr static unsigned MaxDims = MaxDims_;
+    constexpr static unsigned NDims   = NDims_;
+    constexpr static DimInfo<RepT> const* Dims = Dims_;
+    static_assert(NDims <= MaxDims);
+  };
+
+  // The absolute upper bound of "MaxDims" (see "Encodings"); used for fixed-
+  // size per-Dim arrays in run-time and on-disk structs:
+  constexpr inline unsigned AbsMaxDims = 9;
+
+  //=========================================================================//
+  // "RepCode":                                                              //
+  //=========================================================================//
+  // Stable 1-byte codes of the supported "RepT"s, for use in self-describing
+  // on-disk and on-wire formats. 0 means "unsupported":
+  //
+  template<typename RepT> inline constexpr uint8_t RepCode = 0;
+  template<> inline constexpr uint8_t RepCode<float>                     = 1;
+  template<> inline constexpr uint8_t RepCode<double>                    = 2;
+  template<> inline constexpr uint8_t RepCode<long double>               = 3;
+  template<> inline constexpr uint8_t RepCode<std::complex<float>>       = 4;
+  template<> inline constexpr uint8_t RepCode<std::complex<double>>      = 5;
+  template<> inline constexpr uint8_t RepCode<std::complex<long double>> = 6;
+
+  //=========================================================================//
+  // Run-Time Unit Scales:                                                   //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "RatPow":                                                               //
+  //-------------------------------------------------------------------------//
+  // Run-time analogue of "Encodings::FracPow": x^(Numer/Denom). For integral
+  // powers, uses the same squaring scheme as "IntPow",  so the results agree
+  // with those of compile-time unit conversions:
+  //
+  template<typename F>
+  inline F RatPow(F a_x, int a_numer, unsigned a_denom)
+  {
+    assert(a_denom != 0);
+    if (a_denom != 1)
+      return std::pow(a_x, F(a_numer) / F(a_denom));
+
+    if (a_numer < 0)
+      return F(1.0) / RatPow<F>(a_x, -a_numer, 1);
+    if (a_numer == 0)
+      return F(1.0);
+    if (a_numer == 1)
+      return a_x;
+
+    F halfPow  = RatPow<F>(a_x, a_numer / 2, 1);
+    F halfPow2 = halfPow * halfPow;
+    return (a_numer % 2 == 1) ? halfPow2 * a_x : halfPow2;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "NumerAndDenom":                                                        //
+  //-------------------------------------------------------------------------//
+  // "Encodings::GetNumerAndDenom" throws a "char const*" (which is a type error
+  // at compile time); at run time, the exponents may come from external data,
+  // so the failure is converted into "std::invalid_argument":
+  //
+  template<typename En>
+  constexpr std::pair<int, unsigned> NumerAndDenom(uint64_t a_e)
+  {
+    try
+      { return En::GetNumerAndDenom(a_e); }
+    catch (char const* a_msg)
+      { throw std::invalid_argument(a_msg); }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "DimsScale":                                                            //
+  //-------------------------------------------------------------------------//
+  // Given the Dims Exponent "E" and the scales (in FundUnits) of the Units of
+  // each Dim, returns the scale of the composite Unit, ie Prod(Scale[d]^E[d]).
+  // Dims with 0 exponents are ignored, so their scales may be arbitrary:
+  //
+  template<typename F, unsigned MaxDims>
+  inline F DimsScale(uint64_t a_E, F const* a_dimScales)
+  {
+    using En = Encodings<F, MaxDims>;
+    assert(a_dimScales != nullptr);
+
+    F res = F(1.0);
+    for (unsigned dim = 0; dim < MaxDims; ++dim)
+    {
+      uint64_t e = En::GetFld(a_E, dim);
+      if (e == 0)
+        continue;
+      auto numDen = NumerAndDenom<En>(e);
+      res *= RatPow<F>(a_dimScales[dim], numDen.first, numDen.second);
+    }
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "GetUnitScales":                                                        //
+  //-------------------------------------------------------------------------//
+  // Fills in the per-Dim scales of the Units "U", as declared in the "Sys"
+  // (which is the "DimQ_Sys" generated by "DECLARE_DIMS"). Dims with 0 expon-
+  // ents get the scale of 1. Throws if "E" or "U" refer to non-existent Dims
+  // or Units:
+  //
+  template<typename Sys, typename F>
+  inline void GetUnitScales(uint64_t a_E, uint64_t a_U, F* a_dimScales)
+  {
+    using En = Encodings<typename Sys::RepT, Sys::MaxDims>;
+    assert(a_dimScales != nullptr);
+
+    for (unsigned dim = 0; dim < Sys::MaxDims; ++dim)
+    {
+      a_dimScales[dim] = F(1.0);
+      if (En::GetFld(a_E, dim) == 0)
+        continue;
+
+      unsigned unit = unsigned(En::GetFld(a_U, dim));
+      if (UNLIKELY(dim >= Sys::NDims || unit >= Sys::Dims[dim].m_nUnits))
+        throw std::runtime_error("GetUnitScales: Invalid Dim or Unit");
+
+      a_dimScales[dim] = F(std::real(Sys::Dims[dim].m_unitScales[unit]));
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "UnitsConvFactor":                                                      //
+  //-------------------------------------------------------------------------//
+  // The factor by which magnitudes in the Units (E, FromU) are to be multiplied
+  // in order to get them in the Units (E, ToU):
+  //
+  template<typename Sys>
+  inline double UnitsConvFactor(uint64_t a_E, uint64_t a_fromU, uint64_t a_toU)
+  {
+    if (a_fromU == a_toU)
+      return 1.0;
+    double fromScales[AbsMaxDims];
+    double toScales  [AbsMaxDims];
+    GetUnitScales<Sys>(a_E, a_fromU, fromScales);
+    GetUnitScales<Sys>(a_E, a_toU,   toScales);
+    return DimsScale<double, Sys::MaxDims>(a_E, fromScales) /
+           DimsScale<double, Sys::MaxDims>(a_E, toScales);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ConstUnitsConvFactor":                                                 //
+  //-------------------------------------------------------------------------//
+  // Same as "UnitsConvFactor", but "constexpr" (the Unit scales generated by
+  // "DECLARE_DIMS" are constexpr tables), so that conversions between Units
+  // known at compile time can be folded into constants. Fractional powers are
+  // computed as in "Encodings::FracPow23" (ie via "SqRt" and "CbRt"), so the
+  // denominators of exponents must consist of 2 and 3 multiples only:
+  //
+  // Integral power, by the same squaring scheme as "IntPow":
+  constexpr double ConstIntPow(double a_x, int a_m)
+  {
+    if (a_m < 0)
+      return 1.0 / ConstIntPow(a_x, -a_m);
+    if (a_m == 0)
+      return 1.0;
+    if (a_m == 1)
+      return a_x;
+    double halfPow  = ConstIntPow(a_x, a_m / 2);
+    double halfPow2 = halfPow * halfPow;
+    return (a_m % 2 == 1) ? halfPow2 * a_x : halfPow2;
+  }
+
+  template<typename Sys>
+  constexpr double ConstUnitsConvFactor
+    (uint64_t a_E, uint64_t a_fromU, uint64_t a_toU)
+  {
+    using En = Encodings<typename Sys::RepT, Sys::MaxDims>;
+    if (a_fromU == a_toU)
+      return 1.0;
+
+    double res = 1.0;
+    for (unsigned dim = 0; dim < Sys::MaxDims; ++dim)
+    {
+      uint64_t e = En::GetFld(a_E, dim);
+      if (e == 0)
+        continue;
+      unsigned from = unsigned(En::GetFld(a_fromU, dim));
+      unsigned to   = unsigned(En::GetFld(a_toU,   dim));
+      if (from == to)
+        continue;
+      if (UNLIKELY(dim >= Sys::NDims  || from >= Sys::Dims[dim].m_nUnits ||
+                   to  >= Sys::Dims[dim].m_nUnits))
+        throw std::runtime_error("ConstUnitsConvFactor: Invalid Dim or Unit");
+
+      double x = double(std::real(Sys::Dims[dim].m_unitScales[from])) /
+                 double(std::real(Sys::Dims[dim].m_unitScales[to]));
+      auto   numDen = NumerAndDenom<En>(e);
+      int      numer = numDen.first;
+      unsigned denom = numDen.second;
+      for (; denom % 2 == 0; denom /= 2)
+        x = CEMaths::SqRt<double>(x);
+      for (; denom % 3 == 0; denom /= 3)
+        x = CEMaths::CbRt<double>(x);
+      if (UNLIKELY(denom != 1))
+        throw std::runtime_error("ConstUnitsConvFactor: UnSupported Power");
+
+      res *= ConstIntPow(x, numer);
+    }
+    return res;
+  }
+
+  //=========================================================================//
+  // Run-Time Units Strings:                                                 //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "PutUnits":                                                             //
+  //-------------------------------------------------------------------------//
+  // Outputs the Units (E,U) in the same format as "Put" does after the magni-
+  // tude, but w/o the leading space, eg "km sec^(-1)"; DimLess Units produce
+  // an empty string. The output is 0-terminated; returns the ptr to the term-
+  // inating 0. Throws on buffer overflow:
+  //
+  template<typename Sys>
+  char* PutUnits(uint64_t a_E, uint64_t a_U, char* a_buff, char const* a_end)
+  {
+    using En = Encodings<typename Sys::RepT, Sys::MaxDims>;
+    assert(a_buff != nullptr && a_end > a_buff);
+
+    char* curr  = a_buff;
+    bool  first = true;
+    for (unsigned dim = 0; dim < Sys::MaxDims; ++dim)
+    {
+      uint64_t e = En::GetFld(a_E, dim);
+      if (e == 0)
+        continue;
+      unsigned unit = unsigned(En::GetFld(a_U, dim));
+      if (UNLIKELY(dim >= Sys::NDims || unit >= Sys::Dims[dim].m_nUnits))
+        throw std::runtime_error("PutUnits: Invalid Dim or Unit");
+
+      auto     numDen = NumerAndDenom<En>(e);
+      int      numer  = numDen.first;
+      unsigned denom  = numDen.second;
+      size_t   n      = size_t(a_end - curr);
+      int      len    =
+        (numer == 1 && denom == 1)
+        ? snprintf(curr, n, "%s%s",       first ? "" : " ",
+                   Sys::Dims[dim].m_unitNames[unit])
+        : (denom == 1 && numer > 0)
+        ? snprintf(curr, n, "%s%s^%d",    first ? "" : " ",
+                   Sys::Dims[dim].m_unitNames[unit], numer)
+        : (denom == 1)
+        ? snprintf(curr, n, "%s%s^(%d)",  first ? "" : " ",
+                   Sys::Dims[dim].m_unitNames[unit], numer)
+        : snprintf(curr, n, "%s%s^(%d/%u)", first ? "" : " ",
+                   Sys::Dims[dim].m_unitNames[unit], numer, denom);
+
+      // Always allow a reserve of at least 1 byte, as in "Put":
+      if (UNLIKELY(len < 0 || size_t(len) + 1 >= n))
+        throw std::runtime_error("PutUnits: Buffer OverFlow");
+      curr += len;
+      first = false;
+    }
+    *curr = '\0';
+    return curr;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ParseUnits":                                                           //
+  //-------------------------------------------------------------------------//
+  // The inverse of "PutUnits": parses a Units string such as "km sec^(-1)" or
+  // "m^(3/2)*kg^-1" (Unit names separated by spaces or '*', each one optional-
+  // ly followed by "^Int" or "^(Int[/Nat])") into the (E,U) codes. An empty
+  // string (or "1") means DimLess. Repeated Dims are allowed, but then their
+  // Units must be same.  Returns "false" on any error (syntax, unknown Units,
+  // non-representable exponents):
+  //
+  template<typename Sys>
+  bool ParseUnits
+  (
+    char const* a_from,
+    char const* a_to,
+    uint64_t*   a_E,
+    uint64_t*   a_U
+  )
+  {
+    using En = Encodings<typename Sys::RepT, Sys::MaxDims>;
+    assert(a_from != nullptr && a_from <= a_to && a_E != nullptr &&
+           a_U    != nullptr);
+
+    uint64_t    E    = 0;
+    uint64_t    U    = 0;
+    uint64_t    used = 0;   // Bit mask of Dims for which the Units are set
+    char const* curr = a_from;
+
+    auto skipSeps = [&curr, a_to]()
+    {
+      while (curr < a_to && (*curr == ' ' || *curr == '*' || *curr == '\t'))
+        ++curr;
+    };
+    auto parseInt = [&curr, a_to](int* a_res) -> bool
+    {
+      bool neg = (curr < a_to && *curr == '-');
+      if (neg || (curr < a_to && *curr == '+'))
+        ++curr;
+      if (curr >= a_to || *curr < '0' || *curr > '9')
+        return false;
+      int res = 0;
+      for (; curr < a_to && '0' <= *curr && *curr <= '9'; ++curr)
+      {
+        res = 10 * res + (*curr - '0');
+        if (res >= En::IPMod)
+          return false;
+      }
+      *a_res = neg ? (-res) : res;
+      return true;
+    };
+
+    for (skipSeps(); curr < a_to; skipSeps())
+    {
+      // Unit Name:
+      char const* name = curr;
+      while (curr < a_to && *curr != ' ' && *curr != '*' && *curr != '^' &&
+             *curr != '\t')
+        ++curr;
+      size_t nameLen = size_t(curr - name);
+
+      // DimLess "1" is allowed as a placeholder (eg "1/sec" is NOT supported,
+      // but "1" alone is):
+      if (nameLen == 1 && *name == '1')
+        continue;
+
+      // Exponent, if any:
+      int numer = 1;
+      int denom = 1;
+      if (curr < a_to && *curr == '^')
+      {
+        ++curr;
+        bool brackets = (curr < a_to && *curr == '(');
+        if (brackets)
+          ++curr;
+        if (!parseInt(&numer))
+          return false;
+        if (brackets && curr < a_to && *curr == '/')
+        {
+          ++curr;
+          if (!parseInt(&denom) || denom <= 0)
+            return false;
+        }
+        if (brackets)
+        {
+          if (curr >= a_to || *curr != ')')
+            return false;
+          ++curr;
+        }
+      }
+      if (numer == 0)
+        continue;
+
+      // Find the Unit by name (if same-named Units exist for different Dims,
+      // the 1st one is taken):
+      bool found = false;
+      for (unsigned dim = 0; dim < Sys::NDims && !found; ++dim)
+      for (unsigned unit = 0; unit < Sys::Dims[dim].m_nUnits; ++unit)
+      {
+        char const* uname = Sys::Dims[dim].m_unitNames[unit];
+        if (strlen(uname) != nameLen || strncmp(uname, name, nameLen) != 0)
+          continue;
+
+        // Units for the same Dim must be consistent:
+        if ((used >> dim) & 1UL)
+        {
+          if (En::GetFld(U, dim) != unit)
+            return false;
+        }
+        else
+        {
+          U     = En::SetUnit(U, dim, unit);
+          used |= (1UL << dim);
+        }
+        try
+        {
+          E   = En::AddExp
+                (E, En::DivExp(En::MultExp(En::DimExp(dim), numer),
+                               unsigned(denom)));
+        }
+        catch (char const*)
+          { return false; }
+        found = true;
+        break;
+      }
+      if (!found)
+        return false;
+    }
+    *a_E = E;
+    *a_U = En::CleanUpUnits(E, U);
+    return true;
+  }
+
+  //=========================================================================//
+  // "DimsFingerprint":                                                      //
+  //=========================================================================//
+  // A compile-time 64-bit FNV-1a hash of the whole Dimension System: "RepCode"
+  // and "MaxDims", then the names of all Dims (in their declaration order),
+  // and the names and scales of all their Units (in the order of Unit codes).
+  // Two "DECLARE_DIMS" produce the same fingerprint iff they are compatible
+  // (up to hash collisions):
+  //
+  constexpr inline uint64_t FNVOffset = 0xcbf29ce484222325UL;
+  constexpr inline uint64_t FNVPrime  = 0x00000100000001b3UL;
+
+  constexpr uint64_t FNVMix(uint64_t a_h, uint64_t a_x)
+  {
+    // The 8 bytes of "a_x" in the Little-Endian order:
+    for (unsigned i = 0; i < 8; ++i)
+      a_h = (a_h ^ ((a_x >> (8 * i)) & 0xffU)) * FNVPrime;
+    return a_h;
+  }
+
+  constexpr uint64_t FNVMixStr(uint64_t a_h, char const* a_str)
+  {
+    for (; *a_str != '\0'; ++a_str)
+      a_h = (a_h ^ uint64_t(static_cast<unsigned char>(*a_str))) * FNVPrime;
+    // Terminate the string, so that ("ab","c") and ("a","bc") differ:
+    return (a_h ^ 0xffU) * FNVPrime;
+  }
+
+  template<typename Sys>
+  constexpr uint64_t MkDimsFingerprint()
+  {
+    using RepT = typename Sys::RepT;
+    uint64_t h = FNVOffset;
+    h = FNVMix(h, RepCode<RepT>);
+    h = FNVMix(h, Sys::MaxDims);
+    h = FNVMix(h, Sys::NDims);
+    for (unsigned dim = 0; dim < Sys::NDims; ++dim)
+    {
+      DimInfo<RepT> const& di = Sys::Dims[dim];
+      h = FNVMixStr(h, di.m_name);
+      h = FNVMix   (h, di.m_nUnits);
+      for (unsigned unit = 0; unit < di.m_nUnits; ++unit)
+      {
+        // The scales are hashed as "double"s (the real parts if complex):
+        double scale = 0.0;
+        if constexpr (CEMaths::IsComplex<RepT>)
+          scale = double(di.m_unitScales[unit].real());
+        else
+          scale = double(di.m_unitScales[unit]);
+        h = FNVMixStr(h, di.m_unitNames[unit]);
+        h = FNVMix   (h, std::bit_cast<uint64_t>(scale));
+      }
+    }
+    return h;
+  }
+
+  template<typename Sys>
+  constexpr inline uint64_t DimsFingerprint = MkDimsFingerprint<Sys>();
+}
+// End namespace Bits
+}
+// End namespace DimTypes
@@ -0,0 +1,495 @@
+// vim:ts=2:et
+//===========================================================================//
+//                              "DimTypes/CSV.hpp":                          //
+//         Streaming CSV Reader and Writer with Unit-Annotated Headers       //
+//===========================================================================//
+// Header fields are of the form "Name[Units]", eg "range[km]", "rate[km sec^(
+// -1)]";  DimLess columns may omit the "[Units]" part. The Units syntax is that
+// of "Bits::ParseUnits".  Data fields are parsed with "std::from_chars" (empty
+// fields become NaN). XXX: Quoted fields are only supported if they do not
+// contain delimiters or line breaks:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include "Bits/FileIO.hpp"
+#include <vector>
+#include <array>
+#include <string>
+#include <charconv>
+#include <utility>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // CSV Parsing Utils:                                                      //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "FindDelim":                                                            //
+  //-------------------------------------------------------------------------//
+  // Returns the ptr to the 1st occurrence of "a_delim" or '\n' in [From, To),
+  // or "a_to" if there is none. Scans 32 (AVX2) or 16 (SSE2) bytes at a time:
+  //
+  inline char const* FindDelim
+    (char const* a_from, char const* a_to, char a_delim)
+  {
+    assert(a_from <= a_to);
+# if defined(__AVX2__)
+    __m256i const d  = _mm256_set1_epi8(a_delim);
+    __m256i const nl = _mm256_set1_epi8('\n');
+    for (; a_from + 32 <= a_to; a_from += 32)
+    {
+      __m256i  v    =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a_from));
+      unsigned mask = unsigned(_mm256_movemask_epi8
+        (_mm256_or_si256(_mm256_cmpeq_epi8(v, d), _mm256_cmpeq_epi8(v, nl))));
+      if (mask != 0)
+        return a_from + __builtin_ctz(mask);
+    }
+# elif defined(__SSE2__)
+    __m128i const d  = _mm_set1_epi8(a_delim);
+    __m128i const nl = _mm_set1_epi8('\n');
+    for (; a_from + 16 <= a_to; a_from += 16)
+    {
+      __m128i  v    = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_from));
+      unsigned mask = unsigned(_mm_movemask_epi8
+        (_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, nl))));
+      if (mask != 0)
+        return a_from + __builtin_ctz(mask);
+    }
+# endif
+    // The tail (or the generic case):
+    for (; a_from < a_to; ++a_from)
+      if (*a_from == a_delim || *a_from == '\n')
+        return a_from;
+    return a_to;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "TrimField":                                                            //
+  //-------------------------------------------------------------------------//
+  // Removes surrounding white space, '\r' and double quotes:
+  //
+  inline void TrimField(char const** a_from, char const** a_to)
+  {
+    char const* from = *a_from;
+    char const* to   = *a_to;
+    while (from < to && (*from   == ' ' || *from   == '\t'))
+      ++from;
+    while (to > from && (to[-1]  == ' ' || to[-1]  == '\t' || to[-1] == '\r'))
+      --to;
+    if (to - from >= 2 && *from == '"' && to[-1] == '"')
+    {
+      ++from;
+      --to;
+    }
+    *a_from = from;
+    *a_to   = to;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "ParseNum":                                                             //
+  //-------------------------------------------------------------------------//
+  // Parses a (trimmed) numeric field; empty fields become NaN. Returns "false"
+  // on a syntax error or trailing garbage:
+  //
+  template<typename F>
+  inline bool ParseNum(char const* a_from, char const* a_to, F* a_res)
+  {
+    static_assert(std::is_floating_point_v<F>);
+    if (a_from == a_to)
+    {
+      *a_res = CEMaths::NaN<F>;
+      return true;
+    }
+    // "std::from_chars" does not accept the leading '+':
+    if (*a_from == '+')
+      ++a_from;
+    auto res = std::from_chars(a_from, a_to, *a_res);
+    return res.ec == std::errc() && res.ptr == a_to;
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "CSVReader":                                                            //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS"; "DQs" are the reques-
+  // ted column types. Columns are selected by name (or by position, if the
+  // corresp name is NULL); the Units found in the header are converted into
+  // those of "DQs" on the fly. "ReadChunk" fills in at most "a_maxRows" rows,
+  // so the memory usage is bounded by the chunk size and the I/O buffer size:
+  //
+  template<typename Sys, typename... DQs>
+  class CSVReader
+  {
+  private:
+    using RepT = typename Sys::RepT;
+    constexpr static unsigned NC = sizeof...(DQs);
+    static_assert(NC > 0 && (... && (DimQTraits<DQs>::IsDimQ &&
+                  std::is_same_v<typename DimQTraits<DQs>::RepT, RepT> &&
+                  DimQTraits<DQs>::MaxDims == Sys::MaxDims)),
+                  "CSVReader: Incompatible DimQ Column Types");
+    static_assert(std::is_floating_point_v<RepT>,
+                  "CSVReader: Only Real RepTs are supported");
+
+    int                   m_fd;
+    char                  m_delim;
+    std::vector<char>     m_buff;
+    size_t                m_beg;      // Unprocessed data are in [Beg, End)
+    size_t                m_end;
+    bool                  m_eof;
+    uint64_t              m_lineNo;
+    std::vector<int>      m_dstCol;   // FileCol => RequestedCol (or -1)
+    std::array<RepT, NC>  m_factors;  // Unit conversion factors
+
+    [[noreturn]] void Fail(char const* a_msg) const
+    {
+      char buff[256];
+      snprintf(buff, sizeof(buff), "CSVReader: Line %lu: %s", m_lineNo, a_msg);
+      throw std::runtime_error(buff);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "GetLine":                                                            //
+    //-----------------------------------------------------------------------//
+    // Returns "false" at EOF. Otherwise, [*a_from, *a_to) is the line w/o the
+    // trailing '\n'; it remains valid until the next call:
+    //
+    bool GetLine(char const** a_from, char const** a_to)
+    {
+      while (true)
+      {
+        char const* beg = m_buff.data() + m_beg;
+        char const* end = m_buff.data() + m_end;
+        auto const* nl  =
+          static_cast<char const*>(memchr(beg, '\n', size_t(end - beg)));
+        if (nl != nullptr || (m_eof && beg < end))
+        {
+          *a_from = beg;
+          *a_to   = (nl != nullptr) ? nl : end;
+          m_beg   = (nl != nullptr) ? size_t(nl + 1 - m_buff.data()) : m_end;
+          ++m_lineNo;
+          return true;
+        }
+        if (m_eof)
+          return false;
+
+        // Need more data: Move the partial line to the front of the buffer,
+        // and grow the latter if the line does not fit:
+        size_t left = m_end - m_beg;
+        memmove(m_buff.data(), m_buff.data() + m_beg, left);
+        m_beg = 0;
+        m_end = left;
+        if (m_end == m_buff.size())
+          m_buff.resize(2 * m_buff.size());
+
+        size_t want = m_buff.size() - m_end;
+        size_t got  =
+          Bits::ReadUpTo(m_fd, m_buff.data() + m_end, want, "CSVReader");
+        m_end += got;
+        m_eof  = (got < want);
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ParseHeader":                                                        //
+    //-----------------------------------------------------------------------//
+    void ParseHeader(std::array<char const*, NC> const& a_names)
+    {
+      char const* from = nullptr;
+      char const* to   = nullptr;
+      if (!GetLine(&from, &to))
+        Fail("Missing Header");
+
+      // Collect all header fields: (Name, Units):
+      std::vector<std::pair<std::string, std::string>> hdr;
+      for (char const* curr = from; curr <= to; )
+      {
+        char const* fend = Bits::FindDelim(curr, to, m_delim);
+        char const* nb   = curr;
+        char const* ne   = fend;
+        Bits::TrimField(&nb, &ne);
+
+        auto const* lb =
+          static_cast<char const*>(memchr(nb, '[', size_t(ne - nb)));
+        if (lb != nullptr)
+        {
+          if (ne[-1] != ']')
+            Fail("Invalid Header Field");
+          char const* nameEnd = lb;
+          Bits::TrimField(&nb, &nameEnd);
+          hdr.emplace_back(std::string(nb, nameEnd),
+                           std::string(lb + 1, ne - 1));
+        }
+        else
+          hdr.emplace_back(std::string(nb, ne), std::string());
+        curr = fend + 1;
+      }
+      m_dstCol.assign(hdr.size(), -1);
+
+      // Map the requested columns onto the header ones:
+      constexpr uint64_t Es[NC] = { DimQTraits<DQs>::E... };
+      constexpr uint64_t Us[NC] = { DimQTraits<DQs>::U... };
+
+      for (unsigned k = 0; k < NC; ++k)
+      {
+        size_t j = k;
+        if (a_names[k] != nullptr)
+          for (j = 0; j < hdr.size() && hdr[j].first != a_names[k]; ++j) ;
+        if (j >= hdr.size())
+          Fail("Requested Column Not Found");
+        if (m_dstCol[j] >= 0)
+          Fail("Column Requested Twice");
+
+        uint64_t E = 0;
+        uint64_t U = 0;
+        std::string const& units = hdr[j].second;
+        if (!Bits::ParseUnits<Sys>
+            (units.data(), units.data() + units.size(), &E, &U))
+          Fail("Invalid Units in Header");
+        if (E != Es[k])
+          Fail("Dims MisMatch in Header");
+
+        m_dstCol [j] = int(k);
+        m_factors[k] = RepT(Bits::UnitsConvFactor<Sys>
+                      (E, U, Bits::Encodings<RepT, Sys::MaxDims>::CleanUpUnits
+                             (E, Us[k])));
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Store": Appends the parsed row to the output columns:                //
+    //-----------------------------------------------------------------------//
+    template<size_t... I>
+    void Store
+    (
+      std::index_sequence<I...>,
+      std::array<RepT, NC> const& a_vals,
+      std::vector<DQs>&...        a_cols
+    )
+    const
+      { (a_cols.push_back(DQs(a_vals[I] * m_factors[I])), ...); }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    CSVReader
+    (
+      char const*                         a_path,
+      std::array<char const*, NC> const&  a_names,
+      char                                a_delim     = ',',
+      size_t                              a_buffSize  = 1 << 20
+    )
+    : m_fd     (open(a_path, O_RDONLY | O_CLOEXEC)),
+      m_delim  (a_delim),
+      m_buff   (std::max<size_t>(a_buffSize, 64)),
+      m_beg    (0),
+      m_end    (0),
+      m_eof    (false),
+      m_lineNo (0),
+      m_dstCol (),
+      m_factors()
+    {
+      if (UNLIKELY(m_fd < 0))
+        Bits::ThrowSysErr("CSVReader::Ctor");
+      try
+        { ParseHeader(a_names); }
+      catch (...)
+      {
+        close(m_fd);
+        throw;
+      }
+    }
+
+    ~CSVReader() { close(m_fd); }
+
+    CSVReader(CSVReader const&)            = delete;
+    CSVReader& operator=(CSVReader const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "ReadChunk":                                                          //
+    //-----------------------------------------------------------------------//
+    // Clears the output columns and fills them with up to "a_maxRows" rows.
+    // Returns the number of rows actually read (0 at EOF):
+    //
+    size_t ReadChunk(size_t a_maxRows, std::vector<DQs>&... a_cols)
+    {
+      (a_cols.clear(),           ...);
+      (a_cols.reserve(a_maxRows), ...);
+
+      size_t              nRows = 0;
+      char const*         from  = nullptr;
+      char const*         to    = nullptr;
+      std::array<RepT, NC> vals;
+
+      while (nRows < a_maxRows && GetLine(&from, &to))
+      {
+        // Skip empty lines:
+        if (from == to || (to - from == 1 && *from == '\r'))
+          continue;
+
+        vals.fill(NaN<RepT>);
+        size_t j = 0;
+        for (char const* curr = from; curr <= to; ++j)
+        {
+          char const* fend = Bits::FindDelim(curr, to, m_delim);
+          if (j < m_dstCol.size() && m_dstCol[j] >= 0)
+          {
+            char const* fb = curr;
+            char const* fe = fend;
+            Bits::TrimField(&fb, &fe);
+            RepT* val = &vals[size_t(m_dstCol[j])];
+            if (UNLIKELY(!Bits::ParseNum<RepT>(fb, fe, val)))
+              Fail("Invalid Number");
+          }
+          curr = fend + 1;
+        }
+        Store(std::make_index_sequence<NC>(), vals, a_cols...);
+        ++nRows;
+      }
+      return nRows;
+    }
+  };
+
+  //=========================================================================//
+  // "CSVWriter":                                                            //
+  //=========================================================================//
+  // Writes the "Name[Units]" header on construction, then rows of "DQs" (in
+  // the shortest round-trip representation, via "std::to_chars"):
+  //
+  template<typename Sys, typename... DQs>
+  class CSVWriter
+  {
+  private:
+    using RepT = typename Sys::RepT;
+    constexpr static unsigned NC = sizeof...(DQs);
+    static_assert(NC > 0 && (... && (DimQTraits<DQs>::IsDimQ &&
+                  std::is_same_v<typename DimQTraits<DQs>::RepT, RepT> &&
+                  DimQTraits<DQs>::MaxDims == Sys::MaxDims)),
+                  "CSVWriter: Incompatible DimQ Column Types");
+    static_assert(std::is_floating_point_v<RepT>,
+                  "CSVWriter: Only Real RepTs are supported");
+
+    constexpr static size_t BuffSize  = 1 << 16;
+    constexpr static size_t MaxRowLen = NC * 64;   // Enough for any row
+
+    int                m_fd;
+    char               m_delim;
+    std::vector<char>  m_buff;
+    size_t             m_len;
+
+    void Put(char a_c) { m_buff[m_len++] = a_c; }
+
+    template<typename DQ>
+    void PutVal(DQ a_val, bool a_first)
+    {
+      if (!a_first)
+        Put(m_delim);
+      auto res = std::to_chars(m_buff.data() + m_len,
+                               m_buff.data() + m_buff.size(),
+                               a_val.Magnitude());
+      assert(res.ec == std::errc());
+      m_len = size_t(res.ptr - m_buff.data());
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    CSVWriter
+    (
+      char const*                         a_path,
+      std::array<char const*, NC> const&  a_names,
+      char                                a_delim = ','
+    )
+    : m_fd   (-1),
+      m_delim(a_delim),
+      m_buff (BuffSize + MaxRowLen),
+      m_len  (0)
+    {
+      // Make the Header first, as "PutUnits" may throw:
+      constexpr uint64_t Es[NC] = { DimQTraits<DQs>::E... };
+      constexpr uint64_t Us[NC] = { DimQTraits<DQs>::U... };
+      std::string hdr;
+      for (unsigned k = 0; k < NC; ++k)
+      {
+        assert(a_names[k] != nullptr);
+        if (k != 0)
+          hdr += m_delim;
+        hdr += a_names[k];
+        if (Es[k] != 0)
+        {
+          char units[256];
+          Bits::PutUnits<Sys>(Es[k], Us[k], units, units + sizeof(units));
+          hdr += '[';
+          hdr += units;
+          hdr += ']';
+        }
+      }
+      hdr += '\n';
+
+      m_fd = open(a_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (UNLIKELY(m_fd < 0))
+        Bits::ThrowSysErr("CSVWriter::Ctor");
+      try
+        { Bits::WriteAll(m_fd, hdr.data(), hdr.size(), "CSVWriter::Ctor"); }
+      catch (...)
+      {
+        // The Dtor will not be invoked, so close the file here:
+        close(m_fd);
+        throw;
+      }
+    }
+
+    ~CSVWriter()
+    {
+      if (m_fd >= 0)
+        try { Close(); } catch (...) {}
+    }
+
+    CSVWriter(CSVWriter const&)            = delete;
+    CSVWriter& operator=(CSVWriter const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "WriteRows": From "a_n"-long column arrays:                           //
+    //-----------------------------------------------------------------------//
+    void WriteRows(size_t a_n, DQs const*... a_cols)
+    {
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        unsigned k = 0;
+        (PutVal(a_cols[i], (k++ == 0)), ...);
+        Put('\n');
+        if (m_len >= BuffSize)
+          Flush();
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Flush", "Close":                                                     //
+    //-----------------------------------------------------------------------//
+    void Flush()
+    {
+      Bits::WriteAll(m_fd, m_buff.data(), m_len, "CSVWriter::Flush");
+      m_len = 0;
+    }
+
+    void Close()
+    {
+      if (m_fd < 0)
+        return;
+      Flush();
+      int fd = m_fd;
+      m_fd   = -1;
+      if (UNLIKELY(close(fd) < 0))
+        Bits::ThrowSysErr("CSVWriter::Close");
+    }
+  };
+}
+// End namespace DimTypes
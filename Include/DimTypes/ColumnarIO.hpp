@@ -0,0 +1,523 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "DimTypes/ColumnarIO.hpp":                        //
+//     Self-Describing Binary Columnar Files of "DimQ"s, with mmap Reader    //
+//===========================================================================//
+// File Layout (all integers in the native byte order, which is verified by the
+// reader via "m_endianTag"):
+// (*) "ColFileHdr"  (256 bytes) at offset 0;
+// (*) data of each column: a contiguous array of "RepT"s, 64-byte-aligned;
+// (*) "ColDescr"s   (160 bytes each) for all columns, after the data.
+// The Header is written last (on "Close"), so the columns can be streamed out
+// without knowing their number or lengths in advance:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include "Bits/FileIO.hpp"
+#include <vector>
+#include <span>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // On-Disk Structs:                                                        //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "ColFileHdr":                                                           //
+  //-------------------------------------------------------------------------//
+  struct ColFileHdr
+  {
+    char     m_magic[8];          // "DimQCol"
+    uint32_t m_version;           // Currently 1
+    uint32_t m_endianTag;         // 0x01020304 in the writer's byte order
+    uint32_t m_maxDims;           // "MaxDims" of the writer's "DimQ_Sys"
+    uint32_t m_nCols;
+    uint64_t m_nRows;             // Same for all columns
+    uint64_t m_descrsOff;         // Offset of the "ColDescr" table
+    uint64_t m_fileSize;
+    char     m_dimNames[AbsMaxDims][16];  // Writer's Dim names, by Dim code
+    uint8_t  m_reserved[64];
+  };
+  static_assert(sizeof(ColFileHdr) == 256);
+
+  constexpr inline char     ColFileMagic[8]  = "DimQCol";
+  constexpr inline uint32_t ColFileVersion   = 1;
+  constexpr inline uint32_t ColFileEndianTag = 0x01020304;
+  constexpr inline uint64_t ColDataAlign     = 64;
+
+  //-------------------------------------------------------------------------//
+  // "ColDescr":                                                             //
+  //-------------------------------------------------------------------------//
+  // NB: The scales (in FundUnits) of the Units used in each Dim are stored as
+  // "double"s regardless of "RepT"; they are what the reader actually uses for
+  // conversions, so the Unit codes are informative only:
+  //
+  struct ColDescr
+  {
+    char     m_name[48];          // 0-terminated
+    uint64_t m_E;                 // Dims  Exponent code
+    uint64_t m_U;                 // Units code
+    uint64_t m_dataOff;           // Multiple of "ColDataAlign"
+    uint64_t m_nRows;
+    uint8_t  m_repCode;           // "RepCode<RepT>"
+    uint8_t  m_repSize;           // sizeof(RepT)
+    uint8_t  m_reserved[6];
+    double   m_scales[AbsMaxDims];// Scale of the Unit of each Dim; 1 if Exp=0
+  };
+  static_assert(sizeof(ColDescr) == 160);
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "ColumnarWriter":                                                       //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS". Usage:
+  // (*) "WriteColumn" for a whole in-memory array, or
+  // (*) "BeginColumn", "Append" (any number of times), "EndColumn" for stream-
+  //     ing a column in chunks;
+  // (*) "Close" (also invoked by the Dtor, but then errors are not reported):
+  //
+  template<typename Sys>
+  class ColumnarWriter
+  {
+  private:
+    using RepT = typename Sys::RepT;
+    using En   = Bits::Encodings<RepT, Sys::MaxDims>;
+    static_assert(Bits::RepCode<RepT> != 0, "ColumnarWriter: UnSupported RepT");
+
+    int                          m_fd;
+    uint64_t                     m_off;       // Curr write offset
+    bool                         m_inCol;     // Inside Begin/EndColumn?
+    Bits::ColDescr               m_curr;      // Of the curr column
+    std::vector<Bits::ColDescr>  m_descrs;    // Of the finished columns
+
+    //-----------------------------------------------------------------------//
+    // "WriteAll":                                                           //
+    //-----------------------------------------------------------------------//
+    void WriteAll(void const* a_data, size_t a_len)
+    {
+      Bits::WriteAll(m_fd, a_data, a_len, "ColumnarWriter::WriteAll");
+      m_off += a_len;
+    }
+
+    // Zero-padding of the curr offset up to "ColDataAlign":
+    void Align()
+    {
+      static constexpr char Zeros[Bits::ColDataAlign] = {};
+      size_t pad = size_t((Bits::ColDataAlign - m_off % Bits::ColDataAlign) %
+                           Bits::ColDataAlign);
+      WriteAll(Zeros, pad);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    explicit ColumnarWriter(char const* a_path)
+    : m_fd   (open(a_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+      m_off  (0),
+      m_inCol(false),
+      m_curr (),
+      m_descrs()
+    {
+      if (UNLIKELY(m_fd < 0))
+        Bits::ThrowSysErr("ColumnarWriter::Ctor");
+      // Reserve space for the Header (written on "Close"):
+      try
+      {
+        Bits::ColFileHdr hdr {};
+        WriteAll(&hdr, sizeof(hdr));
+      }
+      catch (...)
+      {
+        // The Dtor will not be invoked, so close the file here:
+        close(m_fd);
+        throw;
+      }
+    }
+
+    ~ColumnarWriter()
+    {
+      if (m_fd >= 0)
+        try { Close(); } catch (...) {}
+    }
+
+    ColumnarWriter(ColumnarWriter const&)            = delete;
+    ColumnarWriter& operator=(ColumnarWriter const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "BeginColumn":                                                        //
+    //-----------------------------------------------------------------------//
+    template<uint64_t E, uint64_t U>
+    void BeginColumn(char const* a_name)
+    {
+      assert(a_name != nullptr);
+      if (UNLIKELY(m_fd < 0 || m_inCol))
+        throw std::runtime_error("ColumnarWriter::BeginColumn: Invalid State");
+
+      Align();
+      Bits::ColDescr descr {};
+      strncpy(descr.m_name, a_name, sizeof(descr.m_name) - 1);
+      descr.m_E       = E;
+      descr.m_U       = En::CleanUpUnits(E, U);
+      descr.m_dataOff = m_off;
+      descr.m_nRows   = 0;
+      descr.m_repCode = Bits::RepCode<RepT>;
+      descr.m_repSize = uint8_t(sizeof(RepT));
+      Bits::GetUnitScales<Sys>(E, U, descr.m_scales);
+      for (unsigned dim = Sys::MaxDims; dim < Bits::AbsMaxDims; ++dim)
+        descr.m_scales[dim] = 1.0;
+
+      m_curr  = descr;
+      m_inCol = true;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Append": Streams a chunk of the curr column directly from the array:  //
+    //-----------------------------------------------------------------------//
+    template<uint64_t E, uint64_t U>
+    void Append(DimQ<E, U, RepT, Sys::MaxDims> const* a_data, size_t a_n)
+    {
+      assert(a_data != nullptr || a_n == 0);
+      if (UNLIKELY(!m_inCol))
+        throw std::runtime_error("ColumnarWriter::Append: No Curr Column");
+
+      Bits::ColDescr& descr = m_curr;
+      if (UNLIKELY(descr.m_E != E || descr.m_U != En::CleanUpUnits(E, U)))
+        throw std::runtime_error("ColumnarWriter::Append: Type MisMatch");
+
+      WriteAll(a_data, a_n * sizeof(RepT));
+      descr.m_nRows += a_n;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "EndColumn":                                                          //
+    //-----------------------------------------------------------------------//
+    // The Descr is only recorded once the column is validated, so a rejected
+    // column is dropped (its data remain in the file, but are unreferenced),
+    // and the writer can still be "Close"d into a valid file:
+    //
+    void EndColumn()
+    {
+      if (UNLIKELY(!m_inCol))
+        throw std::runtime_error("ColumnarWriter::EndColumn: No Curr Column");
+      m_inCol = false;
+
+      // All columns must be of same length:
+      if (UNLIKELY(!m_descrs.empty() &&
+                   m_curr.m_nRows != m_descrs.front().m_nRows))
+        throw std::runtime_error("ColumnarWriter::EndColumn: NRows MisMatch");
+      m_descrs.push_back(m_curr);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "WriteColumn": All of the above together:                             //
+    //-----------------------------------------------------------------------//
+    template<uint64_t E, uint64_t U>
+    void WriteColumn
+    (
+      char const*                                 a_name,
+      DimQ<E, U, RepT, Sys::MaxDims> const*       a_data,
+      size_t                                      a_n
+    )
+    {
+      BeginColumn<E, U>(a_name);
+      Append     <E, U>(a_data, a_n);
+      EndColumn();
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Close": Writes out the Descrs and the Header:                        //
+    //-----------------------------------------------------------------------//
+    void Close()
+    {
+      if (m_fd < 0)
+        return;
+      if (UNLIKELY(m_inCol))
+        throw std::runtime_error("ColumnarWriter::Close: UnFinished Column");
+
+      Align();
+      Bits::ColFileHdr hdr {};
+      memcpy(hdr.m_magic, Bits::ColFileMagic, sizeof(hdr.m_magic));
+      hdr.m_version   = Bits::ColFileVersion;
+      hdr.m_endianTag = Bits::ColFileEndianTag;
+      hdr.m_maxDims   = Sys::MaxDims;
+      hdr.m_nCols     = uint32_t(m_descrs.size());
+      hdr.m_nRows     = m_descrs.empty() ? 0 : m_descrs.front().m_nRows;
+      hdr.m_descrsOff = m_off;
+      for (unsigned dim = 0; dim < Sys::NDims; ++dim)
+        strncpy(hdr.m_dimNames[dim], Sys::Dims[dim].m_name,
+                sizeof(hdr.m_dimNames[dim]) - 1);
+
+      WriteAll(m_descrs.data(), m_descrs.size() * sizeof(Bits::ColDescr));
+      hdr.m_fileSize  = m_off;
+
+      if (UNLIKELY(pwrite(m_fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)))
+        Bits::ThrowSysErr("ColumnarWriter::Close");
+
+      int fd = m_fd;
+      m_fd   = -1;
+      if (UNLIKELY(close(fd) < 0))
+        Bits::ThrowSysErr("ColumnarWriter::Close");
+    }
+  };
+
+  //=========================================================================//
+  // "ColumnarReader":                                                       //
+  //=========================================================================//
+  // "mmap"s the whole file read-only. The Header is validated once in the Ctor;
+  // each column is validated against the requested "DimQ" type on the first
+  // "GetColumn" call for that type, subsequent calls are O(1). If the Units
+  // are those of the file, no data are touched at all, so the cost of loading
+  // is that of the page faults on actual access. Otherwise, the column is con-
+  // verted (once per Units) into a buffer owned by the reader, so all spans
+  // returned remain valid (and unchanged) for the life-time of the reader:
+  //
+  template<typename Sys>
+  class ColumnarReader
+  {
+  private:
+    using RepT = typename Sys::RepT;
+    using En   = Bits::Encodings<RepT, Sys::MaxDims>;
+
+    // A copy of a column converted into other Units:
+    struct ColConv
+    {
+      uint64_t              m_U;
+      std::vector<RepT>     m_data;
+    };
+
+    // State of a column:
+    struct ColState
+    {
+      Bits::ColDescr const* m_descr;
+      uint64_t              m_U;          // Units valid for the mapped data
+      bool                  m_checked;    // Dims validated?
+      std::vector<ColConv>  m_convs;      // Converted copies, by Units
+    };
+
+    char*                      m_base;
+    size_t                     m_size;
+    Bits::ColFileHdr const*    m_hdr;
+    std::vector<ColState>      m_cols;
+
+    [[noreturn]] static void Fail(char const* a_msg)
+    {
+      throw std::runtime_error
+        (std::string("ColumnarReader: Invalid File: ") + a_msg);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    explicit ColumnarReader(char const* a_path)
+    : m_base(nullptr),
+      m_size(0),
+      m_hdr (nullptr),
+      m_cols()
+    {
+      int fd = open(a_path, O_RDONLY | O_CLOEXEC);
+      if (UNLIKELY(fd < 0))
+        Bits::ThrowSysErr("ColumnarReader::Ctor");
+
+      struct stat st;
+      if (UNLIKELY(fstat(fd, &st) < 0))
+      {
+        close(fd);
+        Bits::ThrowSysErr("ColumnarReader::Ctor");
+      }
+      m_size = size_t(st.st_size);
+      if (UNLIKELY(m_size < sizeof(Bits::ColFileHdr)))
+      {
+        close(fd);
+        Fail("Too Short");
+      }
+      void* base =
+        mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (UNLIKELY(base == MAP_FAILED))
+        Bits::ThrowSysErr("ColumnarReader::Ctor");
+      m_base = static_cast<char*>(base);
+
+      try
+      {
+        // Validate the Header:
+        m_hdr = reinterpret_cast<Bits::ColFileHdr const*>(m_base);
+        if (memcmp(m_hdr->m_magic, Bits::ColFileMagic, 8) != 0)
+          Fail("Bad Magic");
+        if (m_hdr->m_version   != Bits::ColFileVersion)
+          Fail("UnSupported Version");
+        if (m_hdr->m_endianTag != Bits::ColFileEndianTag)
+          Fail("Wrong Endianness");
+        if (m_hdr->m_fileSize  != m_size)
+          Fail("Size MisMatch (Truncated or UnClosed?)");
+        if (m_hdr->m_maxDims   != Sys::MaxDims)
+          Fail("MaxDims MisMatch");
+        // NB: All offsets and sizes come from the file, so the checks below
+        // are arranged to be free of integer overflows:
+        if (m_hdr->m_descrsOff % alignof(Bits::ColDescr) != 0 ||
+            m_hdr->m_descrsOff > m_size                         ||
+            m_hdr->m_nCols     >
+            (m_size - m_hdr->m_descrsOff) / sizeof(Bits::ColDescr))
+          Fail("Bad Descrs Table");
+
+        auto const* descrs = reinterpret_cast<Bits::ColDescr const*>
+                             (m_base + m_hdr->m_descrsOff);
+        m_cols.resize(m_hdr->m_nCols);
+
+        for (unsigned i = 0; i < m_hdr->m_nCols; ++i)
+        {
+          Bits::ColDescr const& descr = descrs[i];
+          if (descr.m_nRows != m_hdr->m_nRows                ||
+              descr.m_dataOff % Bits::ColDataAlign != 0      ||
+              descr.m_repSize == 0                           ||
+              descr.m_dataOff > m_hdr->m_descrsOff           ||
+              descr.m_nRows   >
+              (m_hdr->m_descrsOff - descr.m_dataOff) / descr.m_repSize)
+            Fail("Bad Column Descr");
+
+          ColState& col = m_cols[i];
+          col.m_descr   = &descr;
+          col.m_U       = descr.m_U;
+          col.m_checked = false;
+        }
+      }
+      catch (...)
+      {
+        munmap(m_base, m_size);
+        throw;
+      }
+    }
+
+    ~ColumnarReader()
+      { munmap(m_base, m_size); }
+
+    ColumnarReader(ColumnarReader const&)            = delete;
+    ColumnarReader& operator=(ColumnarReader const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    unsigned    NCols() const { return m_hdr->m_nCols; }
+    uint64_t    NRows() const { return m_hdr->m_nRows; }
+
+    char const* ColName(unsigned a_col) const
+    {
+      assert(a_col < NCols());
+      return m_cols[a_col].m_descr->m_name;
+    }
+
+    // Returns -1 if not found:
+    int FindCol(char const* a_name) const
+    {
+      assert(a_name != nullptr);
+      for (unsigned i = 0; i < NCols(); ++i)
+        if (strncmp(ColName(i), a_name, sizeof(Bits::ColDescr::m_name)) == 0)
+          return int(i);
+      return -1;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "GetColumn": Typed View (Zero-Copy unless the Units are converted):   //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    std::span<DQ const> GetColumn(unsigned a_col)
+    {
+      using Tr = DimQTraits<DQ>;
+      static_assert(Tr::IsDimQ &&
+                    std::is_same_v<typename Tr::RepT, RepT> &&
+                    Tr::MaxDims == Sys::MaxDims,
+                    "ColumnarReader::GetColumn: Incompatible DimQ");
+      constexpr uint64_t E = Tr::E;
+      constexpr uint64_t U = En::CleanUpUnits(E, Tr::U);
+
+      if (UNLIKELY(a_col >= NCols()))
+        throw std::out_of_range("ColumnarReader::GetColumn: Invalid Col");
+
+      ColState&             col   = m_cols[a_col];
+      Bits::ColDescr const& descr = *col.m_descr;
+      RepT const* data =
+        reinterpret_cast<RepT const*>(m_base + descr.m_dataOff);
+      auto  res  = std::span<DQ const>
+                   (reinterpret_cast<DQ const*>(data), descr.m_nRows);
+
+      // Fast Path: Already validated for this type:
+      if (LIKELY(col.m_checked && descr.m_E == E && col.m_U == U))
+        return res;
+
+      // Otherwise, validate the Rep and Dims:
+      if (UNLIKELY(descr.m_E != E))
+        throw std::runtime_error("ColumnarReader::GetColumn: Dims MisMatch");
+
+      if (!col.m_checked)
+      {
+        if (UNLIKELY(descr.m_repCode != Bits::RepCode<RepT> ||
+                     descr.m_repSize != sizeof(RepT)))
+          throw std::runtime_error("ColumnarReader::GetColumn: RepT MisMatch");
+
+        // Dims are identified by their codes, so the names of all Dims used
+        // must be same in the writer's and the reader's "DimQ_Sys":
+        for (unsigned dim = 0; dim < Sys::MaxDims; ++dim)
+          if (En::GetFld(E, dim) != 0 &&
+              (dim >= Sys::NDims ||
+               strncmp(m_hdr->m_dimNames[dim], Sys::Dims[dim].m_name,
+                       sizeof(m_hdr->m_dimNames[dim])) != 0))
+            throw std::runtime_error
+                  ("ColumnarReader::GetColumn: Dim Names MisMatch");
+        col.m_checked = true;
+      }
+
+      // Convert the Units if the Scales differ (NB: different Unit codes with
+      // same Scales do not require any conversion):
+      double newScales[Bits::AbsMaxDims];
+      Bits::GetUnitScales<Sys>(E, U, newScales);
+
+      bool same = true;
+      for (unsigned dim = 0; dim < Sys::MaxDims; ++dim)
+        same &= (En::GetFld(E, dim) == 0 ||
+                 newScales[dim] == descr.m_scales[dim]);
+
+      if (same)
+      {
+        col.m_U = U;
+        return res;
+      }
+
+      // Re-use a previous conversion into these Units, or make a new one:
+      for (ColConv const& conv: col.m_convs)
+        if (conv.m_U == U)
+          return std::span<DQ const>
+                 (reinterpret_cast<DQ const*>(conv.m_data.data()),
+                  conv.m_data.size());
+
+      RepT factor =
+        RepT(Bits::DimsScale<double, Sys::MaxDims>(E, descr.m_scales) /
+             Bits::DimsScale<double, Sys::MaxDims>(E, newScales));
+      std::vector<RepT> conv(data, data + descr.m_nRows);
+      for (RepT& x: conv)
+        x *= factor;
+
+      // NB: Moving the vector does not move its buffer, so the spans returned
+      // earlier remain valid:
+      col.m_convs.push_back(ColConv{U, std::move(conv)});
+      return std::span<DQ const>
+             (reinterpret_cast<DQ const*>(col.m_convs.back().m_data.data()),
+              descr.m_nRows);
+    }
+
+    template<typename DQ>
+    std::span<DQ const> GetColumn(char const* a_name)
+    {
+      int col = FindCol(a_name);
+      if (UNLIKELY(col < 0))
+        throw std::out_of_range("ColumnarReader::GetColumn: No such Col");
+      return GetColumn<DQ>(unsigned(col));
+    }
+  };
+}
+// End namespace DimTypes
@@ -5,6 +5,8 @@
 //===========================================================================//
 #pragma  once
 #include "Bits/Encodings.hpp"
+#include "Bits/UnitsInfo.hpp"
+#include "Bits/BoundedPut.hpp"
 #include "Bits/Macros.h"
 
 namespace DimTypes
@@ -41,15 +43,10 @@ namespace DimTypes
     : m_val(val)
     {}
 
-    // Copy Ctor:
-    constexpr DimQ(DimQ const& a_right): m_val(a_right.m_val) {}
-
-    // Assignment:
-    constexpr DimQ& operator= (DimQ const& a_right)
-    {
-      m_val = a_right.m_val;
-      return *this;
-    }
+    // Copy Ctor and Assignment: Defaulted, so that "DimQ" remains trivially-
+    // copyable (and thus can be "memcpy"ed, "mmap"ed etc) whenever "RepT" is:
+    constexpr DimQ(DimQ const&)             = default;
+    constexpr DimQ& operator= (DimQ const&) = default;
 
     // Conversion from another Rep (but E and U must match):
     template<typename R>
@@ -309,10 +306,10 @@ namespace DimTypes
 #   undef  DIMLESS_UNARY_FUNC
 #   endif
 #   define DIMLESS_UNARY_FUNC(FuncName) \
-    constexpr DimQ<0, 0, RepT, MaxDims> FuncName(DimQ a_x) const \
+    constexpr DimQ<0, 0, RepT, MaxDims> FuncName() const \
     { \
       static_assert(E==0, "ERROR: " #FuncName ": Must be DimLess"); \
-      return  DimQ<0, 0, RepT, MaxDims>(Bits::CEMaths::FuncName(a_x.m_val)); \
+      return  DimQ<0, 0, RepT, MaxDims>(Bits::CEMaths::FuncName(m_val)); \
     }
     DIMLESS_UNARY_FUNC(Exp)
     DIMLESS_UNARY_FUNC(Log)
@@ -396,6 +393,38 @@ namespace DimTypes
   };
   // End "DimQ" class
 
+  //=========================================================================//
+  // "DimQTraits", "IsDimQ":                                                 //
+  //=========================================================================//
+  // Compile-time access to the template params of a "DimQ" type;  useful for
+  // generic code operating on arrays and columns of "DimQ"s:
+  //
+  template<typename T>
+  struct DimQTraits
+  {
+    constexpr static bool IsDimQ = false;
+  };
+
+  template<uint64_t E_, uint64_t U_, typename RepT_, unsigned MaxDims_>
+  struct DimQTraits<DimQ<E_, U_, RepT_, MaxDims_>>
+  {
+    constexpr static bool     IsDimQ  = true;
+    constexpr static uint64_t E       = E_;
+    constexpr static uint64_t U       = U_;
+    using                     RepT    = RepT_;
+    constexpr static unsigned MaxDims = MaxDims_;
+  };
+
+  template<typename T>
+  inline constexpr bool IsDimQ = DimQTraits<T>::IsDimQ;
+
+  // "DimQ" has exactly the same layout as its "RepT", so arrays of "DimQ"s can
+  // be viewed as arrays of "RepT"s (and vice versa) without any copying:
+  static_assert(sizeof (DimQ<0, 0, double, Bits::DefMaxDims>) == sizeof (double)
+             && alignof(DimQ<0, 0, double, Bits::DefMaxDims>) == alignof(double)
+             && std::is_trivially_copyable_v
+                      <DimQ<0, 0, double, Bits::DefMaxDims>>);
+
   //=========================================================================//
   // Syntactic Sugar: Above methods in Prefix notation:                      //
   //=========================================================================//
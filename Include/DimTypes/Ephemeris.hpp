@@ -0,0 +1,619 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "DimTypes/Ephemeris.hpp":                         //
+//      JPL DE Binary Ephemerides: "mmap" Reader and Batch Evaluation        //
+//===========================================================================//
+// "DEEphemeris" reads the JPL DE binary files (eg "linux_p1550p2650.430") in
+// the native byte order: the file is "mmap"ed, the Header is validated once
+// in the Ctor, and the data records are then accessed in place.
+// Each record covers a fixed interval of JDs (TDB); for each body, it holds
+// the Chebyshev coefficients of the X, Y, Z position components (in km) over
+// a number of equal sub-intervals. The positions are the sums of the Chebyshev
+// series, and the velocities (km/day) are the sums of their derivatives.
+// For batches of epochs ("GetPos", "GetPosVel"):
+// (*) the segment (record and sub-interval) lookups are cached from one epoch
+//     to the next, so for sorted or clustered epochs they are mostly skipped;
+// (*) with AVX2, 4 epochs are evaluated at a time, the Chebyshev recurrences
+//     (for T_k and T_k') running in the SIMD lanes; if all 4 epochs are in the
+//     same segment (the common case), the coefficients are just broadcast.
+// The results are "Vec3"s of the "DimQ" types chosen by the caller; the Units
+// conversion factors from km and km/day are computed at compile time (by
+// "ConstUnitsConvFactor") and folded into the evaluation.
+// The template params "Km" and "Day" are the "DimQ" types of the km and the
+// day in the caller's Dims System "Sys" (eg "Len_km", "Time_day"):
+//
+#pragma  once
+#include "Vec3.hpp"
+#include "Bits/FileIO.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "DEBody":                                                               //
+  //=========================================================================//
+  // The bodies, in the order of the DE Header pointers.  All positions are
+  // relative to the Solar System Barycenter, except for the "Moon",  which is
+  // geocentric. "Earth" is not stored in the files; it is derived from "EMB"
+  // (the Earth-Moon Barycenter) and the "Moon":
+  //
+  enum class DEBody: unsigned
+  {
+    Mercury = 0,
+    Venus   = 1,
+    EMB     = 2,
+    Mars    = 3,
+    Jupiter = 4,
+    Saturn  = 5,
+    Uranus  = 6,
+    Neptune = 7,
+    Pluto   = 8,
+    Moon    = 9,
+    Sun     = 10,
+    Earth   = 11
+  };
+
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // DE Header Layout:                                                       //
+  //-------------------------------------------------------------------------//
+  // Byte offsets in the 1st record:  3 title lines (84 chars each), 400 const
+  // names (6 chars each), SS[3] (start JD, end JD, record interval in days),
+  // NCON, AU (km), EMRAT, IPT[12][3], DENUM, LPT[3]; if NCON > 400, the extra
+  // const names follow:
+  //
+  constexpr inline size_t DEOffNames   = 252;
+  constexpr inline size_t DEOffSS      = 2652;
+  constexpr inline size_t DEOffNCon    = 2676;
+  constexpr inline size_t DEOffAU      = 2680;
+  constexpr inline size_t DEOffEMRat   = 2688;
+  constexpr inline size_t DEOffIPT     = 2696;
+  constexpr inline size_t DEOffDENum   = 2840;
+  constexpr inline size_t DEOffLPT     = 2844;
+  constexpr inline size_t DEOffXNames  = 2856;
+  constexpr inline size_t DEHdrSize    = 2856;
+  constexpr inline size_t DENameLen    = 6;
+  constexpr inline unsigned DENSeries  = 13;   // 11 bodies, nutations, libr
+
+  template<typename T>
+  inline T DELoad(char const* a_base, size_t a_off)
+  {
+    T res;
+    memcpy(&res, a_base + a_off, sizeof(T));
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "DESeg": A Cached Segment (Sub-Interval of a Record) of one Series:     //
+  //-------------------------------------------------------------------------//
+  struct DESeg
+  {
+    double        m_from;     // Sub-interval [m_from, m_to)
+    double        m_to;
+    double        m_scale;    // 2 / (sub-interval length)
+    double const* m_coeffs;   // [3][NCoeffs]: X, Y, Z
+  };
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "DEEphemeris":                                                          //
+  //=========================================================================//
+  template<typename Sys, typename Km, typename Day>
+  class DEEphemeris
+  {
+  private:
+    using KmTr  = DimQTraits<Km>;
+    using DayTr = DimQTraits<Day>;
+    static_assert(KmTr::IsDimQ && DayTr::IsDimQ && KmTr::E != DayTr::E,
+                  "DEEphemeris: Km and Day must be DimQs of different Dims");
+    static_assert(std::is_same_v<typename Sys::RepT, double>,
+                  "DEEphemeris: RepT must be double");
+
+    using KmPerDay = decltype(std::declval<Km>() / std::declval<Day>());
+    using KpDTr    = DimQTraits<KmPerDay>;
+
+    struct Series
+    {
+      unsigned m_off;       // 0-based offset in a record (in doubles)
+      unsigned m_nCoeffs;   // Per component
+      unsigned m_nSubs;     // Number of sub-intervals
+    };
+
+    char const*   m_base;
+    size_t        m_size;
+    double const* m_recs;      // Data records
+    size_t        m_recLen;    // Record length (in doubles)
+    size_t        m_nRecs;
+    double        m_start;
+    double        m_end;
+    double        m_step;
+    unsigned      m_nCon;
+    int           m_deNum;
+    double        m_au;
+    double        m_emRat;
+    Series        m_series[Bits::DENSeries];
+
+    [[noreturn]] static void Fail(char const* a_msg)
+    {
+      throw std::runtime_error
+        (std::string("DEEphemeris: Invalid File: ") + a_msg);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    explicit DEEphemeris(char const* a_path)
+    : m_base(nullptr),
+      m_size(0)
+    {
+      int fd = open(a_path, O_RDONLY | O_CLOEXEC);
+      if (UNLIKELY(fd < 0))
+        Bits::ThrowSysErr("DEEphemeris::Ctor");
+
+      struct stat st;
+      if (UNLIKELY(fstat(fd, &st) < 0))
+      {
+        close(fd);
+        Bits::ThrowSysErr("DEEphemeris::Ctor");
+      }
+      m_size = size_t(st.st_size);
+      if (UNLIKELY(m_size < Bits::DEHdrSize))
+      {
+        close(fd);
+        Fail("Too Short");
+      }
+      void* base = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (UNLIKELY(base == MAP_FAILED))
+        Bits::ThrowSysErr("DEEphemeris::Ctor");
+      m_base = static_cast<char const*>(base);
+
+      try
+      {
+        using Bits::DELoad;
+        m_start = DELoad<double>  (m_base, Bits::DEOffSS);
+        m_end   = DELoad<double>  (m_base, Bits::DEOffSS + 8);
+        m_step  = DELoad<double>  (m_base, Bits::DEOffSS + 16);
+        m_nCon  = DELoad<unsigned>(m_base, Bits::DEOffNCon);
+        m_au    = DELoad<double>  (m_base, Bits::DEOffAU);
+        m_emRat = DELoad<double>  (m_base, Bits::DEOffEMRat);
+        m_deNum = DELoad<int>     (m_base, Bits::DEOffDENum);
+
+        // The same checks also detect files in the wrong byte order:
+        if (!(m_step > 0.0 && m_end > m_start) || m_nCon > 10000 ||
+            m_deNum <= 0   || m_deNum > 10000  || !(m_emRat > 0.0))
+          Fail("Bad Header (Wrong Endianness?)");
+
+        // Series pointers (1-based offsets in the Header):
+        for (unsigned i = 0; i < Bits::DENSeries; ++i)
+        {
+          size_t off = (i < 12) ? (Bits::DEOffIPT + 12 * i) : Bits::DEOffLPT;
+          int ipt[3];
+          for (unsigned j = 0; j < 3; ++j)
+            ipt[j] = DELoad<int>(m_base, off + 4 * j);
+          if (ipt[0] < 0 || ipt[1] < 0 || ipt[2] < 0)
+            Fail("Bad Series Ptrs");
+          m_series[i] = Series{ unsigned(ipt[0] > 0 ? ipt[0] - 1 : 0),
+                                unsigned(ipt[1]), unsigned(ipt[2]) };
+        }
+
+        // The record length follows from the file size, as the files consist
+        // of exactly 2 Header records and the data records for [start, end]:
+        double nRecs = (m_end - m_start) / m_step;
+        m_nRecs      = size_t(nRecs + 0.5);
+        if (m_nRecs == 0 || std::abs(nRecs - double(m_nRecs)) > 1e-9 ||
+            m_size % ((m_nRecs + 2) * sizeof(double)) != 0)
+          Fail("Size MisMatch");
+        m_recLen = m_size / ((m_nRecs + 2) * sizeof(double));
+
+        for (unsigned i = 0; i < Bits::DENSeries; ++i)
+        {
+          Series const& s = m_series[i];
+          if (s.m_nCoeffs == 0)
+            continue;
+          unsigned nComps = (i == 11) ? 2 : 3;
+          if (s.m_off < 2 || s.m_nCoeffs < 2 || s.m_nSubs == 0 ||
+              s.m_off + size_t(s.m_nCoeffs) * s.m_nSubs * nComps > m_recLen)
+            Fail("Bad Series Ptrs");
+        }
+        if (m_recLen * sizeof(double) < Bits::DEHdrSize +
+            (m_nCon > 400 ? (m_nCon - 400) * Bits::DENameLen : 0) ||
+            m_recLen < m_nCon)
+          Fail("Bad Record Length");
+
+        m_recs = reinterpret_cast<double const*>(m_base) + 2 * m_recLen;
+        if (m_recs[0] != m_start || m_recs[1] != m_start + m_step)
+          Fail("Bad 1st Record");
+      }
+      catch (...)
+      {
+        munmap(const_cast<char*>(m_base), m_size);
+        throw;
+      }
+    }
+
+    ~DEEphemeris()
+      { munmap(const_cast<char*>(m_base), m_size); }
+
+    DEEphemeris(DEEphemeris const&)            = delete;
+    DEEphemeris& operator=(DEEphemeris const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    int    DENum()   const { return m_deNum; }
+    double StartJD() const { return m_start; }
+    double EndJD()   const { return m_end;   }
+    Km     AU()      const { return Km(m_au); }
+    double EMRat()   const { return m_emRat; }
+
+    // The val of a named const (eg "GMS", "CLIGHT"); throws if not found:
+    double GetConst(char const* a_name) const
+    {
+      size_t len = strlen(a_name);
+      for (unsigned i = 0; len <= Bits::DENameLen && i < m_nCon; ++i)
+      {
+        char const* name =
+          m_base + Bits::DENameLen * i +
+          ((i < 400) ? Bits::DEOffNames
+                     : (Bits::DEOffXNames - 400 * Bits::DENameLen));
+        if (memcmp(name, a_name, len) != 0)
+          continue;
+        bool padded = true;
+        for (size_t j = len; j < Bits::DENameLen; ++j)
+          padded &= (name[j] == ' ');
+        if (padded)
+          return Bits::DELoad<double>
+                 (m_base, (m_recLen + i) * sizeof(double));
+      }
+      throw std::invalid_argument
+            (std::string("DEEphemeris::GetConst: Not Found: ") + a_name);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Batch Evaluation:                                                     //
+    //-----------------------------------------------------------------------//
+    // "a_jds" are the epochs (JD, TDB); throws "std::out_of_range" if any of
+    // them are outside [StartJD, EndJD]:
+    //
+    template<typename PosDQ>
+    void GetPos(DEBody a_body, double const* a_jds, size_t a_n,
+                Vec3<PosDQ>* a_pos) const
+    {
+      constexpr double PosF = PosFactor<PosDQ>();
+      Get<PosF, 0.0, PosDQ, PosDQ>(a_body, a_jds, a_n, a_pos, nullptr);
+    }
+
+    template<typename PosDQ, typename VelDQ>
+    void GetPosVel(DEBody a_body, double const* a_jds, size_t a_n,
+                   Vec3<PosDQ>* a_pos, Vec3<VelDQ>* a_vel) const
+    {
+      constexpr double PosF = PosFactor<PosDQ>();
+      constexpr double VelF = VelFactor<VelDQ>();
+      Get<PosF, VelF, PosDQ, VelDQ>(a_body, a_jds, a_n, a_pos, a_vel);
+    }
+
+    // Single epochs:
+    template<typename PosDQ>
+    Vec3<PosDQ> GetPos(DEBody a_body, double a_jd) const
+    {
+      Vec3<PosDQ> pos;
+      GetPos(a_body, &a_jd, 1, &pos);
+      return pos;
+    }
+
+    template<typename PosDQ, typename VelDQ>
+    std::pair<Vec3<PosDQ>, Vec3<VelDQ>> GetPosVel
+      (DEBody a_body, double a_jd) const
+    {
+      Vec3<PosDQ> pos;
+      Vec3<VelDQ> vel;
+      GetPosVel(a_body, &a_jd, 1, &pos, &vel);
+      return {pos, vel};
+    }
+
+  private:
+    //-----------------------------------------------------------------------//
+    // Compile-Time Units Conversion Factors:                                //
+    //-----------------------------------------------------------------------//
+    template<typename PosDQ>
+    constexpr static double PosFactor()
+    {
+      using Tr = DimQTraits<PosDQ>;
+      static_assert(Tr::IsDimQ && Tr::E == KmTr::E,
+                    "DEEphemeris: Position must be a Len DimQ");
+      return Bits::ConstUnitsConvFactor<Sys>(Tr::E, KmTr::U, Tr::U);
+    }
+
+    template<typename VelDQ>
+    constexpr static double VelFactor()
+    {
+      using Tr = DimQTraits<VelDQ>;
+      static_assert(Tr::IsDimQ && Tr::E == KpDTr::E,
+                    "DEEphemeris: Velocity must be a Len/Time DimQ");
+      return Bits::ConstUnitsConvFactor<Sys>(Tr::E, KpDTr::U, Tr::U);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Lookup": Finds the segment of Series "a_s" containing "a_jd":        //
+    //-----------------------------------------------------------------------//
+    void Lookup(Series const& a_s, double a_jd, Bits::DESeg* a_seg) const
+    {
+      if (UNLIKELY(!(a_jd >= m_start && a_jd <= m_end)))
+        throw std::out_of_range("DEEphemeris: Epoch out of range");
+
+      size_t rec = std::min(size_t((a_jd - m_start) / m_step), m_nRecs - 1);
+      double const* r      = m_recs + rec * m_recLen;
+      double        subLen = (r[1] - r[0]) / double(a_s.m_nSubs);
+      unsigned      sub    = std::min(unsigned((a_jd - r[0]) / subLen),
+                                      a_s.m_nSubs - 1);
+      a_seg->m_from   = r[0] + double(sub) * subLen;
+      a_seg->m_to     = (sub + 1 == a_s.m_nSubs)
+                        ? r[1] : (a_seg->m_from + subLen);
+      a_seg->m_scale  = 2.0 / subLen;
+      a_seg->m_coeffs = r + a_s.m_off + size_t(sub) * 3 * a_s.m_nCoeffs;
+    }
+
+    // Cached version:
+    void Lookup(Series const& a_s, double a_jd, Bits::DESeg* a_seg,
+                bool* a_valid) const
+    {
+      if (!(*a_valid && a_jd >= a_seg->m_from && a_jd < a_seg->m_to))
+      {
+        Lookup(a_s, a_jd, a_seg);
+        *a_valid = true;
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "EvalOne": Scalar Chebyshev Evaluation of a Single Epoch:             //
+    //-----------------------------------------------------------------------//
+    template<bool WithVel>
+    static void EvalOne(Bits::DESeg const& a_seg, unsigned a_nc, double a_jd,
+                        double* a_pos, double* a_vel)
+    {
+      double        t  = (a_jd - a_seg.m_from) * a_seg.m_scale - 1.0;
+      double const* cx = a_seg.m_coeffs;
+      double const* cy = cx + a_nc;
+      double const* cz = cy + a_nc;
+
+      double t0 = 1.0, t1 = t, v0 = 0.0, v1 = 1.0;
+      double px = cx[0] + cx[1] * t,  py = cy[0] + cy[1] * t,
+             pz = cz[0] + cz[1] * t;
+      double vx = cx[1], vy = cy[1], vz = cz[1];
+      for (unsigned k = 2; k < a_nc; ++k)
+      {
+        double t2 = 2.0 * t * t1 - t0;
+        px += cx[k] * t2;
+        py += cy[k] * t2;
+        pz += cz[k] * t2;
+        if constexpr (WithVel)
+        {
+          double v2 = 2.0 * t1 + 2.0 * t * v1 - v0;
+          vx += cx[k] * v2;
+          vy += cy[k] * v2;
+          vz += cz[k] * v2;
+          v0 = v1;
+          v1 = v2;
+        }
+        t0 = t1;
+        t1 = t2;
+      }
+      a_pos[0] = px;
+      a_pos[1] = py;
+      a_pos[2] = pz;
+      if constexpr (WithVel)
+      {
+        a_vel[0] = vx * a_seg.m_scale;
+        a_vel[1] = vy * a_seg.m_scale;
+        a_vel[2] = vz * a_seg.m_scale;
+      }
+    }
+
+#   if defined(__AVX2__)
+    //-----------------------------------------------------------------------//
+    // "Eval4": SIMD Chebyshev Evaluation of 4 Epochs:                       //
+    //-----------------------------------------------------------------------//
+    // If "Same", all 4 epochs are in the segment "a_segs[0]":
+    //
+    template<bool WithVel, bool Same>
+    static void Eval4(Bits::DESeg const* a_segs, unsigned a_nc,
+                      double const* a_jds, __m256d* a_pos, __m256d* a_vel)
+    {
+      __m256d from, scale;
+      if constexpr (Same)
+      {
+        from  = _mm256_set1_pd(a_segs[0].m_from);
+        scale = _mm256_set1_pd(a_segs[0].m_scale);
+      }
+      else
+      {
+        from  = _mm256_setr_pd(a_segs[0].m_from,  a_segs[1].m_from,
+                               a_segs[2].m_from,  a_segs[3].m_from);
+        scale = _mm256_setr_pd(a_segs[0].m_scale, a_segs[1].m_scale,
+                               a_segs[2].m_scale, a_segs[3].m_scale);
+      }
+      __m256d const one = _mm256_set1_pd(1.0);
+      __m256d const two = _mm256_set1_pd(2.0);
+      __m256d t   = _mm256_sub_pd
+                    (_mm256_mul_pd
+                      (_mm256_sub_pd(_mm256_loadu_pd(a_jds), from), scale),
+                     one);
+      __m256d t2x = _mm256_mul_pd(two, t);
+
+      // The coeff "k" of the component "c", in all lanes:
+      auto coeff = [a_segs, a_nc](unsigned a_c, unsigned a_k) -> __m256d
+      {
+        size_t j = size_t(a_c) * a_nc + a_k;
+        if constexpr (Same)
+          return _mm256_set1_pd(a_segs[0].m_coeffs[j]);
+        else
+          return _mm256_setr_pd(a_segs[0].m_coeffs[j], a_segs[1].m_coeffs[j],
+                                a_segs[2].m_coeffs[j], a_segs[3].m_coeffs[j]);
+      };
+
+      __m256d t0 = one, t1 = t, v0 = _mm256_setzero_pd(), v1 = one;
+      for (unsigned c = 0; c < 3; ++c)
+      {
+        a_pos[c] = _mm256_add_pd(coeff(c, 0), _mm256_mul_pd(coeff(c, 1), t));
+        if constexpr (WithVel)
+          a_vel[c] = coeff(c, 1);
+      }
+      for (unsigned k = 2; k < a_nc; ++k)
+      {
+        __m256d tk = _mm256_sub_pd(_mm256_mul_pd(t2x, t1), t0);
+        __m256d vk;
+        if constexpr (WithVel)
+          vk = _mm256_sub_pd
+               (_mm256_add_pd(_mm256_mul_pd(two, t1), _mm256_mul_pd(t2x, v1)),
+                v0);
+        for (unsigned c = 0; c < 3; ++c)
+        {
+          __m256d ck = coeff(c, k);
+          a_pos[c]   = _mm256_add_pd(a_pos[c], _mm256_mul_pd(ck, tk));
+          if constexpr (WithVel)
+            a_vel[c] = _mm256_add_pd(a_vel[c], _mm256_mul_pd(ck, vk));
+        }
+        if constexpr (WithVel)
+        {
+          v0 = v1;
+          v1 = vk;
+        }
+        t0 = t1;
+        t1 = tk;
+      }
+      if constexpr (WithVel)
+        for (unsigned c = 0; c < 3; ++c)
+          a_vel[c] = _mm256_mul_pd(a_vel[c], scale);
+    }
+#   endif
+
+    //-----------------------------------------------------------------------//
+    // "EvalSeries": A Batch for a Single Series, in km and km/day:          //
+    //-----------------------------------------------------------------------//
+    // The results are multiplied by "PosF" and "VelF", and stored via "a_put"
+    // ("a_put(i, pos[3], vel[3])"):
+    //
+    template<bool WithVel, typename Put>
+    void EvalSeries(unsigned a_i, double const* a_jds, size_t a_n,
+                    Put const& a_put) const
+    {
+      Series const& s = m_series[a_i];
+      if (UNLIKELY(s.m_nCoeffs == 0))
+        throw std::invalid_argument("DEEphemeris: Body not in the file");
+
+      Bits::DESeg seg;
+      bool        valid = false;
+      size_t      i     = 0;
+#     if defined(__AVX2__)
+      {
+        Bits::DESeg   segs[4];
+        __m256d       pos [3], vel[3];
+        alignas(32) double p[3][4], v[3][4] = {};
+        for (; i + 4 <= a_n; i += 4)
+        {
+          Lookup(s, a_jds[i], &seg, &valid);
+          bool same = true;
+          for (unsigned l = 1; l < 4; ++l)
+            same &= (a_jds[i + l] >= seg.m_from && a_jds[i + l] < seg.m_to);
+          if (LIKELY(same))
+          {
+            segs[0] = seg;
+            Eval4<WithVel, true> (segs, s.m_nCoeffs, a_jds + i, pos, vel);
+          }
+          else
+          {
+            segs[0] = seg;
+            for (unsigned l = 1; l < 4; ++l)
+            {
+              Lookup(s, a_jds[i + l], &seg, &valid);
+              segs[l] = seg;
+            }
+            Eval4<WithVel, false>(segs, s.m_nCoeffs, a_jds + i, pos, vel);
+          }
+          for (unsigned c = 0; c < 3; ++c)
+          {
+            _mm256_store_pd(p[c], pos[c]);
+            if constexpr (WithVel)
+              _mm256_store_pd(v[c], vel[c]);
+          }
+          for (unsigned l = 0; l < 4; ++l)
+          {
+            double pl[3] = { p[0][l], p[1][l], p[2][l] };
+            double vl[3] = { v[0][l], v[1][l], v[2][l] };
+            a_put(i + l, pl, vl);
+          }
+        }
+      }
+#     endif
+      for (; i < a_n; ++i)
+      {
+        double pl[3], vl[3];
+        Lookup(s, a_jds[i], &seg, &valid);
+        EvalOne<WithVel>(seg, s.m_nCoeffs, a_jds[i], pl, vl);
+        a_put(i, pl, vl);
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Get": Common Impl of "GetPos" and "GetPosVel":                       //
+    //-----------------------------------------------------------------------//
+    template<double PosF, double VelF, typename PosDQ, typename VelDQ>
+    void Get(DEBody a_body, double const* a_jds, size_t a_n,
+             Vec3<PosDQ>* a_pos, Vec3<VelDQ>* a_vel) const
+    {
+      constexpr bool WithVel = (VelF != 0.0);
+      assert(a_jds != nullptr && a_pos != nullptr &&
+             (!WithVel || a_vel != nullptr));
+
+      auto put = [a_pos, a_vel](size_t a_j, double const* a_p,
+                                double const* a_v)
+      {
+        for (unsigned c = 0; c < 3; ++c)
+        {
+          a_pos[a_j].m_c[c] = PosDQ(a_p[c] * PosF);
+          if constexpr (WithVel)
+            a_vel[a_j].m_c[c] = VelDQ(a_v[c] * VelF);
+        }
+      };
+      unsigned body = unsigned(a_body);
+      if (body < 11)
+      {
+        EvalSeries<WithVel>(body, a_jds, a_n, put);
+        return;
+      }
+      if (UNLIKELY(a_body != DEBody::Earth))
+        throw std::invalid_argument("DEEphemeris: Invalid Body");
+
+      // Earth = EMB - Moon / (1 + EMRAT):
+      EvalSeries<WithVel>(unsigned(DEBody::EMB), a_jds, a_n, put);
+      double const mf = 1.0 / (1.0 + m_emRat);
+      EvalSeries<WithVel>
+        (unsigned(DEBody::Moon), a_jds, a_n,
+         [a_pos, a_vel, mf](size_t a_j, double const* a_p, double const* a_v)
+         {
+           for (unsigned c = 0; c < 3; ++c)
+           {
+             a_pos[a_j].m_c[c] -= PosDQ(a_p[c] * (mf * PosF));
+             if constexpr (WithVel)
+               a_vel[a_j].m_c[c] -= VelDQ(a_v[c] * (mf * VelF));
+           }
+         });
+    }
+  };
+}
+// End namespace DimTypes
@@ -0,0 +1,355 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/ExactSum.hpp":                         //
+//    Reproducible (Order-Independent) Summation via a Superaccumulator      //
+//===========================================================================//
+// "Sum" in "Reductions.hpp" is deterministic for a FIXED chunking of a given
+// array, but the result of a floating-point sum in general depends on the ord-
+// er of additions. "ReproAcc<DQ>" and "ExactSum" are fully order-independent:
+// they accumulate the EXACT sum of "float" or "double" vals in a fixed-point
+// "superaccumulator" (after R. M. Neal, "Fast Exact Summation Using Small and
+// Large Superaccumulators", 2015), which covers the whole exponent range of
+// "double" in 67 signed 64-bit "chunks" of 32 bits each, with deferred carry
+// propagation (once per "SuperAccBatch" additions). Addition of a val is two
+// integer additions; since integer addition is associative, the accumulator
+// state (and the result, which is the exact sum correctly rounded to "double")
+// does not depend on the order of the vals, on the number of threads, on the
+// way partial accumulators are merged, or on the instruction set. The AVX2
+// kernel decomposes 4 vals at a time into chunk indices and 32-bit limbs.
+// "float" vals are accumulated exactly as well; their sum is rounded to
+// "double" and then to "float".
+// Inf and NaN vals are counted separately: the result is NaN if there were
+// NaNs, or Infs of both signs; otherwise it is +-Inf if there were Infs:
+//
+#pragma  once
+#include "Reductions.hpp"
+#include <bit>
+#include <cmath>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // "SuperAcc":                                                             //
+  //=========================================================================//
+  // The chunk "i" has the weight 2^(32*i - 1075), so the LSB of chunk 0 is the
+  // smallest subnormal "double" 2^(-1074) times 1/2; the top chunks only rec-
+  // eive carries:
+  //
+  constexpr inline unsigned SuperAccChunks = 67;
+  constexpr inline unsigned SuperAccBatch  = 512;   // Adds between carries
+
+  struct SuperAcc
+  {
+    int64_t  m_chunks[SuperAccChunks] = {};
+    unsigned m_pending = 0;     // Adds since the last carry propagation
+    bool     m_nan     = false;
+    bool     m_posInf  = false;
+    bool     m_negInf  = false;
+
+    //-----------------------------------------------------------------------//
+    // "Normalize": Propagates the carries:                                  //
+    //-----------------------------------------------------------------------//
+    // Afterwards, all chunks except the top one are in [0, 2^32):
+    //
+    void Normalize()
+    {
+      for (unsigned i = 0; i < SuperAccChunks - 1; ++i)
+      {
+        int64_t c          = m_chunks[i] >> 32;    // Arithmetic shift
+        m_chunks[i]       -= c * (int64_t(1) << 32);
+        m_chunks[i + 1]   += c;
+      }
+      m_pending = 0;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "AddSpecial": Inf or NaN:                                             //
+    //-----------------------------------------------------------------------//
+    void AddSpecial(double a_x)
+    {
+      if (std::isnan(a_x))
+        m_nan    = true;
+      else
+      if (a_x > 0.0)
+        m_posInf = true;
+      else
+        m_negInf = true;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "AddBits": A finite val, given by its bit pattern:                    //
+    //-----------------------------------------------------------------------//
+    void AddBits(uint64_t a_bits)
+    {
+      unsigned exp  = unsigned(a_bits >> 52) & 0x7ffU;
+      int64_t  mant = int64_t(a_bits & ((uint64_t(1) << 52) - 1));
+      if (exp != 0)
+        mant |= int64_t(1) << 52;
+      else
+        exp   = 1;                                 // Subnormal
+      unsigned idx  = exp >> 5;
+      unsigned low  = exp & 31;
+      int64_t  lo   = int64_t((uint64_t(mant) << low) & 0xffffffffU);
+      int64_t  hi   = mant >> (32 - low);
+      if (int64_t(a_bits) < 0)
+      {
+        m_chunks[idx]     -= lo;
+        m_chunks[idx + 1] -= hi;
+      }
+      else
+      {
+        m_chunks[idx]     += lo;
+        m_chunks[idx + 1] += hi;
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Add": A single val:                                                  //
+    //-----------------------------------------------------------------------//
+    void Add(double a_x)
+    {
+      if (UNLIKELY(!std::isfinite(a_x)))
+      {
+        AddSpecial(a_x);
+        return;
+      }
+      AddBits(std::bit_cast<uint64_t>(a_x));
+      if (UNLIKELY(++m_pending >= SuperAccBatch))
+        Normalize();
+    }
+
+    //-----------------------------------------------------------------------//
+    // "AddBlock": Up to "SuperAccBatch" vals (w/o carry propagation):       //
+    //-----------------------------------------------------------------------//
+    template<typename F>
+    void AddBlock(F const* a_x, size_t a_n)
+    {
+      assert(a_n <= SuperAccBatch);
+      size_t i = 0;
+#     if defined(__AVX2__)
+      {
+        __m256i const expMask  = _mm256_set1_epi64x(0x7ff);
+        __m256i const mantMask = _mm256_set1_epi64x((int64_t(1) << 52) - 1);
+        __m256i const implicit = _mm256_set1_epi64x(int64_t(1) << 52);
+        __m256i const one      = _mm256_set1_epi64x(1);
+        __m256i const low5     = _mm256_set1_epi64x(31);
+        __m256i const low32    = _mm256_set1_epi64x(0xffffffff);
+        __m256i const c32      = _mm256_set1_epi64x(32);
+        __m256i const zero     = _mm256_setzero_si256();
+        alignas(32) int64_t idx[4], lo[4], hi[4];
+
+        for (; i + 4 <= a_n; i += 4)
+        {
+          __m256i b;
+          if constexpr (std::is_same_v<F, double>)
+            b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a_x + i));
+          else
+            b = _mm256_castpd_si256(_mm256_cvtps_pd(_mm_loadu_ps(a_x + i)));
+          __m256i e   = _mm256_and_si256(_mm256_srli_epi64(b, 52), expMask);
+          if (UNLIKELY(!_mm256_testz_si256
+                        (_mm256_cmpeq_epi64(e, expMask),
+                         _mm256_set1_epi64x(-1))))
+          {
+            // Some Inf or NaN: process this group in the scalar way:
+            for (size_t j = i; j < i + 4; ++j)
+              if (std::isfinite(double(a_x[j])))
+                AddBits(std::bit_cast<uint64_t>(double(a_x[j])));
+              else
+                AddSpecial(double(a_x[j]));
+            continue;
+          }
+          __m256i isSub = _mm256_cmpeq_epi64(e, zero);
+          __m256i m     = _mm256_or_si256
+                          (_mm256_and_si256(b, mantMask),
+                           _mm256_andnot_si256(isSub, implicit));
+          e             = _mm256_or_si256(e, _mm256_and_si256(isSub, one));
+          __m256i lw    = _mm256_and_si256(e, low5);
+          __m256i l     = _mm256_and_si256(_mm256_sllv_epi64(m, lw), low32);
+          __m256i h     = _mm256_srlv_epi64(m, _mm256_sub_epi64(c32, lw));
+          // Apply the signs: (x ^ s) - s, where "s" is 0 or -1:
+          __m256i s     = _mm256_cmpgt_epi64(zero, b);
+          l = _mm256_sub_epi64(_mm256_xor_si256(l, s), s);
+          h = _mm256_sub_epi64(_mm256_xor_si256(h, s), s);
+
+          _mm256_store_si256(reinterpret_cast<__m256i*>(idx),
+                             _mm256_srli_epi64(e, 5));
+          _mm256_store_si256(reinterpret_cast<__m256i*>(lo), l);
+          _mm256_store_si256(reinterpret_cast<__m256i*>(hi), h);
+          for (int j = 0; j < 4; ++j)
+          {
+            m_chunks[idx[j]]     += lo[j];
+            m_chunks[idx[j] + 1] += hi[j];
+          }
+        }
+      }
+#     endif
+      for (; i < a_n; ++i)
+      {
+        double x = double(a_x[i]);
+        if (LIKELY(std::isfinite(x)))
+          AddBits(std::bit_cast<uint64_t>(x));
+        else
+          AddSpecial(x);
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "AddArray":                                                           //
+    //-----------------------------------------------------------------------//
+    template<typename F>
+    void AddArray(F const* a_x, size_t a_n)
+    {
+      if (m_pending != 0)
+        Normalize();
+      for (size_t i = 0; i < a_n; i += SuperAccBatch)
+      {
+        AddBlock(a_x + i, std::min<size_t>(SuperAccBatch, a_n - i));
+        Normalize();
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Merge":                                                              //
+    //-----------------------------------------------------------------------//
+    void Merge(SuperAcc const& a_right)
+    {
+      SuperAcc right = a_right;
+      right.Normalize();
+      Normalize();
+      for (unsigned i = 0; i < SuperAccChunks; ++i)
+        m_chunks[i] += right.m_chunks[i];
+      Normalize();
+      m_nan    = m_nan    || a_right.m_nan;
+      m_posInf = m_posInf || a_right.m_posInf;
+      m_negInf = m_negInf || a_right.m_negInf;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Result": The exact sum, correctly rounded to "double":               //
+    //-----------------------------------------------------------------------//
+    double Result() const
+    {
+      if (m_nan || (m_posInf && m_negInf))
+        return CEMaths::NaN<double>;
+      if (m_posInf)
+        return  CEMaths::Inf<double>;
+      if (m_negInf)
+        return -CEMaths::Inf<double>;
+
+      SuperAcc acc = *this;
+      acc.Normalize();
+      // The sign is that of the top chunk; for a negative sum, negate all
+      // chunks and re-normalize, so that all of them become non-negative:
+      bool neg = acc.m_chunks[SuperAccChunks - 1] < 0;
+      if (neg)
+      {
+        for (int64_t& c: acc.m_chunks)
+          c = -c;
+        acc.Normalize();
+      }
+      int h = int(SuperAccChunks) - 1;
+      while (h >= 0 && acc.m_chunks[h] == 0)
+        --h;
+      if (h < 0)
+        return 0.0;
+
+      // Take the 3 top chunks (at most 96 bits, as the top one is small), and
+      // reduce them to 64 bits with a "sticky" LSB, so that the conversion
+      // into "double" (with its 53-bit mantissa) rounds correctly:
+      int      base = std::max(h - 2, 0);
+      unsigned __int128 v = 0;
+      for (int i = h; i >= base; --i)
+        v = (v << 32) | uint64_t(acc.m_chunks[i]);
+      bool sticky = false;
+      for (int i = 0; i < base; ++i)
+        sticky = sticky || (acc.m_chunks[i] != 0);
+
+      int nbits = 128 - ((uint64_t(v >> 64) != 0)
+                         ? std::countl_zero(uint64_t(v >> 64))
+                         : 64 + std::countl_zero(uint64_t(v)));
+      int shift = std::max(nbits - 64, 0);
+      unsigned __int128 one = 1;
+      if (shift != 0)
+        sticky = sticky || ((v & ((one << shift) - 1)) != 0);
+      uint64_t top = uint64_t(v >> shift) | (sticky ? 1U : 0U);
+      double   res = std::ldexp(double(top), shift + 32 * base - 1075);
+      return neg ? -res : res;
+    }
+  };
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "ReproAcc": Reproducible Accumulator of "DimQ"s:                        //
+  //=========================================================================//
+  // Accumulates vals of the type "DQ" (with "float" or "double" RepT); any
+  // "DimQ" accepted by "DQ::operator+=" can be added. Partial accumulators
+  // (eg from different threads) can be merged in any order:
+  //
+  template<typename DQ>
+  class ReproAcc
+  {
+  private:
+    static_assert(Bits::IsReducible<DQ>, "ReproAcc: UnSupported DimQ Type");
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    using En   = Bits::Encodings<RepT, Tr::MaxDims>;
+
+    Bits::SuperAcc m_acc;
+
+  public:
+    template<uint64_t F, uint64_t V>
+    void Add(DimQ<F, V, RepT, Tr::MaxDims> a_x)
+    {
+      static_assert(Tr::E == F, "ERROR: ReproAcc::Add: Different Dims");
+      static_assert(En::UnitsOK(Tr::E, Tr::U, V),
+                    "ERROR: ReproAcc::Add: Units do not unify");
+      m_acc.Add(double(a_x.Magnitude()));
+    }
+
+    void Add(DQ const* a_vals, size_t a_n)
+    {
+      assert(a_vals != nullptr || a_n == 0);
+      m_acc.AddArray(reinterpret_cast<RepT const*>(a_vals), a_n);
+    }
+
+    void Merge(ReproAcc const& a_right) { m_acc.Merge(a_right.m_acc); }
+
+    DQ Result() const { return DQ(RepT(m_acc.Result())); }
+  };
+
+  //=========================================================================//
+  // "ExactSum":                                                             //
+  //=========================================================================//
+  // Parallel (using the same chunking and threads as "Sum"), but the result is
+  // the exact sum correctly rounded, and does not depend on the chunking:
+  //
+  template<typename DQ>
+  DQ ExactSum(DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+  {
+    static_assert(Bits::IsReducible<DQ>, "ExactSum: UnSupported DimQ Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    assert(a_vals != nullptr || a_n == 0);
+    RepT const* x = reinterpret_cast<RepT const*>(a_vals);
+
+    return DQ(RepT(Bits::ParReduce<Bits::SuperAcc>
+      (a_n, a_nThreads, [x](size_t a_from, size_t a_len)
+        {
+          Bits::SuperAcc acc;
+          acc.AddArray(x + a_from, a_len);
+          return acc;
+        }
+      ).Result()));
+  }
+
+  template<typename DQ, size_t Ext>
+  auto ExactSum(std::span<DQ, Ext> a_vals, unsigned a_nThreads = 0)
+    { return ExactSum(a_vals.data(), a_vals.size(), a_nThreads); }
+}
+// End namespace DimTypes
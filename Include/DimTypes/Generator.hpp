@@ -0,0 +1,458 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/Generator.hpp":                        //
+//        Coroutine-Based Lazy Generators of "DimQ" Batches with Fusion      //
+//===========================================================================//
+// "Generator<T>" is a coroutine type (similar to C++23 "std::generator") which
+// yields BATCHES of "T"s as "std::span<T const>", so the cost of a coroutine
+// resumption is amortised over the whole batch. A yielded span remains valid
+// until the generator is resumed again. Any coroutine returning "Generator<T>"
+// can be a source; "GenFromSpan" and "GenFromReader" are provided for arrays
+// and for "read"-like functions (eg reading from files or sockets).
+// The adapters "Mapped", "Filtered", "Converted" and "Windowed" are applied
+// with "|". Consecutive element-wise adapters ("Mapped", "Filtered", "Conver-
+// ted") are FUSED into a single function applied in a single loop in a single
+// coroutine (created when the result is iterated, or converted into a "Gener-
+// ator", or followed by "Windowed"), rather than creating a coroutine per ad-
+// apter. The value types are inferred at compile time, so a "Mapped" or "Fil-
+// tered" function which cannot accept the curr type (eg because of different
+// Dims) is a compile-time error. Generators are single-pass, so they must be
+// passed to "|" as rvalues (use "std::move" for named ones). Eg:
+//
+//   for (std::span<Vel_km_sec const> batch:
+//        GenFromReader<Len_m>(readF)     | Converted<Sys, Len_km>()
+//        | Mapped  ([](Len_km a_x)     { return a_x / 1.0_sec; })
+//        | Filtered([](Vel_km_sec a_v) { return !IsNeg(a_v);   }))
+//     ...
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "Generator":                                                            //
+  //=========================================================================//
+  template<typename T>
+  class Generator
+  {
+    static_assert(!std::is_const_v<T> && !std::is_reference_v<T>,
+                  "Generator: Invalid Value Type");
+  public:
+    struct promise_type;
+    friend struct promise_type;   // Uses the private Ctor
+
+    using Batch = std::span<T const>;
+
+    //-----------------------------------------------------------------------//
+    // "promise_type":                                                       //
+    //-----------------------------------------------------------------------//
+    struct promise_type
+    {
+      Batch              m_curr;
+      std::exception_ptr m_exc;
+
+      Generator get_return_object()
+        { return Generator(Handle::from_promise(*this)); }
+
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend()   noexcept { return {}; }
+
+      std::suspend_always yield_value(Batch a_batch) noexcept
+      {
+        m_curr = a_batch;
+        return {};
+      }
+
+      void return_void() noexcept {}
+
+      void unhandled_exception() { m_exc = std::current_exception(); }
+
+      // "co_await" is not allowed in generators:
+      template<typename U>
+      std::suspend_never await_transform(U&&) = delete;
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    //-----------------------------------------------------------------------//
+    // "iterator" (over the Batches):                                        //
+    //-----------------------------------------------------------------------//
+    class iterator
+    {
+    private:
+      Handle m_h;
+
+    public:
+      using value_type      = Batch;
+      using difference_type = std::ptrdiff_t;
+
+      iterator() noexcept: m_h() {}
+      explicit iterator(Handle a_h) noexcept: m_h(a_h) {}
+
+      Batch const& operator*() const noexcept
+        { return m_h.promise().m_curr; }
+
+      iterator& operator++()
+      {
+        Generator::Resume(m_h);
+        return *this;
+      }
+
+      void operator++(int) { ++*this; }
+
+      bool operator==(std::default_sentinel_t) const noexcept
+        { return m_h == nullptr || m_h.done(); }
+    };
+
+  private:
+    Handle m_h;
+
+    explicit Generator(Handle a_h) noexcept: m_h(a_h) {}
+
+    static void Resume(Handle a_h)
+    {
+      a_h.resume();
+      if (UNLIKELY(bool(a_h.promise().m_exc)))
+        std::rethrow_exception(std::exchange(a_h.promise().m_exc, nullptr));
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Move-Only:                                                            //
+    //-----------------------------------------------------------------------//
+    Generator(Generator&& a_right) noexcept
+    : m_h(std::exchange(a_right.m_h, nullptr))
+    {}
+
+    Generator& operator=(Generator&& a_right) noexcept
+    {
+      if (this != &a_right)
+      {
+        if (m_h)
+          m_h.destroy();
+        m_h = std::exchange(a_right.m_h, nullptr);
+      }
+      return *this;
+    }
+
+    Generator(Generator const&)            = delete;
+    Generator& operator=(Generator const&) = delete;
+
+    ~Generator()
+    {
+      if (m_h)
+        m_h.destroy();
+    }
+
+    //-----------------------------------------------------------------------//
+    // Iteration (single-pass):                                              //
+    //-----------------------------------------------------------------------//
+    iterator begin()
+    {
+      if (m_h)
+        Resume(m_h);
+      return iterator(m_h);
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+  };
+
+  //=========================================================================//
+  // Sources:                                                                //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "GenFromSpan": Batches of (at most) "a_batchSize" vals of an array:     //
+  //-------------------------------------------------------------------------//
+  // NB: The array must outlive the generator:
+  //
+  template<typename T>
+  Generator<T> GenFromSpan(std::span<T const> a_vals, size_t a_batchSize = 1024)
+  {
+    if (UNLIKELY(a_batchSize == 0))
+      throw std::invalid_argument("GenFromSpan: BatchSize must be positive");
+    for (size_t i = 0; i < a_vals.size(); i += a_batchSize)
+      co_yield a_vals.subspan(i, std::min(a_batchSize, a_vals.size() - i));
+  }
+
+  //-------------------------------------------------------------------------//
+  // "GenFromReader":                                                        //
+  //-------------------------------------------------------------------------//
+  // "n = a_read(buff, a_batchSize)" fills in "buff" with up to "a_batchSize"
+  // vals and returns their number; 0 means the end of the stream:
+  //
+  template<typename T, typename Read>
+  Generator<T> GenFromReader(Read a_read, size_t a_batchSize = 1024)
+  {
+    static_assert(std::is_invocable_r_v<size_t, Read&, T*, size_t>,
+                  "GenFromReader: Invalid Reader");
+    if (UNLIKELY(a_batchSize == 0))
+      throw std::invalid_argument("GenFromReader: BatchSize must be positive");
+    std::vector<T> buff(a_batchSize);
+    while (true)
+    {
+      size_t n = a_read(buff.data(), a_batchSize);
+      if (n == 0)
+        co_return;
+      if (UNLIKELY(n > a_batchSize))
+        throw std::runtime_error("GenFromReader: Reader overflow");
+      co_yield std::span<T const>(buff.data(), n);
+    }
+  }
+
+namespace Bits
+{
+  //=========================================================================//
+  // Fused Element-Wise Adapters:                                            //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "FusedGen":                                                             //
+  //-------------------------------------------------------------------------//
+  // "K" is the fused function: "bool k(In const& x, Out* y)" which returns
+  // false iff "x" is filtered out:
+  //
+  template<typename In, typename Out, typename K>
+  class FusedGen
+  {
+  private:
+    Generator<In>                 m_src;
+    K                             m_k;
+    std::optional<Generator<Out>> m_gen;   // Once materialised
+
+    static Generator<Out> Run(Generator<In> a_src, K a_k)
+    {
+      std::vector<Out> buff;
+      for (std::span<In const> batch: a_src)
+      {
+        if (buff.size() < batch.size())
+          buff.resize(batch.size());
+        size_t m = 0;
+        for (In const& x: batch)
+          m += a_k(x, buff.data() + m);
+        if (m != 0)
+          co_yield std::span<Out const>(buff.data(), m);
+      }
+    }
+
+  public:
+    using Value = Out;
+
+    FusedGen(Generator<In>&& a_src, K a_k)
+    : m_src(std::move(a_src)),
+      m_k  (std::move(a_k)),
+      m_gen()
+    {}
+
+    // Appends another element-wise function:
+    template<typename Out2, typename K2>
+    auto Then(K2 a_k2) &&
+    {
+      auto k = [k1 = std::move(m_k), k2 = std::move(a_k2)]
+               (In const& a_x, Out2* a_y)
+      {
+        Out tmp;
+        return k1(a_x, &tmp) && k2(tmp, a_y);
+      };
+      return FusedGen<In, Out2, decltype(k)>(std::move(m_src), std::move(k));
+    }
+
+    operator Generator<Out>() &&
+      { return Run(std::move(m_src), std::move(m_k)); }
+
+    auto begin()
+    {
+      if (!m_gen)
+        m_gen.emplace(Run(std::move(m_src), std::move(m_k)));
+      return m_gen->begin();
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+  };
+
+  // The trivial "K" (for a "Generator" not followed by element-wise adapters):
+  template<typename T>
+  struct IdK
+  {
+    bool operator()(T const& a_x, T* a_y) const
+    {
+      *a_y = a_x;
+      return true;
+    }
+  };
+
+  template<typename T>
+  FusedGen<T, T, IdK<T>> ToFused(Generator<T>&& a_gen)
+    { return FusedGen<T, T, IdK<T>>(std::move(a_gen), IdK<T>()); }
+
+  template<typename In, typename Out, typename K>
+  FusedGen<In, Out, K>&& ToFused(FusedGen<In, Out, K>&& a_gen)
+    { return std::move(a_gen); }
+
+  template<typename G>
+  using GenValue =
+    typename std::remove_cvref_t<decltype(ToFused(std::declval<G>()))>::Value;
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // Adapters:                                                               //
+  //=========================================================================//
+  // The adapter objects (the right-hand args of "|"). NB: They are in the
+  // "DimTypes" namespace, so that the "|"s are found by ADL:
+  //
+  template<typename F> struct MapAdapter    { F m_f; };
+  template<typename F> struct FilterAdapter { F m_f; };
+  template<typename Sys, typename DQ> struct ConvAdapter {};
+  struct WindowAdapter { size_t m_size; size_t m_step; };
+
+  //-------------------------------------------------------------------------//
+  // "Mapped": "f(x)" for each val "x":                                      //
+  //-------------------------------------------------------------------------//
+  template<typename F>
+  MapAdapter<F> Mapped(F a_f) { return {std::move(a_f)}; }
+
+  template<typename G, typename F>
+  auto operator|(G&& a_gen, MapAdapter<F> a_ad)
+  {
+    using In  = Bits::GenValue<G>;
+    static_assert(std::is_invocable_v<F const&, In const&>,
+                  "Mapped: The function cannot accept the curr vals "
+                  "(different Dims?)");
+    using Out = std::decay_t<std::invoke_result_t<F const&, In const&>>;
+    return Bits::ToFused(std::forward<G>(a_gen)).template Then<Out>
+      ([f = std::move(a_ad.m_f)](In const& a_x, Out* a_y)
+       {
+         *a_y = f(a_x);
+         return true;
+       });
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Filtered": Passes on only the vals "x" for which "pred(x)" holds:      //
+  //-------------------------------------------------------------------------//
+  template<typename F>
+  FilterAdapter<F> Filtered(F a_pred) { return {std::move(a_pred)}; }
+
+  template<typename G, typename F>
+  auto operator|(G&& a_gen, FilterAdapter<F> a_ad)
+  {
+    using In = Bits::GenValue<G>;
+    static_assert(std::is_invocable_r_v<bool, F const&, In const&>,
+                  "Filtered: The predicate cannot accept the curr vals "
+                  "(different Dims?)");
+    return Bits::ToFused(std::forward<G>(a_gen)).template Then<In>
+      ([f = std::move(a_ad.m_f)](In const& a_x, In* a_y)
+       {
+         if (!f(a_x))
+           return false;
+         *a_y = a_x;
+         return true;
+       });
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Converted": Into other Units of the same Dims:                         //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  ConvAdapter<Sys, DQ> Converted() { return {}; }
+
+  template<typename G, typename Sys, typename DQ>
+  auto operator|(G&& a_gen, ConvAdapter<Sys, DQ>)
+  {
+    using In   = Bits::GenValue<G>;
+    using Tr   = DimQTraits<In>;
+    using TrO  = DimQTraits<DQ>;
+    static_assert(Tr::IsDimQ && TrO::IsDimQ &&
+                  std::is_same_v<typename Tr::RepT, typename TrO::RepT> &&
+                  Tr::MaxDims == TrO::MaxDims,
+                  "Converted: UnSupported DimQ Type");
+    static_assert(Tr::E == TrO::E, "Converted: Different Dims");
+    using RepT = typename Tr::RepT;
+    using En   = Bits::Encodings<RepT, Tr::MaxDims>;
+
+    RepT factor = RepT(Bits::UnitsConvFactor<Sys>
+                       (Tr::E, En::CleanUpUnits(Tr::E, Tr::U),
+                               En::CleanUpUnits(Tr::E, TrO::U)));
+    return Bits::ToFused(std::forward<G>(a_gen)).template Then<DQ>
+      ([factor](In const& a_x, DQ* a_y)
+       {
+         *a_y = DQ(a_x.Magnitude() * factor);
+         return true;
+       });
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Windowed":                                                             //
+  //-------------------------------------------------------------------------//
+  // Yields each window of "a_size" consecutive vals as a separate batch; the
+  // windows start every "a_step" vals (so they overlap if "a_step < a_size");
+  // an incomplete last window is not yielded. This adapter always creates a
+  // new coroutine:
+  //
+  inline WindowAdapter Windowed(size_t a_size, size_t a_step = 0)
+  {
+    if (UNLIKELY(a_size == 0))
+      throw std::invalid_argument("Windowed: Size must be positive");
+    return {a_size, (a_step != 0) ? a_step : a_size};
+  }
+
+namespace Bits
+{
+  template<typename T>
+  Generator<T> RunWindows(Generator<T> a_src, WindowAdapter a_ad)
+  {
+    // "buff" holds the vals from the start of the curr window; "skip" is the
+    // number of vals to be dropped before the next window starts (if the
+    // step is larger than the size):
+    std::vector<T> buff;
+    buff.reserve(2 * std::max(a_ad.m_size, a_ad.m_step));
+    size_t skip = 0;
+    for (std::span<T const> batch: a_src)
+    {
+      for (size_t i = 0; i < batch.size(); )
+      {
+        if (skip != 0)
+        {
+          size_t k = std::min(skip, batch.size() - i);
+          skip    -= k;
+          i       += k;
+          continue;
+        }
+        size_t k = std::min(a_ad.m_size - buff.size(), batch.size() - i);
+        buff.insert(buff.end(), batch.begin() + long(i),
+                                batch.begin() + long(i + k));
+        i += k;
+        if (buff.size() == a_ad.m_size)
+        {
+          co_yield std::span<T const>(buff);
+          if (a_ad.m_step < a_ad.m_size)
+            buff.erase(buff.begin(), buff.begin() + long(a_ad.m_step));
+          else
+          {
+            skip = a_ad.m_step - a_ad.m_size;
+            buff.clear();
+          }
+        }
+      }
+    }
+  }
+}
+// End namespace Bits
+
+  template<typename G>
+  auto operator|(G&& a_gen, WindowAdapter a_ad)
+  {
+    using T = Bits::GenValue<G>;
+    Generator<T> src = Bits::ToFused(std::forward<G>(a_gen));
+    return Bits::RunWindows(std::move(src), a_ad);
+  }
+}
+// End namespace DimTypes
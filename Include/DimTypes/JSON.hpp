@@ -0,0 +1,535 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "DimTypes/JSON.hpp":                           //
+//          JSON Encoding and Decoding of "DimQ"s, Arrays and Tables         //
+//===========================================================================//
+// Formats:
+// (*) a single "DimQ":  {"v":1.5,"u":"km sec^(-1)"};
+// (*) an array:         {"v":[1.5,2.5,null],"u":"km sec^(-1)"}, ie the Units
+//     are encoded once per array;
+// (*) a table:          {"range":{"v":[...],"u":"km"},"rate":{"v":[...],...}}.
+// The Units strings are in the "Bits::PutUnits" format; "u" is omitted for
+// DimLess vals. On encoding, they are taken from the compile-time suffixes
+// (see "BoundedPut.hpp"); on decoding, they are validated against the target
+// type and converted if necessary (the exact match is a fast path). Numbers
+// are formatted and parsed with "std::{to,from}_chars"; NaNs and Infs are en-
+// coded as "null" (which is decoded as NaN). Only real "RepT"s are supported:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <utility>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Encoding Utils:                                                         //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "JSONPutNum":                                                           //
+  //-------------------------------------------------------------------------//
+  template<typename F>
+  inline void JSONPutNum(F a_val, std::string* a_out)
+  {
+    static_assert(std::is_floating_point_v<F>,
+                  "JSON: Only Real RepTs are supported");
+    if (UNLIKELY(!std::isfinite(a_val)))
+    {
+      a_out->append("null", 4);
+      return;
+    }
+    char buff[64];
+    auto res = std::to_chars(buff, buff + sizeof(buff), a_val);
+    assert(res.ec == std::errc());
+    a_out->append(buff, res.ptr);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONPutStr": With escaping:                                            //
+  //-------------------------------------------------------------------------//
+  inline void JSONPutStr(char const* a_str, std::string* a_out)
+  {
+    a_out->push_back('"');
+    for (char const* c = a_str; *c != '\0'; ++c)
+    {
+      if (*c == '"' || *c == '\\')
+      {
+        a_out->push_back('\\');
+        a_out->push_back(*c);
+      }
+      else
+      if (static_cast<unsigned char>(*c) < 0x20)
+      {
+        char buff[8];
+        snprintf(buff, sizeof(buff), "\\u%04x", unsigned(*c));
+        a_out->append(buff);
+      }
+      else
+        a_out->push_back(*c);
+    }
+    a_out->push_back('"');
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONPutUnits": ',"u":"..."' (nothing for DimLess vals):                //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  inline void JSONPutUnits(std::string* a_out)
+  {
+    using Tr = DimQTraits<DQ>;
+    static_assert(Tr::IsDimQ && Tr::MaxDims == Sys::MaxDims &&
+                  std::is_same_v<typename Tr::RepT, typename Sys::RepT>,
+                  "JSON: Incompatible DimQ Type");
+    // NB: The suffix is of the form " Unit1 Unit2^N ...", so skip the leading
+    // space:
+    constexpr auto& Suffix = UnitsSuffix<Sys, Tr::E, Tr::U>;
+    if constexpr (Suffix.size() > 1)
+    {
+      a_out->append(",\"u\":\"", 6);
+      a_out->append(Suffix.data() + 1, Suffix.size() - 2);
+      a_out->push_back('"');
+    }
+  }
+
+  //=========================================================================//
+  // "JSONIn": A Minimal Pull Parser:                                        //
+  //=========================================================================//
+  class JSONIn
+  {
+  private:
+    char const* m_curr;
+    char const* m_end;
+
+  public:
+    JSONIn(char const* a_from, char const* a_to)
+    : m_curr(a_from),
+      m_end (a_to)
+    { assert(a_from != nullptr && a_from <= a_to); }
+
+    char const* Pos() const { return m_curr; }
+
+    [[noreturn]] static void Fail(char const* a_msg)
+      { throw std::runtime_error(std::string("JSONDecode: ") + a_msg); }
+
+    void SkipWS()
+    {
+      while (m_curr < m_end &&
+            (*m_curr == ' '  || *m_curr == '\n' || *m_curr == '\r' ||
+             *m_curr == '\t'))
+        ++m_curr;
+    }
+
+    // Consumes "a_c" if it is the next non-WS char:
+    bool Accept(char a_c)
+    {
+      SkipWS();
+      if (m_curr < m_end && *m_curr == a_c)
+      {
+        ++m_curr;
+        return true;
+      }
+      return false;
+    }
+
+    void Expect(char a_c)
+    {
+      if (UNLIKELY(!Accept(a_c)))
+        Fail("Syntax Error");
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Str":                                                                //
+    //-----------------------------------------------------------------------//
+    // Returns a view into the input if there are no escapes (the common case),
+    // or into "a_tmp" otherwise. "\u" escapes are only supported for ASCII:
+    //
+    std::string_view Str(std::string* a_tmp)
+    {
+      Expect('"');
+      char const* from = m_curr;
+      while (m_curr < m_end && *m_curr != '"' && *m_curr != '\\')
+        ++m_curr;
+      if (UNLIKELY(m_curr >= m_end))
+        Fail("UnTerminated String");
+      if (LIKELY(*m_curr == '"'))
+        return std::string_view(from, size_t(m_curr++ - from));
+
+      a_tmp->assign(from, m_curr);
+      while (true)
+      {
+        if (UNLIKELY(m_curr >= m_end))
+          Fail("UnTerminated String");
+        char c = *m_curr++;
+        if (c == '"')
+          break;
+        if (c == '\\')
+        {
+          if (UNLIKELY(m_curr >= m_end))
+            Fail("UnTerminated String");
+          c = *m_curr++;
+          switch (c)
+          {
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u':
+            {
+              unsigned code = 0;
+              auto res = std::from_chars(m_curr, std::min(m_curr + 4, m_end),
+                                         code, 16);
+              if (UNLIKELY(res.ptr != m_curr + 4 || code >= 0x80))
+                Fail("UnSupported Escape");
+              m_curr = res.ptr;
+              c      = char(code);
+              break;
+            }
+            default:  break;   // '"', '\\', '/'
+          }
+        }
+        a_tmp->push_back(c);
+      }
+      return std::string_view(*a_tmp);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Num": A number or "null" (-> NaN):                                   //
+    //-----------------------------------------------------------------------//
+    template<typename F>
+    F Num()
+    {
+      SkipWS();
+      if (m_end - m_curr >= 4 && memcmp(m_curr, "null", 4) == 0)
+      {
+        m_curr += 4;
+        return CEMaths::NaN<F>;
+      }
+      F    res;
+      auto rc = std::from_chars(m_curr, m_end, res);
+      if (UNLIKELY(rc.ec != std::errc()))
+        Fail("Invalid Number");
+      m_curr = rc.ptr;
+      return res;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "SkipValue": Any JSON value:                                          //
+    //-----------------------------------------------------------------------//
+    void SkipValue()
+    {
+      SkipWS();
+      if (UNLIKELY(m_curr >= m_end))
+        Fail("Unexpected End");
+      std::string tmp;
+      char c = *m_curr;
+      if (c == '"')
+        Str(&tmp);
+      else
+      if (c == '{' || c == '[')
+      {
+        char close = (c == '{') ? '}' : ']';
+        ++m_curr;
+        if (Accept(close))
+          return;
+        do
+        {
+          if (c == '{')
+          {
+            Str(&tmp);
+            Expect(':');
+          }
+          SkipValue();
+        }
+        while (Accept(','));
+        Expect(close);
+      }
+      else
+        // A number, "true", "false" or "null":
+        while (m_curr < m_end && *m_curr != ',' && *m_curr != '}' &&
+               *m_curr != ']' && *m_curr != ' ' && *m_curr != '\n' &&
+               *m_curr != '\r' && *m_curr != '\t')
+          ++m_curr;
+    }
+  };
+
+  //=========================================================================//
+  // Decoding Utils:                                                         //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "JSONUnitsFactor":                                                      //
+  //-------------------------------------------------------------------------//
+  // Validates the Units string against "DQ" and returns the conversion factor
+  // into the Units of "DQ":
+  //
+  template<typename Sys, typename DQ>
+  typename Sys::RepT JSONUnitsFactor(std::string_view a_units)
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Sys::RepT;
+    using En   = Encodings<RepT, Sys::MaxDims>;
+
+    // Fast Path: Exactly the Units of "DQ":
+    constexpr auto& Suffix = UnitsSuffix<Sys, Tr::E, Tr::U>;
+    if (Suffix.size() > 1 && a_units.size() == Suffix.size() - 2 &&
+        memcmp(a_units.data(), Suffix.data() + 1, a_units.size()) == 0)
+      return RepT(1.0);
+
+    uint64_t E = 0;
+    uint64_t U = 0;
+    // NB: Missing Units (empty "a_units") mean DimLess:
+    if (UNLIKELY(!a_units.empty() && !ParseUnits<Sys>
+                 (a_units.data(), a_units.data() + a_units.size(), &E, &U)))
+      JSONIn::Fail("Invalid Units");
+    if (UNLIKELY(E != Tr::E))
+      JSONIn::Fail("Dims MisMatch");
+    return RepT(UnitsConvFactor<Sys>(E, U, En::CleanUpUnits(Tr::E, Tr::U)));
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONGetVal": {"v":Num[,"u":Str]}:                                      //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  DQ JSONGetVal(JSONIn* a_in)
+  {
+    using RepT = typename Sys::RepT;
+    std::string      tmpK;
+    std::string      tmpU;
+    std::string_view units;
+    RepT             val  = CEMaths::NaN<RepT>;
+    bool             hasV = false;
+
+    a_in->Expect('{');
+    if (!a_in->Accept('}'))
+    {
+      do
+      {
+        std::string_view key = a_in->Str(&tmpK);
+        a_in->Expect(':');
+        if (key == "v")
+        {
+          val  = a_in->Num<RepT>();
+          hasV = true;
+        }
+        else
+        if (key == "u")
+          units = a_in->Str(&tmpU);
+        else
+          a_in->SkipValue();
+      }
+      while (a_in->Accept(','));
+      a_in->Expect('}');
+    }
+    if (UNLIKELY(!hasV))
+      JSONIn::Fail("Missing Value");
+    return DQ(val * JSONUnitsFactor<Sys, DQ>(units));
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONGetArr": {"v":[Num,...][,"u":Str]}:                                //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  void JSONGetArr(JSONIn* a_in, std::vector<DQ>* a_res)
+  {
+    using RepT = typename Sys::RepT;
+    std::string      tmpK;
+    std::string      tmpU;
+    std::string_view units;
+    bool             hasV = false;
+
+    a_res->clear();
+    a_in->Expect('{');
+    if (!a_in->Accept('}'))
+    {
+      do
+      {
+        std::string_view key = a_in->Str(&tmpK);
+        a_in->Expect(':');
+        if (key == "v")
+        {
+          a_in->Expect('[');
+          if (!a_in->Accept(']'))
+          {
+            do
+              a_res->push_back(DQ(a_in->Num<RepT>()));
+            while (a_in->Accept(','));
+            a_in->Expect(']');
+          }
+          hasV = true;
+        }
+        else
+        if (key == "u")
+          units = a_in->Str(&tmpU);
+        else
+          a_in->SkipValue();
+      }
+      while (a_in->Accept(','));
+      a_in->Expect('}');
+    }
+    if (UNLIKELY(!hasV))
+      JSONIn::Fail("Missing Values");
+
+    // The Units may come after the vals, so convert them in the end:
+    RepT factor = JSONUnitsFactor<Sys, DQ>(units);
+    if (factor != RepT(1.0))
+      for (DQ& x: *a_res)
+        x = DQ(x.Magnitude() * factor);
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // Encoding:                                                               //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS". The output is APPEN-
+  // DED to "a_out", so re-using the same string avoids re-allocations:
+  //-------------------------------------------------------------------------//
+  // "JSONEncode": A single "DimQ":                                          //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  void JSONEncode(DQ a_val, std::string* a_out)
+  {
+    assert(a_out != nullptr);
+    a_out->append("{\"v\":", 5);
+    Bits::JSONPutNum(a_val.Magnitude(), a_out);
+    Bits::JSONPutUnits<Sys, DQ>(a_out);
+    a_out->push_back('}');
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONEncode": An array of "DimQ"s:                                      //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  void JSONEncode(DQ const* a_vals, size_t a_n, std::string* a_out)
+  {
+    assert(a_out != nullptr && (a_vals != nullptr || a_n == 0));
+    a_out->reserve(a_out->size() + 24 * a_n + 64);
+    a_out->append("{\"v\":[", 6);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      if (i != 0)
+        a_out->push_back(',');
+      Bits::JSONPutNum(a_vals[i].Magnitude(), a_out);
+    }
+    a_out->push_back(']');
+    Bits::JSONPutUnits<Sys, DQ>(a_out);
+    a_out->push_back('}');
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONEncodeTable": Named columns of "a_n" rows each:                    //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename... DQs>
+  void JSONEncodeTable
+  (
+    size_t                                          a_n,
+    std::array<char const*, sizeof...(DQs)> const&  a_names,
+    std::string*                                    a_out,
+    DQs const*...                                   a_cols
+  )
+  {
+    assert(a_out != nullptr);
+    a_out->push_back('{');
+    size_t k = 0;
+    ((a_out->append(k == 0 ? "" : ","),
+      Bits::JSONPutStr(a_names[k], a_out),
+      a_out->push_back(':'),
+      JSONEncode<Sys, DQs>(a_cols, a_n, a_out),
+      ++k), ...);
+    a_out->push_back('}');
+  }
+
+  //=========================================================================//
+  // Decoding:                                                               //
+  //=========================================================================//
+  // All functions parse a JSON value starting at "a_from" (leading WS is OK),
+  // and return the ptr to the char following it. Throw "std::runtime_error"
+  // on syntax errors and incompatible Dims:
+  //-------------------------------------------------------------------------//
+  // "JSONDecode": A single "DimQ":                                          //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  char const* JSONDecode(char const* a_from, char const* a_to, DQ* a_res)
+  {
+    assert(a_res != nullptr);
+    Bits::JSONIn in(a_from, a_to);
+    *a_res = Bits::JSONGetVal<Sys, DQ>(&in);
+    return in.Pos();
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONDecode": An array of "DimQ"s:                                      //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  char const* JSONDecode
+    (char const* a_from, char const* a_to, std::vector<DQ>* a_res)
+  {
+    assert(a_res != nullptr);
+    Bits::JSONIn in(a_from, a_to);
+    Bits::JSONGetArr<Sys, DQ>(&in, a_res);
+    return in.Pos();
+  }
+
+  //-------------------------------------------------------------------------//
+  // "JSONDecodeTable":                                                      //
+  //-------------------------------------------------------------------------//
+  // The columns are selected by name, in any order; other columns are skipped.
+  // All requested columns must be present and of the same length:
+  //
+  template<typename Sys, typename... DQs>
+  char const* JSONDecodeTable
+  (
+    char const*                                     a_from,
+    char const*                                     a_to,
+    std::array<char const*, sizeof...(DQs)> const&  a_names,
+    std::vector<DQs>*...                            a_cols
+  )
+  {
+    constexpr size_t NC = sizeof...(DQs);
+    Bits::JSONIn     in(a_from, a_to);
+    std::string      tmp;
+    bool             found[NC] {};
+
+    // Decodes the "a_k"th column; "I" are the column indices:
+    auto getCol = [&]<size_t... I>(size_t a_k, std::index_sequence<I...>)
+    {
+      ((I == a_k ? Bits::JSONGetArr<Sys, DQs>(&in, a_cols) : void()), ...);
+    };
+
+    in.Expect('{');
+    if (!in.Accept('}'))
+    {
+      do
+      {
+        std::string_view key = in.Str(&tmp);
+        in.Expect(':');
+        size_t k = 0;
+        while (k < NC && key != a_names[k])
+          ++k;
+        if (k < NC)
+        {
+          if (UNLIKELY(found[k]))
+            Bits::JSONIn::Fail("Duplicate Column");
+          getCol(k, std::make_index_sequence<NC>());
+          found[k] = true;
+        }
+        else
+          in.SkipValue();
+      }
+      while (in.Accept(','));
+      in.Expect('}');
+    }
+    size_t sizes[NC] = { a_cols->size()... };
+    for (size_t k = 0; k < NC; ++k)
+      if (UNLIKELY(!found[k] || sizes[k] != sizes[0]))
+        Bits::JSONIn::Fail("Missing Column or Length MisMatch");
+    return in.Pos();
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,381 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "DimTypes/Kepler.hpp":                          //
+//     Batch Solution of Kepler's Equation and Two-Body State Vectors        //
+//===========================================================================//
+// "KeplerSolve" solves Kepler's equation for arrays of (e, M):
+//   elliptic   (e < 1):  E - e sin(E)  = M,
+//   hyperbolic (e > 1):  e sinh(H) - H = M,
+// by a FIXED number "NIter" of Halley iterations from Danby-type starters, so
+// that all lanes do the same work and the loops are vectorisable: the inputs
+// are processed in blocks, the elliptic and the hyperbolic cases of a block
+// are compacted separately, and the trigonometric / hyperbolic functions are
+// computed by branch-free polynomial kernels (full double precision in the
+// ranges used here) rather than by the "libm" calls, which stop the compiler
+// from vectorising the loops.
+// "KeplerPropagate" converts arrays of "OrbitElems" (with the semi-major axis
+// typed as a "Len" and the epoch as a "Time") and the "GM" of the central
+// body (typed as "Len^3 Time^-2") into state vectors at a given time.  Mean
+// motions are computed with the "DimQ" types, so "GM", "a" and "t" must have
+// unifiable Units (eg "km^3 sec^-2", "km", "sec"), which is checked at compile
+// time. Angles are DimLess (radians).
+// For large catalogs, call it on sub-ranges from "ThreadPool::ParallelFor":
+//
+#pragma  once
+#include "Vec3.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+namespace DimTypes
+{
+  // The default number of Halley iterations: enough for the full double pre-
+  // cision (relative, incl near M = 0) for 0 <= e <= 1-1e-6 and for 1+1e-6 <=
+  // e <= 100, |M| <= 1e6, with a margin (5 iterations suffice in the tests):
+  constexpr inline unsigned KeplerDefIters = 7;
+
+namespace Bits
+{
+  constexpr inline unsigned KeplerBlockSize = 64;
+
+  //-------------------------------------------------------------------------//
+  // Branch-Free Elementary Functions:                                       //
+  //-------------------------------------------------------------------------//
+  // "RoundK": Round to nearest, by the 1.5*2^52 trick (valid for |x| < 2^51);
+  // the low bits of "*a_q" are those of the resulting integer:
+  //
+  inline double RoundK(double a_x, uint64_t* a_q)
+  {
+    constexpr double Magic = 6755399441055744.0;
+    double y = a_x + Magic;
+    *a_q     = std::bit_cast<uint64_t>(y);
+    return y - Magic;
+  }
+
+  // "SinCosK": Cody-Waite reduction mod Pi/2, then the Cephes polynomials:
+  inline void SinCosK(double a_x, double* a_s, double* a_c)
+  {
+    constexpr double TwoOverPi = 0.636619772367581343076;
+    constexpr double PiO2_1    = 1.5707962512969970703125;
+    constexpr double PiO2_2    = 7.54978941586159635336e-8;
+    constexpr double PiO2_3    = 5.39030285815811905290e-15;
+    uint64_t q;
+    double   k = RoundK(a_x * TwoOverPi, &q);
+    double   r = ((a_x - k * PiO2_1) - k * PiO2_2) - k * PiO2_3;
+    double   z = r * r;
+    double   s = r + r * z *
+      (((((1.58962301576546568060e-10  * z - 2.50507477628578072866e-8) * z
+          + 2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z
+          + 8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+    double   c = 1.0 - 0.5 * z + z * z *
+      (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z
+          - 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z
+          - 1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+    double   ss = (q & 1) ? c : s;
+    double   cc = (q & 1) ? s : c;
+    *a_s = (q & 2)       ? -ss : ss;
+    *a_c = ((q + 1) & 2) ? -cc : cc;
+  }
+
+  // "ExpK": Cephes rational approximation, with 2^n made from the bits:
+  inline double ExpK(double a_x)
+  {
+    constexpr double   Log2E = 1.4426950408889634073599;
+    constexpr double   C1    = 6.93145751953125e-1;
+    constexpr double   C2    = 1.42860682030941723212e-6;
+    constexpr uint64_t Magic = 0x4338000000000000UL;
+    a_x = std::min(std::max(a_x, -708.0), 709.0);
+    uint64_t q;
+    double   n  = RoundK(a_x * Log2E, &q);
+    double   r  = (a_x - n * C1) - n * C2;
+    double   rr = r * r;
+    double   p  = r * ((1.26177193074810590878e-4 * rr +
+                        3.02994407707441961300e-2) * rr + 1.0);
+    double   d  = ((3.00198505138664455042e-6 * rr +
+                    2.52448340349684104192e-3) * rr +
+                    2.27265548208155028766e-1) * rr + 2.0;
+    double   e  = 1.0 + 2.0 * p / (d - p);
+    return e * std::bit_cast<double>((q - Magic + 1023) << 52);
+  }
+
+  // "LogApprox": ~1e-4 relative precision, for the starters only (x > 0):
+  inline double LogApprox(double a_x)
+  {
+    constexpr double   Ln2   = 0.693147180559945309417;
+    constexpr double   Magic = 6755399441055744.0;
+    uint64_t b = std::bit_cast<uint64_t>(a_x);
+    // Mantissa in [1, 2), rescaled to [0.75, 1.5):
+    uint64_t hi = (b >> 51) & 1;
+    double   m  = std::bit_cast<double>
+                  ((b & 0x000fffffffffffffUL) | ((1023 - hi) << 52));
+    uint64_t k  = (b >> 52) - 1023 + hi;
+    double   kd = std::bit_cast<double>
+                  (std::bit_cast<uint64_t>(Magic) + k) - Magic;
+    double   s  = (m - 1.0) / (m + 1.0);
+    double   s2 = s * s;
+    return kd * Ln2 + 2.0 * s * (1.0 + s2 * (1.0 / 3.0 + s2 * 0.2));
+  }
+
+  //-------------------------------------------------------------------------//
+  // "KeplerKernel": Uniform Halley Iterations over Contiguous Arrays:       //
+  //-------------------------------------------------------------------------//
+  // Returns the anomaly in "a_E", and its (sin, cos) or (sinh, cosh) in
+  // "a_s", "a_c":
+  //
+  template<bool Hyp, unsigned NIter>
+  inline void KeplerKernel(double const* a_e, double const* a_M, unsigned a_n,
+                           double* a_E, double* a_s, double* a_c)
+  {
+    constexpr double TwoPi_1  = 4.0 * 1.5707962512969970703125;
+    constexpr double TwoPi_2  = 4.0 * 7.54978941586159635336e-8;
+    constexpr double TwoPi_3  = 4.0 * 5.39030285815811905290e-15;
+    constexpr double OneOver2Pi = 0.159154943091895335769;
+
+    auto funcs = [](double a_x, double* a_sf, double* a_cf)
+    {
+      if constexpr (Hyp)
+      {
+        // For small |x|, "ex - 1/ex" cancels, so "sinh" is then given by its
+        // Taylor series (to x^15, which is within 1 ulp for |x| < 0.5); both
+        // are computed and one is selected, so the loop remains branch-free:
+        double ex = ExpK(a_x), emx = 1.0 / ex;
+        double x2 = a_x * a_x;
+        double sp = a_x + a_x * x2 *
+          (1.66666666666666666667e-1  + x2 *
+          (8.33333333333333333333e-3  + x2 *
+          (1.98412698412698412698e-4  + x2 *
+          (2.75573192239858906526e-6  + x2 *
+          (2.50521083854417187751e-8  + x2 *
+          (1.60590438368216145994e-10 + x2 *
+           7.64716373181981647590e-13))))));
+        *a_sf = (std::abs(a_x) < 0.5) ? sp : 0.5 * (ex - emx);
+        *a_cf = 0.5 * (ex + emx);
+      }
+      else
+        SinCosK(a_x, a_sf, a_cf);
+    };
+
+    // Starters (for elliptic orbits, M is reduced to [-Pi, Pi]):
+    double Mr[KeplerBlockSize];
+    for (unsigned l = 0; l < a_n; ++l)
+    {
+      double e = a_e[l], M = a_M[l];
+      if constexpr (Hyp)
+        a_E[l] = std::copysign(LogApprox(2.0 * std::abs(M) / e + 1.8), M);
+      else
+      {
+        uint64_t q;
+        double   k = RoundK(M * OneOver2Pi, &q);
+        M          = ((M - k * TwoPi_1) - k * TwoPi_2) - k * TwoPi_3;
+        a_E[l]     = M + std::copysign(0.85 * e, M);
+      }
+      // For small |M| (esp with e close to 1), the root is close to that of
+      // |1-e| x + e x^3/6 = |M|, ie below both |M|/|1-e| and (6|M|/e)^(1/3);
+      // the smaller of those is then a better starter, which gives the root
+      // to full RELATIVE precision down to |M| ~ 1e-300:
+      double aM = std::abs(M);
+      double x0 = std::min(aM / std::abs(1.0 - e),
+                           ExpK(LogApprox(6.0 * aM / e) / 3.0));
+      a_E[l]    = std::copysign(std::min(std::abs(a_E[l]), x0), M);
+      Mr[l]     = M;
+    }
+
+    // Halley iterations (f'' = e * sf in both cases):
+    for (unsigned it = 0; it < NIter; ++it)
+      for (unsigned l = 0; l < a_n; ++l)
+      {
+        double e = a_e[l], x = a_E[l], sf, cf;
+        funcs(x, &sf, &cf);
+        double f, f1;
+        if constexpr (Hyp)
+        {
+          f  = e * sf - x - Mr[l];
+          f1 = e * cf - 1.0;
+        }
+        else
+        {
+          f  = x - e * sf - Mr[l];
+          f1 = 1.0 - e * cf;
+        }
+        a_E[l] = x - f / (f1 - 0.5 * f * (e * sf) / f1);
+      }
+    for (unsigned l = 0; l < a_n; ++l)
+      funcs(a_E[l], a_s + l, a_c + l);
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "KeplerSolve":                                                          //
+  //=========================================================================//
+  // Eccentric (or hyperbolic) anomalies "a_E" for eccentricities "a_e" and
+  // mean anomalies "a_M" (radians). The elliptic anomalies are returned in
+  // [-Pi-1, Pi+1] (ie for M reduced to [-Pi, Pi]). Throws on e < 0 or e == 1
+  // (the parabolic case is not supported):
+  //
+  template<unsigned NIter = KeplerDefIters>
+  void KeplerSolve(double const* a_e, double const* a_M, size_t a_n,
+                   double* a_E)
+  {
+    constexpr unsigned B = Bits::KeplerBlockSize;
+    double eE[B], ME[B], eH[B], MH[B], E[B], s[B], c[B];
+    unsigned iE[B], iH[B];
+
+    for (size_t from = 0; from < a_n; from += B)
+    {
+      unsigned n  = unsigned(std::min<size_t>(B, a_n - from));
+      unsigned nE = 0, nH = 0;
+      for (unsigned l = 0; l < n; ++l)
+      {
+        double e = a_e[from + l];
+        if (UNLIKELY(!(e >= 0.0) || e == 1.0))
+          throw std::invalid_argument("KeplerSolve: Invalid Eccentricity");
+        if (e < 1.0)
+        {
+          iE[nE] = l;  eE[nE] = e;  ME[nE] = a_M[from + l];  ++nE;
+        }
+        else
+        {
+          iH[nH] = l;  eH[nH] = e;  MH[nH] = a_M[from + l];  ++nH;
+        }
+      }
+      Bits::KeplerKernel<false, NIter>(eE, ME, nE, E, s, c);
+      for (unsigned j = 0; j < nE; ++j)
+        a_E[from + iE[j]] = E[j];
+      Bits::KeplerKernel<true,  NIter>(eH, MH, nH, E, s, c);
+      for (unsigned j = 0; j < nH; ++j)
+        a_E[from + iH[j]] = E[j];
+    }
+  }
+
+  //=========================================================================//
+  // "OrbitElems":                                                           //
+  //=========================================================================//
+  // Classical elements; "m_a" < 0 for hyperbolic orbits (e > 1):
+  //
+  template<typename LenDQ, typename TimeDQ>
+  struct OrbitElems
+  {
+    LenDQ  m_a;        // Semi-major axis
+    double m_e;        // Eccentricity
+    double m_i;        // Inclination
+    double m_node;     // Longitude of the ascending node
+    double m_argPeri;  // Argument of the periapsis
+    double m_M0;       // Mean anomaly at "m_epoch"
+    TimeDQ m_epoch;
+  };
+
+  template<typename LenDQ, typename TimeDQ>
+  using KeplerVel =
+    decltype(std::declval<LenDQ>() / std::declval<TimeDQ>());
+
+  //=========================================================================//
+  // "KeplerPropagate":                                                      //
+  //=========================================================================//
+  // Position and velocity vectors at time "a_t", in the frame of the elements
+  // (eg ecliptic J2000), relative to the central body with "a_gm":
+  //
+  template<unsigned NIter = KeplerDefIters,
+           typename LenDQ, typename TimeDQ, typename GMDQ>
+  void KeplerPropagate
+  (
+    GMDQ                                   a_gm,
+    OrbitElems<LenDQ, TimeDQ> const*       a_elems,
+    size_t                                 a_n,
+    TimeDQ                                 a_t,
+    Vec3<LenDQ>*                           a_pos,
+    Vec3<KeplerVel<LenDQ, TimeDQ>>*        a_vel
+  )
+  {
+    using VelDQ = KeplerVel<LenDQ, TimeDQ>;
+    using GMTr  = DimQTraits<GMDQ>;
+    using Len3  = decltype(std::declval<LenDQ>() * std::declval<LenDQ>() *
+                           std::declval<LenDQ>());
+    using Time2 = decltype(std::declval<TimeDQ>() * std::declval<TimeDQ>());
+    static_assert(GMTr::IsDimQ &&
+                  GMTr::E == DimQTraits<decltype(std::declval<Len3>() /
+                                                 std::declval<Time2>())>::E,
+                  "ERROR: KeplerPropagate: GM must be Len^3 Time^-2");
+    assert(a_elems != nullptr && a_pos != nullptr && a_vel != nullptr);
+
+    constexpr unsigned B = Bits::KeplerBlockSize;
+    double eE[B], ME[B], eH[B], MH[B], E[B], s[B], c[B];
+    double A[B], N[B], sA[B], cA[B];  // |a|, n, and sin/cos of the anomaly
+    unsigned iE[B], iH[B];
+
+    for (size_t from = 0; from < a_n; from += B)
+    {
+      unsigned n  = unsigned(std::min<size_t>(B, a_n - from));
+      unsigned nE = 0, nH = 0;
+      OrbitElems<LenDQ, TimeDQ> const* el = a_elems + from;
+
+      // Mean motions and mean anomalies (with "DimQ"s):
+      for (unsigned l = 0; l < n; ++l)
+      {
+        double e = el[l].m_e;
+        LenDQ  a = el[l].m_a;
+        if (UNLIKELY(!(e >= 0.0) || e == 1.0 || IsZero(a) ||
+                     ((e < 1.0) != IsPos(a))))
+          throw std::invalid_argument("KeplerPropagate: Invalid Elements");
+        LenDQ  aa = Abs(a);
+        auto   nm = SqRt(a_gm / (aa * aa * aa));
+        double M  = el[l].m_M0 + double(nm * (a_t - el[l].m_epoch));
+        A[l]      = aa.Magnitude();
+        N[l]      = nm.Magnitude();
+        if (e < 1.0)
+        {
+          iE[nE] = l;  eE[nE] = e;  ME[nE] = M;  ++nE;
+        }
+        else
+        {
+          iH[nH] = l;  eH[nH] = e;  MH[nH] = M;  ++nH;
+        }
+      }
+      Bits::KeplerKernel<false, NIter>(eE, ME, nE, E, s, c);
+      for (unsigned j = 0; j < nE; ++j)
+      {
+        sA[iE[j]] = s[j];
+        cA[iE[j]] = c[j];
+      }
+      Bits::KeplerKernel<true,  NIter>(eH, MH, nH, E, s, c);
+      for (unsigned j = 0; j < nH; ++j)
+      {
+        sA[iH[j]] = s[j];
+        cA[iH[j]] = c[j];
+      }
+
+      // State vectors: perifocal coords, rotated by Rz(node) Rx(i) Rz(w):
+      for (unsigned l = 0; l < n; ++l)
+      {
+        double e  = el[l].m_e;
+        bool   hy = (e > 1.0);
+        double q  = std::sqrt(std::abs(1.0 - e * e));
+        // Elliptic:   x = a (cos E - e), y = a q sin E, r = a (1 - e cos E);
+        // Hyperbolic: x = a (e - cosh H), y = a q sinh H, r = a(e cosh H - 1):
+        double x  = A[l] * (hy ? (e - cA[l]) : (cA[l] - e));
+        double y  = A[l] * q * sA[l];
+        double d  = hy ? (e * cA[l] - 1.0) : (1.0 - e * cA[l]);
+        double an = A[l] * N[l] / d;
+        double vx = -an * sA[l];
+        double vy = an * q * cA[l];
+
+        double si, ci, sO, cO, sw, cw;
+        Bits::SinCosK(el[l].m_i,       &si, &ci);
+        Bits::SinCosK(el[l].m_node,    &sO, &cO);
+        Bits::SinCosK(el[l].m_argPeri, &sw, &cw);
+        double P[3] = {  cw * cO - sw * ci * sO,  cw * sO + sw * ci * cO,
+                         sw * si };
+        double Q[3] = { -sw * cO - cw * ci * sO, -sw * sO + cw * ci * cO,
+                         cw * si };
+        for (unsigned k = 0; k < 3; ++k)
+        {
+          a_pos[from + l].m_c[k] = LenDQ(x  * P[k] + y  * Q[k]);
+          a_vel[from + l].m_c[k] = VelDQ(vx * P[k] + vy * Q[k]);
+        }
+      }
+    }
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,383 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "DimTypes/MonteCarlo.hpp":                        //
+//     Counter-Based RNG, Typed Distributions, Parallel Monte Carlo Driver   //
+//===========================================================================//
+// "PhiloxStream" is the Philox4x32-10 counter-based generator (Salmon et al,
+// "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11): the output block "i"
+// is a pure function of (key, counter), so there is no sequential state, any
+// number of independent streams can be created from one seed, and the blocks
+// are generated in a loop w/o loop-carried dependencies, which the compiler
+// vectorises (the 32x32->64-bit multiplications map onto "vpmuludq" etc).
+// The key is the 64-bit seed; the counter is (block index, stream id).
+// "UniformDist", "NormalDist" and "LogNormalDist" fill arrays of "DimQ"s; their
+// params are "DimQ"s whose Dims and Units are checked at compile time against
+// the result type (eg the mean and the sigma of a mass in "kg" must be masses
+// in "kg"). "MonteCarlo" runs a user kernel over fixed-size blocks of samples
+// on a "ThreadPool"; the block "b" always gets the stream "b", and the block
+// results are reduced in the block order, so the result does not depend on
+// the number of threads:
+//
+#pragma  once
+#include "Parallel.hpp"
+#include <cmath>
+#include <numbers>
+#include <type_traits>
+#include <vector>
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "PhiloxStream":                                                         //
+  //=========================================================================//
+  class PhiloxStream
+  {
+  private:
+    uint32_t m_key[2];
+    uint64_t m_stream;
+    uint64_t m_block;     // Next block (of 4 words) to be generated
+
+    constexpr static size_t BuffBlocks = 256;
+
+  public:
+    //-----------------------------------------------------------------------//
+    // "Block": Philox4x32-10 for the given counter and key:                 //
+    //-----------------------------------------------------------------------//
+    constexpr static void Block
+      (uint32_t const a_ctr[4], uint32_t const a_key[2], uint32_t a_out[4])
+    {
+      constexpr uint64_t M0 = 0xD2511F53;
+      constexpr uint64_t M1 = 0xCD9E8D57;
+      constexpr uint32_t W0 = 0x9E3779B9;
+      constexpr uint32_t W1 = 0xBB67AE85;
+
+      uint32_t c0 = a_ctr[0], c1 = a_ctr[1], c2 = a_ctr[2], c3 = a_ctr[3];
+      uint32_t k0 = a_key[0], k1 = a_key[1];
+      for (int r = 0; r < 10; ++r)
+      {
+        uint64_t p0 = M0 * c0;
+        uint64_t p1 = M1 * c2;
+        uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c0 = n0;
+        c1 = uint32_t(p1);
+        c2 = n2;
+        c3 = uint32_t(p0);
+        k0 += W0;
+        k1 += W1;
+      }
+      a_out[0] = c0;
+      a_out[1] = c1;
+      a_out[2] = c2;
+      a_out[3] = c3;
+    }
+
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    PhiloxStream(uint64_t a_seed, uint64_t a_stream)
+    : m_key   { uint32_t(a_seed), uint32_t(a_seed >> 32) },
+      m_stream(a_stream),
+      m_block (0)
+    {}
+
+    uint64_t Stream() const { return m_stream; }
+
+    //-----------------------------------------------------------------------//
+    // "Fill": Raw 32-bit words:                                             //
+    //-----------------------------------------------------------------------//
+    // Consumes ceil(a_n/4) blocks (the unused words of the last one, if any,
+    // are discarded):
+    //
+    void Fill(uint32_t* a_out, size_t a_n)
+    {
+      uint32_t buff[BuffBlocks][4];
+      uint32_t s0 = uint32_t(m_stream);
+      uint32_t s1 = uint32_t(m_stream >> 32);
+
+      for (size_t done = 0; done < a_n; )
+      {
+        size_t nb = std::min(BuffBlocks, (a_n - done + 3) / 4);
+        // This loop is vectorisable: no dependencies between the blocks:
+        for (size_t b = 0; b < nb; ++b)
+        {
+          uint64_t i    = m_block + b;
+          uint32_t c[4] = { uint32_t(i), uint32_t(i >> 32), s0, s1 };
+          Block(c, m_key, buff[b]);
+        }
+        m_block += nb;
+        size_t k = std::min(4 * nb, a_n - done);
+        memcpy(a_out + done, buff, k * sizeof(uint32_t));
+        done += k;
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "U01", "FillU01": Uniform in the OPEN interval (0, 1):                //
+    //-----------------------------------------------------------------------//
+    // "double"s use 52 random bits (2 words each), "float"s use 23 bits (1
+    // word each); the vals are the mid-points of the 2^52 (2^23) sub-intervals,
+    // which are exactly representable (with 53 (24) significant bits), so they
+    // are never 0 or 1 (the max is 1 - 2^-53 (1 - 2^-24)):
+    //
+    constexpr static double U01(uint32_t a_hi, uint32_t a_lo)
+    {
+      uint64_t u = (uint64_t(a_hi) << 32 | a_lo) >> 12;
+      return (double(u) + 0.5) * 0x1.0p-52;
+    }
+
+    constexpr static float U01(uint32_t a_w)
+      { return (float(a_w >> 9) + 0.5f) * 0x1.0p-23f; }
+
+    template<typename F>
+    void FillU01(F* a_out, size_t a_n)
+    {
+      static_assert(std::is_same_v<F, float> || std::is_same_v<F, double>,
+                    "FillU01: UnSupported Type");
+      constexpr size_t WPV   = std::is_same_v<F, double> ? 2 : 1;
+      constexpr size_t NVals = BuffBlocks * 4 / WPV;
+      uint32_t words[BuffBlocks * 4];
+
+      for (size_t done = 0; done < a_n; )
+      {
+        size_t k = std::min(NVals, a_n - done);
+        Fill(words, k * WPV);
+        for (size_t i = 0; i < k; ++i)
+        {
+          if constexpr (WPV == 2)
+            a_out[done + i] = U01(words[2*i], words[2*i+1]);
+          else
+            a_out[done + i] = U01(words[i]);
+        }
+        done += k;
+      }
+    }
+  };
+
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // "CheckDistParam":                                                       //
+  //-------------------------------------------------------------------------//
+  // "P" must be of the same Dims as "DQ", and its Units must unify with those
+  // of "DQ" (so that its magnitude can be used directly):
+  //
+  template<typename DQ, typename P>
+  constexpr bool CheckDistParam()
+  {
+    using Tr  = DimQTraits<DQ>;
+    using TrP = DimQTraits<P>;
+    static_assert(TrP::IsDimQ &&
+                  std::is_same_v<typename TrP::RepT, typename Tr::RepT> &&
+                  TrP::MaxDims == Tr::MaxDims,
+                  "Dist: Invalid Param Type");
+    static_assert(TrP::E == Tr::E, "ERROR: Dist: Param of Different Dims");
+    static_assert(Bits::Encodings<typename Tr::RepT, Tr::MaxDims>::UnitsOK
+                  (Tr::E, Tr::U, TrP::U),
+                  "ERROR: Dist: Param Units do not unify");
+    return true;
+  }
+
+  template<typename DQ>
+  constexpr inline bool IsSampleable =
+    DimQTraits<DQ>::IsDimQ &&
+    (std::is_same_v<typename DimQTraits<DQ>::RepT, float> ||
+     std::is_same_v<typename DimQTraits<DQ>::RepT, double>);
+
+  //-------------------------------------------------------------------------//
+  // "FillStdNormal": Box-Muller:                                            //
+  //-------------------------------------------------------------------------//
+  // Uses "a_n" (rounded up to even) uniform vals:
+  //
+  template<typename F>
+  void FillStdNormal(PhiloxStream* a_rng, F* a_out, size_t a_n)
+  {
+    constexpr size_t    Chunk = 512;
+    constexpr F         TwoPi = F(2.0 * std::numbers::pi);
+    F u[Chunk];
+    for (size_t done = 0; done < a_n; )
+    {
+      size_t k  = std::min(Chunk, a_n - done);
+      size_t k2 = (k + 1) / 2;
+      a_rng->FillU01(u, 2 * k2);
+      for (size_t i = 0; i < k2; ++i)
+      {
+        F r  = std::sqrt(F(-2.0) * std::log(u[i]));
+        F th = TwoPi * u[k2 + i];
+        a_out[done + i]           = r * std::cos(th);
+        if (k2 + i < k)
+          a_out[done + k2 + i]    = r * std::sin(th);
+      }
+      done += k;
+    }
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // Distributions:                                                          //
+  //=========================================================================//
+  // Each one provides "Fill(rng, out, n)" which fills "out[0..n)" with vals of
+  // the type "DQ":
+  //-------------------------------------------------------------------------//
+  // "UniformDist": In [lo, hi):                                             //
+  //-------------------------------------------------------------------------//
+  // NB: "lo + width * u" may round up to "hi" even for u < 1, so the vals are
+  // clamped to the largest "RepT" below "hi":
+  //
+  template<typename DQ>
+  class UniformDist
+  {
+  private:
+    static_assert(Bits::IsSampleable<DQ>, "UniformDist: UnSupported Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    RepT m_lo;
+    RepT m_width;
+    RepT m_hi;
+    RepT m_max;     // Below "m_hi"
+
+  public:
+    template<typename P1, typename P2>
+    UniformDist(P1 a_lo, P2 a_hi)
+    : m_lo   (a_lo.Magnitude()),
+      m_width(a_hi.Magnitude() - a_lo.Magnitude()),
+      m_hi   (a_hi.Magnitude()),
+      m_max  (std::nextafter(m_hi, m_lo))
+    {
+      static_assert(Bits::CheckDistParam<DQ, P1>() &&
+                    Bits::CheckDistParam<DQ, P2>());
+      if (UNLIKELY(!(m_width > RepT(0.0)) || !std::isfinite(m_width)))
+        throw std::invalid_argument("UniformDist: Invalid Range");
+    }
+
+    void Fill(PhiloxStream& a_rng, DQ* a_out, size_t a_n) const
+    {
+      RepT* out = reinterpret_cast<RepT*>(a_out);
+      a_rng.FillU01(out, a_n);
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        RepT x = m_lo + m_width * out[i];
+        out[i] = (x < m_hi) ? x : m_max;
+      }
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "NormalDist":                                                           //
+  //-------------------------------------------------------------------------//
+  template<typename DQ>
+  class NormalDist
+  {
+  private:
+    static_assert(Bits::IsSampleable<DQ>, "NormalDist: UnSupported Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    RepT m_mean;
+    RepT m_sigma;
+
+  public:
+    template<typename P1, typename P2>
+    NormalDist(P1 a_mean, P2 a_sigma)
+    : m_mean (a_mean.Magnitude()),
+      m_sigma(a_sigma.Magnitude())
+    {
+      static_assert(Bits::CheckDistParam<DQ, P1>() &&
+                    Bits::CheckDistParam<DQ, P2>());
+      if (UNLIKELY(!(m_sigma >= RepT(0.0)) || !std::isfinite(m_sigma)))
+        throw std::invalid_argument("NormalDist: Invalid Sigma");
+    }
+
+    void Fill(PhiloxStream& a_rng, DQ* a_out, size_t a_n) const
+    {
+      RepT* out = reinterpret_cast<RepT*>(a_out);
+      Bits::FillStdNormal(&a_rng, out, a_n);
+      for (size_t i = 0; i < a_n; ++i)
+        out[i] = m_mean + m_sigma * out[i];
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "LogNormalDist": "median * exp(sigmaLog * Z)" where "Z" is N(0, 1):     //
+  //-------------------------------------------------------------------------//
+  // The median is of the Dims of "DQ"; the log-scale sigma is DimLess:
+  //
+  template<typename DQ>
+  class LogNormalDist
+  {
+  private:
+    static_assert(Bits::IsSampleable<DQ>, "LogNormalDist: UnSupported Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    RepT m_median;
+    RepT m_sigmaLog;
+
+  public:
+    template<typename P>
+    LogNormalDist(P a_median, RepT a_sigmaLog)
+    : m_median  (a_median.Magnitude()),
+      m_sigmaLog(a_sigmaLog)
+    {
+      static_assert(Bits::CheckDistParam<DQ, P>());
+      if (UNLIKELY(!(m_median > RepT(0.0)) || !(m_sigmaLog >= RepT(0.0)) ||
+                   !std::isfinite(m_median)  || !std::isfinite(m_sigmaLog)))
+        throw std::invalid_argument("LogNormalDist: Invalid Params");
+    }
+
+    void Fill(PhiloxStream& a_rng, DQ* a_out, size_t a_n) const
+    {
+      RepT* out = reinterpret_cast<RepT*>(a_out);
+      Bits::FillStdNormal(&a_rng, out, a_n);
+      for (size_t i = 0; i < a_n; ++i)
+        out[i] = m_median * std::exp(m_sigmaLog * out[i]);
+    }
+  };
+
+  //=========================================================================//
+  // "MonteCarlo": The Parallel Driver:                                      //
+  //=========================================================================//
+  // Splits "a_nSamples" into blocks of "a_blockSize" (the last one may be
+  // shorter), and calls "a_kernel(rng, n)" for each block, where "rng" is the
+  // "PhiloxStream" (a_seed, BlockNo) and "n" is the block size; the results
+  // are combined as "a_red(... a_red(a_red(a_init, r0), r1) ...)". The kernel
+  // typically fills (thread-local) arrays of typed samples by the distribu-
+  // tions above, and reduces them into a typed result (eg a "DimQ" sum):
+  //
+  template<typename Res, typename Red, typename Kernel>
+  Res MonteCarlo
+  (
+    ThreadPool&   a_pool,
+    size_t        a_nSamples,
+    uint64_t      a_seed,
+    Res           a_init,
+    Red const&    a_red,
+    Kernel const& a_kernel,
+    size_t        a_blockSize = 65536
+  )
+  {
+    static_assert(std::is_invocable_r_v<Res, Kernel const&, PhiloxStream&,
+                                        size_t>,
+                  "MonteCarlo: The Kernel must return the Result type");
+    static_assert(std::is_invocable_r_v<Res, Red const&, Res, Res>,
+                  "MonteCarlo: The Reducer must return the Result type");
+    if (UNLIKELY(a_blockSize == 0))
+      throw std::invalid_argument("MonteCarlo: BlockSize must be positive");
+
+    size_t nBlocks = (a_nSamples + a_blockSize - 1) / a_blockSize;
+    std::vector<Res> partials(nBlocks, a_init);
+    a_pool.ParallelFor
+      (nBlocks, 1,
+       [&](size_t a_from, size_t a_to)
+       {
+         for (size_t b = a_from; b < a_to; ++b)
+         {
+           PhiloxStream rng(a_seed, b);
+           size_t       n = std::min(a_blockSize, a_nSamples - b * a_blockSize);
+           partials[b]    = a_kernel(rng, n);
+         }
+       });
+
+    Res res = a_init;
+    for (Res const& p: partials)
+      res = a_red(res, p);
+    return res;
+  }
+}
+// End namespace DimTypes
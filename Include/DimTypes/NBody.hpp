@@ -0,0 +1,521 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "DimTypes/NBody.hpp":                           //
+//          Gravitational Accelerations of N Bodies: Direct Summation        //
+//                          and Barnes-Hut Tree                              //
+//===========================================================================//
+// "NBody<LenDQ, TimeDQ>" computes the accelerations
+//   a_i = Sum_{j != i} GM_j (r_j - r_i) / (|r_j - r_i|^2 + eps^2)^(3/2)
+// for positions typed as "LenDQ", "GM"s typed as "Len^3 Time^-2" (eg "km^3
+// sec^-2", or "AU^3 day^-2" as "GMS" in "DimTest.cpp") and the results typed
+// as "Len Time^-2"; "eps" is an optional softening length.
+// The positions are first copied into internal SoA arrays, translated to the
+// centre of their bounding box and scaled by a power of 2 (exactly) so that
+// all coords are in [-1, 1]:  this keeps the squared distances well within
+// the single-precision range used by the SIMD reciprocal square roots below
+// (as long as the bodies are no closer than ~1e-18 of the system size).
+// (*) "Direct": the O(N^2) sum, over blocks of targets and cache-sized tiles
+//     of sources; with AVX2, 4 sources are processed at a time, the 1/r being
+//     computed by "rsqrt" in single precision refined by 2 Newton iterations
+//     (relative error ~1e-14);
+// (*) "BarnesHut": an octree of the bodies is built (serially), and each tar-
+//     get walks it, replacing the cells which are far enough (by the "theta"
+//     opening criterion, with Barnes' correction for the offset of the centre
+//     of mass) by their monopoles; the targets are processed in the tree order
+//     for the memory locality. The cost is O(N log N), with the relative errors
+//     of the accelerations ~1e-3 for theta = 0.5;
+// (*) "Accel" uses "BarnesHut" for "theta" > 0 and N >= "NBodyBHMinN", and
+//     "Direct" otherwise.
+// In both cases, the targets are processed in parallel by a "ThreadPool".
+// An "NBody" object keeps its buffers between the calls (so that there are no
+// allocations in the steady state), and thus must not be used by multiple
+// threads concurrently:
+//
+#pragma  once
+#include "Vec3.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+  // The min number of bodies for which "Accel" uses the Barnes-Hut tree:
+  constexpr inline size_t NBodyBHMinN = 4096;
+
+namespace Bits
+{
+  constexpr inline size_t   NBodyTargetBlock = 32;    // Targets per block
+  constexpr inline size_t   NBodySourceTile  = 512;   // 16K of SoA per tile
+  constexpr inline unsigned NBodyLeafSize    = 8;     // Max bodies per leaf
+  constexpr inline unsigned NBodyMaxDepth    = 48;
+
+  //-------------------------------------------------------------------------//
+  // "NBodyRow": Sum of the Accelerations of One Target by a Tile:           //
+  //-------------------------------------------------------------------------//
+  // "a_n" must be a multiple of 4 (the arrays are padded with massless
+  // bodies).  The pairs at the zero distance (ie the target itself if there
+  // is no softening) contribute nothing:
+  //
+  inline void NBodyRow
+  (
+    double        a_xi,
+    double        a_yi,
+    double        a_zi,
+    double        a_eps2,
+    double const* a_x,
+    double const* a_y,
+    double const* a_z,
+    double const* a_m,
+    size_t        a_n,
+    double*       a_ax,
+    double*       a_ay,
+    double*       a_az
+  )
+  {
+    assert(a_n % 4 == 0);
+#   if defined(__AVX2__)
+    __m256d const xi   = _mm256_set1_pd(a_xi);
+    __m256d const yi   = _mm256_set1_pd(a_yi);
+    __m256d const zi   = _mm256_set1_pd(a_zi);
+    __m256d const eps2 = _mm256_set1_pd(a_eps2);
+    __m256d const c15  = _mm256_set1_pd(1.5);
+    __m256d const c05  = _mm256_set1_pd(0.5);
+    __m256d const zero = _mm256_setzero_pd();
+    __m256d sx = zero, sy = zero, sz = zero;
+
+    for (size_t j = 0; j < a_n; j += 4)
+    {
+      __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(a_x + j), xi);
+      __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(a_y + j), yi);
+      __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(a_z + j), zi);
+      __m256d r2 = _mm256_add_pd
+        (_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+         _mm256_add_pd(_mm256_mul_pd(dz, dz), eps2));
+
+      // 1/r: "rsqrt" (12 bits), then 2 Newton iterations y *= 1.5 - r2/2 y^2
+      // (~46 bits); the zero "r2"s are masked out:
+      __m256d y  = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2)));
+      __m256d h  = _mm256_mul_pd(c05, r2);
+      y = _mm256_mul_pd
+          (y, _mm256_sub_pd(c15, _mm256_mul_pd(h, _mm256_mul_pd(y, y))));
+      y = _mm256_mul_pd
+          (y, _mm256_sub_pd(c15, _mm256_mul_pd(h, _mm256_mul_pd(y, y))));
+      y = _mm256_and_pd(y, _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+
+      __m256d f  = _mm256_mul_pd
+                   (_mm256_loadu_pd(a_m + j),
+                    _mm256_mul_pd(y, _mm256_mul_pd(y, y)));
+      sx = _mm256_add_pd(sx, _mm256_mul_pd(f, dx));
+      sy = _mm256_add_pd(sy, _mm256_mul_pd(f, dy));
+      sz = _mm256_add_pd(sz, _mm256_mul_pd(f, dz));
+    }
+    alignas(32) double s[3][4];
+    _mm256_store_pd(s[0], sx);
+    _mm256_store_pd(s[1], sy);
+    _mm256_store_pd(s[2], sz);
+    *a_ax += (s[0][0] + s[0][1]) + (s[0][2] + s[0][3]);
+    *a_ay += (s[1][0] + s[1][1]) + (s[1][2] + s[1][3]);
+    *a_az += (s[2][0] + s[2][1]) + (s[2][2] + s[2][3]);
+#   else
+    double sx = 0.0, sy = 0.0, sz = 0.0;
+    for (size_t j = 0; j < a_n; ++j)
+    {
+      double dx = a_x[j] - a_xi;
+      double dy = a_y[j] - a_yi;
+      double dz = a_z[j] - a_zi;
+      double r2 = dx * dx + dy * dy + dz * dz + a_eps2;
+      double y  = (r2 > 0.0) ? 1.0 / std::sqrt(r2) : 0.0;
+      double f  = a_m[j] * y * y * y;
+      sx += f * dx;
+      sy += f * dy;
+      sz += f * dz;
+    }
+    *a_ax += sx;
+    *a_ay += sy;
+    *a_az += sz;
+#   endif
+  }
+
+  //-------------------------------------------------------------------------//
+  // "NBodyNode": Octree Node:                                               //
+  //-------------------------------------------------------------------------//
+  struct NBodyNode
+  {
+    double   m_cx, m_cy, m_cz;  // Centre of mass
+    double   m_m;               // Total GM
+    double   m_open2;           // Opened if the squared distance is below it
+    uint32_t m_first;           // First child node, or first (sorted) body
+    uint32_t m_count;           // Number of children or bodies
+    bool     m_leaf;
+  };
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "NBody":                                                                //
+  //=========================================================================//
+  template<typename LenDQ, typename TimeDQ>
+  class NBody
+  {
+  public:
+    using Time2 = decltype(std::declval<TimeDQ>() * std::declval<TimeDQ>());
+    using GMDQ  = decltype(std::declval<LenDQ>() * std::declval<LenDQ>() *
+                           std::declval<LenDQ>() / std::declval<Time2>());
+    using AccDQ = decltype(std::declval<LenDQ>() / std::declval<Time2>());
+
+    static_assert(std::is_same_v<AccDQ,
+                                 decltype(std::declval<GMDQ>() /
+                                          (std::declval<LenDQ>() *
+                                           std::declval<LenDQ>()))>,
+                  "ERROR: NBody: Inconsistent Len and Time Units");
+    static_assert(std::is_same_v<typename DimQTraits<LenDQ>::RepT, double>,
+                  "ERROR: NBody: RepT must be double");
+
+  private:
+    ThreadPool*                  m_pool;
+    double                       m_theta;
+    LenDQ                        m_soft;
+    // Scaled SoA copies of the positions and GMs (in the input order for
+    // "Direct", in the tree order for "BarnesHut"),  padded to a multiple of
+    // 4 with massless bodies:
+    std::vector<double>          m_x, m_y, m_z, m_m;
+    double                       m_c[3];    // Centre of the positions
+    double                       m_scale;   // Of the positions
+    double                       m_eps2;    // Scaled
+    // "BarnesHut" only:
+    std::vector<uint32_t>        m_perm;    // Tree order -> input order
+    std::vector<uint32_t>        m_tmp;
+    std::vector<Bits::NBodyNode> m_nodes;
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Ctor:                                                                 //
+    //-----------------------------------------------------------------------//
+    // "a_theta" = 0 disables the Barnes-Hut tree in "Accel":
+    //
+    explicit NBody(double      a_theta = 0.0,
+                   LenDQ       a_soft  = LenDQ(0.0),
+                   ThreadPool& a_pool  = ThreadPool::Default())
+    : m_pool (&a_pool),
+      m_theta(a_theta),
+      m_soft (a_soft),
+      m_x    (),
+      m_y    (),
+      m_z    (),
+      m_m    (),
+      m_c    { 0.0, 0.0, 0.0 },
+      m_scale(1.0),
+      m_eps2 (0.0),
+      m_perm (),
+      m_tmp  (),
+      m_nodes()
+    {
+      if (UNLIKELY(!(a_theta >= 0.0) || !(a_soft >= LenDQ(0.0))))
+        throw std::invalid_argument("NBody: Invalid Theta or Softening");
+    }
+
+    double Theta() const { return m_theta; }
+    LenDQ  Soft () const { return m_soft;  }
+
+    //-----------------------------------------------------------------------//
+    // "Accel":                                                              //
+    //-----------------------------------------------------------------------//
+    void Accel(Vec3<LenDQ> const* a_pos, GMDQ const* a_gm, size_t a_n,
+               Vec3<AccDQ>* a_acc)
+    {
+      if (m_theta > 0.0 && a_n >= NBodyBHMinN)
+        BarnesHut(a_pos, a_gm, a_n, a_acc);
+      else
+        Direct   (a_pos, a_gm, a_n, a_acc);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Direct":                                                             //
+    //-----------------------------------------------------------------------//
+    void Direct(Vec3<LenDQ> const* a_pos, GMDQ const* a_gm, size_t a_n,
+                Vec3<AccDQ>* a_acc)
+    {
+      assert(a_pos != nullptr && a_gm != nullptr && a_acc != nullptr);
+      if (a_n == 0)
+        return;
+      Load(a_pos, a_gm, a_n, nullptr);
+      size_t const np = m_x.size();
+
+      m_pool->ParallelFor(a_n, Bits::NBodyTargetBlock,
+      [this, a_acc, np](size_t a_from, size_t a_to)
+      {
+        constexpr size_t TI = Bits::NBodyTargetBlock;
+        constexpr size_t TJ = Bits::NBodySourceTile;
+        assert(a_to - a_from <= TI);
+        double ax[TI] = {}, ay[TI] = {}, az[TI] = {};
+
+        // Each source tile stays in L1 while the block of targets runs on it:
+        for (size_t j = 0; j < np; j += TJ)
+        {
+          size_t nj = std::min(TJ, np - j);
+          for (size_t i = a_from; i < a_to; ++i)
+            Bits::NBodyRow(m_x[i], m_y[i], m_z[i], m_eps2,
+                           m_x.data() + j, m_y.data() + j, m_z.data() + j,
+                           m_m.data() + j, nj,
+                           ax + (i - a_from), ay + (i - a_from),
+                           az + (i - a_from));
+        }
+        for (size_t i = a_from; i < a_to; ++i)
+          a_acc[i] = Result(ax[i - a_from], ay[i - a_from], az[i - a_from]);
+      });
+    }
+
+    //-----------------------------------------------------------------------//
+    // "BarnesHut":                                                          //
+    //-----------------------------------------------------------------------//
+    // "theta" must be positive:
+    //
+    void BarnesHut(Vec3<LenDQ> const* a_pos, GMDQ const* a_gm, size_t a_n,
+                   Vec3<AccDQ>* a_acc)
+    {
+      assert(a_pos != nullptr && a_gm != nullptr && a_acc != nullptr);
+      if (UNLIKELY(!(m_theta > 0.0) ||
+                   a_n >= size_t(std::numeric_limits<uint32_t>::max())))
+        throw std::invalid_argument("NBody::BarnesHut: Invalid Theta or N");
+      if (a_n == 0)
+        return;
+
+      // Build the tree over the input order, then re-load the SoA arrays in
+      // the tree order:
+      Load(a_pos, a_gm, a_n, nullptr);
+      m_perm.resize(a_n);
+      m_tmp .resize(a_n);
+      for (size_t i = 0; i < a_n; ++i)
+        m_perm[i] = uint32_t(i);
+      m_nodes.clear();
+      m_nodes.emplace_back();
+      Build(0, 0, uint32_t(a_n), 0.0, 0.0, 0.0, 1.0, 0);
+      Load(a_pos, a_gm, a_n, m_perm.data());
+
+      m_pool->ParallelFor(a_n, 256,
+      [this, a_acc](size_t a_from, size_t a_to)
+      {
+        for (size_t t = a_from; t < a_to; ++t)
+        {
+          double ax = 0.0, ay = 0.0, az = 0.0;
+          Walk(m_x[t], m_y[t], m_z[t], &ax, &ay, &az);
+          a_acc[m_perm[t]] = Result(ax, ay, az);
+        }
+      });
+    }
+
+  private:
+    //-----------------------------------------------------------------------//
+    // "Load": Scaled SoA Copies (Permuted by "a_perm" if non-NULL):         //
+    //-----------------------------------------------------------------------//
+    // The centre and the scale are computed by the un-permuted "Load" (the
+    // permuted one in "BarnesHut" re-uses them):
+    //
+    void Load(Vec3<LenDQ> const* a_pos, GMDQ const* a_gm, size_t a_n,
+              uint32_t const* a_perm)
+    {
+      if (a_perm == nullptr)
+      {
+        double lo[3], hi[3];
+        for (unsigned c = 0; c < 3; ++c)
+          lo[c] = hi[c] = a_pos[0][c].Magnitude();
+        for (size_t i = 1; i < a_n; ++i)
+          for (unsigned c = 0; c < 3; ++c)
+          {
+            double v = a_pos[i][c].Magnitude();
+            lo[c] = std::min(lo[c], v);
+            hi[c] = std::max(hi[c], v);
+          }
+        double ext = 0.0;
+        for (unsigned c = 0; c < 3; ++c)
+        {
+          ext     = std::max(ext, hi[c] - lo[c]);
+          m_c[c]  = 0.5 * (lo[c] + hi[c]);
+        }
+        if (UNLIKELY(!std::isfinite(ext)))
+          throw std::invalid_argument("NBody: Invalid Positions");
+
+        // The half-extent is scaled to [0.5, 1), so that the root cell (of
+        // half-size 1) contains all bodies but is not too large ("ilogb" of
+        // the half-extent alone would give [1, 2), ie cells up to 2x larger
+        // than assumed by the opening test):
+        m_scale  = (ext > 0.0)
+                 ? std::ldexp(1.0, -std::ilogb(0.5 * ext) - 1) : 1.0;
+        double e = m_soft.Magnitude() * m_scale;
+        m_eps2   = e * e;
+      }
+      double const s3 = m_scale * m_scale * m_scale;
+      size_t const np = (a_n + 3) / 4 * 4;
+      m_x.assign(np, 0.0);
+      m_y.assign(np, 0.0);
+      m_z.assign(np, 0.0);
+      m_m.assign(np, 0.0);
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        size_t k = (a_perm != nullptr) ? a_perm[i] : i;
+        m_x[i] = (a_pos[k][0].Magnitude() - m_c[0]) * m_scale;
+        m_y[i] = (a_pos[k][1].Magnitude() - m_c[1]) * m_scale;
+        m_z[i] = (a_pos[k][2].Magnitude() - m_c[2]) * m_scale;
+        m_m[i] = a_gm[k].Magnitude() * s3;
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Build": The Sub-Tree of the Bodies "m_perm[a_lo .. a_hi)":           //
+    //-----------------------------------------------------------------------//
+    // The cell is the cube of the half-size "a_half" around (a_gx, a_gy, a_gz);
+    // the bodies are partitioned by octant in place, so that in the end, each
+    // leaf holds a contiguous range of "m_perm":
+    //
+    void Build(uint32_t a_node, uint32_t a_lo, uint32_t a_hi,
+               double a_gx, double a_gy, double a_gz, double a_half,
+               unsigned a_depth)
+    {
+      Bits::NBodyNode nd {};
+      if (a_hi - a_lo <= Bits::NBodyLeafSize || a_depth == Bits::NBodyMaxDepth)
+      {
+        nd.m_leaf  = true;
+        nd.m_first = a_lo;
+        nd.m_count = a_hi - a_lo;
+        for (uint32_t k = a_lo; k < a_hi; ++k)
+        {
+          uint32_t b = m_perm[k];
+          nd.m_cx   += m_m[b] * m_x[b];
+          nd.m_cy   += m_m[b] * m_y[b];
+          nd.m_cz   += m_m[b] * m_z[b];
+          nd.m_m    += m_m[b];
+        }
+      }
+      else
+      {
+        auto octant = [&](uint32_t a_b) -> unsigned
+        {
+          return unsigned(m_x[a_b] >= a_gx)        |
+                 (unsigned(m_y[a_b] >= a_gy) << 1) |
+                 (unsigned(m_z[a_b] >= a_gz) << 2);
+        };
+        uint32_t cnt[8] = {}, off[8];
+        for (uint32_t k = a_lo; k < a_hi; ++k)
+          ++cnt[octant(m_perm[k])];
+        off[0] = a_lo;
+        for (unsigned o = 1; o < 8; ++o)
+          off[o] = off[o - 1] + cnt[o - 1];
+        for (uint32_t k = a_lo; k < a_hi; ++k)
+          m_tmp[off[octant(m_perm[k])]++] = m_perm[k];
+        std::copy(m_tmp.begin() + a_lo, m_tmp.begin() + a_hi,
+                  m_perm.begin() + a_lo);
+
+        nd.m_first = uint32_t(m_nodes.size());
+        for (unsigned o = 0; o < 8; ++o)
+          nd.m_count += (cnt[o] != 0);
+        m_nodes.resize(m_nodes.size() + nd.m_count);
+
+        double   h     = 0.5 * a_half;
+        uint32_t child = nd.m_first;
+        uint32_t lo    = a_lo;
+        for (unsigned o = 0; o < 8; ++o)
+        {
+          if (cnt[o] == 0)
+            continue;
+          Build(child, lo, lo + cnt[o],
+                a_gx + ((o & 1) ? h : -h), a_gy + ((o & 2) ? h : -h),
+                a_gz + ((o & 4) ? h : -h), h, a_depth + 1);
+          Bits::NBodyNode const& c = m_nodes[child];
+          nd.m_cx += c.m_m * c.m_cx;
+          nd.m_cy += c.m_m * c.m_cy;
+          nd.m_cz += c.m_m * c.m_cz;
+          nd.m_m  += c.m_m;
+          lo      += cnt[o];
+          ++child;
+        }
+      }
+      // Centre of mass (or the geometric centre for a massless cell), and the
+      // opening distance (Barnes' criterion: size / theta + the offset of the
+      // centre of mass from the geometric one):
+      if (nd.m_m > 0.0)
+      {
+        nd.m_cx /= nd.m_m;
+        nd.m_cy /= nd.m_m;
+        nd.m_cz /= nd.m_m;
+      }
+      else
+      {
+        nd.m_cx = a_gx;
+        nd.m_cy = a_gy;
+        nd.m_cz = a_gz;
+      }
+      double dx    = nd.m_cx - a_gx, dy = nd.m_cy - a_gy, dz = nd.m_cz - a_gz;
+      double open  = 2.0 * a_half / m_theta + std::sqrt(dx*dx + dy*dy + dz*dz);
+      nd.m_open2   = open * open;
+      m_nodes[a_node] = nd;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Walk": The Acceleration of a Target by the Tree:                     //
+    //-----------------------------------------------------------------------//
+    void Walk(double a_px, double a_py, double a_pz,
+              double* a_ax, double* a_ay, double* a_az) const
+    {
+      uint32_t stack[7 * Bits::NBodyMaxDepth + 8];
+      unsigned sp = 0;
+      stack[sp++] = 0;
+      double ax = 0.0, ay = 0.0, az = 0.0;
+
+      while (sp > 0)
+      {
+        Bits::NBodyNode const& nd = m_nodes[stack[--sp]];
+        double dx = nd.m_cx - a_px, dy = nd.m_cy - a_py, dz = nd.m_cz - a_pz;
+        double r2 = dx * dx + dy * dy + dz * dz + m_eps2;
+
+        if (r2 >= nd.m_open2)
+        {
+          // Far enough: the monopole (r2 > 0 here):
+          double y = 1.0 / std::sqrt(r2);
+          double f = nd.m_m * y * y * y;
+          ax += f * dx;
+          ay += f * dy;
+          az += f * dz;
+        }
+        else
+        if (nd.m_leaf)
+          for (uint32_t k = nd.m_first; k < nd.m_first + nd.m_count; ++k)
+          {
+            double bx = m_x[k] - a_px, by = m_y[k] - a_py, bz = m_z[k] - a_pz;
+            double b2 = bx * bx + by * by + bz * bz + m_eps2;
+            if (b2 > 0.0)
+            {
+              double y = 1.0 / std::sqrt(b2);
+              double f = m_m[k] * y * y * y;
+              ax += f * bx;
+              ay += f * by;
+              az += f * bz;
+            }
+          }
+        else
+          for (uint32_t c = 0; c < nd.m_count; ++c)
+            stack[sp++] = nd.m_first + c;
+      }
+      *a_ax = ax;
+      *a_ay = ay;
+      *a_az = az;
+    }
+
+    // Un-scaling of an acceleration ("GM" scaled by s^3, distances by s):
+    Vec3<AccDQ> Result(double a_ax, double a_ay, double a_az) const
+    {
+      double u = 1.0 / m_scale;
+      return Vec3<AccDQ>{{ AccDQ(a_ax * u), AccDQ(a_ay * u), AccDQ(a_az * u) }};
+    }
+  };
+}
+// End namespace DimTypes
@@ -0,0 +1,893 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "DimTypes/NumPy.hpp":                           //
+//       NumPy ".npy" / ".npz" Files of "DimQ"s, with Units Metadata         //
+//===========================================================================//
+// The arrays are stored as plain 1-D NumPy arrays of "RepT" (dtypes "f4",
+// "f8", "c8", "c16", in the native byte order).  NumPy rejects any extra keys
+// in the ".npy" header dict, so the Units (in the "Bits::PutUnits" format, eg
+// "km sec^(-1)") are stored as 0-d string arrays next to the data:
+// (*) for "Name.npy":   in the sidecar file "Name.units.npy";
+// (*) in ".npz" files:  as the member "Name.units" next to "Name";
+// so in Python, the Units are simply "str(np.load('x.units.npy'))" or
+// "str(z['x.units'])", and are written back by "np.save('x.units.npy', 'km')"
+// or "np.savez(f, **{'x': a, 'x.units': 'km'})". Arrays without Units are
+// DimLess.
+// The ".npz" members are written "stored" (uncompressed),  with the data 64-
+// byte-aligned, so "NpyReader" returns zero-copy spans into the "mmap"ed file.
+// Compressed ".npz" files ("np.savez_compressed") are not supported:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include "Bits/FileIO.hpp"
+#include <array>
+#include <bit>
+#include <charconv>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // ".npy" Format Utils:                                                    //
+  //=========================================================================//
+  constexpr inline char   NpyMagic[] = "\x93NUMPY";
+  constexpr inline size_t NpyAlign   = 64;
+
+  //-------------------------------------------------------------------------//
+  // "NpyDescr": The NumPy dtype string of "RepT", eg "<f8":                 //
+  //-------------------------------------------------------------------------//
+  template<typename RepT>
+  inline std::string NpyDescr()
+  {
+    static_assert(RepCode<RepT> != 0 && RepCode<RepT> != 3 &&
+                  RepCode<RepT> != 6,
+                  "NumPy: UnSupported RepT (long double is platform-specific)");
+    char buff[8];
+    snprintf(buff, sizeof(buff), "%c%c%zu",
+             (std::endian::native == std::endian::little) ? '<' : '>',
+             CEMaths::IsComplex<RepT> ? 'c' : 'f', sizeof(RepT));
+    return buff;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "NpyMkHeader":                                                          //
+  //-------------------------------------------------------------------------//
+  // Version 1.0 header, padded with spaces to a multiple of "NpyAlign". "a_n"
+  // is the length of a 1-D array, or -1 for a 0-d one:
+  //
+  inline std::string NpyMkHeader(std::string const& a_descr, int64_t a_n)
+  {
+    char dict[128];
+    int  len  =
+      (a_n >= 0)
+      ? snprintf(dict, sizeof(dict),
+                 "{'descr': '%s', 'fortran_order': False, 'shape': (%ld,), }",
+                 a_descr.data(), long(a_n))
+      : snprintf(dict, sizeof(dict),
+                 "{'descr': '%s', 'fortran_order': False, 'shape': (), }",
+                 a_descr.data());
+    assert(len > 0 && size_t(len) < sizeof(dict));
+
+    // 10 = Magic (6) + Version (2) + HeaderLen (2); +1 for the final '\n':
+    size_t total = (10 + size_t(len) + 1 + NpyAlign - 1) / NpyAlign * NpyAlign;
+    size_t hLen  = total - 10;
+
+    std::string res(NpyMagic, 6);
+    res.push_back('\x01');
+    res.push_back('\x00');
+    res.push_back(char(hLen & 0xff));
+    res.push_back(char(hLen >> 8));
+    res.append(dict, size_t(len));
+    res.append(total - res.size() - 1, ' ');
+    res.push_back('\n');
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "NpyMkUnits": A complete 0-d ".npy" string array of the Units of "DQ":  //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  inline std::string NpyMkUnits()
+  {
+    using Tr = DimQTraits<DQ>;
+    // NB: The suffix is of the form " Unit1 Unit2^N ...", or just the termin-
+    // ating 0 for DimLess vals:
+    constexpr auto&  Suffix = UnitsSuffix<Sys, Tr::E, Tr::U>;
+    constexpr size_t Len    = (Suffix.size() > 1) ? Suffix.size() - 2 : 0;
+
+    // NumPy strings are UCS-4; an empty string is stored as "<U1":
+    std::string res = NpyMkHeader
+      (((std::endian::native == std::endian::little) ? "<U" : ">U") +
+       std::to_string(std::max<size_t>(Len, 1)), -1);
+    for (size_t i = 0; i < std::max<size_t>(Len, 1); ++i)
+    {
+      uint32_t c = (Len == 0) ? 0 : uint32_t(uint8_t(Suffix[i + 1]));
+      res.append(reinterpret_cast<char const*>(&c), 4);
+    }
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "NpyHdrInfo", "NpyParseHeader":                                         //
+  //-------------------------------------------------------------------------//
+  // Parses the header of a ".npy" image of "a_len" bytes; only 0-d and 1-D
+  // arrays are accepted. Throws "std::runtime_error" on any error:
+  //
+  struct NpyHdrInfo
+  {
+    std::string m_descr;
+    int64_t     m_n;        // -1 for 0-d arrays
+    size_t      m_dataOff;  // From the beginning of the image
+  };
+
+  [[noreturn]] inline void NpyFail(char const* a_msg)
+    { throw std::runtime_error(std::string("NumPy: Invalid Data: ") + a_msg); }
+
+  inline NpyHdrInfo NpyParseHeader(char const* a_data, size_t a_len)
+  {
+    assert(a_data != nullptr);
+    if (UNLIKELY(a_len < 10 || memcmp(a_data, NpyMagic, 6) != 0))
+      NpyFail("Bad Magic");
+
+    // Versions 1.0 (16-bit HeaderLen) and 2.0, 3.0 (32-bit HeaderLen):
+    auto const* u    = reinterpret_cast<uint8_t const*>(a_data);
+    size_t      hOff = (u[6] == 1) ? 10 : 12;
+    if (UNLIKELY(u[6] < 1 || u[6] > 3 || a_len < hOff))
+      NpyFail("UnSupported Version");
+    size_t hLen = (u[6] == 1)
+                ? (size_t(u[8]) | size_t(u[9]) << 8)
+                : (size_t(u[8])  | size_t(u[9])  << 8 |
+                   size_t(u[10]) << 16 | size_t(u[11]) << 24);
+    if (UNLIKELY(hOff + hLen > a_len))
+      NpyFail("Truncated Header");
+
+    std::string_view hdr(a_data + hOff, hLen);
+    NpyHdrInfo       res { {}, 0, hOff + hLen };
+
+    // Returns the position right after the "'key':" and any spaces:
+    auto find = [&hdr](char const* a_key) -> size_t
+    {
+      size_t pos = hdr.find(a_key);
+      if (UNLIKELY(pos == std::string_view::npos))
+        NpyFail("Missing Header Key");
+      pos += strlen(a_key);
+      while (pos < hdr.size() && (hdr[pos] == ' ' || hdr[pos] == ':'))
+        ++pos;
+      return pos;
+    };
+
+    // "descr": a quoted string:
+    size_t pos = find("'descr'");
+    size_t end = hdr.find('\'', pos + 1);
+    if (UNLIKELY(pos >= hdr.size() || hdr[pos] != '\'' ||
+                 end == std::string_view::npos))
+      NpyFail("Invalid descr");
+    res.m_descr = hdr.substr(pos + 1, end - pos - 1);
+
+    // "fortran_order": irrelevant for 0-d and 1-D arrays, but must be there:
+    (void) find("'fortran_order'");
+
+    // "shape": "()" or "(N,)":
+    pos = find("'shape'");
+    if (UNLIKELY(pos >= hdr.size() || hdr[pos] != '('))
+      NpyFail("Invalid shape");
+    ++pos;
+    if (pos < hdr.size() && hdr[pos] == ')')
+      res.m_n = -1;
+    else
+    {
+      auto rc = std::from_chars(hdr.data() + pos, hdr.data() + hdr.size(),
+                                res.m_n);
+      pos     = size_t(rc.ptr - hdr.data());
+      if (UNLIKELY(rc.ec != std::errc() || res.m_n < 0 ||
+                   pos + 1 >= hdr.size() || hdr[pos] != ',' ||
+                   hdr[pos + 1] != ')'))
+        NpyFail("Only 0-d and 1-D Arrays are Supported");
+    }
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "NpyGetStr": The contents of a 0-d "U" or "S" ".npy" array:             //
+  //-------------------------------------------------------------------------//
+  // Only ASCII chars are accepted, as are all Units names:
+  //
+  inline std::string NpyGetStr(char const* a_data, size_t a_len)
+  {
+    NpyHdrInfo info  = NpyParseHeader(a_data, a_len);
+    std::string const& d = info.m_descr;
+    bool       isU   = (d.size() >= 3 && d[1] == 'U');
+    bool       isS   = (d.size() >= 3 && d[1] == 'S');
+    size_t     width = isU ? 4 : 1;
+    size_t     n     = 0;
+    if (UNLIKELY(info.m_n != -1 || !(isU || isS) ||
+                 std::from_chars(d.data() + 2, d.data() + d.size(), n).ec !=
+                 std::errc() || n > (a_len - info.m_dataOff) / width))
+      NpyFail("Invalid Units Array");
+
+    std::string res;
+    auto const* u = reinterpret_cast<uint8_t const*>(a_data + info.m_dataOff);
+    for (size_t i = 0; i < n; ++i, u += width)
+    {
+      uint32_t c =
+        isS           ? uint32_t(u[0])
+        : (d[0] == '>') ? (uint32_t(u[0]) << 24 | uint32_t(u[1]) << 16 |
+                           uint32_t(u[2]) << 8  | uint32_t(u[3]))
+        : (uint32_t(u[0])       | uint32_t(u[1]) << 8 |
+           uint32_t(u[2]) << 16 | uint32_t(u[3]) << 24);
+      if (c == 0)
+        break;    // NumPy pads strings with 0s
+      if (UNLIKELY(c > 0x7f))
+        NpyFail("Non-ASCII Units");
+      res.push_back(char(c));
+    }
+    return res;
+  }
+
+  //=========================================================================//
+  // ".npz" (ZIP) Format Utils:                                              //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "CRC32": As required by ZIP:                                            //
+  //-------------------------------------------------------------------------//
+  constexpr std::array<uint32_t, 256> MkCRC32Table()
+  {
+    std::array<uint32_t, 256> res {};
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? (0xedb88320U ^ (c >> 1)) : (c >> 1);
+      res[i] = c;
+    }
+    return res;
+  }
+  constexpr inline std::array<uint32_t, 256> CRC32Table = MkCRC32Table();
+
+  inline uint32_t CRC32(uint32_t a_crc, void const* a_data, size_t a_len)
+  {
+    auto const* p   = static_cast<uint8_t const*>(a_data);
+    uint32_t    crc = ~a_crc;
+    for (size_t i = 0; i < a_len; ++i)
+      crc = CRC32Table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+  }
+
+  //-------------------------------------------------------------------------//
+  // Little-Endian ZIP Fields:                                               //
+  //-------------------------------------------------------------------------//
+  inline void ZipPut16(std::string* a_out, uint32_t a_x)
+  {
+    a_out->push_back(char(a_x & 0xff));
+    a_out->push_back(char((a_x >> 8) & 0xff));
+  }
+
+  inline void ZipPut32(std::string* a_out, uint32_t a_x)
+  {
+    ZipPut16(a_out, a_x & 0xffff);
+    ZipPut16(a_out, a_x >> 16);
+  }
+
+  inline uint64_t ZipGet(char const* a_p, unsigned a_nBytes)
+  {
+    auto const* u   = reinterpret_cast<uint8_t const*>(a_p);
+    uint64_t    res = 0;
+    for (unsigned i = 0; i < a_nBytes; ++i)
+      res |= uint64_t(u[i]) << (8 * i);
+    return res;
+  }
+
+  constexpr inline uint32_t ZipLocalSig   = 0x04034b50;
+  constexpr inline uint32_t ZipCentralSig = 0x02014b50;
+  constexpr inline uint32_t ZipEOCDSig    = 0x06054b50;
+  constexpr inline uint32_t Zip64EOCDSig  = 0x06064b50;
+  constexpr inline uint32_t Zip64LocSig   = 0x07064b50;
+  constexpr inline uint16_t ZipAlignId    = 0xd935;   // As used by "zipalign"
+  constexpr inline uint16_t ZipDOSDate    = 0x21;     // 1980-01-01
+
+  //-------------------------------------------------------------------------//
+  // "NpySidecarPath": "Name.npy" -> "Name.units.npy":                       //
+  //-------------------------------------------------------------------------//
+  inline std::string NpySidecarPath(char const* a_path)
+  {
+    std::string res(a_path);
+    if (res.size() >= 4 && res.compare(res.size() - 4, 4, ".npy") == 0)
+      res.resize(res.size() - 4);
+    return res + ".units.npy";
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "NpySave": A single array into a ".npy" file (+ the Units sidecar):     //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS":
+  //
+  template<typename Sys, typename DQ>
+  void NpySave(char const* a_path, DQ const* a_data, size_t a_n)
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  Tr::MaxDims == Sys::MaxDims,
+                  "NpySave: Incompatible DimQ Type");
+    assert(a_path != nullptr && (a_data != nullptr || a_n == 0));
+
+    auto save = [](std::string const& a_path1, std::string const& a_hdr,
+                   void const* a_data1,        size_t             a_len)
+    {
+      int fd = open(a_path1.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+      if (UNLIKELY(fd < 0))
+        Bits::ThrowSysErr("NpySave");
+      try
+      {
+        Bits::WriteAll(fd, a_hdr.data(), a_hdr.size(), "NpySave");
+        Bits::WriteAll(fd, a_data1,      a_len,        "NpySave");
+      }
+      catch (...)
+      {
+        close(fd);
+        throw;
+      }
+      if (UNLIKELY(close(fd) < 0))
+        Bits::ThrowSysErr("NpySave");
+    };
+    // NB: "DimQ" is layout-compatible with "RepT":
+    save(a_path, Bits::NpyMkHeader(Bits::NpyDescr<RepT>(), int64_t(a_n)),
+         a_data, a_n * sizeof(RepT));
+    save(Bits::NpySidecarPath(a_path), Bits::NpyMkUnits<Sys, DQ>(),
+         nullptr, 0);
+  }
+
+  //=========================================================================//
+  // "NpzWriter": Multiple named arrays into an ".npz" file:                 //
+  //=========================================================================//
+  // Usage: "Add" any number of arrays (of any types and lengths), then "Close"
+  // (also invoked by the Dtor, but then errors are not reported). ZIP64 is not
+  // used, so the file size is limited to 4 GB (use "NpySave" for larger arr-
+  // ays):
+  //
+  template<typename Sys>
+  class NpzWriter
+  {
+  private:
+    using RepT = typename Sys::RepT;
+
+    struct Entry
+    {
+      std::string m_name;
+      uint32_t    m_crc;
+      uint32_t    m_size;
+      uint32_t    m_off;
+    };
+
+    int                 m_fd;
+    uint64_t            m_off;       // Curr write offset
+    std::vector<Entry>  m_entries;
+
+    void WriteAll(void const* a_data, size_t a_len)
+    {
+      Bits::WriteAll(m_fd, a_data, a_len, "NpzWriter::WriteAll");
+      m_off += a_len;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "AddMember": "a_hdr" followed by "a_data":                            //
+    //-----------------------------------------------------------------------//
+    void AddMember
+    (
+      std::string const& a_name,
+      std::string const& a_hdr,
+      void const*        a_data,
+      size_t             a_len
+    )
+    {
+      if (UNLIKELY(m_fd < 0))
+        throw std::runtime_error("NpzWriter::Add: Already Closed");
+      uint64_t size = a_hdr.size() + a_len;
+      if (UNLIKELY(m_off + size + 1024 + a_name.size() >= UINT32_MAX ||
+                   m_entries.size() >= UINT16_MAX || a_name.size() > 1024))
+        throw std::runtime_error("NpzWriter::Add: ZIP Limits Exceeded");
+
+      uint32_t crc = Bits::CRC32(0,   a_hdr.data(), a_hdr.size());
+      crc          = Bits::CRC32(crc, a_data,       a_len);
+
+      // The "extra" field pads the member data up to "NpyAlign":
+      size_t pad   = (Bits::NpyAlign -
+                      (m_off + 30 + a_name.size() + 6) % Bits::NpyAlign) %
+                     Bits::NpyAlign;
+      std::string lh;
+      Bits::ZipPut32(&lh, Bits::ZipLocalSig);
+      Bits::ZipPut16(&lh, 20);                // Version needed
+      Bits::ZipPut16(&lh, 0);                 // Flags
+      Bits::ZipPut16(&lh, 0);                 // Method: Stored
+      Bits::ZipPut16(&lh, 0);                 // Time
+      Bits::ZipPut16(&lh, Bits::ZipDOSDate);
+      Bits::ZipPut32(&lh, crc);
+      Bits::ZipPut32(&lh, uint32_t(size));    // Compressed
+      Bits::ZipPut32(&lh, uint32_t(size));    // UnCompressed
+      Bits::ZipPut16(&lh, uint32_t(a_name.size()));
+      Bits::ZipPut16(&lh, uint32_t(6 + pad));
+      lh.append(a_name);
+      Bits::ZipPut16(&lh, Bits::ZipAlignId);
+      Bits::ZipPut16(&lh, uint32_t(2 + pad));
+      Bits::ZipPut16(&lh, Bits::NpyAlign);
+      lh.append(pad, '\0');
+
+      m_entries.push_back(Entry{a_name, crc, uint32_t(size), uint32_t(m_off)});
+      WriteAll(lh.data(),    lh.size());
+      assert(m_off % Bits::NpyAlign == 0);
+      WriteAll(a_hdr.data(), a_hdr.size());
+      WriteAll(a_data,       a_len);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    explicit NpzWriter(char const* a_path)
+    : m_fd     (open(a_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+      m_off    (0),
+      m_entries()
+    {
+      if (UNLIKELY(m_fd < 0))
+        Bits::ThrowSysErr("NpzWriter::Ctor");
+    }
+
+    ~NpzWriter()
+    {
+      if (m_fd >= 0)
+        try { Close(); } catch (...) {}
+    }
+
+    NpzWriter(NpzWriter const&)            = delete;
+    NpzWriter& operator=(NpzWriter const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // "Add": The array "a_name" and its Units "a_name.units":               //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    void Add(char const* a_name, DQ const* a_data, size_t a_n)
+    {
+      using Tr = DimQTraits<DQ>;
+      static_assert(Tr::IsDimQ && std::is_same_v<typename Tr::RepT, RepT> &&
+                    Tr::MaxDims == Sys::MaxDims,
+                    "NpzWriter::Add: Incompatible DimQ Type");
+      assert(a_name != nullptr && (a_data != nullptr || a_n == 0));
+
+      AddMember(std::string(a_name) + ".npy",
+                Bits::NpyMkHeader(Bits::NpyDescr<RepT>(), int64_t(a_n)),
+                a_data, a_n * sizeof(RepT));
+      AddMember(std::string(a_name) + ".units.npy",
+                Bits::NpyMkUnits<Sys, DQ>(), nullptr, 0);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Close": Writes out the Central Directory:                            //
+    //-----------------------------------------------------------------------//
+    void Close()
+    {
+      if (m_fd < 0)
+        return;
+
+      std::string cd;
+      for (Entry const& e: m_entries)
+      {
+        Bits::ZipPut32(&cd, Bits::ZipCentralSig);
+        Bits::ZipPut16(&cd, 20);              // Version made by
+        Bits::ZipPut16(&cd, 20);              // Version needed
+        Bits::ZipPut16(&cd, 0);               // Flags
+        Bits::ZipPut16(&cd, 0);               // Method: Stored
+        Bits::ZipPut16(&cd, 0);               // Time
+        Bits::ZipPut16(&cd, Bits::ZipDOSDate);
+        Bits::ZipPut32(&cd, e.m_crc);
+        Bits::ZipPut32(&cd, e.m_size);
+        Bits::ZipPut32(&cd, e.m_size);
+        Bits::ZipPut16(&cd, uint32_t(e.m_name.size()));
+        Bits::ZipPut16(&cd, 0);               // Extra len
+        Bits::ZipPut16(&cd, 0);               // Comment len
+        Bits::ZipPut16(&cd, 0);               // Disk
+        Bits::ZipPut16(&cd, 0);               // Internal attrs
+        Bits::ZipPut32(&cd, 0);               // External attrs
+        Bits::ZipPut32(&cd, e.m_off);
+        cd.append(e.m_name);
+      }
+      uint64_t cdOff  = m_off;
+      uint64_t cdSize = cd.size();
+      Bits::ZipPut32(&cd, Bits::ZipEOCDSig);
+      Bits::ZipPut16(&cd, 0);                 // Disk
+      Bits::ZipPut16(&cd, 0);                 // Disk with the CD
+      Bits::ZipPut16(&cd, uint32_t(m_entries.size()));
+      Bits::ZipPut16(&cd, uint32_t(m_entries.size()));
+      Bits::ZipPut32(&cd, uint32_t(cdSize));
+      Bits::ZipPut32(&cd, uint32_t(cdOff));
+      Bits::ZipPut16(&cd, 0);                 // Comment len
+
+      if (UNLIKELY(cdOff + cd.size() >= UINT32_MAX))
+        throw std::runtime_error("NpzWriter::Close: ZIP Limits Exceeded");
+      WriteAll(cd.data(), cd.size());
+
+      int fd = m_fd;
+      m_fd   = -1;
+      if (UNLIKELY(close(fd) < 0))
+        Bits::ThrowSysErr("NpzWriter::Close");
+    }
+  };
+
+  //=========================================================================//
+  // "NpyReader": ".npy" or ".npz" Files:                                    //
+  //=========================================================================//
+  // As "ColumnarReader", "mmap"s the whole file read-only. The file type is
+  // determined by its magic; a ".npy" file contains a single array (named af-
+  // ter the file), with its Units taken from the sidecar (if it exists); in
+  // ".npz" files, the "Name.units" members are attached to the "Name" arrays,
+  // and non-array members are ignored. Each array is validated against the
+  // requested "DimQ" type on the first "GetArray" call for that type, subse-
+  // quent calls are O(1). Units conversions (if any) are made into copies
+  // owned by the reader (one per Units), so the spans returned for any Units
+  // remain valid for the life-time of the reader. Arrays which are not aligned
+  // on "alignof(RepT)" (possible in ".npz" files written by NumPy) are copied
+  // out on the first access:
+  //
+  template<typename Sys>
+  class NpyReader
+  {
+  private:
+    using RepT = typename Sys::RepT;
+    using En   = Bits::Encodings<RepT, Sys::MaxDims>;
+
+    // A copy of an array converted into other Units:
+    struct ArrConv
+    {
+      uint64_t              m_U;
+      std::vector<RepT>     m_data;
+    };
+
+    struct ArrState
+    {
+      std::string           m_name;
+      std::string           m_descr;
+      char const*           m_data;     // In the "mmap"ed file or in "m_copy"
+      uint64_t              m_n;
+      uint64_t              m_E;
+      uint64_t              m_U;        // Units valid for "m_data"
+      bool                  m_checked;  // RepT validated?
+      std::vector<RepT>     m_copy;     // For unaligned arrays only
+      std::vector<ArrConv>  m_convs;    // Converted copies, by Units
+    };
+
+    char*                  m_base;
+    size_t                 m_size;
+    std::vector<ArrState>  m_arrs;
+
+    [[noreturn]] static void Fail(char const* a_msg)
+    {
+      throw std::runtime_error
+        (std::string("NpyReader: Invalid File: ") + a_msg);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "MkArr": From a ".npy" image:                                         //
+    //-----------------------------------------------------------------------//
+    static ArrState
+    MkArr(std::string a_name, char const* a_data, size_t a_len)
+    {
+      Bits::NpyHdrInfo info = Bits::NpyParseHeader(a_data, a_len);
+      if (UNLIKELY(info.m_n < 0))
+        Fail("0-d Array");
+      // NB: The RepT is validated later, but the size must be consistent with
+      // the descr in any case:
+      size_t width = 0;
+      std::from_chars(info.m_descr.data() + std::min<size_t>
+                      (2, info.m_descr.size()),
+                      info.m_descr.data() + info.m_descr.size(), width);
+      if (UNLIKELY(width == 0 ||
+                   (a_len - info.m_dataOff) / width < uint64_t(info.m_n)))
+        Fail("Truncated Array");
+
+      return ArrState{ std::move(a_name), std::move(info.m_descr),
+                       a_data + info.m_dataOff, uint64_t(info.m_n),
+                       0, 0, false, {}, {} };
+    }
+
+    // Sets the (E,U) of "a_arr" from the Units string:
+    static void SetUnits(ArrState* a_arr, std::string const& a_units)
+    {
+      if (UNLIKELY(!a_units.empty() && !Bits::ParseUnits<Sys>
+                   (a_units.data(), a_units.data() + a_units.size(),
+                    &a_arr->m_E, &a_arr->m_U)))
+        Fail("Invalid Units");
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ParseNpz": The ZIP Central Directory:                                //
+    //-----------------------------------------------------------------------//
+    // Whether [a_off, a_off + a_len) is within the file (NB: the offsets come
+    // from the file, so the sum itself may overflow):
+    bool InFile(uint64_t a_off, uint64_t a_len) const
+      { return a_off <= m_size && a_len <= m_size - a_off; }
+
+    void ParseNpz()
+    {
+      // Find the EOCD (followed by a comment of up to 64K):
+      if (UNLIKELY(m_size < 22))
+        Fail("Too Short");
+      size_t eocd = m_size - 22;
+      while (Bits::ZipGet(m_base + eocd, 4) != Bits::ZipEOCDSig)
+      {
+        if (UNLIKELY(eocd == 0 || m_size - eocd > 22 + 65535))
+          Fail("No ZIP End Record");
+        --eocd;
+      }
+      uint64_t nEntries = Bits::ZipGet(m_base + eocd + 10, 2);
+      uint64_t cdOff    = Bits::ZipGet(m_base + eocd + 16, 4);
+
+      // ZIP64 (as written by NumPy for large arrays):
+      if ((nEntries == 0xffff || cdOff == 0xffffffff) && eocd >= 20 &&
+          Bits::ZipGet(m_base + eocd - 20, 4) == Bits::Zip64LocSig)
+      {
+        uint64_t e64 = Bits::ZipGet(m_base + eocd - 12, 8);
+        if (UNLIKELY(!InFile(e64, 56) ||
+                     Bits::ZipGet(m_base + e64, 4) != Bits::Zip64EOCDSig))
+          Fail("Bad ZIP64 End Record");
+        nEntries = Bits::ZipGet(m_base + e64 + 32, 8);
+        cdOff    = Bits::ZipGet(m_base + e64 + 48, 8);
+      }
+
+      std::vector<std::pair<std::string, std::string>> units;
+      uint64_t curr = cdOff;
+      for (uint64_t i = 0; i < nEntries; ++i)
+      {
+        if (UNLIKELY(!InFile(curr, 46) ||
+                     Bits::ZipGet(m_base + curr, 4) != Bits::ZipCentralSig))
+          Fail("Bad ZIP Central Directory");
+        char const* ce       = m_base + curr;
+        uint64_t    flags    = Bits::ZipGet(ce + 8,  2);
+        uint64_t    method   = Bits::ZipGet(ce + 10, 2);
+        uint64_t    cSize    = Bits::ZipGet(ce + 20, 4);
+        uint64_t    size     = Bits::ZipGet(ce + 24, 4);
+        uint64_t    nameLen  = Bits::ZipGet(ce + 28, 2);
+        uint64_t    extraLen = Bits::ZipGet(ce + 30, 2);
+        uint64_t    commLen  = Bits::ZipGet(ce + 32, 2);
+        uint64_t    lhOff    = Bits::ZipGet(ce + 42, 4);
+        if (UNLIKELY(!InFile(curr + 46, nameLen + extraLen + commLen)))
+          Fail("Bad ZIP Central Directory");
+        std::string name(ce + 46, nameLen);
+
+        // The ZIP64 extra field contains those of the sizes and the offset
+        // which do not fit into 32 bits, in this order (NB: all offsets are
+        // relative to the extra field, and are small):
+        char const* extra = ce + 46 + nameLen;
+        for (uint64_t x = 0; x + 4 <= extraLen; )
+        {
+          uint64_t id  = Bits::ZipGet(extra + x,     2);
+          uint64_t len = Bits::ZipGet(extra + x + 2, 2);
+          uint64_t v   = x + 4;
+          uint64_t end = std::min(v + len, extraLen);
+          if (id == 1)
+            for (uint64_t* fld: { &size, &cSize, &lhOff })
+              if (*fld == 0xffffffff && v + 8 <= end)
+              {
+                *fld = Bits::ZipGet(extra + v, 8);
+                v   += 8;
+              }
+          x += 4 + len;
+        }
+        curr += 46 + nameLen + extraLen + commLen;
+
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".npy") != 0)
+          continue;   // Not an array
+        name.resize(name.size() - 4);
+
+        if (UNLIKELY(method != 0 || (flags & 1) != 0 || cSize != size))
+          Fail("Compressed or Encrypted Members are not Supported");
+        if (UNLIKELY(!InFile(lhOff, 30) ||
+                     Bits::ZipGet(m_base + lhOff, 4) != Bits::ZipLocalSig))
+          Fail("Bad ZIP Local Header");
+        uint64_t dataOff = lhOff + 30 + Bits::ZipGet(m_base + lhOff + 26, 2) +
+                                        Bits::ZipGet(m_base + lhOff + 28, 2);
+        if (UNLIKELY(!InFile(dataOff, size)))
+          Fail("Truncated ZIP Member");
+
+        if (name.size() > 6 &&
+            name.compare(name.size() - 6, 6, ".units") == 0)
+          units.emplace_back
+            (name.substr(0, name.size() - 6),
+             Bits::NpyGetStr(m_base + dataOff, size));
+        else
+          m_arrs.push_back(MkArr(std::move(name), m_base + dataOff, size));
+      }
+      // Attach the Units:
+      for (auto const& [name, str]: units)
+        for (ArrState& arr: m_arrs)
+          if (arr.m_name == name)
+            SetUnits(&arr, str);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    explicit NpyReader(char const* a_path)
+    : m_base(nullptr),
+      m_size(0),
+      m_arrs()
+    {
+      int fd = open(a_path, O_RDONLY | O_CLOEXEC);
+      if (UNLIKELY(fd < 0))
+        Bits::ThrowSysErr("NpyReader::Ctor");
+
+      struct stat st;
+      if (UNLIKELY(fstat(fd, &st) < 0))
+      {
+        close(fd);
+        Bits::ThrowSysErr("NpyReader::Ctor");
+      }
+      m_size = size_t(st.st_size);
+      if (UNLIKELY(m_size < 10))
+      {
+        close(fd);
+        Fail("Too Short");
+      }
+      void* base =
+        mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (UNLIKELY(base == MAP_FAILED))
+        Bits::ThrowSysErr("NpyReader::Ctor");
+      m_base = static_cast<char*>(base);
+
+      try
+      {
+        if (Bits::ZipGet(m_base, 4) == Bits::ZipLocalSig)
+          ParseNpz();
+        else
+        {
+          // A single ".npy" array, named after the file:
+          std::string name(a_path);
+          size_t      slash = name.rfind('/');
+          if (slash != std::string::npos)
+            name.erase(0, slash + 1);
+          if (name.size() > 4 && name.compare(name.size() - 4, 4, ".npy") == 0)
+            name.resize(name.size() - 4);
+          m_arrs.push_back(MkArr(std::move(name), m_base, m_size));
+
+          // The sidecar (if any) is small, so just read it in:
+          int sfd = open(Bits::NpySidecarPath(a_path).data(),
+                         O_RDONLY | O_CLOEXEC);
+          if (sfd >= 0)
+          {
+            char   buff[4096];
+            size_t len = 0;
+            try   { len = Bits::ReadUpTo(sfd, buff, sizeof(buff),
+                                         "NpyReader::Ctor"); }
+            catch (...) { close(sfd); throw; }
+            close(sfd);
+            SetUnits(&m_arrs.back(), Bits::NpyGetStr(buff, len));
+          }
+        }
+      }
+      catch (...)
+      {
+        munmap(m_base, m_size);
+        throw;
+      }
+    }
+
+    ~NpyReader()
+      { munmap(m_base, m_size); }
+
+    NpyReader(NpyReader const&)            = delete;
+    NpyReader& operator=(NpyReader const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    unsigned NArrays() const { return unsigned(m_arrs.size()); }
+
+    char const* ArrName(unsigned a_arr) const
+    {
+      assert(a_arr < NArrays());
+      return m_arrs[a_arr].m_name.data();
+    }
+
+    uint64_t ArrSize(unsigned a_arr) const
+    {
+      assert(a_arr < NArrays());
+      return m_arrs[a_arr].m_n;
+    }
+
+    // Returns -1 if not found:
+    int FindArr(char const* a_name) const
+    {
+      assert(a_name != nullptr);
+      for (unsigned i = 0; i < NArrays(); ++i)
+        if (m_arrs[i].m_name == a_name)
+          return int(i);
+      return -1;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "GetArray": Typed View (Zero-Copy unless the Units are converted):    //
+    //-----------------------------------------------------------------------//
+    template<typename DQ>
+    std::span<DQ const> GetArray(unsigned a_arr)
+    {
+      using Tr = DimQTraits<DQ>;
+      static_assert(Tr::IsDimQ &&
+                    std::is_same_v<typename Tr::RepT, RepT> &&
+                    Tr::MaxDims == Sys::MaxDims,
+                    "NpyReader::GetArray: Incompatible DimQ");
+      constexpr uint64_t E = Tr::E;
+      constexpr uint64_t U = En::CleanUpUnits(E, Tr::U);
+
+      if (UNLIKELY(a_arr >= NArrays()))
+        throw std::out_of_range("NpyReader::GetArray: Invalid Arr");
+      ArrState& arr = m_arrs[a_arr];
+
+      // Fast Path: Already validated for this type:
+      if (LIKELY(arr.m_checked && arr.m_E == E && arr.m_U == U))
+        return std::span<DQ const>
+               (reinterpret_cast<DQ const*>(arr.m_data), arr.m_n);
+
+      if (UNLIKELY(arr.m_E != E))
+        throw std::runtime_error("NpyReader::GetArray: Dims MisMatch");
+
+      if (!arr.m_checked)
+      {
+        if (UNLIKELY(arr.m_descr != Bits::NpyDescr<RepT>()))
+          throw std::runtime_error("NpyReader::GetArray: dtype MisMatch");
+
+        if (reinterpret_cast<uintptr_t>(arr.m_data) % alignof(RepT) != 0)
+        {
+          arr.m_copy.resize(arr.m_n);
+          memcpy(arr.m_copy.data(), arr.m_data, arr.m_n * sizeof(RepT));
+          arr.m_data = reinterpret_cast<char const*>(arr.m_copy.data());
+        }
+        arr.m_checked = true;
+      }
+
+      // Units with the same Scale do not require any conversion:
+      RepT const* data = reinterpret_cast<RepT const*>(arr.m_data);
+      RepT factor = RepT(Bits::UnitsConvFactor<Sys>(E, arr.m_U, U));
+      if (factor == RepT(1.0))
+      {
+        arr.m_U = U;
+        return std::span<DQ const>(reinterpret_cast<DQ const*>(data), arr.m_n);
+      }
+
+      // Re-use a previous conversion into these Units, or make a new one:
+      for (ArrConv const& conv: arr.m_convs)
+        if (conv.m_U == U)
+          return std::span<DQ const>
+                 (reinterpret_cast<DQ const*>(conv.m_data.data()), arr.m_n);
+
+      std::vector<RepT> conv(data, data + arr.m_n);
+      for (RepT& x: conv)
+        x *= factor;
+
+      // NB: Moving the vector does not move its buffer, so the spans returned
+      // earlier remain valid:
+      arr.m_convs.push_back(ArrConv{U, std::move(conv)});
+      return std::span<DQ const>
+             (reinterpret_cast<DQ const*>(arr.m_convs.back().m_data.data()),
+              arr.m_n);
+    }
+
+    template<typename DQ>
+    std::span<DQ const> GetArray(char const* a_name)
+    {
+      int arr = FindArr(a_name);
+      if (UNLIKELY(arr < 0))
+        throw std::out_of_range("NpyReader::GetArray: No such Arr");
+      return GetArray<DQ>(unsigned(arr));
+    }
+  };
+}
+// End namespace DimTypes
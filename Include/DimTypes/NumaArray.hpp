@@ -0,0 +1,246 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/NumaArray.hpp":                        //
+//     NUMA-Aware First-Touch Allocation of Large Arrays of Quantities       //
+//===========================================================================//
+// Linux places each memory page on the NUMA node of the thread which touches
+// it first. "NumaArray<T>" therefore allocates its memory by "mmap" (w/o tou-
+// ching it), and then initialises it by "ThreadPool::ParallelForStatic" with
+// the default grain of the parallel algorithms ("ForEach", "Transform", ...)
+// for the same size and pool, so each page ends up on the node of the worker
+// which initially owns it in those algorithms; they then mostly read node-
+// local memory (work stealing only moves the tail ends of the ranges). For a
+// table, use one "NumaArray" per column, all of the same size and pool.
+// Optionally, the memory is aligned to 2 MB and advised for Transparent Huge
+// Pages ("madvise(MADV_HUGEPAGE)"), which reduces the TLB misses on scans;
+// the advice is a hint only, so its failure is not an error.
+// "PinPoolWorkers" pins the threads of a pool to the given CPUs, so that the
+// scheduler does not migrate them away from their memory:
+//
+#pragma  once
+#include "Parallel.hpp"
+#include "Bits/FileIO.hpp"
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  constexpr inline size_t HugePageSize = size_t(2) << 20;
+
+  //-------------------------------------------------------------------------//
+  // "NumaMap": Maps (but does not touch) anonymous memory:                  //
+  //-------------------------------------------------------------------------//
+  // Returns the base addr and the mapped size (which may be larger than
+  // "a_bytes"):
+  //
+  inline std::pair<void*, size_t> NumaMap(size_t a_bytes, bool a_hugePages)
+  {
+    size_t align = a_hugePages ? HugePageSize : size_t(4096);
+    size_t size  = (a_bytes + align - 1) / align * align;
+    size_t extra = a_hugePages ? HugePageSize : 0;
+
+    void* raw = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (UNLIKELY(raw == MAP_FAILED))
+      ThrowSysErr("NumaMap: mmap");
+    if (!a_hugePages)
+      return {raw, size};
+
+    // Trim the mapping to a 2 MB-aligned addr:
+    uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t base = (addr + HugePageSize - 1) / HugePageSize * HugePageSize;
+    size_t    head = base - addr;
+    if (head != 0)
+      munmap(raw, head);
+    if (extra - head != 0)
+      munmap(reinterpret_cast<void*>(base + size), extra - head);
+
+#   ifdef MADV_HUGEPAGE
+    (void) madvise(reinterpret_cast<void*>(base), size, MADV_HUGEPAGE);
+#   endif
+    return {reinterpret_cast<void*>(base), size};
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "NumaArray":                                                            //
+  //=========================================================================//
+  template<typename T>
+  class NumaArray
+  {
+  private:
+    static_assert(std::is_trivially_copyable_v<T> &&
+                  std::is_trivially_destructible_v<T>,
+                  "NumaArray: UnSupported Element Type");
+    T*     m_data;
+    size_t m_n;
+    size_t m_mapped;   // Size of the mapping in bytes
+
+    void Release() noexcept
+    {
+      if (m_data != nullptr)
+        munmap(m_data, m_mapped);
+      m_data   = nullptr;
+      m_n      = 0;
+      m_mapped = 0;
+    }
+
+  public:
+    using value_type = T;
+
+    //-----------------------------------------------------------------------//
+    // Ctors, Dtor:                                                          //
+    //-----------------------------------------------------------------------//
+    NumaArray() noexcept
+    : m_data(nullptr), m_n(0), m_mapped(0)
+    {}
+
+    // Each element is initialised by "a_init(i)" in the worker which owns it;
+    // "a_grain" == 0 means the default grain of the parallel algorithms. NB:
+    // Only invocable "a_init"s select this Ctor, so eg "NumaArray<double>(pool,
+    // n, 1)" is the one below:
+    //
+    template<typename F>
+    requires(std::is_invocable_v<F const&, size_t>)
+    NumaArray
+    (
+      ThreadPool& a_pool,
+      size_t      a_n,
+      F const&    a_init,
+      bool        a_hugePages = false,
+      size_t      a_grain     = 0
+    )
+    : NumaArray()
+    {
+      static_assert(std::is_convertible_v<std::invoke_result_t<F, size_t>, T>,
+                    "NumaArray: Invalid Initialiser");
+      if (a_n == 0)
+        return;
+      auto [base, mapped] = Bits::NumaMap(a_n * sizeof(T), a_hugePages);
+      m_data   = static_cast<T*>(base);
+      m_n      = a_n;
+      m_mapped = mapped;
+
+      T* data = m_data;
+      try
+      {
+        a_pool.ParallelForStatic
+          (a_n,
+           (a_grain != 0)
+           ? a_grain : Bits::DefaultGrain<T>(a_n, a_pool.NThreads()),
+           [data, &a_init](size_t a_from, size_t a_to)
+           {
+             for (size_t i = a_from; i < a_to; ++i)
+               new (data + i) T(a_init(i));
+           });
+      }
+      catch (...)
+      {
+        Release();
+        throw;
+      }
+    }
+
+    // All elements are initialised to "a_val":
+    NumaArray
+    (
+      ThreadPool& a_pool,
+      size_t      a_n,
+      T           a_val       = T(),
+      bool        a_hugePages = false,
+      size_t      a_grain     = 0
+    )
+    : NumaArray(a_pool, a_n, [a_val](size_t) { return a_val; },
+                a_hugePages, a_grain)
+    {}
+
+    NumaArray(NumaArray&& a_right) noexcept
+    : m_data  (std::exchange(a_right.m_data,   nullptr)),
+      m_n     (std::exchange(a_right.m_n,      0)),
+      m_mapped(std::exchange(a_right.m_mapped, 0))
+    {}
+
+    NumaArray& operator=(NumaArray&& a_right) noexcept
+    {
+      if (this != &a_right)
+      {
+        Release();
+        m_data   = std::exchange(a_right.m_data,   nullptr);
+        m_n      = std::exchange(a_right.m_n,      0);
+        m_mapped = std::exchange(a_right.m_mapped, 0);
+      }
+      return *this;
+    }
+
+    NumaArray(NumaArray const&)            = delete;
+    NumaArray& operator=(NumaArray const&) = delete;
+
+    ~NumaArray() { Release(); }
+
+    //-----------------------------------------------------------------------//
+    // Access:                                                               //
+    //-----------------------------------------------------------------------//
+    T*       data()       noexcept { return m_data; }
+    T const* data() const noexcept { return m_data; }
+    size_t   size() const noexcept { return m_n;    }
+    bool     empty() const noexcept { return m_n == 0; }
+
+    T*       begin()       noexcept { return m_data; }
+    T const* begin() const noexcept { return m_data; }
+    T*       end()         noexcept { return m_data + m_n; }
+    T const* end()   const noexcept { return m_data + m_n; }
+
+    T&       operator[](size_t a_i)       noexcept { return m_data[a_i]; }
+    T const& operator[](size_t a_i) const noexcept { return m_data[a_i]; }
+
+    operator std::span<T>()             noexcept { return {m_data, m_n}; }
+    operator std::span<T const>() const noexcept { return {m_data, m_n}; }
+  };
+
+  //=========================================================================//
+  // "PinPoolWorkers":                                                       //
+  //=========================================================================//
+  // Pins the worker "w" of "a_pool" to the CPU "a_cpus[w % a_cpus.size()]".
+  // NB: The worker 0 is the thread calling "ParallelFor" (which may be diff-
+  // erent each time), so the calling thread is NOT pinned, and keeps its own
+  // affinity:
+  //
+  inline void PinPoolWorkers(ThreadPool& a_pool, std::vector<int> const& a_cpus)
+  {
+    if (a_cpus.empty())
+      return;
+    // With "a_n" == NThreads and "a_grain" == 1, the worker "w" gets exactly
+    // the chunk "w" (but all of them run in the calling thread if the pool
+    // runs them serially):
+    pthread_t caller = pthread_self();
+    a_pool.ParallelForStatic
+      (a_pool.NThreads(), 1,
+       [&a_cpus, caller](size_t a_w, size_t)
+       {
+         if (pthread_equal(pthread_self(), caller))
+           return;
+         int       cpu = a_cpus[a_w % a_cpus.size()];
+         cpu_set_t cpus;
+         CPU_ZERO(&cpus);
+         if (cpu >= 0 && cpu < CPU_SETSIZE)
+           CPU_SET(cpu, &cpus);
+         if (UNLIKELY(CPU_COUNT(&cpus) == 0 ||
+                      pthread_setaffinity_np
+                      (pthread_self(), sizeof(cpus), &cpus) != 0))
+           throw std::runtime_error
+                 ("PinPoolWorkers: Cannot pin a thread to CPU " +
+                  std::to_string(cpu));
+       });
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,582 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "DimTypes/ODE.hpp":                            //
+//     ODE Integrators over SoA Batches of Systems with "DimQ" States        //
+//===========================================================================//
+// The state of each system is a tuple of "DimQ" fields (eg "Len_km" and
+// "Vel"); a batch of N independent systems is held as an "ODEBatch", ie in the
+// SoA form (one column of N vals per field). The derivatives of a state batch
+// of type "ODEBatch<Fs...>" w.r.t. the "TimeDQ" have the type "ODEDeriv<Time-
+// DQ, ODEBatch<Fs...>>" == "ODEBatch<decltype(Fs / TimeDQ)...>",  and the RHS
+// functions must have the signature
+//   void(TimeDQ a_t, ODEBatch<Fs...> const& a_y, ODEDeriv<...>& a_dydt),
+// which is checked at compile time, so a RHS producing derivatives of wrong
+// Dims (or Units) does not compile. Time steps are "TimeDQ"s.
+// The solvers:
+// (*) "RK4Solver":      classical 4th-order Runge-Kutta, fixed steps;
+// (*) "RK45Solver":     Dormand-Prince 5(4), with adaptive step control;  the
+//                       abs tolerances are given per field (in its own Units),
+//                       so the error norm (the max over all fields and systems
+//                       of |err| / (atol + rtol * |y|)) is DimLess;
+// (*) "LeapfrogSolver": symplectic (Kick-Drift-Kick) for q'' = a(q), with the
+//                       velocities typed as q / Time and the accelerations as
+//                       q / Time^2.
+// All systems in a batch share the time and the step. The state updates are
+// done by fused kernels (all stages combined in a single pass over the SoA
+// columns), which the compiler vectorises. Scratch space is allocated once,
+// in the solver Ctors:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "ODEBatch":                                                             //
+  //=========================================================================//
+  template<typename... Fields>
+  class ODEBatch
+  {
+  private:
+    static_assert(sizeof...(Fields) >= 1 && (IsDimQ<Fields> && ...),
+                  "ODEBatch: Fields must be DimQs");
+    using F0 = std::tuple_element_t<0, std::tuple<Fields...>>;
+
+  public:
+    using RepT = typename DimQTraits<F0>::RepT;
+    static_assert((std::is_same_v<typename DimQTraits<Fields>::RepT, RepT>
+                   && ...), "ODEBatch: Fields must have the same RepT");
+    static_assert(std::is_floating_point_v<RepT>,
+                  "ODEBatch: RepT must be a real floating-point type");
+
+    constexpr static size_t NFields = sizeof...(Fields);
+
+    template<size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+  private:
+    std::tuple<std::vector<Fields>...> m_cols;
+    size_t                             m_n;
+
+  public:
+    explicit ODEBatch(size_t a_n = 0)
+    : m_cols(std::vector<Fields>(a_n)...),
+      m_n   (a_n)
+    {}
+
+    size_t size() const { return m_n; }
+
+    template<size_t I>
+    std::span<Field<I>>       Get()       { return std::get<I>(m_cols); }
+
+    template<size_t I>
+    std::span<Field<I> const> Get() const { return std::get<I>(m_cols); }
+
+    // The columns as arrays of "RepT"s (for the update kernels):
+    std::array<RepT*, NFields> Raw()
+    {
+      return std::apply
+        ([](auto&... a_cols)
+         {
+           return std::array<RepT*, NFields>
+             {{ reinterpret_cast<RepT*>(a_cols.data())... }};
+         },
+         m_cols);
+    }
+
+    std::array<RepT const*, NFields> Raw() const
+    {
+      return std::apply
+        ([](auto const&... a_cols)
+         {
+           return std::array<RepT const*, NFields>
+             {{ reinterpret_cast<RepT const*>(a_cols.data())... }};
+         },
+         m_cols);
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "ODEDeriv": The Type of d(State)/d(Time):                               //
+  //-------------------------------------------------------------------------//
+namespace Bits
+{
+  template<typename TimeDQ, typename Batch>
+  struct ODEDerivT;
+
+  template<typename TimeDQ, typename... Fields>
+  struct ODEDerivT<TimeDQ, ODEBatch<Fields...>>
+  {
+    using type = ODEBatch
+      <decltype(std::declval<Fields>() / std::declval<TimeDQ>())...>;
+  };
+
+  template<typename TimeDQ, typename Batch, typename RHS>
+  constexpr void CheckRHS()
+  {
+    static_assert(IsDimQ<TimeDQ>, "ERROR: ODE: TimeDQ must be a DimQ");
+    static_assert
+      (std::is_invocable_v
+        <RHS const&, TimeDQ, Batch const&,
+         typename ODEDerivT<TimeDQ, Batch>::type&>,
+       "ERROR: ODE: RHS must be void(Time, State const&, (State/Time)&)");
+  }
+}
+// End namespace Bits
+
+  template<typename TimeDQ, typename Batch>
+  using ODEDeriv = typename Bits::ODEDerivT<TimeDQ, Batch>::type;
+
+namespace Bits
+{
+  //=========================================================================//
+  // Fused Update Kernels:                                                   //
+  //=========================================================================//
+  // "ODECombine": a_out = a_y + a_h * Sum_{j<S} a_c[j] * a_k[j], for each of
+  // the "NF" columns at once. "a_out" may be "a_y":
+  //
+  template<unsigned S, typename F, size_t NF>
+  inline void ODECombine
+  (
+    std::array<F*, NF> const&                        a_out,
+    std::array<F const*, NF> const&                  a_y,
+    F                                                a_h,
+    std::array<F, S> const&                          a_c,
+    std::array<std::array<F const*, NF>, S> const&   a_k,
+    size_t                                           a_n
+  )
+  {
+    for (size_t f = 0; f < NF; ++f)
+    {
+      F*       out = a_out[f];
+      F const* y   = a_y  [f];
+      F const* k[S];
+      for (unsigned j = 0; j < S; ++j)
+        k[j] = a_k[j][f];
+
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        F acc = a_c[0] * k[0][i];
+        for (unsigned j = 1; j < S; ++j)
+          acc += a_c[j] * k[j][i];
+        out[i] = y[i] + a_h * acc;
+      }
+    }
+  }
+
+  // "ODEErrNorm": max |a_h * Sum a_e[j] * a_k[j]| / (atol + rtol * max(|y0|,
+  // |y1|)) over all columns and systems (NaN if any term is NaN):
+  //
+  template<unsigned S, typename F, size_t NF>
+  inline F ODEErrNorm
+  (
+    std::array<F const*, NF> const&                  a_y0,
+    std::array<F const*, NF> const&                  a_y1,
+    F                                                a_h,
+    std::array<F, S> const&                          a_e,
+    std::array<std::array<F const*, NF>, S> const&   a_k,
+    std::array<F, NF> const&                         a_atol,
+    F                                                a_rtol,
+    size_t                                           a_n
+  )
+  {
+    F    res = F(0.0);
+    bool nan = false;
+    for (size_t f = 0; f < NF; ++f)
+    {
+      F const* y0 = a_y0[f];
+      F const* y1 = a_y1[f];
+      F const* k[S];
+      for (unsigned j = 0; j < S; ++j)
+        k[j] = a_k[j][f];
+      F atol = a_atol[f];
+
+      for (size_t i = 0; i < a_n; ++i)
+      {
+        F err = a_e[0] * k[0][i];
+        for (unsigned j = 1; j < S; ++j)
+          err += a_e[j] * k[j][i];
+        F sc  = atol + a_rtol * std::max(std::abs(y0[i]), std::abs(y1[i]));
+        F r   = std::abs(a_h * err) / sc;
+        res   = std::max(res, r);
+        nan  |= (r != r);
+      }
+    }
+    return nan ? std::numeric_limits<F>::quiet_NaN() : res;
+  }
+
+  // "ODELastStep": Is the step "a_h" from "a_t" the last one before "a_tEnd"
+  // (allowing for the rounding errors in "a_t")?
+  //
+  template<typename TimeDQ>
+  inline bool ODELastStep(TimeDQ a_t, TimeDQ a_tEnd, TimeDQ a_h)
+  {
+    using RepT = typename DimQTraits<TimeDQ>::RepT;
+    constexpr RepT Tol = RepT(64) * std::numeric_limits<RepT>::epsilon();
+    return (a_tEnd - a_t).Magnitude() <=
+           a_h.Magnitude() + Tol * std::max(std::abs(a_tEnd.Magnitude()),
+                                            std::abs(a_h   .Magnitude()));
+  }
+
+  template<typename F, size_t NF>
+  inline std::array<F const*, NF> ConstCols(std::array<F*, NF> const& a_p)
+  {
+    std::array<F const*, NF> res;
+    for (size_t f = 0; f < NF; ++f)
+      res[f] = a_p[f];
+    return res;
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "RK4Solver":                                                            //
+  //=========================================================================//
+  template<typename TimeDQ, typename Batch>
+  class RK4Solver
+  {
+  private:
+    using Deriv = ODEDeriv<TimeDQ, Batch>;
+    using RepT  = typename Batch::RepT;
+    constexpr static size_t NF = Batch::NFields;
+
+    Deriv m_k[4];
+    Batch m_tmp;
+
+  public:
+    explicit RK4Solver(size_t a_n)
+    : m_k  { Deriv(a_n), Deriv(a_n), Deriv(a_n), Deriv(a_n) },
+      m_tmp(a_n)
+    {}
+
+    // A single step from "a_t" to "a_t + a_h":
+    template<typename RHS>
+    void Step(RHS const& a_rhs, TimeDQ a_t, Batch* a_y, TimeDQ a_h)
+    {
+      Bits::CheckRHS<TimeDQ, Batch, RHS>();
+      assert(a_y != nullptr && a_y->size() == m_tmp.size());
+      size_t n  = a_y->size();
+      RepT   h  = a_h.Magnitude();
+      auto   y  = a_y->Raw();
+      auto   yc = Bits::ConstCols(y);
+      auto   t  = m_tmp.Raw();
+      std::array<RepT const*, NF> k[4];
+      for (unsigned j = 0; j < 4; ++j)
+        k[j] = Bits::ConstCols(m_k[j].Raw());
+
+      a_rhs(a_t, *a_y, m_k[0]);
+      Bits::ODECombine<1>(t, yc, h, {{RepT(0.5)}}, {{k[0]}}, n);
+      a_rhs(a_t + RepT(0.5) * a_h, m_tmp, m_k[1]);
+      Bits::ODECombine<1>(t, yc, h, {{RepT(0.5)}}, {{k[1]}}, n);
+      a_rhs(a_t + RepT(0.5) * a_h, m_tmp, m_k[2]);
+      Bits::ODECombine<1>(t, yc, h, {{RepT(1.0)}}, {{k[2]}}, n);
+      a_rhs(a_t + a_h,             m_tmp, m_k[3]);
+      Bits::ODECombine<4>
+        (y, yc, h,
+         {{RepT(1.0/6.0), RepT(1.0/3.0), RepT(1.0/3.0), RepT(1.0/6.0)}},
+         {{k[0], k[1], k[2], k[3]}}, n);
+    }
+
+    // Fixed steps "a_h" from "*a_t" to "a_tEnd" (the last one is shortened if
+    // necessary); returns the number of steps:
+    template<typename RHS>
+    size_t Integrate(RHS const& a_rhs, TimeDQ* a_t, Batch* a_y, TimeDQ a_tEnd,
+                     TimeDQ a_h)
+    {
+      assert(a_t != nullptr);
+      if (UNLIKELY(!IsPos(a_h)))
+        throw std::invalid_argument("RK4Solver::Integrate: Invalid Step");
+      // "*a_t" is computed from "t0", not accumulated, so that the rounding
+      // errors do not produce a spurious tiny last step:
+      TimeDQ const t0     = *a_t;
+      size_t       nSteps = 0;
+      for (; *a_t < a_tEnd; ++nSteps)
+      {
+        bool   last = Bits::ODELastStep(*a_t, a_tEnd, a_h);
+        TimeDQ h    = last ? (a_tEnd - *a_t) : a_h;
+        Step(a_rhs, *a_t, a_y, h);
+        *a_t = last ? a_tEnd : (t0 + RepT(nSteps + 1) * a_h);
+      }
+      return nSteps;
+    }
+  };
+
+  //=========================================================================//
+  // "RK45Solver": Dormand-Prince 5(4) with FSAL:                            //
+  //=========================================================================//
+  template<typename TimeDQ, typename Batch>
+  class RK45Solver
+  {
+  private:
+    using Deriv = ODEDeriv<TimeDQ, Batch>;
+    using RepT  = typename Batch::RepT;
+    constexpr static size_t NF = Batch::NFields;
+    using Cols  = std::array<RepT const*, NF>;
+
+    Deriv                   m_k[7];
+    Batch                   m_tmp;
+    Batch                   m_y5;
+    std::array<RepT, NF>    m_atol;
+    RepT                    m_rtol;
+    bool                    m_k1OK;   // "m_k[0]" is f(t, y) (FSAL)?
+    RepT                    m_err;    // Last error norm
+
+    // Butcher tableau:
+    constexpr static std::array<RepT, 1> A2 = {{ RepT(1.0/5.0) }};
+    constexpr static std::array<RepT, 2> A3 =
+      {{ RepT(3.0/40.0), RepT(9.0/40.0) }};
+    constexpr static std::array<RepT, 3> A4 =
+      {{ RepT(44.0/45.0), RepT(-56.0/15.0), RepT(32.0/9.0) }};
+    constexpr static std::array<RepT, 4> A5 =
+      {{ RepT(19372.0/6561.0), RepT(-25360.0/2187.0), RepT(64448.0/6561.0),
+         RepT(-212.0/729.0) }};
+    constexpr static std::array<RepT, 5> A6 =
+      {{ RepT(9017.0/3168.0),  RepT(-355.0/33.0),     RepT(46732.0/5247.0),
+         RepT(49.0/176.0),     RepT(-5103.0/18656.0) }};
+    constexpr static std::array<RepT, 5> B5 =  // k2 has the 0 weight: omitted
+      {{ RepT(35.0/384.0),     RepT(500.0/1113.0),    RepT(125.0/192.0),
+         RepT(-2187.0/6784.0), RepT(11.0/84.0) }};
+    constexpr static std::array<RepT, 6> E  =  // B5 - B4, w/o k2, with k7
+      {{ RepT(71.0/57600.0),   RepT(-71.0/16695.0),   RepT(71.0/1920.0),
+         RepT(-17253.0/339200.0), RepT(22.0/525.0),   RepT(-1.0/40.0) }};
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // "a_atol" are the abs tolerances of the fields (in their own Units):
+    //
+    template<typename... Fields>
+    RK45Solver(size_t a_n, std::tuple<Fields...> const& a_atol, RepT a_rtol)
+    : m_k   { Deriv(a_n), Deriv(a_n), Deriv(a_n), Deriv(a_n), Deriv(a_n),
+              Deriv(a_n), Deriv(a_n) },
+      m_tmp (a_n),
+      m_y5  (a_n),
+      m_atol(std::apply([](auto... a_tols)
+                        { return std::array<RepT, NF>
+                                 {{ a_tols.Magnitude()... }}; },
+                        a_atol)),
+      m_rtol(a_rtol),
+      m_k1OK(false),
+      m_err (RepT(0.0))
+    {
+      static_assert(std::is_same_v<ODEBatch<Fields...>, Batch>,
+                    "RK45Solver: The Tolerances must have the State types");
+      for (RepT tol: m_atol)
+        if (UNLIKELY(!(tol > RepT(0.0))))
+          throw std::invalid_argument("RK45Solver: Invalid Tolerances");
+      if (UNLIKELY(!(a_rtol >= RepT(0.0))))
+        throw std::invalid_argument("RK45Solver: Invalid Tolerances");
+    }
+
+    // The error norm of the last step (<= 1 if accepted):
+    RepT LastErr() const { return m_err; }
+
+    //-----------------------------------------------------------------------//
+    // "TryStep":                                                            //
+    //-----------------------------------------------------------------------//
+    // Attempts a step "*a_h" from "*a_t". If accepted, advances "*a_t" and
+    // "*a_y" and returns "true"; in any case, sets "*a_h" to the next step
+    // size suggested. NB: "*a_y" must not be modified by the caller between
+    // successive calls (otherwise, call "Reset" first):
+    //
+    template<typename RHS>
+    bool TryStep(RHS const& a_rhs, TimeDQ* a_t, Batch* a_y, TimeDQ* a_h)
+    {
+      Bits::CheckRHS<TimeDQ, Batch, RHS>();
+      assert(a_t != nullptr && a_y != nullptr && a_h != nullptr &&
+             a_y->size() == m_tmp.size());
+      size_t n  = a_y->size();
+      TimeDQ h  = *a_h;
+      RepT   hm = h.Magnitude();
+      Cols   yc = Bits::ConstCols(a_y->Raw());
+      auto   t  = m_tmp.Raw();
+      Cols   k[7];
+      for (unsigned j = 0; j < 7; ++j)
+        k[j] = Bits::ConstCols(m_k[j].Raw());
+
+      if (!m_k1OK)
+        a_rhs(*a_t, *a_y, m_k[0]);
+
+      Bits::ODECombine<1>(t, yc, hm, A2, {{k[0]}}, n);
+      a_rhs(*a_t + RepT(1.0/5.0)  * h, m_tmp, m_k[1]);
+      Bits::ODECombine<2>(t, yc, hm, A3, {{k[0], k[1]}}, n);
+      a_rhs(*a_t + RepT(3.0/10.0) * h, m_tmp, m_k[2]);
+      Bits::ODECombine<3>
+        (t, yc, hm, A4, {{k[0], k[1], k[2]}}, n);
+      a_rhs(*a_t + RepT(4.0/5.0)  * h, m_tmp, m_k[3]);
+      Bits::ODECombine<4>
+        (t, yc, hm, A5, {{k[0], k[1], k[2], k[3]}}, n);
+      a_rhs(*a_t + RepT(8.0/9.0)  * h, m_tmp, m_k[4]);
+      Bits::ODECombine<5>
+        (t, yc, hm, A6, {{k[0], k[1], k[2], k[3], k[4]}}, n);
+      a_rhs(*a_t + h,                  m_tmp, m_k[5]);
+
+      auto y5 = m_y5.Raw();
+      Bits::ODECombine<5>
+        (y5, yc, hm, B5, {{k[0], k[2], k[3], k[4], k[5]}}, n);
+      a_rhs(*a_t + h,                  m_y5,  m_k[6]);
+
+      m_err = Bits::ODEErrNorm<6>
+        (yc, Bits::ConstCols(y5), hm, E,
+         {{k[0], k[2], k[3], k[4], k[5], k[6]}}, m_atol, m_rtol, n);
+
+      // Next step size (the standard controller, with the factor in [0.2, 5];
+      // NaN errors give the min factor):
+      RepT fact = (m_err > RepT(0.0))
+                  ? RepT(0.9) * std::pow(m_err, RepT(-0.2)) : RepT(5.0);
+      fact      = (fact == fact) ? std::clamp(fact, RepT(0.2), RepT(5.0))
+                                 : RepT(0.2);
+      bool ok   = (m_err <= RepT(1.0));
+      if (ok)
+      {
+        // Copy (rather than swap) the new state, so that the caller's spans
+        // of "*a_y" columns remain valid:
+        auto y = a_y->Raw();
+        for (size_t f = 0; f < NF; ++f)
+          std::copy(y5[f], y5[f] + n, y[f]);
+        std::swap(m_k[0], m_k[6]);
+        *a_t  += h;
+        m_k1OK = true;
+      }
+      else
+        fact   = std::min(fact, RepT(1.0));
+      *a_h = fact * h;
+      return ok;
+    }
+
+    // Must be called if the state was modified outside "TryStep":
+    void Reset() { m_k1OK = false; }
+
+    //-----------------------------------------------------------------------//
+    // "Integrate":                                                          //
+    //-----------------------------------------------------------------------//
+    // Adaptive steps from "*a_t" to "a_tEnd", starting with the step "*a_h"
+    // (which is updated); returns the number of accepted steps. Throws if the
+    // step size becomes too small, or "a_maxSteps" attempts are exceeded:
+    //
+    template<typename RHS>
+    size_t Integrate(RHS const& a_rhs, TimeDQ* a_t, Batch* a_y, TimeDQ a_tEnd,
+                     TimeDQ* a_h, size_t a_maxSteps = 1000000)
+    {
+      assert(a_t != nullptr && a_h != nullptr);
+      if (UNLIKELY(!IsPos(*a_h)))
+        throw std::invalid_argument("RK45Solver::Integrate: Invalid Step");
+      Reset();
+      size_t nOK = 0;
+      for (size_t i = 0; *a_t < a_tEnd; ++i)
+      {
+        if (UNLIKELY(i >= a_maxSteps))
+          throw std::runtime_error("RK45Solver::Integrate: Too Many Steps");
+
+        bool   last = Bits::ODELastStep(*a_t, a_tEnd, *a_h);
+        TimeDQ h    = last ? (a_tEnd - *a_t) : *a_h;
+        if (UNLIKELY(h.Magnitude() <=
+                     RepT(16) * std::numeric_limits<RepT>::epsilon() *
+                     std::abs(a_tEnd.Magnitude())))
+          throw std::runtime_error("RK45Solver::Integrate: Step Too Small");
+
+        if (TryStep(a_rhs, a_t, a_y, &h))
+        {
+          ++nOK;
+          if (last)
+            *a_t = a_tEnd;  // Avoid the rounding residue
+          // Do not let the shortened last step reduce the next one:
+          *a_h = last ? std::max(h, *a_h) : h;
+        }
+        else
+          *a_h = h;
+      }
+      return nOK;
+    }
+  };
+
+  //=========================================================================//
+  // "LeapfrogSolver": Kick-Drift-Kick:                                      //
+  //=========================================================================//
+  // For q'' = a(t, q); the accelerations functor has the signature
+  //   void(TimeDQ a_t, QBatch const& a_q, ODEDeriv<TimeDQ, VBatch>& a_acc):
+  //
+  template<typename TimeDQ, typename QBatch>
+  class LeapfrogSolver
+  {
+  public:
+    using VBatch = ODEDeriv<TimeDQ, QBatch>;
+    using ABatch = ODEDeriv<TimeDQ, VBatch>;
+
+  private:
+    using RepT = typename QBatch::RepT;
+    ABatch m_acc;
+    bool   m_accOK;   // "m_acc" is a(t, q)?
+
+  public:
+    explicit LeapfrogSolver(size_t a_n)
+    : m_acc  (a_n),
+      m_accOK(false)
+    {}
+
+    // Must be called if the state was modified outside "Step":
+    void Reset() { m_accOK = false; }
+
+    template<typename Acc>
+    void Step(Acc const& a_acc, TimeDQ a_t, QBatch* a_q, VBatch* a_v,
+              TimeDQ a_h)
+    {
+      static_assert
+        (std::is_invocable_v<Acc const&, TimeDQ, QBatch const&, ABatch&>,
+         "ERROR: Leapfrog: Acc must be void(Time, Q const&, (Q/Time^2)&)");
+      assert(a_q != nullptr && a_v != nullptr &&
+             a_q->size() == m_acc.size() && a_v->size() == m_acc.size());
+      size_t n  = a_q->size();
+      RepT   h  = a_h.Magnitude();
+      auto   q  = a_q->Raw();
+      auto   v  = a_v->Raw();
+      auto   ac = Bits::ConstCols(m_acc.Raw());
+
+      if (!m_accOK)
+        a_acc(a_t, *a_q, m_acc);
+      Bits::ODECombine<1>(v, Bits::ConstCols(v), h, {{RepT(0.5)}}, {{ac}}, n);
+      Bits::ODECombine<1>
+        (q, Bits::ConstCols(q), h, {{RepT(1.0)}}, {{Bits::ConstCols(v)}}, n);
+      a_acc(a_t + a_h, *a_q, m_acc);
+      Bits::ODECombine<1>(v, Bits::ConstCols(v), h, {{RepT(0.5)}}, {{ac}}, n);
+      m_accOK = true;
+    }
+
+    // Fixed steps (the last one is shortened if necessary); returns the number
+    // of steps:
+    template<typename Acc>
+    size_t Integrate(Acc const& a_acc, TimeDQ* a_t, QBatch* a_q, VBatch* a_v,
+                     TimeDQ a_tEnd, TimeDQ a_h)
+    {
+      assert(a_t != nullptr);
+      if (UNLIKELY(!IsPos(a_h)))
+        throw std::invalid_argument("LeapfrogSolver::Integrate: Invalid Step");
+      Reset();
+      // "*a_t" is computed from "t0", not accumulated, so that the rounding
+      // errors do not produce a spurious tiny last step:
+      TimeDQ const t0     = *a_t;
+      size_t       nSteps = 0;
+      for (; *a_t < a_tEnd; ++nSteps)
+      {
+        bool   last = Bits::ODELastStep(*a_t, a_tEnd, a_h);
+        TimeDQ h    = last ? (a_tEnd - *a_t) : a_h;
+        Step(a_acc, *a_t, a_q, a_v, h);
+        *a_t = last ? a_tEnd : (t0 + RepT(nSteps + 1) * a_h);
+      }
+      return nSteps;
+    }
+  };
+}
+// End namespace DimTypes
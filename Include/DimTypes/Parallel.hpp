@@ -0,0 +1,485 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "DimTypes/Parallel.hpp":                        //
+//     Work-Stealing Thread Pool and Parallel Algorithms over "DimQ" Arrays  //
+//===========================================================================//
+// "ThreadPool::ParallelFor(n, grain, f)" splits [0, n) into chunks of "grain"
+// elements and calls "f(from, to)" on them. Initially, each worker (including
+// the calling thread) owns a CONTIGUOUS range of chunks, so with first-touch
+// page placement, the workers mostly access the memory on their own NUMA nodes;
+// a worker which has run out of chunks steals the upper half of the remaining
+// range of another one. A nested "ParallelFor" (from within "f", possibly via
+// the workers of other pools) on a pool which is already running it, runs
+// serially in the calling worker.
+// "Transform", "ForEach" and "TransformReduce" are built on top of it. The
+// default grain size of "Transform" and "ForEach" gives each worker ~8 chunks
+// (but no less than 4096 elements per chunk), rounded up to a multiple of the
+// 64-byte SIMD/cache-line width, so that (for 64-byte-aligned arrays) the
+// chunks never share cache lines and vectorised loops have no unaligned heads;
+// for "TransformReduce", the grain size determines the result, so its default
+// is fixed (4096 elements), regardless of the number of threads. The result
+// types are inferred from the user functions, so eg "Transform" of lengths by
+// "a_x / 1.0_sec" produces an array of velocities:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // "PoolRange": The range of chunks owned by a worker:                     //
+  //-------------------------------------------------------------------------//
+  struct alignas(64) PoolRange
+  {
+    std::mutex m_mtx;
+    size_t     m_lo = 0;
+    size_t     m_hi = 0;
+  };
+
+  //-------------------------------------------------------------------------//
+  // "PoolLink", "CurrPools":                                                //
+  //-------------------------------------------------------------------------//
+  // The chain of the pools running the "ParallelFor"s which (transitively)
+  // invoked the curr thread, innermost first. The links live on the stacks of
+  // the "ParallelFor" callers, and are passed on to the workers for the dura-
+  // tion of the job:
+  //
+  struct PoolLink
+  {
+    void const*     m_pool;
+    PoolLink const* m_outer;
+  };
+
+  inline thread_local PoolLink const* CurrPools = nullptr;
+
+  inline bool InPool(void const* a_pool)
+  {
+    for (PoolLink const* l = CurrPools; l != nullptr; l = l->m_outer)
+      if (l->m_pool == a_pool)
+        return true;
+    return false;
+  }
+
+  // Sets "CurrPools" until the end of the scope, then restores the prev val:
+  class PoolScope
+  {
+  private:
+    PoolLink const* m_saved;
+
+  public:
+    explicit PoolScope(PoolLink const* a_link)
+    : m_saved(CurrPools)
+      { CurrPools = a_link; }
+
+    ~PoolScope() { CurrPools = m_saved; }
+
+    PoolScope(PoolScope const&)            = delete;
+    PoolScope& operator=(PoolScope const&) = delete;
+  };
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "ThreadPool":                                                           //
+  //=========================================================================//
+  class ThreadPool
+  {
+  private:
+    unsigned                          m_nThreads;   // Including the caller
+    std::vector<std::thread>          m_threads;
+    std::unique_ptr<Bits::PoolRange[]> m_ranges;    // [m_nThreads]
+
+    std::mutex                        m_jobMtx;     // Serialises the jobs
+    std::mutex                        m_mtx;        // Protects the following:
+    std::condition_variable           m_startCV;
+    std::condition_variable           m_doneCV;
+    uint64_t                          m_gen;
+    unsigned                          m_nBusy;
+    bool                              m_stop;
+
+    // The curr job:
+    void                            (*m_fn)(void const*, size_t, size_t);
+    void const*                       m_ctx;
+    size_t                            m_n;
+    size_t                            m_grain;
+    bool                              m_steal;
+    Bits::PoolLink const*             m_link;       // Of the caller
+    std::atomic<bool>                 m_failed;
+    std::exception_ptr                m_exc;
+
+    //-----------------------------------------------------------------------//
+    // "TakeOwn", "Steal": Get a chunk for the worker "a_w":                 //
+    //-----------------------------------------------------------------------//
+    bool TakeOwn(unsigned a_w, size_t* a_k)
+    {
+      Bits::PoolRange& r = m_ranges[a_w];
+      std::lock_guard  lock(r.m_mtx);
+      if (r.m_lo >= r.m_hi)
+        return false;
+      *a_k = r.m_lo++;
+      return true;
+    }
+
+    bool Steal(unsigned a_w, size_t* a_k)
+    {
+      for (unsigned i = 1; i < m_nThreads; ++i)
+      {
+        Bits::PoolRange& v  = m_ranges[(a_w + i) % m_nThreads];
+        size_t           lo = 0;
+        size_t           hi = 0;
+        {
+          std::lock_guard lock(v.m_mtx);
+          if (v.m_lo >= v.m_hi)
+            continue;
+          hi       = v.m_hi;
+          lo       = hi - (v.m_hi - v.m_lo + 1) / 2;
+          v.m_hi   = lo;
+        }
+        // Keep the rest of the stolen range (so that it can be stolen again):
+        Bits::PoolRange& own = m_ranges[a_w];
+        std::lock_guard  lock(own.m_mtx);
+        own.m_lo = lo + 1;
+        own.m_hi = hi;
+        *a_k     = lo;
+        return true;
+      }
+      return false;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "RunWorker": Processes the chunks until there are none left:          //
+    //-----------------------------------------------------------------------//
+    void RunWorker(unsigned a_w)
+    {
+      for (size_t k = 0; TakeOwn(a_w, &k) || (m_steal && Steal(a_w, &k)); )
+      {
+        if (m_failed.load(std::memory_order_relaxed))
+          continue;   // Just drain the chunks
+        size_t from = k * m_grain;
+        try
+          { m_fn(m_ctx, from, std::min(m_n, from + m_grain)); }
+        catch (...)
+        {
+          std::lock_guard lock(m_mtx);
+          if (!m_exc)
+            m_exc = std::current_exception();
+          m_failed.store(true, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ThreadBody":                                                         //
+    //-----------------------------------------------------------------------//
+    void ThreadBody(unsigned a_w)
+    {
+      uint64_t              gen  = 0;
+      Bits::PoolLink const* link = nullptr;
+      while (true)
+      {
+        {
+          std::unique_lock lock(m_mtx);
+          m_startCV.wait(lock, [this, gen]{ return m_stop || m_gen != gen; });
+          if (m_stop)
+            return;
+          gen  = m_gen;
+          link = m_link;
+        }
+        {
+          Bits::PoolScope scope(link);
+          RunWorker(a_w);
+        }
+        std::lock_guard lock(m_mtx);
+        if (--m_nBusy == 0)
+          m_doneCV.notify_one();
+      }
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor, Dtor:                                               //
+    //-----------------------------------------------------------------------//
+    // "a_nThreads" == 0 means the hardware concurrency:
+    //
+    explicit ThreadPool(unsigned a_nThreads = 0)
+    : m_nThreads((a_nThreads != 0)
+                 ? a_nThreads
+                 : std::max(std::thread::hardware_concurrency(), 1U)),
+      m_threads (),
+      m_ranges  (new Bits::PoolRange[m_nThreads]),
+      m_gen     (0),
+      m_nBusy   (0),
+      m_stop    (false),
+      m_fn      (nullptr),
+      m_ctx     (nullptr),
+      m_n       (0),
+      m_grain   (1),
+      m_steal   (true),
+      m_link    (nullptr),
+      m_failed  (false),
+      m_exc     ()
+    {
+      for (unsigned w = 1; w < m_nThreads; ++w)
+        m_threads.emplace_back([this, w]() { ThreadBody(w); });
+    }
+
+    ~ThreadPool()
+    {
+      {
+        std::lock_guard lock(m_mtx);
+        m_stop = true;
+      }
+      m_startCV.notify_all();
+      for (auto& thread: m_threads)
+        thread.join();
+    }
+
+    ThreadPool(ThreadPool const&)            = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    unsigned NThreads() const { return m_nThreads; }
+
+    // The process-wide pool (of the hardware concurrency):
+    static ThreadPool& Default()
+    {
+      static ThreadPool s_pool;
+      return s_pool;
+    }
+
+    //-----------------------------------------------------------------------//
+    // "ParallelFor":                                                        //
+    //-----------------------------------------------------------------------//
+    // Calls "a_f(from, to)" on the chunks of [0, a_n). The chunk boundaries are
+    // always multiples of "a_grain", regardless of the number of threads and
+    // the scheduling. The first exception thrown by "a_f" (if any) is re-thrown
+    // after all workers have finished:
+    //
+    template<typename F>
+    void ParallelFor(size_t a_n, size_t a_grain, F const& a_f)
+      { Run(a_n, a_grain, a_f, true); }
+
+    //-----------------------------------------------------------------------//
+    // "ParallelForStatic":                                                  //
+    //-----------------------------------------------------------------------//
+    // As "ParallelFor", but w/o work stealing: the worker "w" processes exact-
+    // ly the chunks it initially owns under "ParallelFor" with the same "a_n"
+    // and "a_grain", ie [nChunks*w/NThreads, nChunks*(w+1)/NThreads). This is
+    // used for the first-touch placement of memory pages (see "NumaArray"):
+    //
+    template<typename F>
+    void ParallelForStatic(size_t a_n, size_t a_grain, F const& a_f)
+      { Run(a_n, a_grain, a_f, false); }
+
+  private:
+    template<typename F>
+    void Run(size_t a_n, size_t a_grain, F const& a_f, bool a_steal)
+    {
+      size_t grain   = std::max<size_t>(a_grain, 1);
+      size_t nChunks = (a_n + grain - 1) / grain;
+      if (nChunks == 0)
+        return;
+
+      // Serial execution:
+      if (m_nThreads == 1 || nChunks == 1 || Bits::InPool(this))
+      {
+        for (size_t from = 0; from < a_n; from += grain)
+          a_f(from, std::min(a_n, from + grain));
+        return;
+      }
+
+      std::lock_guard jobLock(m_jobMtx);
+      Bits::PoolLink  link { this, Bits::CurrPools };
+      m_fn    = [](void const* a_ctx, size_t a_from, size_t a_to)
+                { (*static_cast<F const*>(a_ctx))(a_from, a_to); };
+      m_ctx   = &a_f;
+      m_n     = a_n;
+      m_grain = grain;
+      m_steal = a_steal;
+      m_link  = &link;
+      m_exc   = nullptr;
+      m_failed.store(false, std::memory_order_relaxed);
+
+      for (unsigned w = 0; w < m_nThreads; ++w)
+      {
+        std::lock_guard lock(m_ranges[w].m_mtx);
+        m_ranges[w].m_lo = nChunks *  w      / m_nThreads;
+        m_ranges[w].m_hi = nChunks * (w + 1) / m_nThreads;
+      }
+      {
+        std::lock_guard lock(m_mtx);
+        m_nBusy = m_nThreads - 1;
+        ++m_gen;
+      }
+      m_startCV.notify_all();
+
+      // The calling thread is worker 0:
+      {
+        Bits::PoolScope scope(&link);
+        RunWorker(0);
+      }
+
+      std::unique_lock lock(m_mtx);
+      m_doneCV.wait(lock, [this]{ return m_nBusy == 0; });
+      if (m_exc)
+        std::rethrow_exception(m_exc);
+    }
+  };
+
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // "DefaultGrain", "ReduceGrain":                                          //
+  //-------------------------------------------------------------------------//
+  constexpr inline size_t MinGrain = 4096;
+
+  template<typename T>
+  inline size_t DefaultGrain(size_t a_n, unsigned a_nThreads)
+  {
+    constexpr size_t Width = std::max<size_t>(64 / sizeof(T), 1);
+    size_t grain = std::max(MinGrain, a_n / (8 * size_t(a_nThreads)));
+    return (grain + Width - 1) / Width * Width;
+  }
+
+  // Independent of the number of threads (and a multiple of any "Width"):
+  constexpr inline size_t ReduceGrain = MinGrain;
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // Parallel Algorithms:                                                    //
+  //=========================================================================//
+  // "a_grain" == 0 means the default one (see above):
+  //-------------------------------------------------------------------------//
+  // "ForEach": "a_f(a_vals[i])" (which may modify the vals):                //
+  //-------------------------------------------------------------------------//
+  template<typename T, typename F>
+  void ForEach
+  (
+    ThreadPool& a_pool,
+    T*          a_vals,
+    size_t      a_n,
+    F const&    a_f,
+    size_t      a_grain = 0
+  )
+  {
+    assert(a_vals != nullptr || a_n == 0);
+    a_pool.ParallelFor
+      (a_n,
+       (a_grain != 0)
+       ? a_grain : Bits::DefaultGrain<T>(a_n, a_pool.NThreads()),
+       [a_vals, &a_f](size_t a_from, size_t a_to)
+       {
+         for (size_t i = a_from; i < a_to; ++i)
+           a_f(a_vals[i]);
+       });
+  }
+
+  template<typename T, size_t Ext, typename F>
+  void ForEach
+    (ThreadPool& a_pool, std::span<T, Ext> a_vals, F const& a_f,
+     size_t a_grain = 0)
+    { ForEach(a_pool, a_vals.data(), a_vals.size(), a_f, a_grain); }
+
+  //-------------------------------------------------------------------------//
+  // "Transform": "a_out[i] = a_f(a_in[i])":                                 //
+  //-------------------------------------------------------------------------//
+  template<typename In, typename Out, typename F>
+  void Transform
+  (
+    ThreadPool& a_pool,
+    In const*   a_in,
+    size_t      a_n,
+    Out*        a_out,
+    F const&    a_f,
+    size_t      a_grain = 0
+  )
+  {
+    static_assert(std::is_same_v<std::invoke_result_t<F, In const&>, Out>,
+                  "Transform: The Function Result is not of the Out Type");
+    assert((a_in != nullptr && a_out != nullptr) || a_n == 0);
+    a_pool.ParallelFor
+      (a_n,
+       (a_grain != 0)
+       ? a_grain : Bits::DefaultGrain<Out>(a_n, a_pool.NThreads()),
+       [a_in, a_out, &a_f](size_t a_from, size_t a_to)
+       {
+         for (size_t i = a_from; i < a_to; ++i)
+           a_out[i] = a_f(a_in[i]);
+       });
+  }
+
+  // This version returns a new vector of the inferred type:
+  template<typename In, size_t Ext, typename F>
+  auto Transform
+    (ThreadPool& a_pool, std::span<In, Ext> a_in, F const& a_f,
+     size_t a_grain = 0)
+  {
+    using Out = std::invoke_result_t<F, std::remove_cv_t<In> const&>;
+    std::vector<Out> res(a_in.size());
+    Transform(a_pool, a_in.data(), a_in.size(), res.data(), a_f, a_grain);
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "TransformReduce":                                                      //
+  //-------------------------------------------------------------------------//
+  // "a_red(... a_red(a_red(a_init, a_f(a_in[0])), a_f(a_in[1])) ...)". The vals
+  // are reduced within each chunk, and then the chunk results are reduced in
+  // the order of chunks, so for a given grain size (incl the default one), the
+  // result does not depend on the number of threads or on the scheduling (even
+  // for floating-point vals). "a_red" must be associative:
+  //
+  template<typename In, typename Res, typename Red, typename F>
+  Res TransformReduce
+  (
+    ThreadPool& a_pool,
+    In const*   a_in,
+    size_t      a_n,
+    Res         a_init,
+    Red const&  a_red,
+    F const&    a_f,
+    size_t      a_grain = 0
+  )
+  {
+    assert(a_in != nullptr || a_n == 0);
+    size_t grain = (a_grain != 0) ? a_grain : Bits::ReduceGrain;
+    size_t nChunks = (a_n + grain - 1) / grain;
+
+    std::vector<Res> partials(nChunks, a_init);
+    a_pool.ParallelFor
+      (a_n, grain,
+       [a_in, grain, &partials, &a_red, &a_f](size_t a_from, size_t a_to)
+       {
+         Res acc = a_f(a_in[a_from]);
+         for (size_t i = a_from + 1; i < a_to; ++i)
+           acc = a_red(acc, a_f(a_in[i]));
+         partials[a_from / grain] = acc;
+       });
+
+    Res res = a_init;
+    for (Res const& p: partials)
+      res = a_red(res, p);
+    return res;
+  }
+
+  template<typename In, size_t Ext, typename Res, typename Red, typename F>
+  Res TransformReduce
+    (ThreadPool& a_pool, std::span<In, Ext> a_in, Res a_init,
+     Red const& a_red, F const& a_f, size_t a_grain = 0)
+  {
+    return TransformReduce
+      (a_pool, a_in.data(), a_in.size(), a_init, a_red, a_f, a_grain);
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,507 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "DimTypes/Pipeline.hpp":                        //
+//       Batched, Pipelined Stream Stages over Lock-Free SPSC Queues         //
+//===========================================================================//
+// A "Pipeline" is a Source, followed by any number of Stages, followed by a
+// Sink. Each of them runs in its own thread (optionally pinned to a CPU), and
+// they exchange fixed-size BATCHES of values (of up to "BatchSize" elements)
+// through lock-free SPSC ring buffers of batches, so the synchronisation cost
+// is paid once per batch, and a batch (a few KB) stays in L1/L2 while a stage
+// is working on it.  The value types produced by each Stage are inferred at
+// compile time, and a Stage which cannot accept the output of the previous one
+// (eg because of different Dims) is a compile-time error. Eg:
+//
+//   auto p = MakePipeline<Sys, Len>(readF)         // size_t(Len*, size_t)
+//            .ConvertTo<Len_km>()                  // Len   -> Len_km
+//            .Map   ([](Len_km x) { return x / 1.0_sec; }) // -> Vel_km_sec
+//            .Filter([](Vel_km_sec v) { return !IsNeg(v); });
+//   p.Run([&](Vel_km_sec const* a_vs, size_t a_n) { ... }, {2, 3, 4, 5, 6});
+//
+// The Source is called as "n = src(buff, BatchSize)" and returns the number of
+// values it has written (0 means the end of the stream). The Sink is called as
+// "sink(vals, n)" for each non-empty batch. The first exception thrown by any
+// of them stops the whole pipeline, and is re-thrown by "Run":
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // "PipeWait": Back-Off while waiting for the other side of a queue:     //
+  //-------------------------------------------------------------------------//
+  inline void PipeWait(unsigned* a_spins)
+  {
+    if (*a_spins < 64)
+    {
+      ++*a_spins;
+#     if defined(__x86_64__) || defined(__i386__)
+      _mm_pause();
+#     endif
+    }
+    else
+      std::this_thread::yield();
+  }
+
+  //=========================================================================//
+  // "BatchRing": Lock-Free SPSC Ring Buffer of Batches:                     //
+  //=========================================================================//
+  // The producer gets a slot by "BeginPush", fills it in place and publishes
+  // it by "EndPush" (or re-uses it next time, if it has not called "EndPush");
+  // similarly for the consumer. Both "Begin*" return NULL once the pipeline is
+  // aborted; "BeginPop" also returns NULL once the ring is closed and empty:
+  //
+  template<typename T, unsigned BatchSize>
+  class BatchRing
+  {
+  public:
+    struct alignas(64) Batch
+    {
+      T      m_data[BatchSize];
+      size_t m_n;
+    };
+
+  private:
+    // Producer side:
+    alignas(64) std::atomic<uint64_t> m_head;
+    uint64_t                          m_tailCache;
+    // Consumer side:
+    alignas(64) std::atomic<uint64_t> m_tail;
+    uint64_t                          m_headCache;
+    // Shared:
+    alignas(64) std::atomic<bool>     m_closed;
+    std::atomic<bool> const*          m_abort;
+    uint64_t                          m_mask;
+    std::unique_ptr<Batch[]>          m_slots;
+
+  public:
+    BatchRing(unsigned a_capacity, std::atomic<bool> const* a_abort)
+    : m_head     (0),
+      m_tailCache(0),
+      m_tail     (0),
+      m_headCache(0),
+      m_closed   (false),
+      m_abort    (a_abort),
+      m_mask     (a_capacity - 1),
+      m_slots    ()
+    {
+      if (UNLIKELY(a_capacity == 0 || (a_capacity & (a_capacity - 1)) != 0))
+        throw std::invalid_argument
+              ("BatchRing: Capacity must be a power of 2");
+      m_slots.reset(new Batch[a_capacity]);
+    }
+
+    Batch* BeginPush()
+    {
+      uint64_t head  = m_head.load(std::memory_order_relaxed);
+      unsigned spins = 0;
+      while (head - m_tailCache > m_mask)
+      {
+        m_tailCache = m_tail.load(std::memory_order_acquire);
+        if (head - m_tailCache <= m_mask)
+          break;
+        if (UNLIKELY(m_abort->load(std::memory_order_relaxed)))
+          return nullptr;
+        PipeWait(&spins);
+      }
+      return &m_slots[head & m_mask];
+    }
+
+    void EndPush()
+      { m_head.store(m_head.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release); }
+
+    void Close() { m_closed.store(true, std::memory_order_release); }
+
+    Batch const* BeginPop()
+    {
+      uint64_t tail  = m_tail.load(std::memory_order_relaxed);
+      unsigned spins = 0;
+      while (tail == m_headCache)
+      {
+        // NB: "m_closed" must be read BEFORE "m_head", otherwise we could
+        // miss the last batch:
+        bool closed = m_closed.load(std::memory_order_acquire);
+        m_headCache = m_head.load(std::memory_order_acquire);
+        if (tail != m_headCache)
+          break;
+        if (closed || UNLIKELY(m_abort->load(std::memory_order_relaxed)))
+          return nullptr;
+        PipeWait(&spins);
+      }
+      return &m_slots[tail & m_mask];
+    }
+
+    void EndPop()
+      { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release); }
+  };
+
+  //=========================================================================//
+  // Stages:                                                                 //
+  //=========================================================================//
+  // Each Stage provides "Out" (the output type for the input type "In") and
+  // "Apply(in, n, out)" which returns the number of output vals (<= n):
+  //
+  //-------------------------------------------------------------------------//
+  // "MapStage": 1-to-1 Transform:                                           //
+  //-------------------------------------------------------------------------//
+  template<typename In, typename F>
+  struct MapStage
+  {
+    static_assert(std::is_invocable_v<F const&, In const&>,
+                  "Pipeline::Map: The function cannot accept the output of "
+                  "the previous Stage (different Dims?)");
+    using Out = std::decay_t<std::invoke_result_t<F const&, In const&>>;
+    F m_f;
+
+    size_t Apply(In const* a_in, size_t a_n, Out* a_out) const
+    {
+      for (size_t i = 0; i < a_n; ++i)
+        a_out[i] = m_f(a_in[i]);
+      return a_n;
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "FilterStage": Keeps the vals satisfying the predicate:                 //
+  //-------------------------------------------------------------------------//
+  template<typename In, typename F>
+  struct FilterStage
+  {
+    static_assert(std::is_invocable_r_v<bool, F const&, In const&>,
+                  "Pipeline::Filter: The predicate cannot accept the output "
+                  "of the previous Stage (different Dims?)");
+    using Out = In;
+    F m_f;
+
+    size_t Apply(In const* a_in, size_t a_n, Out* a_out) const
+    {
+      size_t m = 0;
+      for (size_t i = 0; i < a_n; ++i)
+        if (m_f(a_in[i]))
+          a_out[m++] = a_in[i];
+      return m;
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "BatchStage": User-Provided Batch Function:                             //
+  //-------------------------------------------------------------------------//
+  template<typename In, typename OutT, typename F>
+  struct BatchStage
+  {
+    static_assert(std::is_invocable_r_v<size_t, F&, In const*, size_t, OutT*>,
+                  "Pipeline::MapBatch: The function cannot accept the output "
+                  "of the previous Stage (different Dims?)");
+    using Out = OutT;
+    F m_f;
+
+    // The result is checked, as it is used as the size of the output batch:
+    size_t Apply(In const* a_in, size_t a_n, Out* a_out)
+    {
+      size_t m = m_f(a_in, a_n, a_out);
+      if (UNLIKELY(m > a_n))
+        throw std::runtime_error("Pipeline: MapBatch overflow");
+      return m;
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "ConvStage": Conversion into other Units of the same Dims:              //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename In, typename OutDQ>
+  struct ConvStage
+  {
+    using Tr  = DimQTraits<In>;
+    using TrO = DimQTraits<OutDQ>;
+    static_assert(Tr::IsDimQ && TrO::IsDimQ &&
+                  std::is_same_v<typename Tr::RepT,  typename TrO::RepT> &&
+                  Tr::MaxDims == TrO::MaxDims,
+                  "Pipeline::ConvertTo: UnSupported DimQ Type");
+    static_assert(Tr::E == TrO::E, "Pipeline::ConvertTo: Different Dims");
+
+    using Out  = OutDQ;
+    using RepT = typename Tr::RepT;
+    using En   = Bits::Encodings<RepT, Tr::MaxDims>;
+    RepT m_factor;
+
+    ConvStage()
+    : m_factor(RepT(Bits::UnitsConvFactor<Sys>
+                    (Tr::E, En::CleanUpUnits(Tr::E, Tr::U),
+                            En::CleanUpUnits(Tr::E, TrO::U))))
+    {}
+
+    size_t Apply(In const* a_in, size_t a_n, Out* a_out) const
+    {
+      for (size_t i = 0; i < a_n; ++i)
+        a_out[i] = Out(a_in[i].Magnitude() * m_factor);
+      return a_n;
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "PinCurrThread":                                                        //
+  //-------------------------------------------------------------------------//
+  inline void PinCurrThread(int a_cpu)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(a_cpu, &cpus);
+    if (UNLIKELY(pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)
+                 != 0))
+      throw std::runtime_error
+            ("Pipeline::Run: Cannot pin a thread to CPU " +
+             std::to_string(a_cpu));
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "Pipeline":                                                             //
+  //=========================================================================//
+  // "Types" is the "std::tuple" of the value types: that of the Source, then
+  // the output types of all "Stages" (also a "std::tuple"):
+  //
+  template<typename Sys, unsigned BatchSize, typename Src,
+           typename Types, typename Stages>
+  class Pipeline;
+
+  template<typename Sys,   unsigned    BatchSize, typename Src,
+           typename... Ts, typename... Ss>
+  class Pipeline<Sys, BatchSize, Src, std::tuple<Ts...>, std::tuple<Ss...>>
+  {
+  private:
+    static_assert(BatchSize > 0, "Pipeline: BatchSize must be positive");
+    constexpr static size_t NStages = sizeof...(Ss);
+
+    using Types = std::tuple<Ts...>;
+    using Out   = std::tuple_element_t<NStages, Types>;
+
+    template<size_t I>
+    using Ring  = Bits::BatchRing<std::tuple_element_t<I, Types>, BatchSize>;
+
+    template<typename, unsigned, typename, typename, typename>
+    friend class Pipeline;
+
+    template<typename S>
+    using Next  =
+      Pipeline<Sys, BatchSize, Src, std::tuple<Ts..., typename S::Out>,
+               std::tuple<Ss..., S>>;
+
+    Src                m_src;
+    std::tuple<Ss...>  m_stages;
+    unsigned           m_ringCap;
+
+    template<typename S>
+    Next<S> Append(S a_stage) &&
+    {
+      return Next<S>
+        (std::move(m_src),
+         std::tuple_cat(std::move(m_stages), std::tuple<S>(std::move(a_stage))),
+         m_ringCap);
+    }
+
+    //-----------------------------------------------------------------------//
+    // Thread Bodies:                                                        //
+    //-----------------------------------------------------------------------//
+    template<size_t I, typename Rings>
+    void RunStage(Rings& a_rings)
+    {
+      auto& in    = *std::get<I>    (a_rings);
+      auto& out   = *std::get<I + 1>(a_rings);
+      auto& stage =  std::get<I>    (m_stages);
+      while (auto const* b = in.BeginPop())
+      {
+        auto* o = out.BeginPush();
+        if (UNLIKELY(o == nullptr))
+          break;
+        o->m_n = stage.Apply(b->m_data, b->m_n, o->m_data);
+        in.EndPop();
+        // An empty output batch is not published; the slot is re-used:
+        if (o->m_n != 0)
+          out.EndPush();
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "RunAll": Starts all threads, joins them:                             //
+    //-----------------------------------------------------------------------//
+    template<typename Sink, size_t... Is>
+    void RunAll
+    (
+      Sink&                   a_sink,
+      std::vector<int> const& a_cpus,
+      std::index_sequence<Is...>
+    )
+    {
+      std::atomic<bool>  abort(false);
+      std::mutex         excMtx;
+      std::exception_ptr exc;
+
+      // Ring "I" connects the Stage "I-1" (or the Source) with the Stage "I"
+      // (or the Sink):
+      std::tuple<std::unique_ptr<Ring<Is>>..., std::unique_ptr<Ring<NStages>>>
+        rings(std::make_unique<Ring<Is>>     (m_ringCap, &abort)...,
+              std::make_unique<Ring<NStages>>(m_ringCap, &abort));
+
+      // Runs the body "a_f" of the thread "a_t", then closes the output ring
+      // (if any):
+      auto wrap = [&](size_t a_t, auto&& a_f, auto* a_out)
+      {
+        try
+        {
+          if (!a_cpus.empty())
+            Bits::PinCurrThread(a_cpus[a_t % a_cpus.size()]);
+          a_f();
+        }
+        catch (...)
+        {
+          std::lock_guard lock(excMtx);
+          if (!exc)
+            exc = std::current_exception();
+          abort.store(true, std::memory_order_relaxed);
+        }
+        if (a_out != nullptr)
+          a_out->Close();
+      };
+
+      std::vector<std::thread> threads;
+      threads.reserve(NStages + 2);
+
+      // The Source:
+      threads.emplace_back([&]
+      {
+        auto& out = *std::get<0>(rings);
+        wrap(0, [&]
+        {
+          while (auto* o = out.BeginPush())
+          {
+            o->m_n = m_src(o->m_data, size_t(BatchSize));
+            if (o->m_n == 0)
+              break;
+            if (UNLIKELY(o->m_n > BatchSize))
+              throw std::runtime_error("Pipeline: Source overflow");
+            out.EndPush();
+          }
+        },
+        &out);
+      });
+
+      // The Stages:
+      (threads.emplace_back([&]
+      {
+        wrap(Is + 1, [&] { RunStage<Is>(rings); },
+             std::get<Is + 1>(rings).get());
+      }), ...);
+
+      // The Sink:
+      threads.emplace_back([&]
+      {
+        auto& in = *std::get<NStages>(rings);
+        wrap(NStages + 1, [&]
+        {
+          while (auto const* b = in.BeginPop())
+          {
+            a_sink(b->m_data, b->m_n);
+            in.EndPop();
+          }
+        },
+        static_cast<Ring<NStages>*>(nullptr));
+      });
+
+      for (auto& thread: threads)
+        thread.join();
+      if (exc)
+        std::rethrow_exception(exc);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor (normally invoked via "MakePipeline"):               //
+    //-----------------------------------------------------------------------//
+    Pipeline(Src a_src, std::tuple<Ss...> a_stages, unsigned a_ringCap)
+    : m_src    (std::move(a_src)),
+      m_stages (std::move(a_stages)),
+      m_ringCap(a_ringCap)
+    {}
+
+    //-----------------------------------------------------------------------//
+    // Adding the Stages (consume the curr object):                          //
+    //-----------------------------------------------------------------------//
+    // "Map": "f(x)" for each val "x":
+    template<typename F>
+    auto Map(F a_f) &&
+      { return std::move(*this).Append(Bits::MapStage<Out, F>{std::move(a_f)});}
+
+    // "Filter": Passes on only the vals "x" for which "pred(x)" holds:
+    template<typename F>
+    auto Filter(F a_pred) &&
+    {
+      return std::move(*this).Append
+             (Bits::FilterStage<Out, F>{std::move(a_pred)});
+    }
+
+    // "MapBatch": "m = f(in, n, out)" for each batch, where "m <= n" (checked):
+    template<typename OutT, typename F>
+    auto MapBatch(F a_f) &&
+    {
+      return std::move(*this).Append
+             (Bits::BatchStage<Out, OutT, F>{std::move(a_f)});
+    }
+
+    // "ConvertTo": Into other Units of the same Dims:
+    template<typename OutDQ>
+    auto ConvertTo() &&
+      { return std::move(*this).Append(Bits::ConvStage<Sys, Out, OutDQ>()); }
+
+    //-----------------------------------------------------------------------//
+    // "Run":                                                                //
+    //-----------------------------------------------------------------------//
+    // Runs the whole stream through the pipeline, until the Source returns 0.
+    // If "a_cpus" is non-empty, the Source is pinned to "a_cpus[0]", the Stage
+    // "I" to "a_cpus[I+1]" and the Sink to the next one (cyclically):
+    //
+    template<typename Sink>
+    void Run(Sink a_sink, std::vector<int> const& a_cpus = {})
+    {
+      static_assert(std::is_invocable_v<Sink&, Out const*, size_t>,
+                    "Pipeline::Run: The Sink cannot accept the output of the "
+                    "last Stage (different Dims?)");
+      RunAll(a_sink, a_cpus, std::make_index_sequence<NStages>());
+    }
+  };
+
+  //=========================================================================//
+  // "MakePipeline":                                                         //
+  //=========================================================================//
+  // "T" is the type of vals produced by the Source "a_src"; "a_ringCap" is the
+  // number of batches in each queue (a power of 2):
+  //
+  template<typename Sys, typename T, unsigned BatchSize = 256, typename Src>
+  auto MakePipeline(Src a_src, unsigned a_ringCap = 16)
+  {
+    static_assert(std::is_invocable_r_v<size_t, Src&, T*, size_t>,
+                  "MakePipeline: Invalid Source");
+    using P = Pipeline<Sys, BatchSize, Src, std::tuple<T>, std::tuple<>>;
+    return P(std::move(a_src), std::tuple<>(), a_ringCap);
+  }
+}
+// End namespace DimTypes
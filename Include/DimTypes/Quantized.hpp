@@ -0,0 +1,372 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/Quantized.hpp":                        //
+//        Lossy Quantised Storage of "DimQ" Arrays with Error Bounds         //
+//===========================================================================//
+// "QuantizedArray" stores "DimQ"s as "int16_t" or "int32_t" multiples of a
+// "quantum" (eg 1.0_mm), offset from a per-block base: x ~= Base + Q * Quantum.
+// The error bound "MaxError()" (half of the quantum, plus a small allowance
+// for rounding) is GUARANTEED: it is verified for every value on encoding,
+// and the blocks which cannot be represented within it (too wide a range, or
+// infinite vals) are stored as raw "RepT"s instead. NaNs are represented by a
+// reserved code. For "double" RepT, the encoding and decoding kernels use AVX2
+// (if available); both paths compute the decoded vals via FMA, so the results
+// are bit-identical:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Encoding and Decoding Kernels:                                          //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "QuantEncode":                                                          //
+  //-------------------------------------------------------------------------//
+  // Encodes "a_n" vals relative to "a_base"; returns "false" if any val can-
+  // not be represented within "a_bound":
+  //
+  template<typename F, typename IntT>
+  bool QuantEncode
+  (
+    F const* a_vals,
+    size_t   a_n,
+    F        a_base,
+    F        a_quantum,
+    F        a_bound,
+    IntT*    a_codes
+  )
+  {
+    // NB: The range is checked in "double": eg for "float" and "int32_t",
+    // F(INT32_MAX) rounds up to 2^31, so the conversion into "IntT" would
+    // overflow:
+    constexpr IntT   NaNCode = std::numeric_limits<IntT>::min();
+    constexpr double Lo      = double(NaNCode + 1);
+    constexpr double Hi      = double(std::numeric_limits<IntT>::max());
+    F                invQ    = F(1.0) / a_quantum;
+    size_t           i       = 0;
+
+#   if defined(__AVX2__) && defined(__FMA__)
+    if constexpr (std::is_same_v<F, double>)
+    {
+      __m256d const B   = _mm256_set1_pd(a_base);
+      __m256d const Q   = _mm256_set1_pd(a_quantum);
+      __m256d const IQ  = _mm256_set1_pd(invQ);
+      __m256d const Bnd = _mm256_set1_pd(a_bound);
+      __m256d const L   = _mm256_set1_pd(Lo);
+      __m256d const H   = _mm256_set1_pd(Hi);
+      __m256d const Abs = _mm256_castsi256_pd(_mm256_set1_epi64x
+                          (0x7fffffffffffffffL));
+      __m128i const NC  = _mm_set1_epi32(NaNCode);
+
+      for (; i + 4 <= a_n; i += 4)
+      {
+        __m256d x     = _mm256_loadu_pd(a_vals + i);
+        __m256d r     = _mm256_round_pd
+                        (_mm256_mul_pd(_mm256_sub_pd(x, B), IQ),
+                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d err   = _mm256_and_pd
+                        (_mm256_sub_pd(_mm256_fmadd_pd(r, Q, B), x), Abs);
+        __m256d ok    = _mm256_and_pd
+                        (_mm256_and_pd(_mm256_cmp_pd(r, L, _CMP_GE_OQ),
+                                       _mm256_cmp_pd(r, H, _CMP_LE_OQ)),
+                         _mm256_cmp_pd(err, Bnd, _CMP_LE_OQ));
+        __m256d isNaN = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+        if (_mm256_movemask_pd(_mm256_or_pd(ok, isNaN)) != 0xf)
+          return false;
+        // NaN lanes get INT32_MIN, which "packs" saturates into INT16_MIN, ie
+        // "NaNCode" in both cases:
+        __m128i q     = _mm256_cvtpd_epi32(_mm256_andnot_pd(isNaN, r));
+        __m128i nan32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32
+                        (_mm256_castpd_si256(isNaN),
+                         _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)));
+        q             = _mm_blendv_epi8(q, NC, nan32);
+        if constexpr (sizeof(IntT) == 4)
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(a_codes + i), q);
+        else
+          _mm_storel_epi64
+            (reinterpret_cast<__m128i*>(a_codes + i), _mm_packs_epi32(q, q));
+      }
+    }
+#   endif
+    // The tail (or the generic case):
+    for (; i < a_n; ++i)
+    {
+      F x = a_vals[i];
+      if (std::isnan(x))
+      {
+        a_codes[i] = NaNCode;
+        continue;
+      }
+      F r = std::nearbyint((x - a_base) * invQ);
+      if (!(Lo <= double(r) && double(r) <= Hi &&
+            std::abs(std::fma(r, a_quantum, a_base) - x) <= a_bound))
+        return false;
+      a_codes[i] = IntT(r);
+    }
+    return true;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "QuantDecode":                                                          //
+  //-------------------------------------------------------------------------//
+  template<typename F, typename IntT>
+  void QuantDecode
+  (
+    IntT const* a_codes,
+    size_t      a_n,
+    F           a_base,
+    F           a_quantum,
+    F*          a_vals
+  )
+  {
+    constexpr IntT NaNCode = std::numeric_limits<IntT>::min();
+    size_t         i       = 0;
+
+#   if defined(__AVX2__) && defined(__FMA__)
+    if constexpr (std::is_same_v<F, double>)
+    {
+      __m256d const B  = _mm256_set1_pd(a_base);
+      __m256d const Q  = _mm256_set1_pd(a_quantum);
+      __m256d const N  = _mm256_set1_pd(CEMaths::NaN<double>);
+      __m128i const NC = _mm_set1_epi32(NaNCode);
+
+      for (; i + 4 <= a_n; i += 4)
+      {
+        __m128i q;
+        if constexpr (sizeof(IntT) == 4)
+          q = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_codes + i));
+        else
+          q = _mm_cvtepi16_epi32
+              (_mm_loadl_epi64(reinterpret_cast<__m128i const*>(a_codes + i)));
+        __m256d x    = _mm256_fmadd_pd(_mm256_cvtepi32_pd(q), Q, B);
+        __m256d nanM = _mm256_castsi256_pd
+                       (_mm256_cvtepi32_epi64(_mm_cmpeq_epi32(q, NC)));
+        _mm256_storeu_pd(a_vals + i, _mm256_blendv_pd(x, N, nanM));
+      }
+    }
+#   endif
+    // The tail (or the generic case):
+    for (; i < a_n; ++i)
+      a_vals[i] = (a_codes[i] == NaNCode)
+                  ? CEMaths::NaN<F>
+                  : std::fma(F(a_codes[i]), a_quantum, a_base);
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "QuantizedArray":                                                       //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS" (used for converting
+  // the quantum into the Units of "DQ"); "IntT" is "int16_t" or "int32_t":
+  //
+  template<typename Sys, typename DQ, typename IntT = int32_t>
+  class QuantizedArray
+  {
+  private:
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    using En   = Bits::Encodings<RepT, Tr::MaxDims>;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  std::is_floating_point_v<RepT>,
+                  "QuantizedArray: Incompatible DimQ Type");
+    static_assert(std::is_same_v<IntT, int16_t> ||
+                  std::is_same_v<IntT, int32_t>,
+                  "QuantizedArray: IntT must be int16_t or int32_t");
+
+    constexpr static uint32_t RawFlag = 0x80000000U;
+
+    RepT                  m_quantum;
+    RepT                  m_maxErr;
+    unsigned              m_blockSize;
+    size_t                m_n;
+    std::vector<RepT>     m_bases;    // Per block
+    std::vector<uint32_t> m_blocks;   // Per block: NRaw blocks before it,
+                                      //   | RawFlag if it is raw itself
+    std::vector<IntT>     m_codes;    // Codes of coded blocks only
+    std::vector<RepT>     m_raw;      // Vals  of raw   blocks only
+
+    //-----------------------------------------------------------------------//
+    // "IsRaw", "Offset": Of the block in "m_raw" or in "m_codes":           //
+    //-----------------------------------------------------------------------//
+    // All blocks but the last one are full, so the offset of a block follows
+    // from the number of raw blocks before it:
+    //
+    bool IsRaw(size_t a_b) const
+      { return (m_blocks[a_b] & RawFlag) != 0; }
+
+    size_t Offset(size_t a_b) const
+    {
+      size_t nr = m_blocks[a_b] & ~RawFlag;
+      return (IsRaw(a_b) ? nr : a_b - nr) * m_blockSize;
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    // The quantum may be in any Units of the same Dims as "DQ":
+    //
+    template<typename QT>
+    QuantizedArray(QT a_quantum, unsigned a_blockSize = 1024)
+    : m_quantum  (a_quantum.Magnitude()),
+      m_maxErr   (),
+      m_blockSize(a_blockSize),
+      m_n        (0)
+    {
+      static_assert(DimQTraits<QT>::E == Tr::E,
+                    "QuantizedArray: The quantum must be of the same Dims");
+      constexpr uint64_t FromU =
+        En::CleanUpUnits(Tr::E, DimQTraits<QT>::U);
+      constexpr uint64_t ToU   = En::CleanUpUnits(Tr::E, Tr::U);
+      if constexpr (FromU != ToU)
+        m_quantum *= RepT(Bits::UnitsConvFactor<Sys>(Tr::E, FromU, ToU));
+
+      if (UNLIKELY(!(m_quantum > RepT(0.0) && std::isfinite(m_quantum)) ||
+                   a_blockSize == 0))
+        throw std::invalid_argument("QuantizedArray: Invalid Params");
+      // Half a quantum, plus a few ULPs of it for the rounding of the base:
+      m_maxErr = m_quantum * (RepT(0.5) +
+                              RepT(4.0) * std::numeric_limits<RepT>::epsilon());
+    }
+
+    //-----------------------------------------------------------------------//
+    // Accessors:                                                            //
+    //-----------------------------------------------------------------------//
+    size_t Size()      const { return m_n;               }
+    size_t NBlocks()   const { return m_bases.size();    }
+    DQ     Quantum()   const { return DQ(m_quantum);     }
+    // The guaranteed bound of |Decoded - Original|:
+    DQ     MaxError()  const { return DQ(m_maxErr);      }
+
+    size_t NRawBlocks() const
+    {
+      size_t res = 0;
+      for (size_t b = 0; b < NBlocks(); ++b)
+        res += IsRaw(b);
+      return res;
+    }
+
+    // The total size of the encoded data, in bytes:
+    size_t StorageBytes() const
+    {
+      return m_bases.size() * (sizeof(RepT) + sizeof(uint32_t)) +
+             m_codes.size() * sizeof(IntT) +
+             m_raw.size()   * sizeof(RepT);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Encode": Replaces the current contents:                              //
+    //-----------------------------------------------------------------------//
+    void Encode(DQ const* a_vals, size_t a_n)
+    {
+      assert(a_vals != nullptr || a_n == 0);
+      // NB: "DimQ" is layout-compatible with "RepT":
+      RepT const* vals = reinterpret_cast<RepT const*>(a_vals);
+      size_t      nb   = (a_n + m_blockSize - 1) / m_blockSize;
+      if (UNLIKELY(nb >= RawFlag))
+        throw std::invalid_argument("QuantizedArray::Encode: Too Many Blocks");
+      m_n = a_n;
+      m_bases .resize(nb);
+      m_blocks.resize(nb);
+      m_codes .resize(a_n);   // Shrunk below if there are raw blocks
+      m_raw   .clear();
+      uint32_t nr = 0;        // Raw blocks so far
+
+      for (size_t b = 0; b < nb; ++b)
+      {
+        size_t      from = b * m_blockSize;
+        size_t      n    = std::min(size_t(m_blockSize), a_n - from);
+        RepT const* bv   = vals + from;
+
+        // The base is the multiple of quantum nearest to the middle of the
+        // range of finite vals:
+        RepT lo = std::numeric_limits<RepT>::max();
+        RepT hi = std::numeric_limits<RepT>::lowest();
+        for (size_t i = 0; i < n; ++i)
+        {
+          lo = std::min(lo, std::isnan(bv[i]) ? lo : bv[i]);
+          hi = std::max(hi, std::isnan(bv[i]) ? hi : bv[i]);
+        }
+        RepT base = (lo <= hi)
+                  ? std::nearbyint((lo / RepT(2) + hi / RepT(2)) / m_quantum) *
+                    m_quantum
+                  : RepT(0.0);
+        m_bases[b] = base;
+
+        // The codes are written after those of the previous coded blocks
+        // (and are overwritten by the next ones if the block becomes raw):
+        IntT* codes = m_codes.data() + (from - size_t(nr) * m_blockSize);
+        if (LIKELY((std::isfinite(base) &&
+                    Bits::QuantEncode<RepT, IntT>
+                    (bv, n, base, m_quantum, m_maxErr, codes))))
+          m_blocks[b] = nr;
+        else
+        {
+          m_blocks[b] = nr | RawFlag;
+          ++nr;
+          m_raw.insert(m_raw.end(), bv, bv + n);
+        }
+      }
+      if (!m_raw.empty())
+      {
+        m_codes.resize(a_n - m_raw.size());
+        m_codes.shrink_to_fit();
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "DecodeBlock", "Decode":                                              //
+    //-----------------------------------------------------------------------//
+    // "DecodeBlock" decodes the block "a_b" into "a_out" (up to "m_blockSize"
+    // vals), so the blocks can be decoded in parallel:
+    //
+    void DecodeBlock(size_t a_b, DQ* a_out) const
+    {
+      assert(a_b < NBlocks() && a_out != nullptr);
+      size_t from = a_b * m_blockSize;
+      size_t n    = std::min(size_t(m_blockSize), m_n - from);
+      RepT*  out  = reinterpret_cast<RepT*>(a_out);
+      if (!IsRaw(a_b))
+        Bits::QuantDecode<RepT, IntT>
+          (m_codes.data() + Offset(a_b), n, m_bases[a_b], m_quantum, out);
+      else
+        memcpy(out, m_raw.data() + Offset(a_b), n * sizeof(RepT));
+    }
+
+    void Decode(DQ* a_out) const
+    {
+      for (size_t b = 0; b < NBlocks(); ++b)
+        DecodeBlock(b, a_out + b * m_blockSize);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Get": A single val:                                                  //
+    //-----------------------------------------------------------------------//
+    DQ Get(size_t a_i) const
+    {
+      assert(a_i < m_n);
+      size_t b   = a_i / m_blockSize;
+      size_t off = Offset(b) + a_i % m_blockSize;
+      if (IsRaw(b))
+        return DQ(m_raw[off]);
+      RepT res;
+      Bits::QuantDecode<RepT, IntT>
+        (m_codes.data() + off, 1, m_bases[b], m_quantum, &res);
+      return DQ(res);
+    }
+  };
+}
+// End namespace DimTypes
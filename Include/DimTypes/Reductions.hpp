@@ -0,0 +1,480 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/Reductions.hpp":                       //
+//     Parallel Deterministic Compensated Reductions over "DimQ" Arrays      //
+//===========================================================================//
+// "Sum", "Dot", "Norm", "Mean", "Min" and "Max" over arrays of "DimQ"s with
+// real "float" or "double" RepT. The results are DETERMINISTIC: they do not
+// depend on the number of threads, nor on the instruction set used:
+// (*) the array is split into chunks of a FIXED size ("ReduceChunk" vals);
+// (*) within a chunk, val "i" goes into the accumulator lane "i % 4", and each
+//     lane uses Neumaier's compensated summation; "Dot" also captures the
+//     rounding error of each product via FMA (as in the "Dot2" algorithm  of
+//     Ogita, Rump and Oishi). The AVX2+FMA kernels perform exactly the same
+//     IEEE 754 operations as the scalar ones (4 lanes at a time);
+// (*) the lanes, and then the chunks, are combined in a fixed pairwise tree.
+// Threads only determine which chunks are computed where. NaNs propagate into
+// "Sum", "Dot", "Norm" and "Mean", but are ignored by "Min" and "Max":
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <atomic>
+#include <span>
+#include <thread>
+#include <vector>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Compensated Accumulators:                                               //
+  //=========================================================================//
+  constexpr inline size_t   ReduceChunk = 65536;  // Multiple of "ReduceLanes"
+  constexpr inline unsigned ReduceLanes = 4;
+
+  //-------------------------------------------------------------------------//
+  // "NeuAcc": Sum with the Compensation term:                               //
+  //-------------------------------------------------------------------------//
+  template<typename F>
+  struct NeuAcc
+  {
+    F m_s = F(0.0);
+    F m_c = F(0.0);
+
+    // Neumaier's step:
+    void Add(F a_x)
+    {
+      F t  = m_s + a_x;
+      m_c += (std::abs(m_s) >= std::abs(a_x)) ? (m_s - t) + a_x
+                                              : (a_x - t) + m_s;
+      m_s  = t;
+    }
+
+    void Merge(NeuAcc const& a_right)
+    {
+      Add(a_right.m_s);
+      m_c += a_right.m_c;
+    }
+
+    F Result() const { return m_s + m_c; }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "MergeTree": Pairwise combination of "a_accs[a_from .. a_to)":          //
+  //-------------------------------------------------------------------------//
+  template<typename Acc>
+  Acc MergeTree(Acc const* a_accs, size_t a_from, size_t a_to)
+  {
+    assert(a_from < a_to);
+    if (a_to - a_from == 1)
+      return a_accs[a_from];
+    size_t mid = a_from + (a_to - a_from) / 2;
+    Acc    res = MergeTree(a_accs, a_from, mid);
+    res.Merge(MergeTree(a_accs, mid, a_to));
+    return res;
+  }
+
+  //=========================================================================//
+  // Chunk Kernels:                                                          //
+  //=========================================================================//
+# if defined(__AVX2__) && defined(__FMA__)
+  //-------------------------------------------------------------------------//
+  // "SimdOps": 4-lane vectors of "double" and "float":                      //
+  //-------------------------------------------------------------------------//
+  template<typename F> struct SimdOps;
+
+  template<> struct SimdOps<double>
+  {
+    using V = __m256d;
+    static V    Zero()                     { return _mm256_setzero_pd();   }
+    static V    Set (double a_x)           { return _mm256_set1_pd(a_x);   }
+    static V    Load(double const* a_p)    { return _mm256_loadu_pd(a_p);  }
+    static void Store(double* a_p, V a_v)  { _mm256_storeu_pd(a_p, a_v);   }
+    static V    Add (V a_x, V a_y)         { return _mm256_add_pd(a_x, a_y); }
+    static V    Sub (V a_x, V a_y)         { return _mm256_sub_pd(a_x, a_y); }
+    static V    Mul (V a_x, V a_y)         { return _mm256_mul_pd(a_x, a_y); }
+    static V    FMA (V a_x, V a_y, V a_z)
+      { return _mm256_fmadd_pd(a_x, a_y, a_z); }
+    static V    FMS (V a_x, V a_y, V a_z)
+      { return _mm256_fmsub_pd(a_x, a_y, a_z); }
+    static V    Min (V a_x, V a_y)         { return _mm256_min_pd(a_x, a_y); }
+    static V    Max (V a_x, V a_y)         { return _mm256_max_pd(a_x, a_y); }
+    static V    Abs (V a_x)
+      { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a_x); }
+    static V    GE  (V a_x, V a_y)
+      { return _mm256_cmp_pd(a_x, a_y, _CMP_GE_OQ); }
+    // "a_m ? a_x : a_y":
+    static V    Sel (V a_m, V a_x, V a_y)
+      { return _mm256_blendv_pd(a_y, a_x, a_m); }
+  };
+
+  template<> struct SimdOps<float>
+  {
+    using V = __m128;
+    static V    Zero()                     { return _mm_setzero_ps();      }
+    static V    Set (float a_x)            { return _mm_set1_ps(a_x);      }
+    static V    Load(float const* a_p)     { return _mm_loadu_ps(a_p);     }
+    static void Store(float* a_p, V a_v)   { _mm_storeu_ps(a_p, a_v);      }
+    static V    Add (V a_x, V a_y)         { return _mm_add_ps(a_x, a_y);  }
+    static V    Sub (V a_x, V a_y)         { return _mm_sub_ps(a_x, a_y);  }
+    static V    Mul (V a_x, V a_y)         { return _mm_mul_ps(a_x, a_y);  }
+    static V    FMA (V a_x, V a_y, V a_z)
+      { return _mm_fmadd_ps(a_x, a_y, a_z); }
+    static V    FMS (V a_x, V a_y, V a_z)
+      { return _mm_fmsub_ps(a_x, a_y, a_z); }
+    static V    Min (V a_x, V a_y)         { return _mm_min_ps(a_x, a_y);  }
+    static V    Max (V a_x, V a_y)         { return _mm_max_ps(a_x, a_y);  }
+    static V    Abs (V a_x)
+      { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a_x); }
+    static V    GE  (V a_x, V a_y)
+      { return _mm_cmp_ps(a_x, a_y, _CMP_GE_OQ); }
+    static V    Sel (V a_m, V a_x, V a_y)
+      { return _mm_blendv_ps(a_y, a_x, a_m); }
+  };
+# endif
+
+  //-------------------------------------------------------------------------//
+  // "DotChunk": Also used for plain sums (then "a_y" is NULL):              //
+  //-------------------------------------------------------------------------//
+  // Returns the combined lanes.
+  // NB: The products are computed as "fma(x, y, +0.0)" rather than "x * y":
+  // otherwise, the compiler (with the default "-ffp-contract=fast") could fuse
+  // the multiplication into the subsequent addition, and the results would de-
+  // pend on the optimisation level.
+  // If "Scaled", both "x" and "y" are multiplied by "a_scale" (a power of 2,
+  // so exactly, unless the vals underflow) before use:
+  //
+  template<typename F, bool Scaled = false>
+  NeuAcc<F> DotChunk(F const* a_x, F const* a_y, size_t a_n,
+                     F a_scale = F(1.0))
+  {
+    F      s[ReduceLanes] = {};
+    F      c[ReduceLanes] = {};
+    size_t i              = 0;
+
+#   if defined(__AVX2__) && defined(__FMA__)
+    {
+      using Ops = SimdOps<F>;
+      using V   = typename Ops::V;
+      V vs = Ops::Zero();
+      V vc = Ops::Zero();
+      V sc = Ops::Set(a_scale);
+      for (; i + ReduceLanes <= a_n; i += ReduceLanes)
+      {
+        V x = Ops::Load(a_x + i);
+        if constexpr (Scaled)
+          x = Ops::Mul(x, sc);
+        if (a_y != nullptr)
+        {
+          // p = x*y exactly as p + e:
+          V y = Ops::Load(a_y + i);
+          if constexpr (Scaled)
+            y = Ops::Mul(y, sc);
+          V p = Ops::FMA(x, y, Ops::Zero());
+          vc  = Ops::Add(vc, Ops::FMS(x, y, p));
+          x   = p;
+        }
+        V t  = Ops::Add(vs, x);
+        vc   = Ops::Add
+               (vc, Ops::Sel(Ops::GE(Ops::Abs(vs), Ops::Abs(x)),
+                             Ops::Add(Ops::Sub(vs, t), x),
+                             Ops::Add(Ops::Sub(x,  t), vs)));
+        vs   = t;
+      }
+      Ops::Store(s, vs);
+      Ops::Store(c, vc);
+    }
+#   endif
+    // The tail (or the generic case): same operations, lane by lane:
+    for (; i < a_n; ++i)
+    {
+      unsigned l = unsigned(i % ReduceLanes);
+      F        x = Scaled ? a_x[i] * a_scale : a_x[i];
+      if (a_y != nullptr)
+      {
+        F y   = Scaled ? a_y[i] * a_scale : a_y[i];
+        F p   = std::fma(x, y, F(0.0));
+        c[l] += std::fma(x, y, -p);
+        x     = p;
+      }
+      F t   = s[l] + x;
+      c[l] += (std::abs(s[l]) >= std::abs(x)) ? (s[l] - t) + x
+                                              : (x - t) + s[l];
+      s[l]  = t;
+    }
+
+    NeuAcc<F> lanes[ReduceLanes];
+    for (unsigned l = 0; l < ReduceLanes; ++l)
+      lanes[l] = NeuAcc<F>{s[l], c[l]};
+    return MergeTree(lanes, 0, ReduceLanes);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "MinMaxChunk":                                                          //
+  //-------------------------------------------------------------------------//
+  // NaNs are skipped; the result is +Inf (-Inf) if there are no other vals:
+  //
+  template<typename F>
+  struct MinMaxAcc
+  {
+    F m_min =  CEMaths::Inf<F>;
+    F m_max = -CEMaths::Inf<F>;
+
+    void Merge(MinMaxAcc const& a_right)
+    {
+      m_min = (a_right.m_min < m_min) ? a_right.m_min : m_min;
+      m_max = (a_right.m_max > m_max) ? a_right.m_max : m_max;
+    }
+  };
+
+  template<typename F>
+  MinMaxAcc<F> MinMaxChunk(F const* a_x, size_t a_n)
+  {
+    MinMaxAcc<F> lanes[ReduceLanes];
+    size_t       i = 0;
+
+#   if defined(__AVX2__) && defined(__FMA__)
+    {
+      // NB: "min(x, acc)" is "(x < acc) ? x : acc", so NaN "x"s are skipped:
+      using Ops = SimdOps<F>;
+      using V   = typename Ops::V;
+      V vMin = Ops::Set( CEMaths::Inf<F>);
+      V vMax = Ops::Set(-CEMaths::Inf<F>);
+      for (; i + ReduceLanes <= a_n; i += ReduceLanes)
+      {
+        V x  = Ops::Load(a_x + i);
+        vMin = Ops::Min(x, vMin);
+        vMax = Ops::Max(x, vMax);
+      }
+      F mins[ReduceLanes];
+      F maxs[ReduceLanes];
+      Ops::Store(mins, vMin);
+      Ops::Store(maxs, vMax);
+      for (unsigned l = 0; l < ReduceLanes; ++l)
+        lanes[l] = MinMaxAcc<F>{mins[l], maxs[l]};
+    }
+#   endif
+    for (; i < a_n; ++i)
+    {
+      MinMaxAcc<F>& acc = lanes[i % ReduceLanes];
+      F             x   = a_x[i];
+      acc.m_min = (x < acc.m_min) ? x : acc.m_min;
+      acc.m_max = (x > acc.m_max) ? x : acc.m_max;
+    }
+    return MergeTree(lanes, 0, ReduceLanes);
+  }
+
+  //=========================================================================//
+  // "ParReduce": The Parallel Driver:                                       //
+  //=========================================================================//
+  // Applies "a_chunkF(from, n)" to all chunks of "a_n" vals (using up to "a_n-
+  // Threads" threads, 0 meaning the hardware concurrency), and merges the res-
+  // ults pairwise:
+  //
+  template<typename Acc, typename ChunkF>
+  Acc ParReduce(size_t a_n, unsigned a_nThreads, ChunkF const& a_chunkF)
+  {
+    size_t nChunks = (a_n + ReduceChunk - 1) / ReduceChunk;
+    if (nChunks == 0)
+      return Acc();
+
+    std::vector<Acc> accs(nChunks);
+    std::atomic<size_t> next = 0;
+    auto worker = [&]()
+    {
+      for (size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) <
+                     nChunks; )
+      {
+        size_t from = k * ReduceChunk;
+        accs[k]     = a_chunkF(from, std::min(ReduceChunk, a_n - from));
+      }
+    };
+
+    unsigned nThreads =
+      (a_nThreads != 0) ? a_nThreads
+                        : std::max(std::thread::hardware_concurrency(), 1U);
+    nThreads = unsigned(std::min<size_t>(nThreads, nChunks));
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nThreads; ++t)
+      threads.emplace_back(worker);
+    worker();
+    for (auto& thread: threads)
+      thread.join();
+
+    return MergeTree(accs.data(), 0, nChunks);
+  }
+
+  template<typename DQ>
+  constexpr inline bool IsReducible =
+    DimQTraits<DQ>::IsDimQ &&
+    (std::is_same_v<typename DimQTraits<DQ>::RepT, float> ||
+     std::is_same_v<typename DimQTraits<DQ>::RepT, double>);
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // Reductions:                                                             //
+  //=========================================================================//
+  // "a_nThreads" == 0 means the hardware concurrency. NB: "DimQ" is layout-
+  // compatible with "RepT", so the arrays are processed as "RepT"s:
+  //-------------------------------------------------------------------------//
+  // "Sum":                                                                  //
+  //-------------------------------------------------------------------------//
+  template<typename DQ>
+  DQ Sum(DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+  {
+    static_assert(Bits::IsReducible<DQ>, "Sum: UnSupported DimQ Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    assert(a_vals != nullptr || a_n == 0);
+    RepT const* x = reinterpret_cast<RepT const*>(a_vals);
+
+    return DQ(Bits::ParReduce<Bits::NeuAcc<RepT>>
+      (a_n, a_nThreads, [x](size_t a_from, size_t a_len)
+        { return Bits::DotChunk<RepT>(x + a_from, nullptr, a_len); }
+      ).Result());
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Dot": The result is of the product Dims:                               //
+  //-------------------------------------------------------------------------//
+  template<typename DQ1, typename DQ2>
+  auto Dot
+  (
+    DQ1 const* a_x,
+    DQ2 const* a_y,
+    size_t     a_n,
+    unsigned   a_nThreads = 0
+  )
+  {
+    static_assert(Bits::IsReducible<DQ1> && Bits::IsReducible<DQ2> &&
+                  std::is_same_v<typename DimQTraits<DQ1>::RepT,
+                                 typename DimQTraits<DQ2>::RepT>,
+                  "Dot: UnSupported DimQ Types");
+    using RepT = typename DimQTraits<DQ1>::RepT;
+    using Res  = decltype(std::declval<DQ1>() * std::declval<DQ2>());
+    assert((a_x != nullptr && a_y != nullptr) || a_n == 0);
+    RepT const* x = reinterpret_cast<RepT const*>(a_x);
+    RepT const* y = reinterpret_cast<RepT const*>(a_y);
+
+    return Res(Bits::ParReduce<Bits::NeuAcc<RepT>>
+      (a_n, a_nThreads, [x, y](size_t a_from, size_t a_len)
+        { return Bits::DotChunk<RepT>(x + a_from, y + a_from, a_len); }
+      ).Result());
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Norm": Euclidean, of same Dims as the vals:                            //
+  //-------------------------------------------------------------------------//
+  // If the sum of squares overflows, or is in (or near) the sub-normal range,
+  // the vals are re-scaled by a power of 2 making the largest |val| ~1 (as in
+  // "hypot" and BLAS "nrm2"), at the cost of 2 more passes; NaNs propagate:
+  //
+  template<typename DQ>
+  DQ Norm(DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+  {
+    static_assert(Bits::IsReducible<DQ>, "Norm: UnSupported DimQ Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    using Lim  = std::numeric_limits<RepT>;
+    RepT ss = Dot(a_vals, a_vals, a_n, a_nThreads).Magnitude();
+    // NB: An overflow makes "ss" NaN rather than +Inf (Inf - Inf in "Dot"):
+    if (LIKELY(a_n == 0 ||
+               (std::isfinite(ss) && ss >= Lim::min() / Lim::epsilon())))
+      return DQ(std::sqrt(ss));
+
+    auto [mn, mx] = MinMax(a_vals, a_n, a_nThreads);
+    RepT big      = std::max(-mn.Magnitude(), mx.Magnitude());
+    if (!(big > RepT(0.0) && std::isfinite(big)))
+      // All 0s, or an Inf, or all NaNs (then "ss" is NaN):
+      return DQ((big < RepT(0.0)) ? ss : big);
+
+    // The exponent is clamped so that the scale itself does not overflow:
+    int  e = std::max(std::ilogb(big), Lim::min_exponent - 1);
+    RepT sc = std::ldexp(RepT(1.0), -e);
+    RepT const* x = reinterpret_cast<RepT const*>(a_vals);
+    ss = Bits::ParReduce<Bits::NeuAcc<RepT>>
+      (a_n, a_nThreads, [x, sc](size_t a_from, size_t a_len)
+        { return Bits::DotChunk<RepT, true>
+                 (x + a_from, x + a_from, a_len, sc); }
+      ).Result();
+    return DQ(std::ldexp(std::sqrt(ss), e));
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Mean": NaN for an empty array:                                         //
+  //-------------------------------------------------------------------------//
+  template<typename DQ>
+  DQ Mean(DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+  {
+    using RepT = typename DimQTraits<DQ>::RepT;
+    return (a_n == 0)
+           ? DQ(Bits::CEMaths::NaN<RepT>)
+           : Sum(a_vals, a_n, a_nThreads) / RepT(a_n);
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Min", "Max": NaNs are ignored:                                         //
+  //-------------------------------------------------------------------------//
+  // The results are +Inf and -Inf, resp, if there are no non-NaN vals:
+  //
+  template<typename DQ>
+  std::pair<DQ, DQ> MinMax
+    (DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+  {
+    static_assert(Bits::IsReducible<DQ>, "MinMax: UnSupported DimQ Type");
+    using RepT = typename DimQTraits<DQ>::RepT;
+    assert(a_vals != nullptr || a_n == 0);
+    RepT const* x = reinterpret_cast<RepT const*>(a_vals);
+
+    auto res = Bits::ParReduce<Bits::MinMaxAcc<RepT>>
+      (a_n, a_nThreads, [x](size_t a_from, size_t a_len)
+        { return Bits::MinMaxChunk<RepT>(x + a_from, a_len); });
+    return std::make_pair(DQ(res.m_min), DQ(res.m_max));
+  }
+
+  template<typename DQ>
+  DQ Min(DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+    { return MinMax(a_vals, a_n, a_nThreads).first; }
+
+  template<typename DQ>
+  DQ Max(DQ const* a_vals, size_t a_n, unsigned a_nThreads = 0)
+    { return MinMax(a_vals, a_n, a_nThreads).second; }
+
+  //-------------------------------------------------------------------------//
+  // "std::span" Versions:                                                   //
+  //-------------------------------------------------------------------------//
+  template<typename DQ, size_t Ext>
+  auto Sum (std::span<DQ, Ext> a_vals, unsigned a_nThreads = 0)
+    { return Sum (a_vals.data(), a_vals.size(), a_nThreads); }
+
+  template<typename DQ1, size_t Ext1, typename DQ2, size_t Ext2>
+  auto Dot
+    (std::span<DQ1, Ext1> a_x, std::span<DQ2, Ext2> a_y,
+     unsigned a_nThreads = 0)
+  {
+    if (UNLIKELY(a_x.size() != a_y.size()))
+      throw std::invalid_argument("Dot: Sizes MisMatch");
+    return Dot(a_x.data(), a_y.data(), a_x.size(), a_nThreads);
+  }
+
+  template<typename DQ, size_t Ext>
+  auto Norm(std::span<DQ, Ext> a_vals, unsigned a_nThreads = 0)
+    { return Norm(a_vals.data(), a_vals.size(), a_nThreads); }
+
+  template<typename DQ, size_t Ext>
+  auto Mean(std::span<DQ, Ext> a_vals, unsigned a_nThreads = 0)
+    { return Mean(a_vals.data(), a_vals.size(), a_nThreads); }
+
+  template<typename DQ, size_t Ext>
+  auto Min (std::span<DQ, Ext> a_vals, unsigned a_nThreads = 0)
+    { return Min (a_vals.data(), a_vals.size(), a_nThreads); }
+
+  template<typename DQ, size_t Ext>
+  auto Max (std::span<DQ, Ext> a_vals, unsigned a_nThreads = 0)
+    { return Max (a_vals.data(), a_vals.size(), a_nThreads); }
+}
+// End namespace DimTypes
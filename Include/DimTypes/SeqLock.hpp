@@ -0,0 +1,180 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "DimTypes/SeqLock.hpp":                         //
+//       SeqLock-Published Snapshots of Records of "DimQ" Fields             //
+//===========================================================================//
+// "SeqLocked<Rec, NSlots>" publishes a record "Rec" (typically a struct of
+// "DimQ" fields, eg position, velocity and epoch) from ONE writer thread to
+// any number of reader threads, w/o any locks or memory allocation:
+// (*) The writer ("Publish") copies the record into the next one of "NSlots"
+//     slots, guarded by the slot's own sequence counter, and then makes it the
+//     latest one by a single release store of the version number. It never
+//     waits for the readers.
+// (*) A reader ("Load") copies the latest slot and re-checks its sequence
+//     counter; it only needs to retry if the writer has published another
+//     "NSlots-1" versions during the copy (ie never in practice, for NSlots
+//     >= 2), so readers are wait-free for all practical purposes, and never
+//     see a torn record.
+// "Rec" must be trivially copyable; it is copied as an array of 64-bit atomic
+// words (using relaxed atomic accesses and fences, so there are no data races
+// in the C++ memory model sense):
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace DimTypes
+{
+  //=========================================================================//
+  // "SeqLocked":                                                            //
+  //=========================================================================//
+  template<typename Rec, unsigned NSlots = 4>
+  class SeqLocked
+  {
+  private:
+    static_assert(std::is_trivially_copyable_v<Rec>,
+                  "SeqLocked: The Record must be trivially copyable");
+    static_assert(NSlots >= 2 && (NSlots & (NSlots - 1)) == 0,
+                  "SeqLocked: NSlots must be a power of 2, >= 2");
+
+    constexpr static size_t NWords = (sizeof(Rec) + 7) / 8;
+
+    //-----------------------------------------------------------------------//
+    // "Slot":                                                               //
+    //-----------------------------------------------------------------------//
+    // "m_seq" is 2*Version once the slot holds "Version", and odd while it is
+    // being written:
+    //
+    struct alignas(64) Slot
+    {
+      std::atomic<uint64_t> m_seq;
+      std::atomic<uint64_t> m_words[NWords];
+    };
+
+    alignas(64) std::atomic<uint64_t> m_latest;     // Latest Version
+    Slot                              m_slots[NSlots];
+    // Writer-only:
+    alignas(64) uint64_t              m_version;
+    Rec                               m_last;
+
+    //-----------------------------------------------------------------------//
+    // "CopyIn", "CopyOut":                                                  //
+    //-----------------------------------------------------------------------//
+    static void CopyIn(Slot* a_slot, Rec const& a_rec) noexcept
+    {
+      uint64_t words[NWords] = {};
+      memcpy(words, &a_rec, sizeof(Rec));
+      for (size_t i = 0; i < NWords; ++i)
+        a_slot->m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    static void CopyOut(Slot const* a_slot, Rec* a_rec) noexcept
+    {
+      uint64_t words[NWords];
+      for (size_t i = 0; i < NWords; ++i)
+        words[i] = a_slot->m_words[i].load(std::memory_order_relaxed);
+      memcpy(static_cast<void*>(a_rec), words, sizeof(Rec));
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    explicit SeqLocked(Rec const& a_init = Rec()) noexcept
+    : m_latest (0),
+      m_version(0),
+      m_last   (a_init)
+    {
+      for (Slot& slot: m_slots)
+      {
+        slot.m_seq.store(0, std::memory_order_relaxed);
+        CopyIn(&slot, a_init);
+      }
+    }
+
+    SeqLocked(SeqLocked const&)            = delete;
+    SeqLocked& operator=(SeqLocked const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Writer Side (single thread only):                                     //
+    //-----------------------------------------------------------------------//
+    // "Publish": Makes "a_rec" the latest snapshot; returns its Version:
+    //
+    uint64_t Publish(Rec const& a_rec) noexcept
+    {
+      uint64_t v    = m_version + 1;
+      Slot&    slot = m_slots[v & (NSlots - 1)];
+
+      slot.m_seq.store(2 * v - 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      CopyIn(&slot, a_rec);
+      slot.m_seq.store(2 * v,     std::memory_order_release);
+      m_latest.store  (v,         std::memory_order_release);
+
+      m_version = v;
+      m_last    = a_rec;
+      return v;
+    }
+
+    // "Modify": Applies "a_f(Rec&)" to the last published record, and pub-
+    // lishes the result:
+    //
+    template<typename F>
+    uint64_t Modify(F const& a_f)
+    {
+      Rec rec = m_last;
+      a_f(rec);
+      return Publish(rec);
+    }
+
+    // The last published record, as seen by the writer:
+    Rec const& Last() const noexcept { return m_last; }
+
+    //-----------------------------------------------------------------------//
+    // Reader Side (any threads):                                            //
+    //-----------------------------------------------------------------------//
+    // "TryLoad": A single attempt; returns the Version (0 for the initial
+    // record), or -1 if the slot was overwritten during the copy:
+    //
+    int64_t TryLoad(Rec* a_rec) const noexcept
+    {
+      uint64_t    v    = m_latest.load(std::memory_order_acquire);
+      Slot const& slot = m_slots[v & (NSlots - 1)];
+
+      uint64_t s1 = slot.m_seq.load(std::memory_order_acquire);
+      if (UNLIKELY(s1 != 2 * v))
+        return -1;
+      CopyOut(&slot, a_rec);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint64_t s2 = slot.m_seq.load(std::memory_order_relaxed);
+      return LIKELY(s1 == s2) ? int64_t(v) : -1;
+    }
+
+    // "Load": Retries until a consistent snapshot is obtained:
+    //
+    Rec Load(uint64_t* a_version = nullptr) const noexcept
+    {
+      Rec rec;
+      int64_t v;
+      while ((v = TryLoad(&rec)) < 0)
+      {
+#       if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#       endif
+      }
+      if (a_version != nullptr)
+        *a_version = uint64_t(v);
+      return rec;
+    }
+
+    // The latest Version (cheap, eg for polling for changes):
+    uint64_t Version() const noexcept
+      { return m_latest.load(std::memory_order_acquire); }
+  };
+}
+// End namespace DimTypes
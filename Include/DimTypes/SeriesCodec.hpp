@@ -0,0 +1,487 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "DimTypes/SeriesCodec.hpp":                       //
+//   Lossless Gorilla-Style XOR / Delta-of-Delta Compression of DimQ Series  //
+//===========================================================================//
+// The data are split into independent blocks (of "a_blockSize" samples each),
+// each one starting with a "Bits::SeriesBlockHdr" which carries the (E,U) co-
+// des (and the "MaxDims" they refer to), the "RepCode" and the number of sam-
+// ples, so the blocks can be located by "ScanSeriesBlocks" and decoded in pa-
+// rallel, directly into "DimQ" arrays.
+// Within a block:
+// (*) the magnitudes are XOR-encoded (as in Facebook's Gorilla): each value's
+//     bit pattern is XORed with the previous one, and only the "meaningful"
+//     bits of the result are stored, re-using the previous leading/trailing
+//     zeros window if possible;
+// (*) optional Int64 time stamps are encoded as zig-zagged deltas-of-deltas
+//     in 1, 9, 12, 16 or 68-bit buckets.
+// All multi-byte data are in the native (Little-Endian on all supported plat-
+// forms) byte order; the bit streams are LSB-first, in 64-bit words:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <bit>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // "SeriesBlockHdr":                                                       //
+  //=========================================================================//
+  struct SeriesBlockHdr
+  {
+    char     m_magic[4];     // "DQZ"
+    uint8_t  m_repCode;      // See "RepCode"; only "float" and "double" here
+    uint8_t  m_hasTS;        // Whether the TS stream is present
+    uint8_t  m_maxDims;      // "MaxDims" of the (E,U) codes
+    uint8_t  m_reserved0;
+    uint32_t m_nVals;        // Number of samples
+    uint32_t m_valsLen;      // Length of the vals bit stream, in bytes (8x)
+    uint32_t m_tsLen;        // Length of the TS   bit stream, in bytes (8x)
+    uint32_t m_reserved1;
+    uint64_t m_E;
+    uint64_t m_U;
+  };
+  static_assert(sizeof(SeriesBlockHdr) == 40);
+
+  constexpr inline char SeriesMagic[4] = "DQZ";
+
+  //=========================================================================//
+  // Bit Streams:                                                            //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "BitWriter": Appends 64-bit words to a byte vector:                     //
+  //-------------------------------------------------------------------------//
+  class BitWriter
+  {
+  private:
+    std::vector<uint8_t>* m_out;
+    uint64_t              m_acc;
+    unsigned              m_n;     // Number of bits in "m_acc", always < 64
+
+    void PutWord(uint64_t a_w)
+    {
+      size_t sz = m_out->size();
+      m_out->resize(sz + 8);
+      memcpy(m_out->data() + sz, &a_w, 8);
+    }
+
+  public:
+    BitWriter(std::vector<uint8_t>* a_out)
+    : m_out(a_out),
+      m_acc(0),
+      m_n  (0)
+    { assert(m_out != nullptr); }
+
+    // Puts the "a_nb" (<= 64) lowest bits of "a_bits":
+    void Put(uint64_t a_bits, unsigned a_nb)
+    {
+      assert(a_nb <= 64);
+      if (a_nb == 0)
+        return;
+      if (a_nb < 64)
+        a_bits &= (uint64_t(1) << a_nb) - 1;
+      m_acc |= a_bits << m_n;
+      unsigned total = m_n + a_nb;
+      if (total >= 64)
+      {
+        PutWord(m_acc);
+        m_acc = (m_n == 0) ? 0 : (a_bits >> (64 - m_n));
+        m_n   = total - 64;
+      }
+      else
+        m_n   = total;
+    }
+
+    // Pads the stream to the 64-bit boundary:
+    void Flush()
+    {
+      if (m_n != 0)
+        PutWord(m_acc);
+      m_acc = 0;
+      m_n   = 0;
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // "BitReader":                                                            //
+  //-------------------------------------------------------------------------//
+  // Reading past the end yields 0s (never out-of-bounds memory access):
+  //
+  class BitReader
+  {
+  private:
+    uint8_t const* m_data;
+    size_t         m_nWords;
+    size_t         m_pos;      // In bits
+
+    uint64_t Word(size_t a_w) const
+    {
+      uint64_t w = 0;
+      if (LIKELY(a_w < m_nWords))
+        memcpy(&w, m_data + 8 * a_w, 8);
+      return w;
+    }
+
+  public:
+    BitReader(uint8_t const* a_data, size_t a_len)
+    : m_data  (a_data),
+      m_nWords(a_len / 8),
+      m_pos   (0)
+    {}
+
+    uint64_t Get(unsigned a_nb)
+    {
+      assert(a_nb <= 64);
+      if (a_nb == 0)
+        return 0;
+      size_t   w   = m_pos >> 6;
+      unsigned off = unsigned(m_pos & 63);
+      uint64_t res = Word(w) >> off;
+      if (off + a_nb > 64)
+        res |= Word(w + 1) << (64 - off);
+      m_pos += a_nb;
+      return (a_nb < 64) ? (res & ((uint64_t(1) << a_nb) - 1)) : res;
+    }
+
+    bool Bit() { return Get(1) != 0; }
+  };
+
+  //=========================================================================//
+  // XOR Codec of Magnitudes:                                                //
+  //=========================================================================//
+  // "UInt" is the unsigned int of the same size as the magnitude. Control
+  // codes: '0': same val; '10': meaningful bits within the previous window;
+  // '11': 6-bit LeadingZeros, 6-bit (Len-1), then Len meaningful bits:
+  //
+  template<typename UInt>
+  void XOREncode(UInt const* a_vals, size_t a_n, BitWriter* a_bw)
+  {
+    constexpr unsigned W = 8 * sizeof(UInt);
+    if (a_n == 0)
+      return;
+    UInt     prev   = a_vals[0];
+    a_bw->Put(prev, W);
+    unsigned prevLz = W + 1;   // Invalid window
+    unsigned prevTz = 0;
+
+    for (size_t i = 1; i < a_n; ++i)
+    {
+      UInt x = a_vals[i] ^ prev;
+      prev   = a_vals[i];
+      if (x == 0)
+      {
+        a_bw->Put(0, 1);
+        continue;
+      }
+      unsigned lz = std::min(unsigned(std::countl_zero(x)), 63U);
+      unsigned tz = unsigned(std::countr_zero(x));
+      if (prevLz <= lz && prevTz <= tz)
+      {
+        a_bw->Put(0b01, 2);
+        a_bw->Put(uint64_t(x >> prevTz), W - prevLz - prevTz);
+      }
+      else
+      {
+        unsigned len = W - lz - tz;
+        a_bw->Put(0b11, 2);
+        a_bw->Put(lz,      6);
+        a_bw->Put(len - 1, 6);
+        a_bw->Put(uint64_t(x >> tz), len);
+        prevLz = lz;
+        prevTz = tz;
+      }
+    }
+  }
+
+  template<typename UInt>
+  void XORDecode(BitReader* a_br, size_t a_n, UInt* a_vals)
+  {
+    constexpr unsigned W = 8 * sizeof(UInt);
+    if (a_n == 0)
+      return;
+    UInt     prev   = UInt(a_br->Get(W));
+    a_vals[0]       = prev;
+    unsigned prevLz = 0;
+    unsigned prevTz = 0;
+
+    for (size_t i = 1; i < a_n; ++i)
+    {
+      if (a_br->Bit())
+      {
+        if (a_br->Bit())
+        {
+          prevLz = unsigned(a_br->Get(6));
+          unsigned len = unsigned(a_br->Get(6)) + 1;
+          if (UNLIKELY(prevLz + len > W))
+            throw std::runtime_error("XORDecode: Corrupt Data");
+          prevTz = W - prevLz - len;
+        }
+        prev ^= UInt(a_br->Get(W - prevLz - prevTz) << prevTz);
+      }
+      a_vals[i] = prev;
+    }
+  }
+
+  //=========================================================================//
+  // Delta-of-Delta Codec of Time Stamps:                                    //
+  //=========================================================================//
+  // Control codes: '0': DoD=0; '10': 7 bits; '110': 9 bits; '1110': 12 bits;
+  // '1111': 64 bits (of the zig-zagged DoD):
+  //
+  inline void DoDEncode(int64_t const* a_ts, size_t a_n, BitWriter* a_bw)
+  {
+    if (a_n == 0)
+      return;
+    a_bw->Put(uint64_t(a_ts[0]), 64);
+    int64_t prevDelta = 0;
+    for (size_t i = 1; i < a_n; ++i)
+    {
+      int64_t  delta = int64_t(uint64_t(a_ts[i]) - uint64_t(a_ts[i-1]));
+      int64_t  dod   = int64_t(uint64_t(delta) - uint64_t(prevDelta));
+      uint64_t z     = (uint64_t(dod) << 1) ^ uint64_t(dod >> 63);
+      prevDelta      = delta;
+      if (z == 0)
+        a_bw->Put(0, 1);
+      else
+      if (z < (1U << 7))
+      {
+        a_bw->Put(0b01,   2);
+        a_bw->Put(z,      7);
+      }
+      else
+      if (z < (1U << 9))
+      {
+        a_bw->Put(0b011,  3);
+        a_bw->Put(z,      9);
+      }
+      else
+      if (z < (1U << 12))
+      {
+        a_bw->Put(0b0111, 4);
+        a_bw->Put(z,     12);
+      }
+      else
+      {
+        a_bw->Put(0b1111, 4);
+        a_bw->Put(z,     64);
+      }
+    }
+  }
+
+  inline void DoDDecode(BitReader* a_br, size_t a_n, int64_t* a_ts)
+  {
+    if (a_n == 0)
+      return;
+    a_ts[0] = int64_t(a_br->Get(64));
+    int64_t prevDelta = 0;
+    for (size_t i = 1; i < a_n; ++i)
+    {
+      unsigned ones = 0;
+      while (ones < 4 && a_br->Bit())
+        ++ones;
+      constexpr unsigned NBits[5] = { 0, 7, 9, 12, 64 };
+      uint64_t z     = a_br->Get(NBits[ones]);
+      int64_t  dod   = int64_t(z >> 1) ^ -int64_t(z & 1);
+      prevDelta      = int64_t(uint64_t(prevDelta) + uint64_t(dod));
+      a_ts[i]        = int64_t(uint64_t(a_ts[i-1]) + uint64_t(prevDelta));
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "SeriesUInt": The UInt type for the XOR codec:                          //
+  //-------------------------------------------------------------------------//
+  template<typename RepT>
+  using SeriesUInt =
+    std::conditional_t<sizeof(RepT) == 8, uint64_t, uint32_t>;
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "CompressSeries":                                                       //
+  //=========================================================================//
+  // Appends the compressed blocks to "a_out". "a_ts" (if non-NULL) are the
+  // time stamps of the samples, of the same length "a_n":
+  //
+  template<typename DQ>
+  void CompressSeries
+  (
+    DQ const*             a_vals,
+    size_t                a_n,
+    std::vector<uint8_t>* a_out,
+    int64_t const*        a_ts        = nullptr,
+    unsigned              a_blockSize = 4096
+  )
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    using UInt = Bits::SeriesUInt<RepT>;
+    static_assert(Tr::IsDimQ && std::is_floating_point_v<RepT> &&
+                  (sizeof(RepT) == 8 || sizeof(RepT) == 4),
+                  "CompressSeries: Only float and double RepTs are supported");
+    assert(a_out != nullptr && a_blockSize > 0);
+
+    for (size_t from = 0; from < a_n; from += a_blockSize)
+    {
+      size_t n      = std::min(size_t(a_blockSize), a_n - from);
+      size_t hdrOff = a_out->size();
+      a_out->resize(hdrOff + sizeof(Bits::SeriesBlockHdr));
+
+      // NB: "DimQ" is layout-compatible with "RepT", and "RepT" with "UInt":
+      Bits::BitWriter bw(a_out);
+      Bits::XOREncode<UInt>
+        (reinterpret_cast<UInt const*>(a_vals + from), n, &bw);
+      bw.Flush();
+      size_t tsOff = a_out->size();
+      if (a_ts != nullptr)
+      {
+        Bits::DoDEncode(a_ts + from, n, &bw);
+        bw.Flush();
+      }
+      Bits::SeriesBlockHdr hdr
+      {
+        .m_magic     = { 'D', 'Q', 'Z', '\0' },
+        .m_repCode   = Bits::RepCode<RepT>,
+        .m_hasTS     = (a_ts != nullptr),
+        .m_maxDims   = uint8_t(Tr::MaxDims),
+        .m_reserved0 = 0,
+        .m_nVals     = uint32_t(n),
+        .m_valsLen   = uint32_t(tsOff - hdrOff - sizeof(Bits::SeriesBlockHdr)),
+        .m_tsLen     = uint32_t(a_out->size() - tsOff),
+        .m_reserved1 = 0,
+        .m_E         = Tr::E,
+        .m_U         = Tr::U
+      };
+      memcpy(a_out->data() + hdrOff, &hdr, sizeof(hdr));
+    }
+  }
+
+  //=========================================================================//
+  // "SeriesBlockInfo", "ScanSeriesBlocks":                                  //
+  //=========================================================================//
+  // Locates all blocks (validating their headers), so that they can be decod-
+  // ed in parallel; "m_outOff" is the index of the 1st sample of the block in
+  // the whole series:
+  //
+  struct SeriesBlockInfo
+  {
+    size_t m_off;
+    size_t m_outOff;
+    size_t m_nVals;
+  };
+
+  inline std::vector<SeriesBlockInfo> ScanSeriesBlocks
+    (uint8_t const* a_data, size_t a_len)
+  {
+    std::vector<SeriesBlockInfo> res;
+    size_t outOff = 0;
+    for (size_t off = 0; off < a_len; )
+    {
+      Bits::SeriesBlockHdr hdr;
+      if (UNLIKELY(a_len - off < sizeof(hdr)))
+        throw std::runtime_error("ScanSeriesBlocks: Truncated Data");
+      memcpy(&hdr, a_data + off, sizeof(hdr));
+      size_t len = sizeof(hdr) + size_t(hdr.m_valsLen) + size_t(hdr.m_tsLen);
+      // Each sample after the 1st one takes at least 1 bit:
+      if (UNLIKELY(memcmp(hdr.m_magic, Bits::SeriesMagic, 4) != 0 ||
+                   a_len - off < len                              ||
+                   (hdr.m_nVals != 0 &&
+                    hdr.m_nVals - 1 > 8 * uint64_t(hdr.m_valsLen))))
+        throw std::runtime_error("ScanSeriesBlocks: Invalid Block");
+      res.push_back(SeriesBlockInfo{ off, outOff, hdr.m_nVals });
+      outOff += hdr.m_nVals;
+      off    += len;
+    }
+    return res;
+  }
+
+  //=========================================================================//
+  // "DecompressSeriesBlock":                                                //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS". Decodes a single blo-
+  // ck at "a_block" into "a_vals" (and "a_ts" if non-NULL; then the block must
+  // contain time stamps).  The Units are converted into those of "DQ" if nec-
+  // essary; a Dims mismatch results in an exception. Returns the number of
+  // samples:
+  //
+  template<typename Sys, typename DQ>
+  size_t DecompressSeriesBlock
+  (
+    uint8_t const* a_block,
+    DQ*            a_vals,
+    int64_t*       a_ts = nullptr
+  )
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    using UInt = Bits::SeriesUInt<RepT>;
+    using En   = Bits::Encodings<RepT, Tr::MaxDims>;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  Tr::MaxDims == Sys::MaxDims,
+                  "DecompressSeriesBlock: Incompatible DimQ Type");
+
+    Bits::SeriesBlockHdr hdr;
+    memcpy(&hdr, a_block, sizeof(hdr));
+    if (UNLIKELY(memcmp(hdr.m_magic, Bits::SeriesMagic, 4) != 0 ||
+                 hdr.m_repCode != Bits::RepCode<RepT>))
+      throw std::runtime_error("DecompressSeriesBlock: Invalid Block/RepT");
+    // The (E,U) codes are only meaningful with the same "MaxDims":
+    if (UNLIKELY(hdr.m_maxDims != Tr::MaxDims))
+      throw std::runtime_error("DecompressSeriesBlock: MaxDims MisMatch");
+    if (UNLIKELY(hdr.m_E != Tr::E))
+      throw std::runtime_error("DecompressSeriesBlock: Dims MisMatch");
+    if (UNLIKELY(a_ts != nullptr && !hdr.m_hasTS))
+      throw std::runtime_error("DecompressSeriesBlock: No Time Stamps");
+
+    uint8_t const* vals = a_block + sizeof(hdr);
+    size_t         n    = hdr.m_nVals;
+    Bits::BitReader br(vals, hdr.m_valsLen);
+    Bits::XORDecode<UInt>(&br, n, reinterpret_cast<UInt*>(a_vals));
+
+    if (a_ts != nullptr)
+    {
+      Bits::BitReader tbr(vals + hdr.m_valsLen, hdr.m_tsLen);
+      Bits::DoDDecode(&tbr, n, a_ts);
+    }
+    // Units conversion (a simple vectorisable loop), if required:
+    uint64_t toU = En::CleanUpUnits(Tr::E, Tr::U);
+    if (hdr.m_U != toU)
+    {
+      RepT  factor = RepT(Bits::UnitsConvFactor<Sys>(Tr::E, hdr.m_U, toU));
+      RepT* mags   = reinterpret_cast<RepT*>(a_vals);
+      for (size_t i = 0; i < n; ++i)
+        mags[i] *= factor;
+    }
+    return n;
+  }
+
+  //=========================================================================//
+  // "DecompressSeries": All blocks, sequentially:                           //
+  //=========================================================================//
+  template<typename Sys, typename DQ>
+  void DecompressSeries
+  (
+    uint8_t const*        a_data,
+    size_t                a_len,
+    std::vector<DQ>*      a_vals,
+    std::vector<int64_t>* a_ts = nullptr
+  )
+  {
+    assert(a_vals != nullptr);
+    auto blocks = ScanSeriesBlocks(a_data, a_len);
+    size_t total = blocks.empty()
+                   ? 0 : (blocks.back().m_outOff + blocks.back().m_nVals);
+    a_vals->resize(total);
+    if (a_ts != nullptr)
+      a_ts->resize(total);
+    for (auto const& b: blocks)
+      DecompressSeriesBlock<Sys, DQ>
+        (a_data + b.m_off, a_vals->data() + b.m_outOff,
+         (a_ts != nullptr) ? (a_ts->data() + b.m_outOff) : nullptr);
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,373 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "DimTypes/Telemetry.hpp":                        //
+//    Sharded Contention-Free Accumulators and Histograms of "DimQ"s         //
+//===========================================================================//
+// Both "ShardedStats" and "ShardedHistogram" keep "NShards" independent cache-
+// line-aligned copies of their state. Each writer thread is assigned a shard
+// (round-robin, on its first use of any sharded object), and only updates that
+// shard with relaxed atomic ops, so as long as there are no more than "NShards"
+// writer threads, the write path touches no cache lines shared with other wri-
+// ters. The shards are merged on read (which is therefore O(NShards), and only
+// approximately consistent while the writers are active). Only "float" and
+// "double" RepTs are supported (as in "AtomicDimQ"):
+//
+#pragma  once
+#include "Atomic.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //-------------------------------------------------------------------------//
+  // "ThreadShard": The shard index of the calling thread:                   //
+  //-------------------------------------------------------------------------//
+  inline std::atomic<unsigned> NextThreadShard = 0;
+
+  template<unsigned NShards>
+  inline unsigned ThreadShard()
+  {
+    static_assert(NShards != 0 && (NShards & (NShards - 1)) == 0,
+                  "ThreadShard: NShards must be a power of 2");
+    thread_local unsigned idx =
+      NextThreadShard.fetch_add(1, std::memory_order_relaxed);
+    return idx & (NShards - 1);
+  }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "ShardedStats": Count, Sum, Sum of Squares, Min, Max:                   //
+  //=========================================================================//
+  template<typename DQ, unsigned NShards = 32>
+  class ShardedStats
+  {
+  private:
+    using RepT = typename DimQTraits<DQ>::RepT;
+    using DQ2  = decltype(std::declval<DQ>() * std::declval<DQ>());
+    static_assert(DimQTraits<DQ>::IsDimQ && std::is_floating_point_v<RepT>,
+                  "ShardedStats: UnSupported DimQ Type");
+
+    struct alignas(64) Shard
+    {
+      std::atomic<uint64_t> m_count;
+      AtomicDimQ<DQ>        m_sum;
+      AtomicDimQ<DQ2>       m_sumSq;
+      AtomicDimQ<DQ>        m_min;
+      AtomicDimQ<DQ>        m_max;
+    };
+    Shard m_shards[NShards];
+
+  public:
+    //-----------------------------------------------------------------------//
+    // "Snapshot": The merged state:                                         //
+    //-----------------------------------------------------------------------//
+    struct Snapshot
+    {
+      uint64_t m_count;
+      DQ       m_sum;
+      DQ2      m_sumSq;
+      DQ       m_min;     // +Inf if empty
+      DQ       m_max;     // -Inf if empty
+
+      // The following return NaN if empty:
+      DQ Mean() const
+        { return m_sum / RepT(m_count); }
+
+      // The population variance (clamped at 0 against rounding errors):
+      DQ2 Var() const
+      {
+        DQ  mean = Mean();
+        DQ2 var  = m_sumSq / RepT(m_count) - mean * mean;
+        return var.IsNeg() ? DQ2(RepT(0.0)) : var;
+      }
+
+      DQ StdDev() const { return SqRt(Var()); }
+    };
+
+    //-----------------------------------------------------------------------//
+    // Default Ctor, "Reset":                                                //
+    //-----------------------------------------------------------------------//
+    ShardedStats() { Reset(); }
+
+    ShardedStats(ShardedStats const&)            = delete;
+    ShardedStats& operator=(ShardedStats const&) = delete;
+
+    // NB: Not atomic w.r.t. concurrent "Record"s:
+    void Reset()
+    {
+      constexpr auto Rlx = std::memory_order_relaxed;
+      constexpr RepT Inf = Bits::CEMaths::Inf<RepT>;
+      for (Shard& s: m_shards)
+      {
+        s.m_count.store(0,                Rlx);
+        s.m_sum  .store(DQ (RepT(0.0)),   Rlx);
+        s.m_sumSq.store(DQ2(RepT(0.0)),   Rlx);
+        s.m_min  .store(DQ ( Inf),        Rlx);
+        s.m_max  .store(DQ (-Inf),        Rlx);
+      }
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Record": The Write Path:                                             //
+    //-----------------------------------------------------------------------//
+    void Record(DQ a_x) noexcept
+    {
+      Shard& s = m_shards[Bits::ThreadShard<NShards>()];
+      s.m_count.fetch_add(1,         std::memory_order_relaxed);
+      s.m_sum  .fetch_add(a_x,       std::memory_order_relaxed);
+      s.m_sumSq.fetch_add(a_x * a_x, std::memory_order_relaxed);
+      s.m_min  .fetch_min(a_x,       std::memory_order_relaxed);
+      s.m_max  .fetch_max(a_x,       std::memory_order_relaxed);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Get": The Read Path:                                                 //
+    //-----------------------------------------------------------------------//
+    Snapshot Get() const
+    {
+      Snapshot res { 0, DQ(RepT(0.0)), DQ2(RepT(0.0)),
+                     DQ( Bits::CEMaths::Inf<RepT>),
+                     DQ(-Bits::CEMaths::Inf<RepT>) };
+      for (Shard const& s: m_shards)
+      {
+        res.m_count += s.m_count.load(std::memory_order_relaxed);
+        res.m_sum   += s.m_sum  .load(std::memory_order_relaxed);
+        res.m_sumSq += s.m_sumSq.load(std::memory_order_relaxed);
+        DQ mn = s.m_min.load(std::memory_order_relaxed);
+        DQ mx = s.m_max.load(std::memory_order_relaxed);
+        res.m_min    = (mn < res.m_min) ? mn : res.m_min;
+        res.m_max    = (mx > res.m_max) ? mx : res.m_max;
+      }
+      return res;
+    }
+  };
+
+  //=========================================================================//
+  // "ShardedHistogram": Log-Linear Buckets:                                 //
+  //=========================================================================//
+  // The layout is given by "a_lo", "a_hi" (in the Units of "DQ", both > 0) and
+  // "a_subBuckets" (a power of 2): each octave [lo*2^k, lo*2^(k+1)) is split
+  // into "a_subBuckets" linear buckets, so the relative width of each bucket
+  // is at most 1/a_subBuckets. Bucket 0 is for vals below "a_lo" (including
+  // negative ones and NaNs), the last bucket is for vals >= "a_hi". The min
+  // and max of the recorded vals are tracked as well (per shard), to bound the
+  // quantiles:
+  //
+  template<typename DQ, unsigned NShards = 32>
+  class ShardedHistogram
+  {
+  private:
+    using RepT = typename DimQTraits<DQ>::RepT;
+    static_assert(DimQTraits<DQ>::IsDimQ && std::is_floating_point_v<RepT>,
+                  "ShardedHistogram: UnSupported DimQ Type");
+
+    // Cache lines of counters:
+    struct alignas(64) Line
+    {
+      std::atomic<uint64_t> m_counts[64 / sizeof(uint64_t)];
+    };
+    constexpr static unsigned LineLen = 64 / sizeof(uint64_t);
+
+    // The observed range (NaNs are ignored):
+    struct alignas(64) Extrema
+    {
+      AtomicDimQ<DQ>      m_min;
+      AtomicDimQ<DQ>      m_max;
+    };
+
+    RepT              m_lo;
+    RepT              m_hi;
+    RepT              m_invLo;
+    unsigned          m_subBuckets;
+    int               m_log2Sub;
+    unsigned          m_nBuckets;    // Including under- and over-flow
+    unsigned          m_nLines;      // Per shard
+    std::vector<Line> m_lines;       // [NShards * m_nLines]
+    std::vector<Extrema> m_extrema;  // [NShards]
+
+    // The regular bucket of "a_r" = x/lo >= 1, not bounded by "hi":
+    unsigned RawBucket(RepT a_r) const noexcept
+    {
+      int  e;
+      RepT m   = std::frexp(a_r, &e);   // r = m * 2^e, m in [0.5, 1)
+      auto sub = unsigned((RepT(2.0) * m - RepT(1.0)) * RepT(m_subBuckets));
+      return 1 + (unsigned(e - 1) << m_log2Sub) +
+             std::min(sub, m_subBuckets - 1);
+    }
+
+  public:
+    //-----------------------------------------------------------------------//
+    // Non-Default Ctor:                                                     //
+    //-----------------------------------------------------------------------//
+    ShardedHistogram(DQ a_lo, DQ a_hi, unsigned a_subBuckets = 16)
+    : m_lo        (a_lo.Magnitude()),
+      m_hi        (a_hi.Magnitude()),
+      m_invLo     (RepT(1.0) / m_lo),
+      m_subBuckets(a_subBuckets),
+      m_log2Sub   (std::countr_zero(a_subBuckets)),
+      m_nBuckets  (0),
+      m_nLines    (0),
+      m_lines     (),
+      m_extrema   (NShards)
+    {
+      if (UNLIKELY(!(m_lo > RepT(0.0) && m_hi > m_lo && std::isfinite(m_hi)) ||
+                   a_subBuckets == 0 ||
+                   (a_subBuckets & (a_subBuckets - 1)) != 0))
+        throw std::invalid_argument("ShardedHistogram: Invalid Layout");
+
+      // The last regular bucket is the one containing "hi" (truncated at "hi"),
+      // unless "hi" is exactly on a bucket boundary:
+      unsigned last = RawBucket(m_hi * m_invLo);
+      m_nBuckets    = last + 2;
+      if (BucketLo(last).Magnitude() >= m_hi)
+        --m_nBuckets;
+      m_nLines      = (m_nBuckets + LineLen - 1) / LineLen;
+      m_lines      = std::vector<Line>(NShards * m_nLines);
+      Reset();
+    }
+
+    ShardedHistogram(ShardedHistogram const&)            = delete;
+    ShardedHistogram& operator=(ShardedHistogram const&) = delete;
+
+    //-----------------------------------------------------------------------//
+    // Layout:                                                               //
+    //-----------------------------------------------------------------------//
+    unsigned NBuckets() const { return m_nBuckets; }
+
+    unsigned BucketOf(DQ a_x) const noexcept
+    {
+      RepT r = a_x.Magnitude() * m_invLo;
+      if (!(r >= RepT(1.0)))
+        return 0;                       // UnderFlow (or NaN)
+      if (a_x.Magnitude() >= m_hi)
+        return m_nBuckets - 1;          // OverFlow
+      return std::min(RawBucket(r), m_nBuckets - 2);
+    }
+
+    // The lower bound of the bucket (-Inf for the UnderFlow one):
+    DQ BucketLo(unsigned a_b) const
+    {
+      assert(a_b < m_nBuckets);
+      if (a_b == 0)
+        return DQ(-Bits::CEMaths::Inf<RepT>);
+      if (a_b == m_nBuckets - 1)
+        return DQ(m_hi);
+      unsigned k = (a_b - 1) >> m_log2Sub;
+      unsigned j = (a_b - 1) &  (m_subBuckets - 1);
+      return DQ(std::ldexp(m_lo, int(k)) *
+                (RepT(1.0) + RepT(j) / RepT(m_subBuckets)));
+    }
+
+    // The upper bound of the bucket (+Inf for the OverFlow one):
+    DQ BucketHi(unsigned a_b) const
+    {
+      assert(a_b < m_nBuckets);
+      return (a_b == m_nBuckets - 1)
+             ? DQ(Bits::CEMaths::Inf<RepT>)
+             : (a_b == m_nBuckets - 2)
+             ? DQ(m_hi)
+             : BucketLo(a_b + 1);
+    }
+
+    //-----------------------------------------------------------------------//
+    // "Record": The Write Path:                                             //
+    //-----------------------------------------------------------------------//
+    void Record(DQ a_x) noexcept
+    {
+      unsigned b     = BucketOf(a_x);
+      unsigned shard = Bits::ThreadShard<NShards>();
+      Line*    l     = m_lines.data() + shard * m_nLines;
+      l[b / LineLen].m_counts[b % LineLen].fetch_add
+        (1, std::memory_order_relaxed);
+      m_extrema[shard].m_min.fetch_min(a_x, std::memory_order_relaxed);
+      m_extrema[shard].m_max.fetch_max(a_x, std::memory_order_relaxed);
+    }
+
+    //-----------------------------------------------------------------------//
+    // The Read Path:                                                        //
+    //-----------------------------------------------------------------------//
+    // "GetCounts": The merged counts of all buckets:
+    //
+    std::vector<uint64_t> GetCounts() const
+    {
+      std::vector<uint64_t> res(m_nBuckets, 0);
+      for (unsigned s = 0; s < NShards; ++s)
+      {
+        Line const* l = m_lines.data() + s * m_nLines;
+        for (unsigned b = 0; b < m_nBuckets; ++b)
+          res[b] += l[b / LineLen].m_counts[b % LineLen].load
+                    (std::memory_order_relaxed);
+      }
+      return res;
+    }
+
+    // "GetMinMax": The observed range (+Inf, -Inf if there are no non-NaN
+    // vals):
+    //
+    std::pair<DQ, DQ> GetMinMax() const
+    {
+      DQ mn( Bits::CEMaths::Inf<RepT>);
+      DQ mx(-Bits::CEMaths::Inf<RepT>);
+      for (Extrema const& e: m_extrema)
+      {
+        DQ smn = e.m_min.load(std::memory_order_relaxed);
+        DQ smx = e.m_max.load(std::memory_order_relaxed);
+        mn     = (smn < mn) ? smn : mn;
+        mx     = (smx > mx) ? smx : mx;
+      }
+      return std::make_pair(mn, mx);
+    }
+
+    // "Quantile": The upper bound of the bucket containing the "a_q" quantile
+    // (0 <= a_q <= 1), clamped to the observed range, so the relative error is
+    // at most 1/a_subBuckets within the [lo, hi) range, and the result is never
+    // above the max recorded val. NaN if empty:
+    //
+    DQ Quantile(double a_q) const
+    {
+      std::vector<uint64_t> counts = GetCounts();
+      uint64_t total = 0;
+      for (uint64_t c: counts)
+        total += c;
+      if (total == 0)
+        return DQ(Bits::CEMaths::NaN<RepT>);
+
+      auto     rank = uint64_t(std::ceil(std::clamp(a_q, 0.0, 1.0) *
+                                         double(total)));
+      uint64_t cum  = 0;
+      unsigned b    = 0;
+      for (; b < m_nBuckets - 1; ++b)
+      {
+        cum += counts[b];
+        if (cum >= std::max<uint64_t>(rank, 1))
+          break;
+      }
+      DQ   res      = BucketHi(b);
+      auto [mn, mx] = GetMinMax();
+      if (!(mn <= mx))
+        return res;     // Only NaNs were recorded
+      return (res > mx) ? mx : (res < mn) ? mn : res;
+    }
+
+    // NB: Not atomic w.r.t. concurrent "Record"s:
+    void Reset()
+    {
+      for (Line& l: m_lines)
+        for (auto& c: l.m_counts)
+          c.store(0, std::memory_order_relaxed);
+      for (Extrema& e: m_extrema)
+      {
+        e.m_min.store(DQ( Bits::CEMaths::Inf<RepT>), std::memory_order_relaxed);
+        e.m_max.store(DQ(-Bits::CEMaths::Inf<RepT>), std::memory_order_relaxed);
+      }
+    }
+  };
+}
+// End namespace DimTypes
@@ -0,0 +1,121 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "DimTypes/Vec3.hpp":                           //
+//               3D Vectors of Dimensioned Quantities ("DimQ"s)              //
+//===========================================================================//
+// "Vec3<DQ>" is a plain aggregate of 3 "DQ"s (so it is trivially copyable and
+// has the layout of "DQ[3]"); the arithmetic ops follow the "DimQ" ones,  so
+// eg a "Vec3<Len_km>" divided by a "Time_sec" is a "Vec3" of velocities, and
+// adding vectors with different Dims is a compile-time error:
+//
+#pragma  once
+#include "DimTypes.hpp"
+
+namespace DimTypes
+{
+  template<typename DQ>
+  struct Vec3
+  {
+    DQ m_c[3];
+
+    constexpr DQ&       operator[](unsigned a_i)       { return m_c[a_i]; }
+    constexpr DQ const& operator[](unsigned a_i) const { return m_c[a_i]; }
+
+    template<typename DQ2>
+    constexpr Vec3& operator+=(Vec3<DQ2> const& a_right)
+    {
+      for (unsigned i = 0; i < 3; ++i)
+        m_c[i] += a_right.m_c[i];
+      return *this;
+    }
+
+    template<typename DQ2>
+    constexpr Vec3& operator-=(Vec3<DQ2> const& a_right)
+    {
+      for (unsigned i = 0; i < 3; ++i)
+        m_c[i] -= a_right.m_c[i];
+      return *this;
+    }
+  };
+
+  //-------------------------------------------------------------------------//
+  // Additive Ops:                                                           //
+  //-------------------------------------------------------------------------//
+  template<typename A, typename B>
+  constexpr Vec3<A> operator+(Vec3<A> const& a_left, Vec3<B> const& a_right)
+  {
+    return Vec3<A>{{ a_left.m_c[0] + a_right.m_c[0],
+                     a_left.m_c[1] + a_right.m_c[1],
+                     a_left.m_c[2] + a_right.m_c[2] }};
+  }
+
+  template<typename A, typename B>
+  constexpr Vec3<A> operator-(Vec3<A> const& a_left, Vec3<B> const& a_right)
+  {
+    return Vec3<A>{{ a_left.m_c[0] - a_right.m_c[0],
+                     a_left.m_c[1] - a_right.m_c[1],
+                     a_left.m_c[2] - a_right.m_c[2] }};
+  }
+
+  template<typename A>
+  constexpr Vec3<A> operator-(Vec3<A> const& a_right)
+    { return Vec3<A>{{ -a_right.m_c[0], -a_right.m_c[1], -a_right.m_c[2] }}; }
+
+  //-------------------------------------------------------------------------//
+  // Multiplication and Division by Scalars ("DimQ"s or "RepT"s):            //
+  //-------------------------------------------------------------------------//
+  template<typename A, typename S>
+  constexpr auto operator*(Vec3<A> const& a_left, S a_right)
+    -> Vec3<decltype(a_left.m_c[0] * a_right)>
+  {
+    return {{ a_left.m_c[0] * a_right, a_left.m_c[1] * a_right,
+              a_left.m_c[2] * a_right }};
+  }
+
+  template<typename S, typename A>
+  constexpr auto operator*(S a_left, Vec3<A> const& a_right)
+    -> Vec3<decltype(a_right.m_c[0] * a_left)>
+    { return a_right * a_left; }
+
+  template<typename A, typename S>
+  constexpr auto operator/(Vec3<A> const& a_left, S a_right)
+    -> Vec3<decltype(a_left.m_c[0] / a_right)>
+  {
+    return {{ a_left.m_c[0] / a_right, a_left.m_c[1] / a_right,
+              a_left.m_c[2] / a_right }};
+  }
+
+  //-------------------------------------------------------------------------//
+  // "Dot", "Cross", "Norm2", "Norm":                                        //
+  //-------------------------------------------------------------------------//
+  template<typename A, typename B>
+  constexpr auto Dot(Vec3<A> const& a_left, Vec3<B> const& a_right)
+  {
+    return a_left.m_c[0] * a_right.m_c[0] + a_left.m_c[1] * a_right.m_c[1] +
+           a_left.m_c[2] * a_right.m_c[2];
+  }
+
+  template<typename A, typename B>
+  constexpr auto Cross(Vec3<A> const& a_left, Vec3<B> const& a_right)
+    -> Vec3<decltype(a_left.m_c[0] * a_right.m_c[0])>
+  {
+    return {{ a_left.m_c[1] * a_right.m_c[2] - a_left.m_c[2] * a_right.m_c[1],
+              a_left.m_c[2] * a_right.m_c[0] - a_left.m_c[0] * a_right.m_c[2],
+              a_left.m_c[0] * a_right.m_c[1] - a_left.m_c[1] * a_right.m_c[0]
+           }};
+  }
+
+  template<typename A>
+  constexpr auto Norm2(Vec3<A> const& a_v) { return Dot(a_v, a_v); }
+
+  template<typename A>
+  constexpr A Norm(Vec3<A> const& a_v)
+  {
+    using std::sqrt;
+    if constexpr (IsDimQ<A>)
+      return SqRt(Norm2(a_v));
+    else
+      return sqrt(Norm2(a_v));
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,244 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "DimTypes/Wire.hpp":                          //
+//          Wire-Stable Binary Serialisation of "DimQ" Values and Arrays     //
+//===========================================================================//
+// Each message starts with a 64-bit tag which combines "DimQ_Fingerprint" of
+// the Dimension System with the (E,U) codes of the type (and the message kind,
+// scalar or array), so the receiver validates the message with a SINGLE int-
+// eger comparison against its compile-time expectation, and no Units strings
+// are ever sent. Formats (all ints and floats are Little-Endian, regardless of
+// the host byte order):
+// (*) scalar: UInt64 Tag, Magnitude;
+// (*) array:  UInt64 Tag, UInt64 N, N Magnitudes.
+// "float" and "double" RepTs (and complex numbers of them) are supported;
+// "long double" is not, as its representation is platform-specific:
+//
+#pragma  once
+#include "DimTypes.hpp"
+#include <bit>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+namespace DimTypes
+{
+namespace Bits
+{
+  //=========================================================================//
+  // Wire Utils:                                                             //
+  //=========================================================================//
+  template<typename RepT>
+  constexpr inline bool IsWireRepT =
+    std::is_same_v<RepT, float>               ||
+    std::is_same_v<RepT, double>              ||
+    std::is_same_v<RepT, std::complex<float>> ||
+    std::is_same_v<RepT, std::complex<double>>;
+
+  //-------------------------------------------------------------------------//
+  // "WireLE": Converts a 4- or 8-byte word between native and LE orders:    //
+  //-------------------------------------------------------------------------//
+  template<typename UInt>
+  constexpr UInt WireLE(UInt a_x)
+  {
+    if constexpr (std::endian::native == std::endian::big)
+      return std::byteswap(a_x);
+    else
+      return a_x;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "WirePutMag", "WireGetMag":                                             //
+  //-------------------------------------------------------------------------//
+  // Magnitudes are sequences of 1 or 2 (for complex) IEEE 754 words:
+  //
+  template<typename RepT>
+  using WireWord = std::conditional_t
+    <sizeof(RepT) / (CEMaths::IsComplex<RepT> ? 2 : 1) == 4,
+     uint32_t, uint64_t>;
+
+  template<typename RepT>
+  inline void WirePutMag(RepT const& a_mag, uint8_t* a_buff)
+  {
+    if constexpr (std::endian::native == std::endian::little)
+      memcpy(a_buff, &a_mag, sizeof(RepT));
+    else
+    {
+      using UInt = WireWord<RepT>;
+      UInt words[sizeof(RepT) / sizeof(UInt)];
+      memcpy(words, &a_mag, sizeof(RepT));
+      for (UInt& w: words)
+        w = WireLE(w);
+      memcpy(a_buff, words, sizeof(RepT));
+    }
+  }
+
+  template<typename RepT>
+  inline RepT WireGetMag(uint8_t const* a_buff)
+  {
+    RepT res;
+    if constexpr (std::endian::native == std::endian::little)
+      memcpy(&res, a_buff, sizeof(RepT));
+    else
+    {
+      using UInt = WireWord<RepT>;
+      UInt words[sizeof(RepT) / sizeof(UInt)];
+      memcpy(words, a_buff, sizeof(RepT));
+      for (UInt& w: words)
+        w = WireLE(w);
+      memcpy(&res, words, sizeof(RepT));
+    }
+    return res;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "WireFail":                                                             //
+  //-------------------------------------------------------------------------//
+  [[noreturn]] inline void WireFail(char const* a_msg)
+    { throw std::runtime_error(std::string("WireDecode: ") + a_msg); }
+}
+// End namespace Bits
+
+  //=========================================================================//
+  // "WireTag", "WireSize":                                                  //
+  //=========================================================================//
+  // "Sys" is the "DimQ_Sys" generated by "DECLARE_DIMS":
+  //
+  template<typename Sys, typename DQ, bool IsArray = false>
+  constexpr inline uint64_t WireTag =
+    Bits::FNVMix(Bits::FNVMix(Bits::FNVMix(
+      Bits::DimsFingerprint<Sys>, DimQTraits<DQ>::E),
+      DimQTraits<DQ>::U), IsArray ? 2 : 1);
+
+  // The size of a scalar message:
+  template<typename DQ>
+  constexpr inline size_t WireSize =
+    sizeof(uint64_t) + sizeof(typename DimQTraits<DQ>::RepT);
+
+  //=========================================================================//
+  // Encoding:                                                               //
+  //=========================================================================//
+  //-------------------------------------------------------------------------//
+  // "WireEncode": A single "DimQ":                                          //
+  //-------------------------------------------------------------------------//
+  // "a_buff" must have room for "WireSize<DQ>" bytes; returns the ptr past
+  // the message:
+  //
+  template<typename Sys, typename DQ>
+  uint8_t* WireEncode(DQ a_val, uint8_t* a_buff)
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  Tr::MaxDims == Sys::MaxDims && Bits::IsWireRepT<RepT> &&
+                  std::is_trivially_copyable_v<DQ>,
+                  "WireEncode: Incompatible DimQ Type");
+    assert(a_buff != nullptr);
+    constexpr uint64_t Tag = Bits::WireLE(WireTag<Sys, DQ>);
+    memcpy(a_buff, &Tag, sizeof(Tag));
+    Bits::WirePutMag(a_val.Magnitude(), a_buff + sizeof(Tag));
+    return a_buff + WireSize<DQ>;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "WireEncode": An array of "DimQ"s (appended to "a_out"):                //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  void WireEncode(DQ const* a_vals, size_t a_n, std::vector<uint8_t>* a_out)
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  Tr::MaxDims == Sys::MaxDims && Bits::IsWireRepT<RepT> &&
+                  std::is_trivially_copyable_v<DQ>,
+                  "WireEncode: Incompatible DimQ Type");
+    assert(a_out != nullptr && (a_vals != nullptr || a_n == 0));
+
+    size_t off = a_out->size();
+    a_out->resize(off + 2 * sizeof(uint64_t) + a_n * sizeof(RepT));
+    uint8_t* curr = a_out->data() + off;
+
+    constexpr uint64_t Tag = Bits::WireLE(WireTag<Sys, DQ, true>);
+    uint64_t           n   = Bits::WireLE(uint64_t(a_n));
+    memcpy(curr,     &Tag, 8);
+    memcpy(curr + 8, &n,   8);
+    curr += 16;
+
+    if constexpr (std::endian::native == std::endian::little)
+      // NB: "DimQ" is layout-compatible with "RepT":
+      memcpy(curr, a_vals, a_n * sizeof(RepT));
+    else
+      for (size_t i = 0; i < a_n; ++i, curr += sizeof(RepT))
+        Bits::WirePutMag(a_vals[i].Magnitude(), curr);
+  }
+
+  //=========================================================================//
+  // Decoding:                                                               //
+  //=========================================================================//
+  // Both functions return the ptr past the decoded message, and throw "std::
+  // runtime_error" if the message is truncated or its tag does not match the
+  // expected one (ie a different Dimension System or type):
+  //-------------------------------------------------------------------------//
+  // "WireDecode": A single "DimQ":                                          //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  uint8_t const* WireDecode
+    (uint8_t const* a_from, uint8_t const* a_to, DQ* a_res)
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  Tr::MaxDims == Sys::MaxDims && Bits::IsWireRepT<RepT> &&
+                  std::is_trivially_copyable_v<DQ>,
+                  "WireDecode: Incompatible DimQ Type");
+    assert(a_from != nullptr && a_from <= a_to && a_res != nullptr);
+    if (UNLIKELY(size_t(a_to - a_from) < WireSize<DQ>))
+      Bits::WireFail("Truncated Message");
+
+    uint64_t tag;
+    memcpy(&tag, a_from, sizeof(tag));
+    if (UNLIKELY((Bits::WireLE(tag) != WireTag<Sys, DQ>)))
+      Bits::WireFail("Tag MisMatch");
+    *a_res = DQ(Bits::WireGetMag<RepT>(a_from + sizeof(tag)));
+    return a_from + WireSize<DQ>;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "WireDecode": An array of "DimQ"s:                                      //
+  //-------------------------------------------------------------------------//
+  template<typename Sys, typename DQ>
+  uint8_t const* WireDecode
+    (uint8_t const* a_from, uint8_t const* a_to, std::vector<DQ>* a_res)
+  {
+    using Tr   = DimQTraits<DQ>;
+    using RepT = typename Tr::RepT;
+    static_assert(Tr::IsDimQ && std::is_same_v<RepT, typename Sys::RepT> &&
+                  Tr::MaxDims == Sys::MaxDims && Bits::IsWireRepT<RepT> &&
+                  std::is_trivially_copyable_v<DQ>,
+                  "WireDecode: Incompatible DimQ Type");
+    assert(a_from != nullptr && a_from <= a_to && a_res != nullptr);
+    size_t len = size_t(a_to - a_from);
+    if (UNLIKELY(len < 16))
+      Bits::WireFail("Truncated Message");
+
+    uint64_t tag;
+    uint64_t n;
+    memcpy(&tag, a_from,     8);
+    memcpy(&n,   a_from + 8, 8);
+    n = Bits::WireLE(n);
+    if (UNLIKELY((Bits::WireLE(tag) != WireTag<Sys, DQ, true>)))
+      Bits::WireFail("Tag MisMatch");
+    if (UNLIKELY((len - 16) / sizeof(RepT) < n))
+      Bits::WireFail("Truncated Message");
+
+    a_res->resize(n);
+    uint8_t const* curr = a_from + 16;
+    if constexpr (std::endian::native == std::endian::little)
+      memcpy(a_res->data(), curr, n * sizeof(RepT));
+    else
+      for (size_t i = 0; i < n; ++i)
+        (*a_res)[i] = DQ(Bits::WireGetMag<RepT>(curr + i * sizeof(RepT)));
+    return curr + n * sizeof(RepT);
+  }
+}
+// End namespace DimTypes
@@ -0,0 +1,220 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "Tests/ArrowTest.cpp":                         //
+//===========================================================================//
+// Export -> Import round-trips via the Arrow C Data Interface, incl sliced
+// batches (as produced by Arrow's "Slice"), malformed metadata, and exports
+// failing on memory allocation (which must not leak):
+//
+#include "DimTypes/Arrow.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+//---------------------------------------------------------------------------//
+// Allocation Failure Injection:                                             //
+//---------------------------------------------------------------------------//
+// If "NewBudget" >= 0, it is the number of "operator new" calls to succeed
+// before one throws; "NLive" is the number of live allocations:
+//
+namespace
+{
+  long NewBudget = -1;
+  long NLive     = 0;
+}
+
+void* operator new(size_t a_n)
+{
+  if (NewBudget == 0)
+    throw std::bad_alloc();
+  if (NewBudget > 0)
+    --NewBudget;
+  void* p = malloc((a_n != 0) ? a_n : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  ++NLive;
+  return p;
+}
+
+void operator delete(void* a_p) noexcept
+{
+  if (a_p != nullptr)
+  {
+    --NLive;
+    free(a_p);
+  }
+}
+
+void operator delete(void* a_p, size_t) noexcept
+  { operator delete(a_p); }
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Rate  = decltype(1.0_km / 1.0_sec);
+  using RateM = decltype(1.0_m  / 1.0_sec);
+}
+
+int main()
+{
+  int nErrs = 0;
+  constexpr size_t N = 100;
+  std::vector<Len_km> ls(N);
+  std::vector<Rate>   rs(N);
+  for (size_t i = 0; i < N; ++i)
+  {
+    ls[i] = Len_km(double(i));
+    rs[i] = Len_km(2.0 * double(i)) / 1.0_sec;
+  }
+
+  //-------------------------------------------------------------------------//
+  // Table Round-Trip:                                                       //
+  //-------------------------------------------------------------------------//
+  ArrowArray  arr;
+  ArrowSchema sch;
+  ExportArrowTable<DimQ_Sys>
+    (N, {{"len", "rate"}}, &arr, &sch, ls.data(), rs.data());
+  {
+    ArrowImport<DimQ_Sys> imp(&arr, &sch);
+    nErrs += (imp.NRows() != N || imp.NCols() != 2 ||
+              strcmp(imp.ColName(1), "rate") != 0);
+
+    // Zero-copy in the same Units:
+    nErrs += (imp.GetColumn<Len_km>(0u).data() != ls.data());
+
+    // Converted copy in other Units:
+    std::vector<RateM> rm;
+    imp.CopyColumn<RateM>(unsigned(imp.FindCol("rate")), &rm);
+    for (size_t i = 0; i < N; ++i)
+      nErrs += !rm[i].ApproxEquals(To_Len(rs[i]));
+
+    // Other Units or Dims require "CopyColumn", or are errors:
+    try
+    {
+      imp.GetColumn<RateM>(1u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+    try
+    {
+      imp.GetColumn<Len>(1u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+  nErrs += (arr.release != nullptr || sch.release != nullptr);
+
+  //-------------------------------------------------------------------------//
+  // Sliced Batch:                                                           //
+  //-------------------------------------------------------------------------//
+  // Slicing a struct sets its own "offset" and "length" only; a child may be
+  // offset as well (here, the "rate" one is exported from a shifted ptr):
+  //
+  ExportArrowTable<DimQ_Sys>
+    (N - 5, {{"len", "rate"}}, &arr, &sch, ls.data(), rs.data() + 5);
+  arr.children[1]->buffers[1] = rs.data();
+  arr.children[1]->offset     = 5;
+  arr.offset                  = 10;
+  arr.length                  = 50;
+  {
+    ArrowImport<DimQ_Sys> imp(&arr, &sch);
+    auto lv = imp.GetColumn<Len_km>(0u);
+    auto rv = imp.GetColumn<Rate>  (1u);
+    nErrs += (lv.size() != 50 || rv.size() != 50);
+    for (size_t i = 0; i < 50; ++i)
+      nErrs += (lv[i] != ls[10 + i] || rv[i] != rs[15 + i]);
+
+    std::vector<RateM> rm;
+    imp.CopyColumn<RateM>(1u, &rm);
+    nErrs += (rm.size() != 50 || !rm[0].ApproxEquals(To_Len(rs[15])));
+  }
+
+  // A slice beyond the children is an error:
+  ExportArrowTable<DimQ_Sys>
+    (N, {{"len", "rate"}}, &arr, &sch, ls.data(), rs.data());
+  arr.offset = 60;
+  arr.length = 50;
+  {
+    ArrowImport<DimQ_Sys> imp(&arr, &sch);
+    try
+    {
+      imp.GetColumn<Len_km>(0u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  //-------------------------------------------------------------------------//
+  // Owned Column, and Malformed Metadata:                                   //
+  //-------------------------------------------------------------------------//
+  ExportArrow<DimQ_Sys>(std::vector<Rate>(rs), "r", &arr, &sch);
+  {
+    ArrowImport<DimQ_Sys> imp(&arr, &sch);
+    auto rv = imp.GetColumn<Rate>(0u);
+    nErrs += (imp.NCols() != 1 || rv.size() != N || rv[7] != rs[7]);
+  }
+
+  // A negative key length:
+  char bad[12];
+  int32_t const badInts[3] = { 1, -8, 4 };
+  memcpy(bad, badInts, sizeof(bad));
+  ExportArrow<DimQ_Sys>(ls.data(), N, "l", &arr, &sch);
+  sch.metadata = bad;
+  {
+    ArrowImport<DimQ_Sys> imp(&arr, &sch);
+    try
+    {
+      imp.GetColumn<Len_km>(0u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  //-------------------------------------------------------------------------//
+  // Allocation Failures at Every Step of a Table Export:                    //
+  //-------------------------------------------------------------------------//
+  for (long budget = 0; ; ++budget)
+  {
+    long nLive = NLive;
+    bool done  = false;
+    NewBudget  = budget;
+    try
+    {
+      ExportArrowTable<DimQ_Sys>
+        (N, {{"len", "rate"}}, &arr, &sch, ls.data(), rs.data());
+      NewBudget = -1;
+      arr.release(&arr);
+      sch.release(&sch);
+      done = true;
+    }
+    catch (std::bad_alloc const&)
+      { NewBudget = -1; }
+    nErrs += (NLive != nLive);
+    if (done)
+      break;
+  }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
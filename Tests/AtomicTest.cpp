@@ -0,0 +1,84 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "Tests/AtomicTest.cpp":                         //
+//===========================================================================//
+#include "DimTypes/Atomic.hpp"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978706996262e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+int main()
+{
+  int nErrs = 0;
+  using Dist = decltype(1.0_km);
+
+  //-------------------------------------------------------------------------//
+  // Single-Threaded Semantics:                                              //
+  //-------------------------------------------------------------------------//
+  DimTypes::AtomicDimQ<Dist> a(5.0_km);
+  nErrs += (a.fetch_add(2.0_km) != 5.0_km);
+  nErrs += (a.load()            != 7.0_km);
+  nErrs += ((a -= 3.0_km)       != 4.0_km);
+  nErrs += (a.exchange(1.0_km)  != 4.0_km);
+
+  Dist exp = 2.0_km;
+  nErrs += a.compare_exchange_strong(exp, 9.0_km);
+  nErrs += (exp != 1.0_km);
+  nErrs += !a.compare_exchange_strong(exp, 9.0_km);
+  nErrs += (Dist(a) != 9.0_km);
+
+  nErrs += (a.fetch_max(3.0_km)  != 9.0_km);
+  nErrs += (a.fetch_max(10.0_km) != 9.0_km);
+  nErrs += (a.fetch_min(-1.0_km) != 10.0_km);
+  nErrs += (a.load()             != -1.0_km);
+  // NB: "a.fetch_add(1.0_sec)" and "a.fetch_add(Len_m(1.0))" do not compile
+
+  //-------------------------------------------------------------------------//
+  // Concurrent Accumulation:                                                //
+  //-------------------------------------------------------------------------//
+  // All increments are exactly representable, so the sum is exact:
+  constexpr unsigned NThreads = 4;
+  constexpr unsigned N        = 200000;
+  DimTypes::AtomicDimQ<Dist> sum;
+  DimTypes::AtomicDimQ<Dist> maxD;
+  {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < NThreads; ++t)
+      threads.emplace_back([&sum, &maxD, t]()
+      {
+        for (unsigned i = 0; i < N; ++i)
+        {
+          sum .fetch_add(0.5_km, std::memory_order_relaxed);
+          maxD.fetch_max(Len_km(double(t * N + i)));
+        }
+      });
+    for (auto& thread: threads)
+      thread.join();
+  }
+  printf("Sum=%s, Max=%s\n",
+         ToStr(sum.load()).data(), ToStr(maxD.load()).data());
+  nErrs += (sum.load()  != Len_km(0.5 * NThreads * N));
+  nErrs += (maxD.load() != Len_km(double(NThreads * N - 1)));
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
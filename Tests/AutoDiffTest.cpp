@@ -0,0 +1,140 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/AutoDiffTest.cpp":                        //
+//===========================================================================//
+// Derivatives of the elementary functions, and of "DimQ" computations (with
+// their types), vs the analytical ones:
+//
+#include "DimTypes/AutoDiff.hpp"
+#include <cstdio>
+#include <cmath>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using D1 = Dual<double, 1>;
+  using D4 = Dual<double, 4>;
+
+  int nErrs = 0;
+
+  void Check(char const* a_name, double a_val, double a_ref)
+  {
+    double err = std::abs(a_val - a_ref) / std::max(1.0, std::abs(a_ref));
+    if (!(err < 1e-13))
+    {
+      printf("%s: %.16e != %.16e\n", a_name, a_val, a_ref);
+      ++nErrs;
+    }
+  }
+}
+
+int main()
+{
+  static_assert(sizeof(D4) == 5 * sizeof(double) &&
+                std::is_trivially_copyable_v<D4>);
+
+  //-------------------------------------------------------------------------//
+  // Elementary Functions (N=1):                                             //
+  //-------------------------------------------------------------------------//
+  using namespace Bits::CEMaths;
+  double const x0 = 0.3;
+  D1     const x  = D1::Var(x0);
+  Check("Exp",   Exp  (x).Deriv(0),  std::exp(x0));
+  Check("Log",   Log  (x).Deriv(0),  1.0 / x0);
+  Check("Cos",   Cos  (x).Deriv(0), -std::sin(x0));
+  Check("Sin",   Sin  (x).Deriv(0),  std::cos(x0));
+  Check("Tan",   Tan  (x).Deriv(0),  1.0 / Sqr(std::cos(x0)));
+  Check("ATan",  ATan (x).Deriv(0),  1.0 / (1.0 + x0 * x0));
+  Check("ASin",  ASin (x).Deriv(0),  1.0 / std::sqrt(1.0 - x0 * x0));
+  Check("ACos",  ACos (x).Deriv(0), -1.0 / std::sqrt(1.0 - x0 * x0));
+  Check("SinH",  SinH (x).Deriv(0),  std::cosh(x0));
+  Check("CosH",  CosH (x).Deriv(0),  std::sinh(x0));
+  Check("TanH",  TanH (x).Deriv(0),  1.0 / Sqr(std::cosh(x0)));
+  Check("ASinH", ASinH(x).Deriv(0),  1.0 / std::sqrt(x0 * x0 + 1.0));
+  Check("ATanH", ATanH(x).Deriv(0),  1.0 / (1.0 - x0 * x0));
+  Check("ACosH", ACosH(x + 1.0).Deriv(0),
+                 1.0 / std::sqrt(Sqr(x0 + 1.0) - 1.0));
+  Check("SqRt",  SqRt (x).Deriv(0),  0.5 / std::sqrt(x0));
+  Check("CbRt",  CbRt (x).Deriv(0),  1.0 / (3.0 * Sqr(std::cbrt(x0))));
+  Check("Abs",   Abs  (-x).Deriv(0), 1.0);
+  Check("Pow",   Pow(x, 2.5).Deriv(0), 2.5 * std::pow(x0, 1.5));
+  Check("Pow2",  Pow(x, x).Deriv(0),
+                 std::pow(x0, x0) * (std::log(x0) + 1.0));
+  Check("Quot",  (Sin(x) / x).Deriv(0),
+                 (x0 * std::cos(x0) - std::sin(x0)) / (x0 * x0));
+  Check("Value", Exp(Sin(x) * x + 2.0).Value(),
+                 std::exp(std::sin(x0) * x0 + 2.0));
+
+  //-------------------------------------------------------------------------//
+  // "DimQ"s: Pendulum Period, 2 Seeds:                                      //
+  //-------------------------------------------------------------------------//
+  using Acc = decltype(1.0_m / (1.0_sec * 1.0_sec));
+  auto L = MkVar<2>(2.0_m, 0);
+  auto g = MkVar<2>(Acc(9.81), 1);
+  auto T = TwoPi<double> * SqRt(L / g);
+  double T0 = 2.0 * M_PI * std::sqrt(2.0 / 9.81);
+  Check("T", ValueOf(T).Magnitude(), T0);
+
+  auto dTdL = Deriv(T, L, 0);
+  auto dTdg = Deriv(T, g, 1);
+  static_assert(std::is_same_v<decltype(dTdL), decltype(1.0_sec / 1.0_m)>);
+  static_assert(std::is_same_v<decltype(dTdg), decltype(1.0_sec / Acc(1.0))>);
+  Check("dT/dL", dTdL.Magnitude(),  T0 / (2.0 * 2.0));
+  Check("dT/dg", dTdg.Magnitude(), -T0 / (2.0 * 9.81));
+  // The derivatives are typed, so they can only be combined consistently:
+  Time_sec dT = dTdL * 0.01_m + dTdg * Acc(0.001);
+  Check("dT", dT.Magnitude(),
+        T0 / (2.0 * 2.0) * 0.01 - T0 / (2.0 * 9.81) * 0.001);
+
+  // A constant is not differentiated; the rational powers via "Pow":
+  auto m    = MkConst<2>(3.0_kg);
+  auto p    = RPow<1, 5>(m * L);
+  Check("dp/dL", Deriv(p, L, 0).Magnitude(), std::pow(6.0, -0.8) / 5.0 * 3.0);
+  Check("dp/dg", Deriv(p, g, 1).Magnitude(), 0.0);
+  auto iL   = IPow<-2>(L);
+  Check("d(1/L^2)/dL", Deriv(iL, L, 0).Magnitude(), -2.0 / 8.0);
+
+  //-------------------------------------------------------------------------//
+  // Jacobian of the Polar -> Cartesian Transform in One Evaluation (N=4):   //
+  //-------------------------------------------------------------------------//
+  using DimLessQ = decltype(1.0_m / 1.0_m);
+  auto r  = MkVar<4>(5.0_km, 0);
+  auto th = MkVar<4>(DimLessQ(0.6), 1);
+  auto px = r * Cos(th);
+  auto py = r * Sin(th);
+  Check("dx/dr",  double(Deriv(px, r,  0)),  std::cos(0.6));
+  Check("dy/dr",  double(Deriv(py, r,  0)),  std::sin(0.6));
+  Check("dx/dth", Deriv(px, th, 1).Magnitude(), -5.0 * std::sin(0.6));
+  Check("dy/dth", Deriv(py, th, 1).Magnitude(),  5.0 * std::cos(0.6));
+  static_assert(std::is_same_v<decltype(Deriv(px, th, 1)), Len_km>);
+
+  // And back: r = SqRt(x^2 + y^2), th = ATan2(y, x) -- the Jacobian product
+  // must be the identity:
+  auto r2  = SqRt(px * px + py * py);
+  auto th2 = py.ATan2(px);
+  Check("dr2/dr",   double(Deriv(r2,  r,  0)), 1.0);
+  Check("dr2/dth",  Deriv(r2,  th, 1).Magnitude(), 0.0);
+  Check("dth2/dr",  Deriv(th2, r,  0).Magnitude(), 0.0);
+  Check("dth2/dth", double(Deriv(th2, th, 1)), 1.0);
+  for (unsigned i = 2; i < 4; ++i)
+    nErrs += (r2.Magnitude().Deriv(i) != 0.0);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
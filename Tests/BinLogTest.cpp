@@ -0,0 +1,135 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "Tests/BinLogTest.cpp":                         //
+//===========================================================================//
+#include "DimTypes/BinLog.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978706996262e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  std::string ReadFile(char const* a_path)
+  {
+    std::string res;
+    FILE*       f = fopen(a_path, "r");
+    char        buff[4096];
+    for (size_t n = 0; (n = fread(buff, 1, sizeof(buff), f)) != 0; )
+      res.append(buff, n);
+    fclose(f);
+    return res;
+  }
+}
+
+int main()
+{
+  int nErrs = 0;
+  char txtPath[64];
+  char binPath[64];
+  char decPath[64];
+  snprintf(txtPath, sizeof(txtPath), "/tmp/BinLogTest-%d.txt", int(getpid()));
+  snprintf(binPath, sizeof(binPath), "/tmp/BinLogTest-%d.bin", int(getpid()));
+  snprintf(decPath, sizeof(decPath), "/tmp/BinLogTest-%d.dec", int(getpid()));
+
+  //-------------------------------------------------------------------------//
+  // Multi-Threaded Text Logging:                                            //
+  //-------------------------------------------------------------------------//
+  constexpr unsigned NThreads = 4;
+  constexpr unsigned N        = 100000;
+  uint64_t           nDropped = 0;
+  {
+    DimTypes::BinLogger<DimQ_Sys> logger(txtPath, false, 1024, 100);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < NThreads; ++t)
+      threads.emplace_back([&logger]()
+      {
+        for (unsigned i = 0; i < N; ++i)
+          if (i % 2 == 0)
+            logger.Log("dist",  Len_km(double(i)));
+          else
+            logger.Log("speed", Len_km(double(i)) / 1.0_sec, int64_t(i));
+      });
+    for (auto& thread: threads)
+      thread.join();
+    logger.Stop();
+    nDropped = logger.NDropped();
+  }
+  std::string txt    = ReadFile(txtPath);
+  size_t      nLines = 0;
+  for (char c: txt)
+    nLines += (c == '\n');
+  printf("Lines: %zu, Dropped: %lu\n", nLines, nDropped);
+  nErrs += (nLines + nDropped != NThreads * N);
+
+  //-------------------------------------------------------------------------//
+  // Binary Logging and Off-Line Decoding vs Text Logging:                   //
+  //-------------------------------------------------------------------------//
+  auto logSome = [](DimTypes::BinLogger<DimQ_Sys>* a_logger)
+  {
+    a_logger->Log("GM",  RPow<3,2>(1.0_AU) / SqRt(1.0_kg), 12345);
+    a_logger->Log("c",   299792.458_km / 1.0_sec);
+    a_logger->Log("one", DimLess(1.0));
+    a_logger->Log("c",   1.0_km / 1.0_day);
+  };
+  {
+    DimTypes::BinLogger<DimQ_Sys> logger(txtPath);
+    logSome(&logger);
+  }
+  {
+    DimTypes::BinLogger<DimQ_Sys> logger(binPath, true);
+    logSome(&logger);
+  }
+  DimTypes::DecodeBinLog<DimQ_Sys>(binPath, decPath);
+  std::string txt1 = ReadFile(txtPath);
+  std::string dec  = ReadFile(decPath);
+  printf("%s", dec.data());
+  nErrs += (txt1 != dec);
+  nErrs += (txt1.find(std::string("c = ") +
+                      ToStr(299792.458_km / 1.0_sec).data()) ==
+            std::string::npos);
+
+  //-------------------------------------------------------------------------//
+  // A Failing Sink: the error is re-thrown by "Stop" (not "terminate"d):    //
+  //-------------------------------------------------------------------------//
+  {
+    DimTypes::BinLogger<DimQ_Sys> logger("/dev/full", false, 1024, 100);
+    logSome(&logger);
+    while (!logger.Failed())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    try
+    {
+      logger.Stop();
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+    logger.Stop();   // Now a no-op
+  }
+  {
+    // Not reported by the Dtor:
+    DimTypes::BinLogger<DimQ_Sys> logger("/dev/full", true, 1024, 100);
+    logSome(&logger);
+  }
+
+  unlink(txtPath);
+  unlink(binPath);
+  unlink(decPath);
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/BoundedPutTest.cpp":                      //
+//===========================================================================//
+// "PutBounded" and "ToStrBounded" vs "Put":  same output if the buffer is
+// large enough, otherwise a truncated (but still 0-terminated) prefix of it:
+//
+#include "DimTypes/DimTypes.hpp"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978707e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+// Complex "RepT" (its literal operators convert "long double"s into it):
+namespace C
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+# pragma  GCC diagnostic push
+# pragma  GCC diagnostic ignored "-Wfloat-conversion"
+  DECLARE_DIMS(
+    std::complex<double>, 9,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec)
+  )
+# pragma  GCC diagnostic pop
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+namespace
+{
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // "Check": Full and Truncated Outputs vs "Put":                           //
+  //-------------------------------------------------------------------------//
+  template<typename DQ>
+  void Check(DQ a_q)
+  {
+    char ref[256];
+    Put(a_q, ref, ref + sizeof(ref));
+    size_t refLen = strlen(ref);
+
+    auto full = ToStrBounded(a_q);
+    static_assert(sizeof(full) == DimQ_MaxPutSize<DQ>);
+    printf("%s\n", full.data());
+    nErrs += (strcmp(full.data(), ref) != 0);
+
+    // With all buffer sizes up to the full length:
+    for (size_t n = 1; n <= refLen + 1; ++n)
+    {
+      char buff[256];
+      memset(buff, 'x', sizeof(buff));
+      bool  trunc = false;
+      char* end   = PutBounded(a_q, buff, buff + n, &trunc);
+      size_t len  = std::min(n - 1, refLen);
+      nErrs += (size_t(end - buff) != len || *end != '\0'    ||
+                strncmp(buff, ref, len) != 0 || trunc != (n <= refLen));
+    }
+  }
+}
+
+int main()
+{
+  Check(1.0_km / 1.0_sec);
+  Check(RPow<3, 2>(1.0_AU) / SqRt(1.5e-300_kg));
+  Check(IPow<-12>(3.0_day));
+  Check(DimLess(NAN));
+  Check(-Len_km(INFINITY));
+
+  // Complex "RepT" (the functions are those of the other "DimQ_Sys"):
+  auto   cq = C::DimLess(std::complex<double>(1.0, -2.0)) * C::Len_km(3.0);
+  char   cref[256];
+  C::Put(cq, cref, cref + sizeof(cref));
+  auto   cfull = C::ToStrBounded(cq);
+  printf("%s\n", cfull.data());
+  nErrs += (strcmp(cfull.data(), cref) != 0);
+  char   cbuff[16];
+  bool   ctrunc = false;
+  C::PutBounded(cq, cbuff, cbuff + sizeof(cbuff), &ctrunc);
+  nErrs += (!ctrunc || strncmp(cbuff, cref, sizeof(cbuff) - 1) != 0);
+
+  // The exact bound: magnitude, space, Units, terminating 0:
+  static_assert(DimQ_MaxPutSize<Len_km> == 24 + 3 + 1);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// vim:ts=2:et
+//===========================================================================//
+//                             "Tests/CSVTest.cpp":                          //
+//===========================================================================//
+#include "DimTypes/CSV.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978706996262e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+int main()
+{
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // Units Strings:                                                          //
+  //-------------------------------------------------------------------------//
+  using Rate = decltype(1.0_km / 1.0_sec);
+  using Acc  = decltype(1.0_m  / IPow<2>(1.0_sec));
+  {
+    char     units[64];
+    uint64_t E = 0;
+    uint64_t U = 0;
+    constexpr auto q = RPow<3,2>(1.0_AU) / SqRt(1.0_kg);
+    DimTypes::Bits::PutUnits<DimQ_Sys>
+      (q.GetDimsCode(), q.GetUnitsCode(), units, units + sizeof(units));
+    bool ok = DimTypes::Bits::ParseUnits<DimQ_Sys>
+      (units, units + strlen(units), &E, &U);
+    printf("Units: [%s] %s\n", units, ToStr(q).data());
+    nErrs += !(ok && E == q.GetDimsCode() && U == q.GetUnitsCode());
+
+    char const* bad = "km furlong^2";
+    nErrs += DimTypes::Bits::ParseUnits<DimQ_Sys>
+      (bad, bad + strlen(bad), &E, &U);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Write and Read Back:                                                    //
+  //-------------------------------------------------------------------------//
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/CSVTest-%d.csv", int(getpid()));
+
+  constexpr size_t N = 10000;
+  std::vector<Len_km> ranges(N);
+  std::vector<Rate>   rates (N);
+  for (size_t i = 0; i < N; ++i)
+  {
+    ranges[i] = Len_km(0.1 * double(i));
+    rates [i] = Len_km(double(i) / 3.0) / 1.0_sec;
+  }
+  {
+    DimTypes::CSVWriter<DimQ_Sys, Len_km, Rate>
+      writer(path, {{"range", "rate"}});
+    writer.WriteRows(N, ranges.data(), rates.data());
+  }
+  {
+    // Columns in a different order, and in other Units; small chunks:
+    using RateMD = decltype(1.0_m / 1.0_day);
+    DimTypes::CSVReader<DimQ_Sys, RateMD, Len>
+      reader(path, {{"rate", "range"}}, ',', 256);
+
+    std::vector<RateMD> rs;
+    std::vector<Len>    ls;
+    size_t i = 0;
+    for (size_t n = 0; (n = reader.ReadChunk(1000, rs, ls)) != 0; i += n)
+      for (size_t j = 0; j < n; ++j)
+      {
+        nErrs += !rs[j].ApproxEquals(To_Len(To_Time_day(rates[i+j])));
+        nErrs += !ls[j].ApproxEquals(To_Len(ranges[i+j]));
+      }
+    nErrs += (i != N);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Hand-Written CSV:                                                       //
+  //-------------------------------------------------------------------------//
+  {
+    FILE* f = fopen(path, "w");
+    fputs("\"id\", rate [km sec^(-1)] ,acc[m*sec^-2]\r\n"
+          "1, 1.5, 9.81\r\n"
+          "2,,+1e-3\r\n", f);
+    fclose(f);
+
+    DimTypes::CSVReader<DimQ_Sys, Rate, Acc, DimLess>
+      reader(path, {{"rate", "acc", "id"}});
+    std::vector<Rate>    rs;
+    std::vector<Acc>     as;
+    std::vector<DimLess> ids;
+    size_t n = reader.ReadChunk(100, rs, as, ids);
+    printf("rate[0]=%s, acc[1]=%s\n", ToStr(rs[0]).data(), ToStr(as[1]).data());
+    nErrs += !(n == 2 && rs[0] == 1.5_km / 1.0_sec && rs[1].IsNaN() &&
+               as[1] == 1e-3_m / IPow<2>(1.0_sec) && double(ids[1]) == 2.0);
+
+    // Dims mismatch must be detected:
+    try
+    {
+      DimTypes::CSVReader<DimQ_Sys, Len> bad(path, {{"rate"}});
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+  unlink(path);
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
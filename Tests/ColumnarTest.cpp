@@ -0,0 +1,147 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/ColumnarTest.cpp":                        //
+//===========================================================================//
+#include "DimTypes/ColumnarIO.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978706996262e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+int main()
+{
+  constexpr size_t N = 100000;
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/ColumnarTest-%d.dqc", int(getpid()));
+
+  //-------------------------------------------------------------------------//
+  // Write a Table of 2 Columns:                                             //
+  //-------------------------------------------------------------------------//
+  std::vector<Len_km> ranges(N);
+  using RateT = decltype(1.0_km / 1.0_sec);
+  std::vector<RateT>  rates (N);
+  for (size_t i = 0; i < N; ++i)
+  {
+    ranges[i] = Len_km(double(i));
+    rates [i] = Len_km(double(i) * 0.5) / 1.0_sec;
+  }
+  {
+    DimTypes::ColumnarWriter<DimQ_Sys> writer(path);
+    writer.WriteColumn("range", ranges.data(), N);
+
+    // Stream the 2nd column in chunks:
+    writer.BeginColumn<DimTypes::DimQTraits<RateT>::E,
+                       DimTypes::DimQTraits<RateT>::U>("rate");
+    for (size_t i = 0; i < N; i += 1000)
+      writer.Append(rates.data() + i, 1000);
+    writer.EndColumn();
+    writer.Close();
+  }
+
+  //-------------------------------------------------------------------------//
+  // Read it back (Zero-Copy and with Unit Conversions):                     //
+  //-------------------------------------------------------------------------//
+  int nErrs = 0;
+  {
+    DimTypes::ColumnarReader<DimQ_Sys> reader(path);
+    printf("NCols=%u, NRows=%lu\n", reader.NCols(), reader.NRows());
+
+    auto rs = reader.GetColumn<Len_km>("range");
+    for (size_t i = 0; i < N; ++i)
+      nErrs += (rs[i] != ranges[i]);
+
+    // Now request the same column in "m": converted into a separate buffer,
+    // so the "km" view remains intact, and is still zero-copy:
+    auto rm = reader.GetColumn<Len>("range");
+    for (size_t i = 0; i < N; ++i)
+      nErrs += !(rm[i].ApproxEquals(To_Len(ranges[i])));
+    for (size_t i = 0; i < N; ++i)
+      nErrs += (rs[i] != ranges[i]);
+    nErrs += (reader.GetColumn<Len_km>("range").data() != rs.data());
+    nErrs += (reader.GetColumn<Len>   ("range").data() != rm.data());
+
+    // And the "rates" in "AU/day":
+    using RateAUD = decltype(1.0_AU / 1.0_day);
+    auto ra = reader.GetColumn<RateAUD>(1u);
+    for (size_t i = 0; i < N; ++i)
+      nErrs += !(ra[i].ApproxEquals(To_Len_AU(To_Time_day(rates[i]))));
+
+    // Dims mismatch must be detected:
+    try
+    {
+      reader.GetColumn<Mass>(0u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  //-------------------------------------------------------------------------//
+  // Corrupted Descr: a huge NRows must be rejected (w/o overflows):         //
+  //-------------------------------------------------------------------------//
+  {
+    int fd = open(path, O_RDWR);
+    DimTypes::Bits::ColFileHdr hdr;
+    nErrs += (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr));
+    uint64_t huge = (1UL << 61) + 1;
+    for (unsigned i = 0; i < hdr.m_nCols; ++i)
+      nErrs += (pwrite(fd, &huge, sizeof(huge),
+                off_t(hdr.m_descrsOff + i * sizeof(DimTypes::Bits::ColDescr) +
+                      offsetof(DimTypes::Bits::ColDescr, m_nRows)))
+                != sizeof(huge));
+    hdr.m_nRows = huge;
+    nErrs += (pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr));
+    close(fd);
+    try
+    {
+      DimTypes::ColumnarReader<DimQ_Sys> reader(path);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  //-------------------------------------------------------------------------//
+  // NRows MisMatch: the column is dropped, and the file remains valid:      //
+  //-------------------------------------------------------------------------//
+  {
+    DimTypes::ColumnarWriter<DimQ_Sys> writer(path);
+    writer.WriteColumn("range", ranges.data(), N);
+    try
+    {
+      writer.WriteColumn("rate", rates.data(), N - 1);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+    writer.WriteColumn("rate", rates.data(), N);
+    writer.Close();
+
+    DimTypes::ColumnarReader<DimQ_Sys> reader(path);
+    nErrs += (reader.NCols() != 2 || reader.NRows() != N ||
+              reader.FindCol("rate") != 1);
+    auto ra = reader.GetColumn<RateT>(1u);
+    for (size_t i = 0; i < N; ++i)
+      nErrs += (ra[i] != rates[i]);
+  }
+  unlink(path);
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
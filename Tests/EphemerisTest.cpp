@@ -0,0 +1,256 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "Tests/EphemerisTest.cpp":                        //
+//===========================================================================//
+// Writes a small synthetic file in the JPL DE binary format (random Cheby-
+// shev coeffs) and checks "DEEphemeris" against a direct evaluation of the
+// series, T_k(t) = cos(k*acos(t)):
+//
+#include "DimTypes/Ephemeris.hpp"
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978707e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  constexpr double   Start  = 2451536.5;
+  constexpr double   Step   = 32.0;
+  constexpr unsigned NRecs  = 6;
+  constexpr double   AUkm   = 149597870.7;
+  constexpr double   EMRat  = 81.30056;
+  // (Offset, NCoeffs, NSubs) for 11 bodies, nutations and librations:
+  unsigned           IPT[13][3];
+  constexpr unsigned NCs[13]  = { 14, 10, 13, 11,  8,  7,  6,  6,  6, 13, 11,
+                                  10, 10 };
+  constexpr unsigned NSubs[13] = { 4,  2,  2,  1,  1,  1,  1,  1,  1,  8,  2,
+                                   4,  4 };
+
+  //-------------------------------------------------------------------------//
+  // "WriteDE":                                                              //
+  //-------------------------------------------------------------------------//
+  // Returns the record length (in doubles):
+  //
+  size_t WriteDE(char const* a_path, std::vector<double>* a_recs)
+  {
+    size_t off = 3;   // 1-based, after the 2 JDs
+    for (unsigned i = 0; i < 13; ++i)
+    {
+      IPT[i][0] = unsigned(off);
+      IPT[i][1] = NCs[i];
+      IPT[i][2] = NSubs[i];
+      off      += NCs[i] * NSubs[i] * ((i == 11) ? 2 : 3);
+    }
+    size_t recLen = off - 1;
+    std::vector<char> hdr(recLen * 8, ' ');
+
+    char const*  names[] = { "AU", "EMRAT", "GMS" };
+    double const vals [] = { AUkm, EMRat, 2.9591220828559e-4 };
+    for (unsigned i = 0; i < 3; ++i)
+      memcpy(hdr.data() + DimTypes::Bits::DEOffNames + 6 * i, names[i],
+             strlen(names[i]));
+    double   ss[3] = { Start, Start + NRecs * Step, Step };
+    unsigned nCon  = 3;
+    int      deNum = 423;
+    memcpy(hdr.data() + DimTypes::Bits::DEOffSS,    ss,     sizeof(ss));
+    memcpy(hdr.data() + DimTypes::Bits::DEOffNCon,  &nCon,  4);
+    memcpy(hdr.data() + DimTypes::Bits::DEOffAU,    &AUkm,  8);
+    memcpy(hdr.data() + DimTypes::Bits::DEOffEMRat, &EMRat, 8);
+    memcpy(hdr.data() + DimTypes::Bits::DEOffIPT,   IPT,    12 * 12);
+    memcpy(hdr.data() + DimTypes::Bits::DEOffDENum, &deNum, 4);
+    memcpy(hdr.data() + DimTypes::Bits::DEOffLPT,   IPT[12], 12);
+
+    std::vector<double> consts(recLen, 0.0);
+    memcpy(consts.data(), vals, sizeof(vals));
+
+    std::mt19937_64                        rng(423);
+    std::uniform_real_distribution<double> coeff(-1e6, 1e6);
+    a_recs->assign(NRecs * recLen, 0.0);
+    for (unsigned r = 0; r < NRecs; ++r)
+    {
+      double* rec = a_recs->data() + r * recLen;
+      rec[0] = Start + r * Step;
+      rec[1] = rec[0] + Step;
+      for (size_t j = 2; j < recLen; ++j)
+        rec[j] = coeff(rng) / double(j % 16 + 1);
+    }
+    FILE* f = fopen(a_path, "wb");
+    fwrite(hdr.data(),     1, hdr.size(),     f);
+    fwrite(consts.data(),  8, consts.size(),  f);
+    fwrite(a_recs->data(), 8, a_recs->size(), f);
+    fclose(f);
+    return recLen;
+  }
+
+  //-------------------------------------------------------------------------//
+  // "RefPosVel": Direct Evaluation (km, km/day):                            //
+  //-------------------------------------------------------------------------//
+  void RefPosVel(std::vector<double> const& a_recs, size_t a_recLen,
+                 unsigned a_body, double a_jd, double* a_pos, double* a_vel)
+  {
+    unsigned r   = std::min(unsigned((a_jd - Start) / Step), NRecs - 1);
+    double   sl  = Step / NSubs[a_body];
+    unsigned sub = std::min(unsigned((a_jd - Start - r * Step) / sl),
+                            NSubs[a_body] - 1);
+    double   t   = 2.0 * (a_jd - Start - r * Step - sub * sl) / sl - 1.0;
+    double   th  = std::acos(t);
+    unsigned nc  = NCs[a_body];
+    double const* c =
+      a_recs.data() + r * a_recLen + IPT[a_body][0] - 1 + sub * 3 * nc;
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      a_pos[i] = 0.0;
+      a_vel[i] = 0.0;
+      // T_k'(t) = k U_{k-1}(t), where U_k are the Chebyshev polys of the 2nd
+      // kind:
+      long double u0 = 0.0L, u1 = 1.0L;
+      for (unsigned k = 0; k < nc; ++k)
+      {
+        a_pos[i] += c[i * nc + k] * std::cos(k * th);
+        if (k == 0)
+          continue;
+        a_vel[i] += double(c[i * nc + k] * k * u1);
+        long double u2 = 2.0L * t * u1 - u0;
+        u0 = u1;
+        u1 = u2;
+      }
+      a_vel[i] *= 2.0 / sl;
+    }
+  }
+}
+
+int main()
+{
+  using namespace DimTypes;
+  int nErrs = 0;
+
+  std::string path = "/tmp/EphemerisTest." + std::to_string(getpid());
+  std::vector<double> recs;
+  size_t recLen = WriteDE(path.data(), &recs);
+
+  using Eph = DEEphemeris<DimQ_Sys, Len_km, Time_day>;
+  Eph eph(path.data());
+  nErrs += (eph.DENum() != 423 || eph.StartJD() != Start ||
+            eph.EndJD() != Start + NRecs * Step   || eph.EMRat() != EMRat);
+  nErrs += (eph.AU() != Len_km(AUkm));
+  nErrs += (eph.GetConst("GMS") != 2.9591220828559e-4);
+  try
+  {
+    (void) eph.GetConst("GM");
+    ++nErrs;
+  }
+  catch (std::invalid_argument const&) {}
+
+  // Compile-time conversion factors:
+  static_assert(Bits::ConstUnitsConvFactor<DimQ_Sys>
+                (GetDimsCode(1.0_km), GetUnitsCode(1.0_km),
+                 GetUnitsCode(1.0_AU)) == 1000.0 / 1.495978707e+11);
+
+  //-------------------------------------------------------------------------//
+  // Batches vs the Direct Evaluation:                                       //
+  //-------------------------------------------------------------------------//
+  // Sorted epochs (mostly same segments), and random ones (not sorted),
+  // including the end points, of odd size (to exercise the scalar tail):
+  std::mt19937_64                        rng(1);
+  std::uniform_real_distribution<double> jd(Start, Start + NRecs * Step);
+  std::vector<double> jds;
+  for (unsigned i = 0; i < 1001; ++i)
+    jds.push_back(Start + i * (NRecs * Step / 1000.0));
+  for (unsigned i = 0; i < 503; ++i)
+    jds.push_back(jd(rng));
+  jds.push_back(Start);
+
+  using Vel_km_day = decltype(1.0_km / 1.0_day);
+  using Vel_AU_day = decltype(1.0_AU / 1.0_day);
+  using Vel_km_sec = decltype(1.0_km / 1.0_sec);
+  size_t n = jds.size();
+  std::vector<Vec3<Len_km>>     posKm(n);
+  std::vector<Vec3<Vel_km_day>> velKm(n);
+  std::vector<Vec3<Len_AU>>     posAU(n);
+  std::vector<Vec3<Vel_AU_day>> velAU(n);
+  std::vector<Vec3<Vel_km_sec>> velS (n);
+  std::vector<Vec3<Len_km>>     moon (n);
+
+  double maxPosErr = 0.0, maxVelErr = 0.0, maxConvErr = 0.0;
+  for (unsigned b = 0; b <= unsigned(DEBody::Earth); ++b)
+  {
+    DEBody body = DEBody(b);
+    eph.GetPosVel(body, jds.data(), n, posKm.data(), velKm.data());
+    eph.GetPosVel(body, jds.data(), n, posAU.data(), velAU.data());
+    eph.GetPosVel(body, jds.data(), n, posKm.data(), velS .data());
+    if (body == DEBody::Earth)
+      eph.GetPos(DEBody::Moon, jds.data(), n, moon.data());
+
+    for (size_t j = 0; j < n; ++j)
+    {
+      double p[3], v[3];
+      if (body != DEBody::Earth)
+        RefPosVel(recs, recLen, b, jds[j], p, v);
+      else
+      {
+        double pm[3], vm[3];
+        RefPosVel(recs, recLen, unsigned(DEBody::EMB),  jds[j], p,  v);
+        RefPosVel(recs, recLen, unsigned(DEBody::Moon), jds[j], pm, vm);
+        for (unsigned c = 0; c < 3; ++c)
+        {
+          nErrs += (std::abs(moon[j][c].Magnitude() - pm[c]) > 1e-5);
+          p[c]  -= pm[c] / (1.0 + EMRat);
+          v[c]  -= vm[c] / (1.0 + EMRat);
+        }
+      }
+      for (unsigned c = 0; c < 3; ++c)
+      {
+        maxPosErr  = std::max(maxPosErr,
+                              std::abs(posKm[j][c].Magnitude() - p[c]) / 1e7);
+        maxVelErr  = std::max(maxVelErr,
+                              std::abs(velKm[j][c].Magnitude() - v[c]) / 1e8);
+        maxConvErr = std::max(maxConvErr,
+          std::abs(posAU[j][c].Magnitude() * AUkm    - p[c]) / 1e7 +
+          std::abs(velAU[j][c].Magnitude() * AUkm    - v[c]) / 1e8 +
+          std::abs(velS [j][c].Magnitude() * 86400.0 - v[c]) / 1e8);
+      }
+    }
+  }
+  printf("Max Errs: Pos=%.3e, Vel=%.3e, Conv=%.3e\n",
+         maxPosErr, maxVelErr, maxConvErr);
+  nErrs += (maxPosErr > 1e-12 || maxVelErr > 1e-12 || maxConvErr > 1e-12);
+
+  // Single epochs (scalar evaluation) agree with batches (SIMD evaluation)
+  // up to rounding:
+  auto pv = eph.GetPosVel<Len_km, Vel_km_day>(DEBody::Mars, jds[1003]);
+  eph.GetPosVel(DEBody::Mars, jds.data(), n, posKm.data(), velKm.data());
+  for (unsigned c = 0; c < 3; ++c)
+    nErrs += (Abs(pv.first [c] - posKm[1003][c]) > 1e-8_km ||
+              Abs(pv.second[c] - velKm[1003][c]) > Vel_km_day(1e-8));
+
+  // Out of range:
+  try
+  {
+    (void) eph.GetPos<Len_km>(DEBody::Sun, Start - 1.0);
+    ++nErrs;
+  }
+  catch (std::out_of_range const&) {}
+
+  unlink(path.data());
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/ExactSumTest.cpp":                        //
+//===========================================================================//
+#include "DimTypes/ExactSum.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+int main()
+{
+  using namespace DimTypes;
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // Exactness:                                                              //
+  //-------------------------------------------------------------------------//
+  // Catastrophic cancellation and subnormals:
+  std::vector<Len_m> v =
+    { 1e300_m, 1.0_m, -1e300_m, Len_m(4.9e-324), Len_m(-4.9e-324), 2.5_m };
+  nErrs += (ExactSum(v.data(), v.size()) != 3.5_m);
+
+  std::vector<Len_m> tiny(3, Len_m(4.9e-324));
+  nErrs += (ExactSum(tiny.data(), tiny.size()) != Len_m(3 * 4.9e-324));
+
+  // Overflow and special vals:
+  constexpr double Max = std::numeric_limits<double>::max();
+  constexpr double Inf = std::numeric_limits<double>::infinity();
+  std::vector<Len_m> big(10, Len_m(Max));
+  nErrs += !std::isinf(ExactSum(big.data(), big.size()).Magnitude());
+  big[3] = Len_m(Inf);
+  big[5] = Len_m(-Inf);
+  nErrs += !std::isnan(ExactSum(big.data(), big.size()).Magnitude());
+
+  //-------------------------------------------------------------------------//
+  // Order Independence:                                                     //
+  //-------------------------------------------------------------------------//
+  // Vals over a wide dynamic range; the sum must be bit-identical for any
+  // order, thread count and merging of partial accumulators:
+  constexpr size_t N = 1000003;
+  std::mt19937_64 rng(12345);
+  std::uniform_real_distribution<double> uni(-1.0, 1.0);
+  std::uniform_int_distribution<int>     expo(-60, 60);
+  std::vector<Len_km> w(N);
+  for (Len_km& x: w)
+    x = Len_km(std::ldexp(uni(rng), expo(rng)));
+
+  Len_km s1 = ExactSum(w.data(), N, 1);
+  Len_km s4 = ExactSum(std::span<Len_km const>(w), 4);
+  std::shuffle(w.begin(), w.end(), rng);
+  Len_km s3 = ExactSum(w.data(), N, 3);
+
+  ReproAcc<Len_km> acc1;
+  ReproAcc<Len_km> acc2;
+  for (size_t i = 0; i < N / 3; ++i)
+    acc1.Add(w[i]);
+  acc2.Add(w.data() + N / 3, N - N / 3);
+  acc2.Merge(acc1);
+
+  printf("Sum=%s\n", ToStr(s1).data());
+  nErrs += (s1 != s4 || s1 != s3 || s1 != acc2.Result());
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
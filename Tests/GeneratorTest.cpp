@@ -0,0 +1,141 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/GeneratorTest.cpp":                       //
+//===========================================================================//
+// Batch generators: sources, fused element-wise adapters (incl Units conver-
+// sions and Dims changes), overlapping and sparse windows, and exceptions:
+//
+#include "DimTypes/Generator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Vel = decltype(1.0_km / 1.0_sec);
+
+  // Flattens the batches, checking that none of them is larger than
+  // "a_maxBatch":
+  template<typename G>
+  auto Collect(G&& a_gen, size_t a_maxBatch, int* a_nErrs)
+  {
+    std::vector<Bits::GenValue<G>> res;
+    for (auto batch: a_gen)
+    {
+      *a_nErrs += (batch.empty() || batch.size() > a_maxBatch);
+      res.insert(res.end(), batch.begin(), batch.end());
+    }
+    return res;
+  }
+}
+
+int main()
+{
+  int nErrs = 0;
+  constexpr size_t N = 1000;
+  std::vector<Len_m> ls(N);
+  for (size_t i = 0; i < N; ++i)
+    ls[i] = Len_m(double(i) - 100.0);
+
+  //-------------------------------------------------------------------------//
+  // Sources:                                                                //
+  //-------------------------------------------------------------------------//
+  std::vector<Len_m> r1 =
+    Collect(GenFromSpan(std::span<Len_m const>(ls), 64), 64, &nErrs);
+  nErrs += (r1 != ls);
+
+  size_t pos   = 0;
+  auto   readF = [&ls, &pos](Len_m* a_buff, size_t a_n)
+  {
+    size_t n = std::min(a_n, std::min<size_t>(N - pos, 37));
+    std::copy_n(ls.data() + pos, n, a_buff);
+    pos     += n;
+    return n;
+  };
+  std::vector<Len_m> r2 = Collect(GenFromReader<Len_m>(readF, 50), 50, &nErrs);
+  nErrs += (r2 != ls);
+
+  //-------------------------------------------------------------------------//
+  // Fused Adapters:                                                         //
+  //-------------------------------------------------------------------------//
+  std::vector<Vel> r3 = Collect
+    (GenFromSpan(std::span<Len_m const>(ls), 100)
+     | Converted<DimQ_Sys, Len_km>()
+     | Mapped  ([](Len_km a_x) { return a_x / 2.0_sec; })
+     | Filtered([](Vel    a_v) { return !a_v.IsNeg();  }),
+     100, &nErrs);
+  nErrs += (r3.size() != N - 100);
+  for (size_t i = 0; i < r3.size(); ++i)
+    nErrs += !r3[i].ApproxEquals(Len_km(double(i) / 1000.0) / 2.0_sec);
+
+  // A named generator (moved), and everything filtered out:
+  Generator<Len_m> g = GenFromSpan(std::span<Len_m const>(ls), 10);
+  nErrs += !Collect(std::move(g) | Filtered([](Len_m a_x)
+                                   { return a_x > 1e6_m; }),
+                    10, &nErrs).empty();
+
+  //-------------------------------------------------------------------------//
+  // "Windowed":                                                             //
+  //-------------------------------------------------------------------------//
+  // Overlapping windows across source batches:
+  unsigned nWins = 0;
+  for (auto win: GenFromSpan(std::span<Len_m const>(ls), 7) | Windowed(10, 3))
+  {
+    nErrs += (win.size() != 10);
+    for (size_t j = 0; j < 10; ++j)
+      nErrs += (win[j] != ls[3 * nWins + j]);
+    ++nWins;
+  }
+  nErrs += (nWins != (N - 10) / 3 + 1);
+
+  // Sparse windows (step > size), after a fused adapter:
+  nWins = 0;
+  for (auto win: GenFromSpan(std::span<Len_m const>(ls), 64)
+                 | Mapped([](Len_m a_x) { return a_x * 2.0; })
+                 | Windowed(4, 10))
+  {
+    nErrs += (win.size() != 4 || win[0] != ls[10 * nWins] * 2.0);
+    ++nWins;
+  }
+  nErrs += (nWins != N / 10);
+
+  //-------------------------------------------------------------------------//
+  // Exceptions:                                                             //
+  //-------------------------------------------------------------------------//
+  try
+  {
+    Collect(GenFromReader<Len_m>([](Len_m*, size_t a_n) { return a_n + 1; },
+                                 8),
+            8, &nErrs);
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+  try
+  {
+    Collect(GenFromSpan(std::span<Len_m const>(ls), 0), 1, &nErrs);
+    ++nErrs;
+  }
+  catch (std::invalid_argument const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "Tests/JSONTest.cpp":                          //
+//===========================================================================//
+// Round-trips of "DimQ"s, arrays and tables via JSON, incl Units conversions
+// on decoding and malformed inputs:
+//
+#include "DimTypes/JSON.hpp"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Rate  = decltype(1.0_km / 1.0_sec);
+  using RateM = decltype(1.0_m  / 1.0_day);
+
+  int nErrs = 0;
+
+  // Decoding "a_json" as "DQ" must throw:
+  template<typename DQ>
+  void ExpectFail(char const* a_json)
+  {
+    try
+    {
+      DQ res;
+      JSONDecode<DimQ_Sys>(a_json, a_json + strlen(a_json), &res);
+      ++nErrs;
+      printf("UnExpected Success: %s\n", a_json);
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+}
+
+int main()
+{
+  //-------------------------------------------------------------------------//
+  // Single "DimQ"s:                                                         //
+  //-------------------------------------------------------------------------//
+  std::string out;
+  Rate const  r0 = 1.5_km / 1.0_sec;
+  JSONEncode<DimQ_Sys>(r0, &out);
+  printf("%s\n", out.c_str());
+  nErrs += (out != "{\"v\":1.5,\"u\":\"km sec^(-1)\"}");
+
+  Rate r1;
+  char const* end = JSONDecode<DimQ_Sys>(out.data(), out.data() + out.size(),
+                                         &r1);
+  nErrs += (r1 != r0 || end != out.data() + out.size());
+
+  // Into other Units, with WS, the keys in another order, and an extra key:
+  char const* js = " { \"u\" : \"m*day^-1\", \"x\": [1, {\"y\": null}],"
+                   " \"v\" : 86400 } ";
+  RateM rm;
+  JSONDecode<DimQ_Sys>(js, js + strlen(js), &rm);
+  nErrs += (rm != 86400.0_m / 1.0_day);
+  JSONDecode<DimQ_Sys>(js, js + strlen(js), &r1);
+  nErrs += !r1.ApproxEquals(0.001_km / 1.0_sec);
+
+  // DimLess: no Units:
+  out.clear();
+  JSONEncode<DimQ_Sys>(DimLess(2.0), &out);
+  nErrs += (out != "{\"v\":2}");
+
+  //-------------------------------------------------------------------------//
+  // Arrays (with NaN and Inf encoded as "null"):                            //
+  //-------------------------------------------------------------------------//
+  std::vector<Len_km> ls { 1.0_km, 2.5_km, Len_km(NAN), Len_km(INFINITY) };
+  out.clear();
+  JSONEncode<DimQ_Sys>(ls.data(), ls.size(), &out);
+  printf("%s\n", out.c_str());
+  nErrs += (out != "{\"v\":[1,2.5,null,null],\"u\":\"km\"}");
+
+  std::vector<Len> lm;
+  JSONDecode<DimQ_Sys>(out.data(), out.data() + out.size(), &lm);
+  nErrs += (lm.size() != 4 || lm[0] != 1000.0_m || lm[1] != 2500.0_m ||
+            !lm[2].IsNaN()  || !lm[3].IsNaN());
+
+  //-------------------------------------------------------------------------//
+  // Tables:                                                                 //
+  //-------------------------------------------------------------------------//
+  std::vector<Rate> rs { 1.0_km / 1.0_sec, 2.0_km / 1.0_sec,
+                         3.0_km / 1.0_sec, 4.0_km / 1.0_sec };
+  out.clear();
+  JSONEncodeTable<DimQ_Sys>(ls.size(), {{"r\"ange", "rate"}}, &out,
+                            ls.data(), rs.data());
+  printf("%s\n", out.c_str());
+
+  // In the reverse order and other Units; the escaped name must match:
+  std::vector<RateM> rms;
+  std::vector<Len>   lms;
+  JSONDecodeTable<DimQ_Sys>(out.data(), out.data() + out.size(),
+                            {{"rate", "r\"ange"}}, &rms, &lms);
+  nErrs += (rms.size() != 4 || lms.size() != 4 || lms[1] != 2500.0_m);
+  for (size_t i = 0; i < rms.size(); ++i)
+    nErrs += !rms[i].ApproxEquals(RateM(double(i + 1) * 1000.0 * 86400.0));
+
+  // Missing column, length mismatch:
+  try
+  {
+    std::vector<Len> x;
+    JSONDecodeTable<DimQ_Sys>(out.data(), out.data() + out.size(),
+                              {{"none"}}, &x);
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  char const* bad = "{\"a\":{\"v\":[1,2]},\"b\":{\"v\":[1]}}";
+  try
+  {
+    std::vector<DimLess> a, b;
+    JSONDecodeTable<DimQ_Sys>(bad, bad + strlen(bad), {{"a", "b"}}, &a, &b);
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  //-------------------------------------------------------------------------//
+  // Malformed Inputs:                                                       //
+  //-------------------------------------------------------------------------//
+  ExpectFail<Len>    ("{\"v\":1,\"u\":\"sec\"}");      // Dims mismatch
+  ExpectFail<Len>    ("{\"v\":1,\"u\":\"furlong\"}");  // Unknown Units
+  ExpectFail<Len>    ("{\"v\":1}");                   // Missing Units
+  ExpectFail<Len>    ("{\"u\":\"m\"}");               // Missing value
+  ExpectFail<Len>    ("{\"v\":abc,\"u\":\"m\"}");     // Invalid number
+  ExpectFail<Len>    ("{\"v\":1,\"u\":\"m");          // UnTerminated
+  ExpectFail<DimLess>("{\"v\":1");                    // UnTerminated
+  ExpectFail<DimLess>("");                            // Empty
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "Tests/KeplerTest.cpp":                         //
+//===========================================================================//
+// "KeplerSolve" vs bisection references (in "long double"), for elliptic and
+// hyperbolic orbits, incl near-zero mean anomalies and eccentricities close
+// to 1, and "KeplerPropagate" vs the vis-viva equation:
+//
+#include "DimTypes/Kepler.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using LD = long double;
+
+  // Kepler's equation, in "long double":
+  LD KeplerF(LD a_e, LD a_M, LD a_x)
+  {
+    return (a_e < 1.0L) ? a_x - a_e * std::sin(a_x)  - a_M
+                        : a_e * std::sinh(a_x) - a_x - a_M;
+  }
+
+  // Both "f"s are monotonic in "x", so the root is found by bisection until
+  // the bracket cannot be split any further:
+  LD Reference(LD a_e, LD a_M)
+  {
+    LD lo = (a_e < 1.0L) ? -5.0L : -50.0L;
+    LD hi = -lo;
+    while (true)
+    {
+      LD mid = 0.5L * (lo + hi);
+      if (!(mid > lo && mid < hi))
+        return mid;
+      (KeplerF(a_e, a_M, mid) < 0.0L ? lo : hi) = mid;
+    }
+  }
+}
+
+int main()
+{
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // "KeplerSolve":                                                          //
+  //-------------------------------------------------------------------------//
+  // All combinations of (e, M), in a single call (so the elliptic and the hy-
+  // perbolic cases are mixed in the blocks). The elliptic Ms are within [-Pi,
+  // Pi], so that they are not reduced:
+  double const es[] = { 0.0, 0.1, 0.5, 0.9, 0.999, 0.999999,
+                        1.000001, 1.001, 1.5, 2.0, 10.0, 100.0 };
+  double const Ms[] = { 1e-300, 1e-12, 1e-8, 1e-4, 0.01, 0.3, 1.0, 2.5,
+                        3.14159, 10.0, 1e3, 1e6 };
+  std::vector<double> ev, Mv;
+  for (double e: es)
+    for (double M: Ms)
+      for (double sgn: { 1.0, -1.0 })
+        if (e > 1.0 || M < M_PI)
+        {
+          ev.push_back(e);
+          Mv.push_back(sgn * M);
+        }
+  size_t n = ev.size();
+  std::vector<double> Ev(n);
+  KeplerSolve(ev.data(), Mv.data(), n, Ev.data());
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    LD e = ev[i], M = Mv[i], E = Ev[i];
+    LD ref = Reference(e, M);
+    // The derivative of "f" at the root, which bounds the attainable accuracy
+    // of the anomaly (close to 1-e or e-1 for small Ms), and the scale of the
+    // terms of "f":
+    LD d1    = (e < 1.0L) ? 1.0L - e * std::cos(ref)
+                          : e * std::cosh(ref) - 1.0L;
+    LD scale = std::abs(ref) + std::abs(M) +
+               e * ((e < 1.0L) ? std::abs(std::sin(ref))
+                               : std::abs(std::sinh(ref)));
+    LD resid = std::abs(KeplerF(e, M, E));
+    LD err   = std::abs(E - ref);
+    bool ok  = resid <= 1e-15L * scale && err <= 1e-15L * scale / d1;
+    if (!ok)
+    {
+      printf("e=%.9g, M=%.9g: E=%.17g, Ref=%.17Lg, Resid=%.3Lg, Err=%.3Lg\n",
+             ev[i], Mv[i], Ev[i], ref, resid, err);
+      ++nErrs;
+    }
+  }
+
+  // Relative errors where the equation is well-conditioned (away from e=1):
+  for (double e: { 0.5, 1.5, 10.0 })
+    for (double M: { 1e-12, 1e-4 })
+    {
+      double E;
+      KeplerSolve(&e, &M, 1, &E);
+      LD ref = Reference(e, M);
+      nErrs += !(std::abs((E - ref) / ref) < 1e-15L);
+    }
+
+  try
+  {
+    double e = 1.0, M = 0.5, E;
+    KeplerSolve(&e, &M, 1, &E);
+    ++nErrs;
+  }
+  catch (std::invalid_argument const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  //-------------------------------------------------------------------------//
+  // "KeplerPropagate": Vis-Viva:                                            //
+  //-------------------------------------------------------------------------//
+  using GM = decltype(1.0_km * 1.0_km * 1.0_km / (1.0_sec * 1.0_sec));
+  GM const gm(398600.4418);
+  std::vector<OrbitElems<Len_km, Time_sec>> els =
+  {
+    { Len_km( 7000.0), 0.0,   0.9, 0.3, 1.2, 0.5,  Time_sec(0.0) },
+    { Len_km(26600.0), 0.74,  1.1, 2.0, 4.7, 3.0,  Time_sec(100.0) },
+    { Len_km(-9000.0), 1.3,   0.2, 1.0, 0.1, 1e-9, Time_sec(0.0) },
+    { Len_km(-5e5),    1.0001, 0.0, 0.0, 0.0, 0.0,  Time_sec(0.0) }
+  };
+  std::vector<Vec3<Len_km>>                       pos(els.size());
+  std::vector<Vec3<KeplerVel<Len_km, Time_sec>>>  vel(els.size());
+  KeplerPropagate(gm, els.data(), els.size(), Time_sec(3600.0),
+                  pos.data(), vel.data());
+  for (size_t i = 0; i < els.size(); ++i)
+  {
+    double r  = 0.0, v2 = 0.0;
+    for (unsigned k = 0; k < 3; ++k)
+    {
+      r  += Sqr(pos[i].m_c[k].Magnitude());
+      v2 += Sqr(vel[i].m_c[k].Magnitude());
+    }
+    r = std::sqrt(r);
+    // v^2 = GM (2/r - 1/a):
+    double vv = gm.Magnitude() * (2.0 / r - 1.0 / els[i].m_a.Magnitude());
+    nErrs += !(std::abs(v2 - vv) < 1e-12 * vv);
+  }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "Tests/MonteCarloTest.cpp":                       //
+//===========================================================================//
+// Philox4x32-10 vs the Random123 Known-Answer Test vectors, the end-points of
+// the uniform vals, the typed distributions, and the independence of the
+// "MonteCarlo" results of the number of threads:
+//
+#include "DimTypes/MonteCarlo.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+
+  // Random123 "kat_vectors": philox4x32 10 (ctr, key, expected output):
+  struct KAT
+  {
+    uint32_t m_ctr[4];
+    uint32_t m_key[2];
+    uint32_t m_out[4];
+  };
+  constexpr KAT KATs[] =
+  {
+    { { 0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+      { 0x00000000, 0x00000000 },
+      { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+    { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+      { 0xffffffff, 0xffffffff },
+      { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+    { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 },
+      { 0xa4093822, 0x299f31d0 },
+      { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } }
+  };
+
+  // "Block" is "constexpr":
+  constexpr bool KAT0()
+  {
+    uint32_t out[4] {};
+    PhiloxStream::Block(KATs[0].m_ctr, KATs[0].m_key, out);
+    return out[0] == KATs[0].m_out[0] && out[3] == KATs[0].m_out[3];
+  }
+  static_assert(KAT0());
+}
+
+int main()
+{
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // Known Answers:                                                          //
+  //-------------------------------------------------------------------------//
+  for (KAT const& kat: KATs)
+  {
+    uint32_t out[4];
+    PhiloxStream::Block(kat.m_ctr, kat.m_key, out);
+    nErrs += (memcmp(out, kat.m_out, sizeof(out)) != 0);
+  }
+
+  // A stream is the blocks (BlockNo, Stream) with the key = seed:
+  PhiloxStream rng(0xa4093822299f31d0ULL, 0x0370734413198a2eULL);
+  uint32_t const ctr[4] = { 5, 0, 0x13198a2e, 0x03707344 };
+  uint32_t const key[2] = { 0x299f31d0, 0xa4093822 };
+  uint32_t       ref[4];
+  PhiloxStream::Block(ctr, key, ref);
+  std::vector<uint32_t> words(24);
+  rng.Fill(words.data(), words.size());
+  nErrs += (memcmp(words.data() + 20, ref, sizeof(ref)) != 0);
+
+  //-------------------------------------------------------------------------//
+  // "U01": The Open Interval (0, 1):                                        //
+  //-------------------------------------------------------------------------//
+  nErrs += (PhiloxStream::U01(0xffffffff, 0xffffffff) != 1.0 - 0x1.0p-53 ||
+            PhiloxStream::U01(0, 0)                   != 0x1.0p-53        ||
+            PhiloxStream::U01(0xffffffffU)            != 1.0f - 0x1.0p-24f ||
+            PhiloxStream::U01(0U)                     != 0x1.0p-24f);
+
+  constexpr size_t N = 100000;
+  std::vector<double> ud(N);
+  std::vector<float>  uf(N);
+  PhiloxStream rng1(12345, 7);
+  rng1.FillU01(ud.data(), N);
+  rng1.FillU01(uf.data(), N);
+  double sum = 0.0;
+  for (size_t i = 0; i < N; ++i)
+  {
+    nErrs += !(ud[i] > 0.0 && ud[i] < 1.0 && uf[i] > 0.0f && uf[i] < 1.0f);
+    sum   += ud[i];
+  }
+  nErrs += !(std::abs(sum / N - 0.5) < 0.005);
+
+  //-------------------------------------------------------------------------//
+  // Distributions:                                                          //
+  //-------------------------------------------------------------------------//
+  std::vector<Len_km> ls(N);
+  UniformDist<Len_km>(1.0_km, 2.0_km).Fill(rng1, ls.data(), N);
+  for (Len_km l: ls)
+    nErrs += !(l >= 1.0_km && l < 2.0_km);
+
+  NormalDist<Len_km>(10.0_km, 2.0_km).Fill(rng1, ls.data(), N);
+  double m1 = 0.0, m2 = 0.0;
+  for (Len_km l: ls)
+  {
+    m1 += l.Magnitude();
+    m2 += l.Magnitude() * l.Magnitude();
+  }
+  m1 /= N;
+  m2  = m2 / N - m1 * m1;
+  nErrs += !(std::abs(m1 - 10.0) < 0.05 &&
+             std::abs(std::sqrt(m2) - 2.0) < 0.05);
+
+  try
+  {
+    UniformDist<Len_km>(2.0_km, 1.0_km);
+    ++nErrs;
+  }
+  catch (std::invalid_argument const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  //-------------------------------------------------------------------------//
+  // "MonteCarlo": The Same Bits for Any Number of Threads:                  //
+  //-------------------------------------------------------------------------//
+  auto kernel = [](PhiloxStream& a_rng, size_t a_n)
+  {
+    std::vector<Len_m> xs(a_n);
+    UniformDist<Len_m>(0.0_m, 1.0_m).Fill(a_rng, xs.data(), a_n);
+    Len_m s(0.0);
+    for (Len_m x: xs)
+      s += x;
+    return s;
+  };
+  auto red = [](Len_m a_x, Len_m a_y) { return a_x + a_y; };
+
+  ThreadPool pool1(1);
+  ThreadPool pool4(4);
+  Len_m r1 = MonteCarlo(pool1, 1000003, 42, 0.0_m, red, kernel, 10000);
+  Len_m r4 = MonteCarlo(pool4, 1000003, 42, 0.0_m, red, kernel, 10000);
+  nErrs += (memcmp(&r1, &r4, sizeof(r1)) != 0 ||
+            !(std::abs(r1.Magnitude() / 1000003 - 0.5) < 0.005));
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
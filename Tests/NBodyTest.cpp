@@ -0,0 +1,219 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "Tests/NBodyTest.cpp":                         //
+//===========================================================================//
+// Checks "NBody" against a "long double" direct summation, and the Barnes-
+// Hut tree against "Direct" on a Plummer sphere; also serves as the end-to-
+// end performance benchmark (the timings are printed):
+//
+#include "DimTypes/NBody.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978707e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using NB  = NBody<Len_AU, Time_day>;
+  using Acc = NB::AccDQ;
+
+  constexpr auto GMS = 2.959122082855911e-4 * IPow<3>(1.0_AU) /
+                       IPow<2>(1.0_day);
+  static_assert(std::is_same_v<NB::GMDQ, std::remove_const_t<decltype(GMS)>>);
+  static_assert(std::is_same_v<Acc, decltype(1.0_AU / IPow<2>(1.0_day))>);
+
+  //-------------------------------------------------------------------------//
+  // "Plummer": A Plummer Sphere (truncated at 50 radii), off the origin:    //
+  //-------------------------------------------------------------------------//
+  void Plummer(size_t a_n, std::vector<Vec3<Len_AU>>* a_pos,
+               std::vector<NB::GMDQ>* a_gm)
+  {
+    std::mt19937_64                        rng(a_n);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    a_pos->resize(a_n);
+    a_gm ->resize(a_n);
+    for (size_t i = 0; i < a_n; ++i)
+    {
+      double r;
+      do
+        r = 1.0 / std::sqrt(std::pow(u(rng), -2.0 / 3.0) - 1.0);
+      while (!(r < 50.0));
+      double z  = 2.0 * u(rng) - 1.0;
+      double ph = 2.0 * M_PI * u(rng);
+      double rh = r * std::sqrt(1.0 - z * z);
+      (*a_pos)[i] = Vec3<Len_AU>{{ Len_AU(1000.0 + rh * std::cos(ph)),
+                                   Len_AU(-500.0 + rh * std::sin(ph)),
+                                   Len_AU(r * z) }};
+      (*a_gm)[i]  = GMS * (0.5 + u(rng)) / double(a_n);
+    }
+  }
+
+  //-------------------------------------------------------------------------//
+  // "MaxRefErr": vs "long double", Relative to Sum |a_ij|:                  //
+  //-------------------------------------------------------------------------//
+  double MaxRefErr(std::vector<Vec3<Len_AU>> const& a_pos,
+                   std::vector<NB::GMDQ>     const& a_gm,
+                   std::vector<Vec3<Acc>>    const& a_acc, double a_eps)
+  {
+    double res = 0.0;
+    size_t n   = a_pos.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+      long double a[3] = { 0.0L, 0.0L, 0.0L }, s = 0.0L;
+      for (size_t j = 0; j < n; ++j)
+      {
+        long double d[3], r2 = (long double)(a_eps) * a_eps;
+        for (unsigned c = 0; c < 3; ++c)
+        {
+          d[c] = (long double)(a_pos[j][c].Magnitude()) -
+                 a_pos[i][c].Magnitude();
+          r2  += d[c] * d[c];
+        }
+        if (r2 == 0.0L)
+          continue;
+        long double f = a_gm[j].Magnitude() / (r2 * std::sqrt(r2));
+        for (unsigned c = 0; c < 3; ++c)
+          a[c] += f * d[c];
+        s += f * std::sqrt(r2 - (long double)(a_eps) * a_eps);
+      }
+      for (unsigned c = 0; c < 3; ++c)
+        res = std::max(res, double(std::abs(a_acc[i][c].Magnitude() - a[c]) /
+                                   s));
+    }
+    return res;
+  }
+
+  // RMS of the relative errors of the vectors:
+  double RMSRelErr(std::vector<Vec3<Acc>> const& a_acc,
+                   std::vector<Vec3<Acc>> const& a_ref)
+  {
+    double s = 0.0;
+    for (size_t i = 0; i < a_acc.size(); ++i)
+      s += double(Norm2(a_acc[i] - a_ref[i]) / Norm2(a_ref[i]));
+    return std::sqrt(s / double(a_acc.size()));
+  }
+
+  double Secs(std::chrono::steady_clock::time_point a_from)
+  {
+    return std::chrono::duration<double>
+           (std::chrono::steady_clock::now() - a_from).count();
+  }
+}
+
+int main()
+{
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // "Direct" vs the Reference (N not a multiple of the SIMD width):         //
+  //-------------------------------------------------------------------------//
+  std::vector<Vec3<Len_AU>> pos;
+  std::vector<NB::GMDQ>     gm;
+  Plummer(1001, &pos, &gm);
+  std::vector<Vec3<Acc>>    acc(pos.size());
+
+  NB direct;
+  direct.Accel(pos.data(), gm.data(), pos.size(), acc.data());
+  double err = MaxRefErr(pos, gm, acc, 0.0);
+  NB soft(0.0, Len_AU(0.01));
+  soft.Accel(pos.data(), gm.data(), pos.size(), acc.data());
+  double errS = MaxRefErr(pos, gm, acc, 0.01);
+  printf("Direct:     Err=%.3e, Softened Err=%.3e\n", err, errS);
+  nErrs += (err > 1e-12 || errS > 1e-12);
+
+  // With a tiny "theta", the tree opens (almost) all cells and is exact:
+  std::vector<Vec3<Acc>> acc0(pos.size());
+  direct.Direct(pos.data(), gm.data(), pos.size(), acc .data());
+  NB bh0(1e-3);
+  bh0.BarnesHut(pos.data(), gm.data(), pos.size(), acc0.data());
+  double err0 = RMSRelErr(acc0, acc);
+  printf("BarnesHut:  Err=%.3e (theta=1e-3)\n", err0);
+  nErrs += (err0 > 1e-10);
+
+  // Coincident bodies contribute nothing to each other:
+  std::vector<Vec3<Len_AU>> same(5, Vec3<Len_AU>{{ 1.0_AU, 2.0_AU, 3.0_AU }});
+  direct.Accel(same.data(), gm.data(), same.size(), acc.data());
+  for (size_t i = 0; i < same.size(); ++i)
+    for (unsigned c = 0; c < 3; ++c)
+      nErrs += !IsZero(acc[i][c]);
+
+  // Invalid params:
+  try
+  {
+    NB bad(-1.0);
+    ++nErrs;
+  }
+  catch (std::invalid_argument const&) {}
+
+  //-------------------------------------------------------------------------//
+  // Barnes-Hut vs Direct, and Timings:                                      //
+  //-------------------------------------------------------------------------//
+  constexpr size_t N = 20000;
+  Plummer(N, &pos, &gm);
+  std::vector<Vec3<Acc>> accD(N), accB(N);
+
+  auto   t0 = std::chrono::steady_clock::now();
+  direct.Direct(pos.data(), gm.data(), N, accD.data());
+  double tD = Secs(t0);
+
+  NB bh(0.5);
+  t0 = std::chrono::steady_clock::now();
+  bh.Accel(pos.data(), gm.data(), N, accB.data());
+  double tB = Secs(t0);
+
+  double errB = RMSRelErr(accB, accD);
+  printf("Direct:     N=%zu, %.3f sec, %.3e Interactions/sec\n",
+         N, tD, double(N) * double(N) / tD);
+  printf("BarnesHut:  N=%zu, %.3f sec, Err=%.3e (theta=0.5)\n",
+         N, tB, errB);
+  nErrs += (errB > 1e-2);
+
+  //-------------------------------------------------------------------------//
+  // Barnes-Hut Accuracy vs the Extent (just below a power of 2, or not):    //
+  //-------------------------------------------------------------------------//
+  // The root cell must be scaled to the extent, so the accuracy is the same:
+  double errH[2];
+  for (unsigned k = 0; k < 2; ++k)
+  {
+    double const half = (k == 0) ? 1.0 : 0.995;
+    constexpr size_t NU = 8192;
+    std::mt19937_64                        rng(7);
+    std::uniform_real_distribution<double> u(-half, half);
+    pos.resize(NU);
+    gm .assign(NU, GMS / double(NU));
+    for (size_t i = 0; i < NU; ++i)
+      pos[i] = Vec3<Len_AU>{{ Len_AU(u(rng)), Len_AU(u(rng)), Len_AU(u(rng)) }};
+    // Make the extent exact:
+    pos[0] = Vec3<Len_AU>{{ Len_AU(-half), Len_AU(-half), Len_AU(-half) }};
+    pos[1] = Vec3<Len_AU>{{ Len_AU( half), Len_AU( half), Len_AU( half) }};
+    accD.resize(NU);
+    accB.resize(NU);
+    direct.Direct   (pos.data(), gm.data(), NU, accD.data());
+    bh    .BarnesHut(pos.data(), gm.data(), NU, accB.data());
+    errH[k] = RMSRelErr(accB, accD);
+  }
+  printf("BarnesHut:  Err=%.3e (Half-Extent=1), %.3e (Half-Extent=0.995)\n",
+         errH[0], errH[1]);
+  nErrs += (errH[1] > 2.0 * errH[0]);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
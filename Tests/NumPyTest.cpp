@@ -0,0 +1,215 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "Tests/NumPyTest.cpp":                          //
+//===========================================================================//
+// ".npy" (+ Units sidecar) and ".npz" round-trips, Units conversions (with
+// the spans returned earlier remaining valid), and malformed files:
+//
+#include "DimTypes/NumPy.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Rate  = decltype(1.0_km / 1.0_sec);
+  using RateM = decltype(1.0_m  / 1.0_sec);
+
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // File Utils:                                                             //
+  //-------------------------------------------------------------------------//
+  std::string ReadFile(char const* a_path)
+  {
+    std::string res;
+    FILE* f = fopen(a_path, "rb");
+    if (f == nullptr)
+      return res;
+    char   buff[4096];
+    size_t len;
+    while ((len = fread(buff, 1, sizeof(buff), f)) > 0)
+      res.append(buff, len);
+    fclose(f);
+    return res;
+  }
+
+  void WriteFile(char const* a_path, std::string const& a_data)
+  {
+    FILE* f = fopen(a_path, "wb");
+    nErrs  += (f == nullptr ||
+               fwrite(a_data.data(), 1, a_data.size(), f) != a_data.size());
+    if (f != nullptr)
+      fclose(f);
+  }
+
+  void PutLE(std::string* a_data, size_t a_off, uint64_t a_x, unsigned a_n)
+  {
+    for (unsigned i = 0; i < a_n; ++i)
+      (*a_data)[a_off + i] = char((a_x >> (8 * i)) & 0xff);
+  }
+
+  // The file must be rejected:
+  void ExpectInvalid(char const* a_path)
+  {
+    try
+    {
+      NpyReader<DimQ_Sys> reader(a_path);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+}
+
+int main()
+{
+  constexpr size_t N = 1000;
+  std::vector<Len_km> ls(N);
+  std::vector<Rate>   rs(N / 2);
+  for (size_t i = 0; i < N; ++i)
+    ls[i] = Len_km(double(i) + 0.5);
+  for (size_t i = 0; i < N / 2; ++i)
+    rs[i] = Len_km(2.0 * double(i)) / 1.0_sec;
+
+  char npyPath[64];
+  char npzPath[64];
+  snprintf(npyPath, sizeof(npyPath), "/tmp/NumPyTest-%d.npy", int(getpid()));
+  snprintf(npzPath, sizeof(npzPath), "/tmp/NumPyTest-%d.npz", int(getpid()));
+  std::string sidecar = Bits::NpySidecarPath(npyPath);
+
+  //-------------------------------------------------------------------------//
+  // ".npy" + Sidecar:                                                       //
+  //-------------------------------------------------------------------------//
+  NpySave<DimQ_Sys>(npyPath, ls.data(), N);
+  {
+    NpyReader<DimQ_Sys> reader(npyPath);
+    nErrs += (reader.NArrays() != 1 || reader.ArrSize(0) != N);
+
+    auto km = reader.GetArray<Len_km>(0u);
+    for (size_t i = 0; i < N; ++i)
+      nErrs += (km[i] != ls[i]);
+
+    // A conversion must not affect the span returned earlier, and is made
+    // only once:
+    auto m = reader.GetArray<Len_m>(0u);
+    for (size_t i = 0; i < N; ++i)
+      nErrs += (km[i] != ls[i] || !m[i].ApproxEquals(To_Len(ls[i])));
+    nErrs += (reader.GetArray<Len_m>(0u).data() != m.data());
+
+    // Back in the original Units: the zero-copy view again:
+    auto km2 = reader.GetArray<Len_km>(0u);
+    nErrs += (km2.data() != km.data() || km2[N - 1] != ls[N - 1]);
+
+    try
+    {
+      reader.GetArray<Time_sec>(0u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  // W/o the sidecar, the array is DimLess:
+  unlink(sidecar.data());
+  {
+    NpyReader<DimQ_Sys> reader(npyPath);
+    try
+    {
+      reader.GetArray<Len_km>(0u);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  // Truncated ".npy":
+  std::string npy = ReadFile(npyPath);
+  WriteFile(npyPath, npy.substr(0, npy.size() / 2));
+  ExpectInvalid(npyPath);
+  unlink(npyPath);
+
+  //-------------------------------------------------------------------------//
+  // ".npz":                                                                 //
+  //-------------------------------------------------------------------------//
+  {
+    NpzWriter<DimQ_Sys> writer(npzPath);
+    writer.Add("len",  ls.data(), N);
+    writer.Add("rate", rs.data(), N / 2);
+    writer.Close();
+  }
+  {
+    NpyReader<DimQ_Sys> reader(npzPath);
+    nErrs += (reader.NArrays() != 2 || reader.FindArr("rate") != 1 ||
+              reader.FindArr("len.units") != -1 ||
+              reader.ArrSize(1) != N / 2);
+
+    auto r  = reader.GetArray<Rate>("rate");
+    auto rm = reader.GetArray<RateM>("rate");
+    auto l  = reader.GetArray<Len_km>("len");
+    for (size_t i = 0; i < N / 2; ++i)
+      nErrs += (r[i] != rs[i] || !rm[i].ApproxEquals(To_Len(rs[i])));
+    nErrs += (l[7] != ls[7] ||
+              reinterpret_cast<uintptr_t>(l.data()) % Bits::NpyAlign != 0);
+
+    try
+    {
+      reader.GetArray<Len_km>("none");
+      ++nErrs;
+    }
+    catch (std::out_of_range const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+
+  //-------------------------------------------------------------------------//
+  // Malformed ".npz"s (NB: the offsets must be checked w/o overflows):      //
+  //-------------------------------------------------------------------------//
+  std::string npz  = ReadFile(npzPath);
+  size_t      eocd = npz.size() - 22;
+  size_t      cd   = size_t(Bits::ZipGet(npz.data() + eocd + 16, 4));
+
+  // Truncated (no End Record):
+  WriteFile(npzPath, npz.substr(0, npz.size() - 10));
+  ExpectInvalid(npzPath);
+
+  // The Central Directory beyond the file:
+  std::string bad = npz;
+  PutLE(&bad, eocd + 16, 0xfffffff0, 4);
+  WriteFile(npzPath, bad);
+  ExpectInvalid(npzPath);
+
+  // A Local Header beyond the file:
+  bad = npz;
+  PutLE(&bad, cd + 42, 0xfffffff0, 4);
+  WriteFile(npzPath, bad);
+  ExpectInvalid(npzPath);
+
+  // A ZIP64 Locator pointing (almost) to the end of the address space:
+  std::string loc(20, '\0');
+  PutLE(&loc, 0,  Bits::Zip64LocSig, 4);
+  PutLE(&loc, 8,  ~uint64_t(0) - 40, 8);
+  bad = npz.substr(0, eocd) + loc + npz.substr(eocd);
+  PutLE(&bad, bad.size() - 22 + 10, 0xffff, 2);
+  WriteFile(npzPath, bad);
+  ExpectInvalid(npzPath);
+
+  unlink(npzPath);
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
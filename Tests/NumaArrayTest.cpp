@@ -0,0 +1,109 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "Tests/NumaArrayTest.cpp":                        //
+//===========================================================================//
+// "NumaArray" construction (by initialiser or by val, incl a val which is not
+// exactly of the element type), huge pages, moves, exceptions, and the pin-
+// ning of pool workers (which must not affect the calling thread):
+//
+#include "DimTypes/NumaArray.hpp"
+#include <cstdio>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+}
+
+int main()
+{
+  int nErrs = 0;
+  ThreadPool pool(4);
+  constexpr size_t N = 300007;
+
+  //-------------------------------------------------------------------------//
+  // Construction:                                                           //
+  //-------------------------------------------------------------------------//
+  NumaArray<Len_km> ls(pool, N, [](size_t a_i) { return Len_km(double(a_i)); });
+  nErrs += (ls.size() != N || ls.empty());
+  for (size_t i = 0; i < N; ++i)
+    nErrs += (ls[i] != Len_km(double(i)));
+
+  // By val (an "int" for "double" must not select the initialiser Ctor):
+  NumaArray<double> ds(pool, N, 1);
+  NumaArray<Len_m>  ms(pool, N, 2.5_m, true);
+  nErrs += (reinterpret_cast<uintptr_t>(ms.data()) % Bits::HugePageSize != 0);
+  for (size_t i = 0; i < N; ++i)
+    nErrs += (ds[i] != 1.0 || ms[i] != 2.5_m);
+
+  NumaArray<double> empty(pool, 0, 7.0);
+  nErrs += (!empty.empty() || empty.data() != nullptr);
+
+  //-------------------------------------------------------------------------//
+  // Moves, Spans:                                                           //
+  //-------------------------------------------------------------------------//
+  Len_km const*     p  = ls.data();
+  NumaArray<Len_km> ls2(std::move(ls));
+  nErrs += (ls2.data() != p || ls.data() != nullptr || ls.size() != 0);
+  ls = std::move(ls2);
+  std::span<Len_km const> sp = std::as_const(ls);
+  nErrs += (sp.data() != p || sp.size() != N || sp[N - 1] != Len_km(N - 1.0));
+
+  //-------------------------------------------------------------------------//
+  // An Initialiser Exception:                                               //
+  //-------------------------------------------------------------------------//
+  try
+  {
+    NumaArray<double> bad(pool, N, [](size_t a_i)
+    {
+      if (a_i == N / 2)
+        throw std::runtime_error("Init Failed");
+      return 0.0;
+    });
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  //-------------------------------------------------------------------------//
+  // "PinPoolWorkers": The Caller's Affinity is Unchanged:                   //
+  //-------------------------------------------------------------------------//
+  cpu_set_t before;
+  cpu_set_t after;
+  nErrs += (sched_getaffinity(0, sizeof(before), &before) != 0);
+  int cpu = 0;
+  while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &before))
+    ++cpu;
+  PinPoolWorkers(pool, { cpu });
+  nErrs += (sched_getaffinity(0, sizeof(after), &after) != 0 ||
+            !CPU_EQUAL(&before, &after));
+
+  // The pool is still usable, and invalid CPUs are errors:
+  NumaArray<double> ds2(pool, N, 3.0);
+  nErrs += (ds2[N - 1] != 3.0);
+  try
+  {
+    PinPoolWorkers(pool, { -1 });
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
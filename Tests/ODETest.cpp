@@ -0,0 +1,223 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "Tests/ODETest.cpp":                           //
+//===========================================================================//
+// A batch of harmonic oscillators x'' = -w^2 x (with different "w"s):  the
+// solutions are checked against the exact ones, and the convergence orders
+// and energy conservation against the theory:
+//
+#include "DimTypes/ODE.hpp"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Vel   = decltype(1.0_m / 1.0_sec);
+  using Freq  = decltype(1.0   / 1.0_sec);
+  using State = ODEBatch<Len_m, Vel>;
+
+  constexpr size_t N = 1001;   // Not a multiple of the SIMD width
+
+  std::vector<Freq> Ws()
+  {
+    std::vector<Freq> ws;
+    for (size_t i = 0; i < N; ++i)
+      ws.push_back(Freq(0.5 + 1.5 * double(i) / double(N)));
+    return ws;
+  }
+
+  State Init()
+  {
+    State y(N);
+    for (size_t i = 0; i < N; ++i)
+    {
+      y.Get<0>()[i] = Len_m(1.0 + 0.001 * double(i));
+      y.Get<1>()[i] = Vel  (0.5 - 0.002 * double(i));
+    }
+    return y;
+  }
+
+  // Max error vs the exact solution at "a_t":
+  double MaxErr(State const& a_y, std::vector<Freq> const& a_ws, Time_sec a_t)
+  {
+    State  y0  = Init();
+    double res = 0.0;
+    for (size_t i = 0; i < N; ++i)
+    {
+      double wt = double(a_ws[i] * a_t);
+      Len_m  x  = y0.Get<0>()[i] * std::cos(wt) +
+                  y0.Get<1>()[i] / a_ws[i] * std::sin(wt);
+      Vel    v  = y0.Get<1>()[i] * std::cos(wt) -
+                  y0.Get<0>()[i] * a_ws[i] * std::sin(wt);
+      res = std::max(res, std::abs((a_y.Get<0>()[i] - x).Magnitude()));
+      res = std::max(res, std::abs((a_y.Get<1>()[i] - v).Magnitude()));
+    }
+    return res;
+  }
+}
+
+int main()
+{
+  int nErrs = 0;
+  std::vector<Freq> ws = Ws();
+
+  // The raw columns of a const batch:
+  {
+    State const y  = Init();
+    auto        rs = y.Raw();
+    nErrs += (static_cast<void const*>(rs[0]) != y.Get<0>().data() ||
+              static_cast<void const*>(rs[1]) != y.Get<1>().data() ||
+              rs[1][N - 1] != y.Get<1>()[N - 1].Magnitude());
+  }
+
+  auto rhs = [&ws](Time_sec, State const& a_y, ODEDeriv<Time_sec, State>& a_d)
+  {
+    auto x  = a_y.Get<0>();
+    auto v  = a_y.Get<1>();
+    auto dx = a_d.Get<0>();
+    auto dv = a_d.Get<1>();
+    for (size_t i = 0; i < N; ++i)
+    {
+      dx[i] = v[i];
+      dv[i] = - ws[i] * ws[i] * x[i];
+    }
+  };
+  Time_sec const tEnd = 10.0_sec;
+
+  //-------------------------------------------------------------------------//
+  // RK4: Error and 4th Order:                                               //
+  //-------------------------------------------------------------------------//
+  double errs[2];
+  for (unsigned j = 0; j < 2; ++j)
+  {
+    RK4Solver<Time_sec, State> rk4(N);
+    State    y = Init();
+    Time_sec t(0.0);
+    size_t   nSteps =
+      rk4.Integrate(rhs, &t, &y, tEnd, Time_sec(0.02 / (j + 1)));
+    nErrs   += (t != tEnd || nSteps != 500 * (j + 1));
+    errs[j]  = MaxErr(y, ws, tEnd);
+  }
+  double ord = std::log2(errs[0] / errs[1]);
+  printf("RK4:      Err=%.3e, Order=%.2f\n", errs[1], ord);
+  nErrs += (errs[1] > 1e-7 || ord < 3.8 || ord > 4.2);
+
+  //-------------------------------------------------------------------------//
+  // RK45: Tolerances are met:                                               //
+  //-------------------------------------------------------------------------//
+  {
+    RK45Solver<Time_sec, State> rk45
+      (N, std::tuple(Len_m(1e-10), Vel(1e-10)), 1e-10);
+    State    y = Init();
+    Time_sec t(0.0);
+    Time_sec h(0.1);
+    size_t   nOK = rk45.Integrate(rhs, &t, &y, tEnd, &h);
+    double   err = MaxErr(y, ws, tEnd);
+    printf("RK45:     Err=%.3e, Steps=%zu\n", err, nOK);
+    nErrs += (t != tEnd || err > 1e-7 || nOK < 10 || nOK > 5000);
+
+    // Continuing in the opposite direction is not supported, but a further
+    // interval is, and the tolerance scales the error:
+    RK45Solver<Time_sec, State> loose
+      (N, std::tuple(Len_m(1e-5), Vel(1e-5)), 1e-5);
+    State    y2 = Init();
+    Time_sec t2(0.0);
+    Time_sec h2(0.1);
+    size_t   nOK2 = loose.Integrate(rhs, &t2, &y2, tEnd, &h2);
+    double   err2 = MaxErr(y2, ws, tEnd);
+    printf("RK45(1e-5): Err=%.3e, Steps=%zu\n", err2, nOK2);
+    nErrs += (nOK2 >= nOK || err2 > 1e-2 || err2 < err);
+  }
+
+  //-------------------------------------------------------------------------//
+  // Leapfrog: 2nd Order and Energy Conservation:                            //
+  //-------------------------------------------------------------------------//
+  using LF = LeapfrogSolver<Time_sec, ODEBatch<Len_m>>;
+  auto acc = [&ws](Time_sec, ODEBatch<Len_m> const& a_q, LF::ABatch& a_a)
+  {
+    auto x = a_q.Get<0>();
+    auto a = a_a.Get<0>();
+    for (size_t i = 0; i < N; ++i)
+      a[i] = - ws[i] * ws[i] * x[i];
+  };
+  auto energy = [&ws](ODEBatch<Len_m> const& a_q, LF::VBatch const& a_v,
+                      size_t a_i)
+  {
+    auto x = a_q.Get<0>()[a_i];
+    auto v = a_v.Get<0>()[a_i];
+    return v * v + ws[a_i] * ws[a_i] * x * x;
+  };
+  for (unsigned j = 0; j < 2; ++j)
+  {
+    LF              lf(N);
+    ODEBatch<Len_m> q (N);
+    LF::VBatch      v (N);
+    State           y0 = Init();
+    std::copy(y0.Get<0>().begin(), y0.Get<0>().end(), q.Get<0>().begin());
+    std::copy(y0.Get<1>().begin(), y0.Get<1>().end(), v.Get<0>().begin());
+
+    Time_sec t(0.0);
+    lf.Integrate(acc, &t, &q, &v, tEnd, Time_sec(0.01 / (j + 1)));
+    double err = 0.0;
+    for (size_t i = 0; i < N; ++i)
+    {
+      double wt = double(ws[i] * tEnd);
+      Len_m  x  = y0.Get<0>()[i] * std::cos(wt) +
+                  y0.Get<1>()[i] / ws[i] * std::sin(wt);
+      err = std::max(err, std::abs((q.Get<0>()[i] - x).Magnitude()));
+    }
+    errs[j] = err;
+
+    // Long-term energy conservation (bounded error, no secular drift):
+    if (j == 1)
+    {
+      Time_sec tLong(0.0);
+      lf.Integrate(acc, &tLong, &q, &v, Time_sec(1000.0), Time_sec(0.05));
+      double maxDE = 0.0;
+      for (size_t i = 0; i < N; ++i)
+      {
+        auto e0 = y0.Get<1>()[i] * y0.Get<1>()[i] +
+                  ws[i] * ws[i] * y0.Get<0>()[i] * y0.Get<0>()[i];
+        maxDE = std::max(maxDE, std::abs(double(energy(q, v, i) / e0) - 1.0));
+      }
+      printf("Leapfrog: Energy Err=%.3e\n", maxDE);
+      nErrs += (maxDE > 5e-3);   // Bounded, ~(w h)^2 / 4
+    }
+  }
+  ord = std::log2(errs[0] / errs[1]);
+  printf("Leapfrog: Err=%.3e, Order=%.2f\n", errs[1], ord);
+  nErrs += (errs[1] > 1e-3 || ord < 1.9 || ord > 2.1);
+
+  //-------------------------------------------------------------------------//
+  // Dims Checks:                                                            //
+  //-------------------------------------------------------------------------//
+  // A RHS which produces (say) Vel instead of Acc is rejected:
+  auto bad = [](Time_sec, State const&, ODEBatch<Vel, Vel>&) {};
+  static_assert(!std::is_invocable_v<decltype(bad) const&, Time_sec,
+                                     State const&,
+                                     ODEDeriv<Time_sec, State>&>);
+  static_assert(std::is_same_v<ODEDeriv<Time_sec, State>,
+                               ODEBatch<Vel, decltype(1.0_m / 1.0_sec /
+                                                      1.0_sec)>>);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/ParallelTest.cpp":                        //
+//===========================================================================//
+// "ThreadPool" algorithms over "DimQ"s, nested "ParallelFor"s across pools
+// (which must not dead-lock), exceptions, and the independence of the
+// "TransformReduce" results of the number of threads:
+//
+#include "DimTypes/Parallel.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Vel = decltype(1.0_m / 1.0_sec);
+}
+
+int main()
+{
+  int nErrs = 0;
+  ThreadPool pool1(1);
+  ThreadPool pool3(3);
+  ThreadPool pool4(4);
+
+  //-------------------------------------------------------------------------//
+  // "Transform", "ForEach":                                                 //
+  //-------------------------------------------------------------------------//
+  constexpr size_t N = 100003;
+  std::vector<Len_m> ls(N);
+  for (size_t i = 0; i < N; ++i)
+    ls[i] = Len_m(1.0 / double(i + 1));
+
+  std::vector<Vel> vs =
+    Transform(pool4, std::span(ls), [](Len_m a_x) { return a_x / 2.0_sec; });
+  for (size_t i = 0; i < N; ++i)
+    nErrs += (vs[i] != ls[i] / 2.0_sec);
+
+  ForEach(pool3, std::span(vs), [](Vel& a_v) { a_v = a_v * 2.0; }, 1000);
+  for (size_t i = 0; i < N; ++i)
+    nErrs += (vs[i] * 1.0_sec != ls[i]);
+
+  //-------------------------------------------------------------------------//
+  // Nested "ParallelFor"s across Pools:                                     //
+  //-------------------------------------------------------------------------//
+  // The workers of "pool3" are invoked (via "pool4") from a "pool4" job, so
+  // their "ParallelFor"s on "pool4" must run serially; so must the ones made
+  // on "pool4" by its own workers after they return from "pool3":
+  std::atomic<size_t> count = 0;
+  auto leaf = [&count](size_t a_from, size_t a_to)
+    { count.fetch_add(a_to - a_from, std::memory_order_relaxed); };
+
+  pool4.ParallelFor(16, 1, [&](size_t, size_t)
+  {
+    pool3.ParallelFor(6, 1, [&](size_t, size_t)
+      { pool4.ParallelFor(10, 1, leaf); });
+    pool4.ParallelFor(10, 1, leaf);
+  });
+  nErrs += (count.load() != 16 * (6 * 10 + 10));
+
+  // The pools remain usable afterwards:
+  count = 0;
+  pool4.ParallelFor(1000, 7, leaf);
+  pool3.ParallelFor(1000, 7, leaf);
+  nErrs += (count.load() != 2000);
+
+  //-------------------------------------------------------------------------//
+  // Exceptions:                                                             //
+  //-------------------------------------------------------------------------//
+  try
+  {
+    pool4.ParallelFor(100, 1, [](size_t a_from, size_t)
+    {
+      if (a_from == 37)
+        throw std::runtime_error("Chunk 37");
+    });
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  //-------------------------------------------------------------------------//
+  // "TransformReduce": The Same Bits for Any Number of Threads:             //
+  //-------------------------------------------------------------------------//
+  auto red = [](Len_m a_x, Len_m a_y) { return a_x + a_y; };
+  auto sqr = [](Len_m a_x)            { return a_x * 3.0;  };
+  Len_m r1 = TransformReduce(pool1, std::span(ls), 0.0_m, red, sqr);
+  for (ThreadPool* pool: { &pool3, &pool4 })
+  {
+    Len_m r = TransformReduce(*pool, std::span(ls), 0.0_m, red, sqr);
+    nErrs  += (memcmp(&r, &r1, sizeof(r)) != 0);
+  }
+  nErrs += !r1.ApproxEquals(Len_m(3.0 * (std::log(double(N)) + 0.5772156649)),
+                            1e-5);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/PipelineTest.cpp":                        //
+//===========================================================================//
+#include "DimTypes/Pipeline.hpp"
+#include <cstdio>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (hour, 3600.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+int main()
+{
+  int nErrs = 0;
+  using Sys   = DimQ_Sys;
+  using Speed = decltype(1.0_km / 1.0_hour);
+
+  //-------------------------------------------------------------------------//
+  // Source -> ConvertTo -> Map -> Filter -> Sink:                           //
+  //-------------------------------------------------------------------------//
+  // The Source produces "N" distances in "m", every 3rd of them negative:
+  constexpr size_t N = 1000003;
+  size_t           i = 0;
+  auto src = [&i](Len_m* a_buff, size_t a_max) -> size_t
+  {
+    size_t n = 0;
+    for (; n < a_max && i < N; ++n, ++i)
+      a_buff[n] = Len_m((i % 3 == 0) ? -double(i) : double(i));
+    return n;
+  };
+
+  size_t cnt = 0;
+  Speed  sum;
+  auto p = DimTypes::MakePipeline<Sys, Len_m, 128>(src, 4)
+           .ConvertTo<Len_km>()
+           .Map   ([](Len_km a_x) { return a_x / 0.5_hour; })
+           .Filter([](Speed  a_v) { return !IsNeg(a_v); });
+  p.Run([&cnt, &sum](Speed const* a_vs, size_t a_n)
+  {
+    for (size_t k = 0; k < a_n; ++k)
+      sum += a_vs[k];
+    cnt += a_n;
+  });
+  // NB: ".Filter([](Len_km) { return true; })" above would not compile
+
+  // The expected result:
+  size_t expCnt = 0;
+  double expSum = 0.0;
+  for (size_t k = 0; k < N; ++k)
+    if (k % 3 != 0 || k == 0)   // NB: -0.0 is not negative
+    {
+      ++expCnt;
+      expSum += 2.0 * double(k) / 1000.0;
+    }
+  printf("Count=%zu, Sum=%s\n", cnt, ToStr(sum).data());
+  nErrs += (cnt != expCnt);
+  nErrs += (std::fabs(sum.Magnitude() - expSum) > 1e-9 * expSum);
+
+  //-------------------------------------------------------------------------//
+  // Exceptions stop the whole pipeline:                                     //
+  //-------------------------------------------------------------------------//
+  i = 0;
+  auto q = DimTypes::MakePipeline<Sys, Len_m, 64>(src)
+           .MapBatch<Len_m>([](Len_m const* a_in, size_t a_n, Len_m* a_out)
+           {
+             for (size_t k = 0; k < a_n; ++k)
+             {
+               if (a_in[k] > 5000.0_m)
+                 throw std::runtime_error("Too Far");
+               a_out[k] = a_in[k];
+             }
+             return a_n;
+           });
+  bool thrown = false;
+  try
+    { q.Run([](Len_m const*, size_t) {}); }
+  catch (std::runtime_error const&)
+    { thrown = true; }
+  nErrs += !thrown;
+
+  // A "MapBatch" function returning more vals than it was given:
+  i = 0;
+  auto r = DimTypes::MakePipeline<Sys, Len_m, 64>(src)
+           .MapBatch<Len_m>([](Len_m const*, size_t a_n, Len_m*)
+             { return a_n + 1; });
+  try
+  {
+    r.Run([](Len_m const*, size_t) {});
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
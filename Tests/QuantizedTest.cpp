@@ -0,0 +1,140 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/QuantizedTest.cpp":                       //
+//===========================================================================//
+#include "DimTypes/Quantized.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0),  (AU, 1.495978706996262e+11)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+namespace F
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    float, ,
+    (Len,  m,   (km,  1000.0f)),
+    (Time, sec)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+namespace
+{
+  //-------------------------------------------------------------------------//
+  // "Check": Encodes, decodes and verifies the error bound:                 //
+  //-------------------------------------------------------------------------//
+  template<typename IntT, typename DQ, typename QT>
+  int Check(std::vector<DQ> const& a_vals, QT a_quantum, size_t* a_nRaw)
+  {
+    DimTypes::QuantizedArray<DimQ_Sys, DQ, IntT> qa(a_quantum, 256);
+    qa.Encode(a_vals.data(), a_vals.size());
+    std::vector<DQ> dec(a_vals.size());
+    qa.Decode(dec.data());
+
+    int nErrs = 0;
+    for (size_t i = 0; i < a_vals.size(); ++i)
+    {
+      DQ x = a_vals[i];
+      if (IsNaN(x))
+        nErrs += !IsNaN(dec[i]) || !IsNaN(qa.Get(i));
+      else
+        nErrs += (Abs(dec[i] - x) > qa.MaxError() ||
+                  qa.Get(i).Magnitude() != dec[i].Magnitude());
+    }
+    *a_nRaw = qa.NRawBlocks();
+    printf("N=%zu, IntT=%zu, Blocks=%zu, Raw=%zu, Bytes=%zu, MaxErr=%s\n",
+           qa.Size(), sizeof(IntT), qa.NBlocks(), qa.NRawBlocks(),
+           qa.StorageBytes(), ToStr(qa.MaxError()).data());
+    return nErrs;
+  }
+}
+
+int main()
+{
+  int nErrs = 0;
+
+  // A smooth series in "km", with the quantum given in "m":
+  std::vector<decltype(1.0_km)> vals;
+  for (int i = 0; i < 10000; ++i)
+    vals.push_back(Len_km(7000.0 + 30.0 * sin(0.001 * i) + 1e-7 * (i % 13)));
+  vals[17]   = Len_km(NAN);
+  vals[4001] = Len_km(NAN);
+
+  size_t nRaw = 0;
+  nErrs += Check<int32_t>(vals, 1.0_m, &nRaw);
+  nErrs += (nRaw != 0);
+  // "int16_t" codes with the 1 m quantum cover ranges of +-32 km per block:
+  nErrs += Check<int16_t>(vals, 1.0_m, &nRaw);
+  nErrs += (nRaw != 0);
+
+  // Outliers and infinities make the corresponding blocks raw:
+  vals[300]  = Len_km(1e9);
+  vals[9000] = Len_km(INFINITY);
+  nErrs += Check<int16_t>(vals, 1.0_m, &nRaw);
+  nErrs += (nRaw != 2);
+
+  // Each block is counted once: the 2 raw ones as "double"s, the others as
+  // codes (10000 vals in 40 blocks of 256 or less):
+  {
+    DimTypes::QuantizedArray<DimQ_Sys, decltype(1.0_km), int16_t>
+      q16(1.0_m, 256);
+    q16.Encode(vals.data(), vals.size());
+    size_t nr = 2 * 256;
+    nErrs += (q16.StorageBytes() !=
+              40 * (8 + 4) + (10000 - nr) * 2 + nr * 8);
+  }
+
+  // "float" with "int32_t" codes: the vals which would round to +-2^31 codes
+  // (not representable) make the block raw, rather than overflow:
+  {
+    std::vector<F::Len> fv { F::Len(-2147483647.0f), F::Len(2147483647.0f),
+                             F::Len(0.0f) };
+    DimTypes::QuantizedArray<F::DimQ_Sys, F::Len, int32_t> qf(F::Len(1.0f));
+    qf.Encode(fv.data(), fv.size());
+    nErrs += (qf.NRawBlocks() != 1);
+    for (size_t i = 0; i < fv.size(); ++i)
+      nErrs += (qf.Get(i) != fv[i]);
+  }
+
+  // The exact round-trip of raw blocks:
+  DimTypes::QuantizedArray<DimQ_Sys, decltype(1.0_km), int16_t> qa(1.0_m);
+  qa.Encode(vals.data(), vals.size());
+  nErrs += (qa.Get(9000).Magnitude() != INFINITY);
+  nErrs += (qa.Get(300) != vals[300]);
+
+  // An invalid quantum:
+  try
+  {
+    DimTypes::QuantizedArray<DimQ_Sys, decltype(1.0_km)> bad(0.0_m);
+    ++nErrs;
+  }
+  catch (std::invalid_argument const&) {}
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "Tests/ReductionsTest.cpp":                       //
+//===========================================================================//
+// Compensated reductions vs exactly-known results, their independence of the
+// number of threads (bit-for-bit), and the NaN and empty-array conventions:
+//
+#include "DimTypes/Reductions.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  using Area = decltype(1.0_m * 1.0_m);
+
+  int nErrs = 0;
+
+  template<typename DQ>
+  bool SameBits(DQ a_x, DQ a_y)
+    { return memcmp(&a_x, &a_y, sizeof(DQ)) == 0; }
+}
+
+int main()
+{
+  // More than 3 chunks, with a tail which is not a multiple of the lanes:
+  constexpr size_t N = 3 * Bits::ReduceChunk + 12345;
+
+  //-------------------------------------------------------------------------//
+  // "Sum": Ill-Conditioned, Exactly-Known Result:                           //
+  //-------------------------------------------------------------------------//
+  // Pairs of (+1e16, -1e16) interleaved with 1s: naive summation loses most of
+  // the 1s, the compensated one must not:
+  std::vector<Len_m> xs(N);
+  size_t nOnes = 0;
+  for (size_t i = 0; i < N; ++i)
+  {
+    switch (i % 3)
+    {
+      case 0:  xs[i] = Len_m( 1e16); break;
+      case 1:  xs[i] = Len_m(1.0);   ++nOnes; break;
+      default: xs[i] = Len_m(-1e16); break;
+    }
+  }
+  // The last "case 0" (if any) is not cancelled:
+  double exact = double(nOnes) + ((N % 3 != 0) ? 1e16 : 0.0);
+
+  Len_m s1 = Sum(xs.data(), N, 1);
+  nErrs += (s1.Magnitude() != exact);
+  for (unsigned nThreads: { 2U, 3U, 8U, 0U })
+    nErrs += !SameBits(Sum(xs.data(), N, nThreads), s1);
+
+  //-------------------------------------------------------------------------//
+  // "Dot", "Norm", "Mean" over Random-ish Vals:                             //
+  //-------------------------------------------------------------------------//
+  std::vector<Len_m>    ys(N);
+  std::vector<Time_day> zs(N);
+  uint64_t st = 12345;
+  for (size_t i = 0; i < N; ++i)
+  {
+    st    = st * 6364136223846793005ULL + 1442695040888963407ULL;
+    ys[i] = Len_m (double(st >> 11) * 0x1p-53 - 0.5);
+    zs[i] = Time_day(double(i % 7) - 3.0);
+  }
+  Area d1 = Dot(ys.data(), ys.data(), N, 1);
+  auto n1 = Norm(ys.data(), N, 1);
+  auto m1 = Mean(ys.data(), N, 1);
+  static_assert(std::is_same_v<decltype(n1), Len_m>);
+
+  // vs a plain "long double" summation:
+  long double dRef = 0.0L, sRef = 0.0L;
+  for (size_t i = 0; i < N; ++i)
+  {
+    dRef += (long double)(ys[i].Magnitude()) * ys[i].Magnitude();
+    sRef += ys[i].Magnitude();
+  }
+  nErrs += !(std::abs(d1.Magnitude() - double(dRef)) < 1e-12 * double(dRef));
+  nErrs += !(std::abs(n1.Magnitude() - std::sqrt(double(dRef))) <
+             1e-12 * std::sqrt(double(dRef)));
+  nErrs += !(std::abs(m1.Magnitude() - double(sRef) / double(N)) < 1e-15);
+
+  // Other Dims: the result is of the product Dims and Units:
+  auto dz = Dot(ys.data(), zs.data(), N, 1);
+  static_assert(std::is_same_v<decltype(dz), decltype(1.0_m * 1.0_day)>);
+
+  for (unsigned nThreads: { 2U, 5U, 0U })
+  {
+    nErrs += !SameBits(Dot (ys.data(), ys.data(), N, nThreads), d1);
+    nErrs += !SameBits(Dot (ys.data(), zs.data(), N, nThreads), dz);
+    nErrs += !SameBits(Norm(ys.data(), N, nThreads), n1);
+    nErrs += !SameBits(Mean(ys.data(), N, nThreads), m1);
+  }
+
+  // "Norm" of huge and tiny vals (whose squares overflow or underflow): the
+  // re-scaling is by powers of 2, so the result is exactly that of "ys":
+  for (int e: { 600, 1000, -600, -1060 })
+  {
+    std::vector<Len_m> ws(N);
+    for (size_t i = 0; i < N; ++i)
+      ws[i] = Len_m(std::ldexp(ys[i].Magnitude(), e));
+    Len_m nw = Norm(ws.data(), N, 1);
+    // Sub-normals (e = -1060) lose some bits:
+    nErrs += (e > -1000)
+             ? !SameBits(nw, Len_m(std::ldexp(n1.Magnitude(), e)))
+             : !(std::abs(std::ldexp(nw.Magnitude(), -e) / n1.Magnitude()
+                          - 1.0) < 1e-6);
+    nErrs += !SameBits(Norm(ws.data(), N, 3), nw);
+  }
+  // NaNs still propagate:
+  std::vector<Len_m> nv { Len_m(1e200), Len_m(Bits::CEMaths::NaN<double>) };
+  nErrs += !(IsNaN(Norm(nv.data(), 2)) && IsNaN(Norm(nv.data() + 1, 1)));
+
+  //-------------------------------------------------------------------------//
+  // "Min", "Max": NaNs are Ignored:                                         //
+  //-------------------------------------------------------------------------//
+  ys[17]    = Len_m(Bits::CEMaths::NaN<double>);
+  ys[N - 1] = Len_m(-7.0);
+  ys[N / 2] = Len_m( 9.0);
+  auto [mn, mx] = MinMax(ys.data(), N, 3);
+  nErrs += (mn != Len_m(-7.0) || mx != Len_m(9.0));
+  nErrs += !std::isnan(Sum(ys.data(), N).Magnitude());
+
+  //-------------------------------------------------------------------------//
+  // Edge Cases:                                                             //
+  //-------------------------------------------------------------------------//
+  nErrs += (Sum(xs.data(), 0) != Len_m(0.0) ||
+            !std::isnan(Mean(xs.data(), 0).Magnitude()) ||
+            Min(xs.data(), 0).Magnitude() != Bits::CEMaths::Inf<double> ||
+            Max(xs.data(), 0).Magnitude() != -Bits::CEMaths::Inf<double>);
+
+  // The "std::span" versions:
+  std::span<Len_m const> sp(xs);
+  nErrs += !SameBits(Sum(sp), s1);
+  try
+  {
+    Dot(sp, sp.first(10));
+    ++nErrs;
+  }
+  catch (std::invalid_argument const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// vim:ts=2:et
+//===========================================================================//
+//                           "Tests/SeqLockTest.cpp":                        //
+//===========================================================================//
+#include "DimTypes/SeqLock.hpp"
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using Vel = decltype(1.0_km / 1.0_sec);
+
+  // A State Vector (not a multiple of 8 bytes in size):
+  struct StateVec
+  {
+    Len_km   m_pos[3];
+    Vel      m_vel[3];
+    Time_sec m_epoch;
+    unsigned m_k;
+  };
+}
+
+int main()
+{
+  int nErrs = 0;
+
+  //-------------------------------------------------------------------------//
+  // Single-Threaded Semantics:                                              //
+  //-------------------------------------------------------------------------//
+  DimTypes::SeqLocked<StateVec> sv;
+  uint64_t ver = 1;
+  StateVec s0  = sv.Load(&ver);
+  nErrs += (ver != 0 || s0.m_k != 0 || s0.m_pos[2] != 0.0_km);
+
+  nErrs += (sv.Modify([](StateVec& a_s) { a_s.m_pos[1] = 7.0_km; }) != 1);
+  StateVec s1  = sv.Load(&ver);
+  nErrs += (ver != 1 || sv.Version() != 1 || s1.m_pos[1] != 7.0_km);
+
+  //-------------------------------------------------------------------------//
+  // 1 Writer, Many Readers: Snapshots must never be torn:                   //
+  //-------------------------------------------------------------------------//
+  // Each record satisfies "pos = vel * epoch" with "epoch = k sec":
+  constexpr unsigned NReaders = 3;
+  constexpr unsigned N        = 200000;
+  std::atomic<bool>  done(false);
+  std::atomic<int>   nTorn(0);
+  std::vector<std::thread> readers;
+
+  for (unsigned r = 0; r < NReaders; ++r)
+    readers.emplace_back([&sv, &done, &nTorn]()
+    {
+      uint64_t prevVer = 0;
+      while (!done.load(std::memory_order_relaxed))
+      {
+        uint64_t v = 0;
+        StateVec s = sv.Load(&v);
+        if (v < 2)
+          continue;
+        bool ok = (v >= prevVer) && (s.m_epoch == Time_sec(double(s.m_k)));
+        for (int j = 0; j < 3; ++j)
+          ok = ok && (s.m_pos[j] == s.m_vel[j] * s.m_epoch);
+        nTorn += !ok;
+        prevVer = v;
+      }
+    });
+
+  for (unsigned k = 1; k <= N; ++k)
+  {
+    StateVec s;
+    s.m_k     = k;
+    s.m_epoch = Time_sec(double(k));
+    for (int j = 0; j < 3; ++j)
+    {
+      s.m_vel[j] = Vel(double(j + 1) * 0.5);
+      s.m_pos[j] = s.m_vel[j] * s.m_epoch;
+    }
+    sv.Publish(s);
+  }
+  done = true;
+  for (auto& reader: readers)
+    reader.join();
+
+  StateVec last = sv.Load(&ver);
+  printf("Version=%lu, Epoch=%s, Torn=%d\n",
+         ver, ToStr(last.m_epoch).data(), nTorn.load());
+  nErrs += (ver != N + 1 || last.m_k != N || nTorn.load() != 0);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
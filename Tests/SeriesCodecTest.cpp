@@ -0,0 +1,129 @@
+// vim:ts=2:et
+//===========================================================================//
+//                         "Tests/SeriesCodecTest.cpp":                      //
+//===========================================================================//
+// Lossless round-trips of "DimQ" series (with and w/o time stamps) via the
+// XOR / Delta-of-Delta codecs, Units conversions on decoding, and corrupted
+// blocks:
+//
+#include "DimTypes/SeriesCodec.hpp"
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+  using namespace DimTypes;
+  int nErrs = 0;
+
+  // Decompressing "a_data" must throw:
+  template<typename DQ>
+  void ExpectFail(std::vector<uint8_t> const& a_data)
+  {
+    try
+    {
+      std::vector<DQ> vals;
+      DecompressSeries<DimQ_Sys>(a_data.data(), a_data.size(), &vals);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+}
+
+int main()
+{
+  //-------------------------------------------------------------------------//
+  // A Random Walk with Regular (but jittered) Time Stamps:                  //
+  //-------------------------------------------------------------------------//
+  constexpr size_t N = 10000;
+  std::mt19937_64                  rng(1);
+  std::normal_distribution<double> nd;
+  std::vector<Len_km>              xs(N);
+  std::vector<int64_t>             ts(N);
+  double x = 100.0;
+  for (size_t i = 0; i < N; ++i)
+  {
+    // Prices-like data: rounded to 0.01, often unchanged:
+    if (rng() % 4 == 0)
+      x += std::round(nd(rng) * 10.0) / 100.0;
+    xs[i] = Len_km(x);
+    ts[i] = 1'700'000'000'000'000'000L + int64_t(i) * 1'000'000 +
+            ((rng() % 8 == 0) ? int64_t(rng() % 1000) : 0);
+  }
+  // Special vals must round-trip bit-exactly:
+  xs[10] = Len_km(NAN);
+  xs[11] = Len_km(-0.0);
+  xs[12] = Len_km(INFINITY);
+
+  std::vector<uint8_t> buff;
+  CompressSeries(xs.data(), N, &buff, ts.data(), 1000);
+  printf("Compressed: %zu -> %zu bytes\n",
+         N * (sizeof(double) + sizeof(int64_t)), buff.size());
+  nErrs += (buff.size() * 2 > N * (sizeof(double) + sizeof(int64_t)));
+
+  auto blocks = ScanSeriesBlocks(buff.data(), buff.size());
+  nErrs += (blocks.size() != 10 || blocks[3].m_outOff != 3000);
+
+  std::vector<Len_km>  ys;
+  std::vector<int64_t> us;
+  DecompressSeries<DimQ_Sys>(buff.data(), buff.size(), &ys, &us);
+  nErrs += (ys.size() != N || us != ts ||
+            memcmp(ys.data(), xs.data(), N * sizeof(double)) != 0);
+
+  // In other Units, w/o time stamps, one block at a time:
+  std::vector<Len> ms(N);
+  for (auto const& b: blocks)
+    DecompressSeriesBlock<DimQ_Sys>
+      (buff.data() + b.m_off, ms.data() + b.m_outOff);
+  for (size_t i = 0; i < N; ++i)
+    nErrs += (i != 10 && ms[i] != To_Len(xs[i]));
+
+  // Time stamps with large jumps (the 64-bit bucket), w/o vals changes:
+  std::vector<int64_t> jumps { 0, INT64_MAX, INT64_MIN, -1, 5, 5, 5 };
+  std::vector<Len_km>  same(jumps.size(), 1.0_km);
+  buff.clear();
+  CompressSeries(same.data(), same.size(), &buff, jumps.data());
+  DecompressSeries<DimQ_Sys>(buff.data(), buff.size(), &ys, &us);
+  nErrs += (us != jumps || ys != same);
+
+  //-------------------------------------------------------------------------//
+  // Errors:                                                                 //
+  //-------------------------------------------------------------------------//
+  buff.clear();
+  CompressSeries(xs.data(), 100, &buff);
+  ExpectFail<Mass>(buff);                         // Dims mismatch
+
+  std::vector<uint8_t> bad = buff;
+  bad.resize(bad.size() - 8);                     // Truncated
+  ExpectFail<Len>(bad);
+
+  bad = buff;
+  bad[offsetof(Bits::SeriesBlockHdr, m_maxDims)] = 9;
+  ExpectFail<Len>(bad);                           // MaxDims mismatch
+
+  bad = buff;
+  uint32_t huge = UINT32_MAX;                     // Too many vals
+  memcpy(bad.data() + offsetof(Bits::SeriesBlockHdr, m_nVals), &huge, 4);
+  ExpectFail<Len>(bad);
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// vim:ts=2:et
+//===========================================================================//
+//                          "Tests/TelemetryTest.cpp":                       //
+//===========================================================================//
+#include "DimTypes/Telemetry.hpp"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (ms,  0.001),   (us, 1e-6)),
+    (Mass, kg)
+  )
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+}
+
+int main()
+{
+  int nErrs = 0;
+  using Lat = decltype(1.0_us);
+
+  //-------------------------------------------------------------------------//
+  // Concurrent Recording:                                                   //
+  //-------------------------------------------------------------------------//
+  constexpr unsigned NThreads = 8;
+  constexpr unsigned N        = 100000;
+  DimTypes::ShardedStats    <Lat> stats;
+  DimTypes::ShardedHistogram<Lat> hist(1.0_us, 1e6_us, 16);
+  {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < NThreads; ++t)
+      threads.emplace_back([&stats, &hist]()
+      {
+        for (unsigned i = 1; i <= N; ++i)
+        {
+          stats.Record(Time_us(double(i)));
+          hist .Record(Time_us(double(i)));
+        }
+      });
+    for (auto& thread: threads)
+      thread.join();
+  }
+  auto s = stats.Get();
+  printf("N=%lu, Mean=%s, StdDev=%s, Min=%s, Max=%s\n", s.m_count,
+         ToStr(s.Mean()).data(), ToStr(s.StdDev()).data(),
+         ToStr(s.m_min).data(),  ToStr(s.m_max).data());
+  nErrs += (s.m_count != NThreads * N);
+  nErrs += (s.m_sum   != Time_us(0.5 * NThreads * N * (N + 1.0)));
+  nErrs += (s.m_min   != 1.0_us || s.m_max != Time_us(N));
+
+  std::vector<uint64_t> counts = hist.GetCounts();
+  uint64_t              total  = 0;
+  for (uint64_t c: counts)
+    total += c;
+  nErrs += (total != NThreads * N);
+
+  // The quantiles are within the relative bucket width (1/16):
+  Lat p50 = hist.Quantile(0.5);
+  printf("P50=%s, P99=%s\n", ToStr(p50).data(),
+         ToStr(hist.Quantile(0.99)).data());
+  nErrs += (p50 < Time_us(N / 2.0) || p50 > Time_us(N / 2.0 * (1 + 1.0/16)));
+
+  // The quantiles are bounded by the observed range:
+  auto [hMin, hMax] = hist.GetMinMax();
+  nErrs += (hMin != s.m_min || hMax != s.m_max);
+  nErrs += (hist.Quantile(0.99) > s.m_max || hist.Quantile(1.0) != s.m_max ||
+            hist.Quantile(0.0)  < s.m_min);
+
+  //-------------------------------------------------------------------------//
+  // Bucket Layout:                                                          //
+  //-------------------------------------------------------------------------//
+  for (unsigned b = 1; b + 1 < hist.NBuckets(); ++b)
+    nErrs += (hist.BucketOf(hist.BucketLo(b)) != b ||
+              !(hist.BucketLo(b) < hist.BucketHi(b)));
+  nErrs += (hist.BucketOf(0.5_us)        != 0);
+  nErrs += (hist.BucketOf(Time_us(NAN))  != 0);
+  nErrs += (hist.BucketOf(2e6_us)        != hist.NBuckets() - 1);
+
+  // "hi" on a bucket boundary: 10 octaves of 4 buckets, + Under- and Over-Flow:
+  DimTypes::ShardedHistogram<Lat> hist1(1.0_us, 1024.0_us, 4);
+  nErrs += (hist1.NBuckets() != 42);
+  nErrs += (hist1.BucketHi(40) != 1024.0_us || hist1.BucketLo(40) != 896.0_us);
+
+  // OverFlow only: the quantiles are the max, not +Inf:
+  hist1.Record(3000.0_us);
+  hist1.Record(2000.0_us);
+  hist1.Record(Time_us(NAN));
+  nErrs += (hist1.Quantile(0.9) != 3000.0_us);
+  hist1.Reset();
+  nErrs += !std::isnan(hist1.Quantile(0.5).Magnitude());
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// vim:ts=2:et
+//===========================================================================//
+//                            "Tests/WireTest.cpp":                          //
+//===========================================================================//
+// Wire round-trips of "DimQ"s and arrays, and rejection of messages from in-
+// compatible Dimension Systems or types, and of truncated ones:
+//
+#include "DimTypes/Wire.hpp"
+#include <cstdio>
+#include <vector>
+
+# ifdef __clang__
+# pragma  clang diagnostic push
+# pragma  clang diagnostic ignored "-Wunused-function"
+# pragma  clang diagnostic ignored "-Wunused-template"
+# pragma  clang diagnostic ignored "-Wunused-const-variable"
+# endif
+namespace A
+{
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+}
+// Same as "A", declared separately:
+namespace B
+{
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86400.0)),
+    (Mass, kg)
+  )
+}
+// Different scale of "day":
+namespace C
+{
+  DECLARE_DIMS(
+    double, ,
+    (Len,  m,   (km,  1000.0)),
+    (Time, sec, (day, 86164.0905)),
+    (Mass, kg)
+  )
+}
+// Complex "RepT" (its literal operators convert "long double"s into it):
+# pragma  GCC diagnostic push
+# pragma  GCC diagnostic ignored "-Wfloat-conversion"
+namespace Z
+{
+  DECLARE_DIMS(
+    std::complex<float>, ,
+    (Len,  m,   (km,  1000.0f)),
+    (Time, sec)
+  )
+}
+# pragma  GCC diagnostic pop
+# ifdef __clang__
+# pragma  clang diagnostic pop
+# endif
+
+namespace
+{
+  using namespace DimTypes;
+  int nErrs = 0;
+
+  // Decoding "a_msg" as "DQ" in "Sys" must throw:
+  template<typename Sys, typename DQ>
+  void ExpectFail(std::vector<uint8_t> const& a_msg)
+  {
+    try
+    {
+      DQ res;
+      WireDecode<Sys>(a_msg.data(), a_msg.data() + a_msg.size(), &res);
+      ++nErrs;
+    }
+    catch (std::runtime_error const& exn)
+      { printf("Expected: %s\n", exn.what()); }
+  }
+}
+
+int main()
+{
+  //-------------------------------------------------------------------------//
+  // Fingerprints:                                                           //
+  //-------------------------------------------------------------------------//
+  static_assert(A::DimQ_Fingerprint == B::DimQ_Fingerprint);
+  static_assert(A::DimQ_Fingerprint != C::DimQ_Fingerprint);
+  using RateA = decltype(A::Len_km(1.0) / A::Time_day(1.0));
+  using RateB = decltype(B::Len_km(1.0) / B::Time_day(1.0));
+  static_assert(WireTag<A::DimQ_Sys, RateA> == WireTag<B::DimQ_Sys, RateB>);
+  static_assert(WireTag<A::DimQ_Sys, RateA> !=
+                WireTag<A::DimQ_Sys, RateA, true>);
+  static_assert(WireSize<RateA> == 16);
+
+  //-------------------------------------------------------------------------//
+  // Scalars:                                                                //
+  //-------------------------------------------------------------------------//
+  std::vector<uint8_t> msg(WireSize<RateA>);
+  RateA const r0 = A::Len_km(2.5) / A::Time_day(1.0);
+  nErrs += (WireEncode<A::DimQ_Sys>(r0, msg.data()) != msg.data() + 16);
+
+  // The wire format is Tag, Magnitude (Little-Endian):
+  uint64_t tag = 0;
+  for (unsigned i = 0; i < 8; ++i)
+    tag |= uint64_t(msg[i]) << (8 * i);
+  nErrs += (tag != WireTag<A::DimQ_Sys, RateA>);
+
+  // Decoded by a compatible System:
+  RateB r1;
+  uint8_t const* end =
+    WireDecode<B::DimQ_Sys>(msg.data(), msg.data() + msg.size(), &r1);
+  nErrs += (end != msg.data() + msg.size() || r1.Magnitude() != 2.5);
+
+  // Other Units, other Dims, other System, truncated:
+  ExpectFail<A::DimQ_Sys, decltype(A::Len(1.0) / A::Time_day(1.0))>(msg);
+  ExpectFail<A::DimQ_Sys, A::Len_km>(msg);
+  ExpectFail<C::DimQ_Sys,
+             decltype(C::Len_km(1.0) / C::Time_day(1.0))>(msg);
+  std::vector<uint8_t> shortMsg(msg.begin(), msg.end() - 1);
+  ExpectFail<A::DimQ_Sys, RateA>(shortMsg);
+
+  // Complex:
+  std::vector<uint8_t> zmsg(WireSize<Z::Len_km>);
+  Z::Len_km const z0(std::complex<float>(1.5f, -2.0f));
+  WireEncode<Z::DimQ_Sys>(z0, zmsg.data());
+  Z::Len_km z1;
+  WireDecode<Z::DimQ_Sys>(zmsg.data(), zmsg.data() + zmsg.size(), &z1);
+  nErrs += (zmsg.size() != 16 || z1 != z0);
+
+  //-------------------------------------------------------------------------//
+  // Arrays (appended to the same buffer):                                   //
+  //-------------------------------------------------------------------------//
+  std::vector<A::Len_km> ls { A::Len_km(1.0), A::Len_km(-2.0),
+                              A::Len_km(3.5) };
+  std::vector<uint8_t> buff;
+  WireEncode<A::DimQ_Sys>(ls.data(), ls.size(), &buff);
+  WireEncode<A::DimQ_Sys>(ls.data(), 0,         &buff);
+  nErrs += (buff.size() != 16 + 3 * 8 + 16);
+
+  std::vector<B::Len_km> ms;
+  uint8_t const* curr =
+    WireDecode<B::DimQ_Sys>(buff.data(), buff.data() + buff.size(), &ms);
+  nErrs += (ms.size() != 3 || ms[1].Magnitude() != -2.0);
+  curr = WireDecode<B::DimQ_Sys>(curr, buff.data() + buff.size(), &ms);
+  nErrs += (!ms.empty() || curr != buff.data() + buff.size());
+
+  // A scalar is not an array, and a huge N is truncation:
+  try
+  {
+    WireDecode<A::DimQ_Sys>(msg.data(), msg.data() + msg.size(), &ms);
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  std::vector<uint8_t> huge = buff;
+  memset(huge.data() + 8, 0xff, 8);
+  try
+  {
+    std::vector<A::Len_km> xs;
+    WireDecode<A::DimQ_Sys>(huge.data(), huge.data() + huge.size(), &xs);
+    ++nErrs;
+  }
+  catch (std::runtime_error const& exn)
+    { printf("Expected: %s\n", exn.what()); }
+
+  printf("Errors: %d\n", nErrs);
+  return (nErrs == 0) ? 0 : 1;
+}